@@ -132,6 +132,7 @@ void _clutter_actor_rerealize (ClutterActor    *self,
 void _clutter_actor_set_opacity_override (ClutterActor *self,
                                           gint          opacity);
 gint _clutter_actor_get_opacity_override (ClutterActor *self);
+gboolean _clutter_actor_is_subtree_damaged (ClutterActor *self);
 void _clutter_actor_set_in_clone_paint (ClutterActor *self,
                                         gboolean      is_in_clone_paint);
 
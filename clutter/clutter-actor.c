@@ -299,6 +299,7 @@
 #include "clutter-enum-types.h"
 #include "clutter-main.h"
 #include "clutter-marshal.h"
+#include "clutter-offscreen-effect-private.h"
 #include "clutter-paint-volume-private.h"
 #include "clutter-private.h"
 #include "clutter-profile.h"
@@ -410,6 +411,7 @@ struct _ClutterActorPrivate
   guint enable_paint_unmapped       : 1;
   guint has_pointer                 : 1;
   guint propagated_one_redraw       : 1;
+  guint subtree_damaged             : 1;
   guint paint_volume_valid          : 1;
   guint last_paint_volume_valid     : 1;
   guint in_clone_paint              : 1;
@@ -1878,10 +1880,23 @@ clutter_actor_real_queue_redraw (ClutterActor *self,
       ClutterActor *stage = _clutter_actor_get_stage_internal (self);
       if (stage != NULL &&
           _clutter_stage_has_full_redraw_queued (CLUTTER_STAGE (stage)))
-        return;
+        {
+          /* the ancestors still need to know that their subtree has
+           * changed; an effect reusing the result of a previous paint
+           * stops its children from being painted, and thus from ever
+           * resetting their propagated_one_redraw flag
+           */
+          for (parent = self;
+               parent != NULL;
+               parent = parent->priv->parent_actor)
+            parent->priv->subtree_damaged = TRUE;
+
+          return;
+        }
     }
 
   self->priv->propagated_one_redraw = TRUE;
+  self->priv->subtree_damaged = TRUE;
 
   /* notify parents, if they are all visible eventually we'll
    * queue redraw on the stage, which queues the redraw idle.
@@ -2320,14 +2335,21 @@ _clutter_actor_apply_modelview_transform (ClutterActor *self,
   CLUTTER_ACTOR_GET_CLASS (self)->apply_transform (self, matrix);
 }
 
+/* runs the pre_paint() of the enabled effects, stopping at the first
+ * effect holding the result of a previous paint of the actor, if any;
+ * in that case the effects after it and the actor itself do not need
+ * to be painted, and @cached_effect is set to that effect
+ */
 static gboolean
-_clutter_actor_effects_pre_paint (ClutterActor *self)
+_clutter_actor_effects_pre_paint (ClutterActor   *self,
+                                  ClutterEffect **cached_effect)
 {
   ClutterActorPrivate *priv = self->priv;
   const GList *effects, *l;
   gboolean was_pre_painted = FALSE;
 
   priv->current_effect = NULL;
+  *cached_effect = NULL;
 
   effects = _clutter_meta_group_peek_metas (priv->effects);
   for (l = effects; l != NULL; l = l->next)
@@ -2341,6 +2363,13 @@ _clutter_actor_effects_pre_paint (ClutterActor *self)
       priv->current_effect = l->data;
 
       was_pre_painted |= _clutter_effect_pre_paint (effect);
+
+      if (CLUTTER_IS_OFFSCREEN_EFFECT (effect) &&
+          _clutter_offscreen_effect_is_cached (CLUTTER_OFFSCREEN_EFFECT (effect)))
+        {
+          *cached_effect = effect;
+          break;
+        }
     }
 
   priv->current_effect = NULL;
@@ -2349,16 +2378,24 @@ _clutter_actor_effects_pre_paint (ClutterActor *self)
 }
 
 static void
-_clutter_actor_effects_post_paint (ClutterActor *self)
+_clutter_actor_effects_post_paint (ClutterActor  *self,
+                                   ClutterEffect *cached_effect)
 {
   ClutterActorPrivate *priv = self->priv;
   const GList *effects, *l;
 
   priv->current_effect = NULL;
 
-  /* we walk the list backwards, to unwind the post-paint order */
+  /* we walk the list backwards, to unwind the post-paint order; the
+   * effects after a cached one were not pre-painted
+   */
   effects = _clutter_meta_group_peek_metas (priv->effects);
-  for (l = g_list_last ((GList *) effects); l != NULL; l = l->prev)
+  if (cached_effect != NULL)
+    l = g_list_find ((GList *) effects, cached_effect);
+  else
+    l = g_list_last ((GList *) effects);
+
+  for (; l != NULL; l = l->prev)
     {
       ClutterEffect *effect = l->data;
       ClutterActorMeta *meta = l->data;
@@ -2695,6 +2732,7 @@ clutter_actor_paint (ClutterActor *self)
 
   if (pick_mode == CLUTTER_PICK_NONE)
     {
+      ClutterEffect *cached_effect = NULL;
       gboolean effect_painted = FALSE;
 
       CLUTTER_COUNTER_INC (_clutter_uprof_context, actor_paint_counter);
@@ -2729,15 +2767,22 @@ clutter_actor_paint (ClutterActor *self)
         }
 
       if (priv->effects != NULL)
-        effect_painted = _clutter_actor_effects_pre_paint (self);
+        effect_painted = _clutter_actor_effects_pre_paint (self,
+                                                           &cached_effect);
       else if (actor_has_shader_data (self))
         clutter_actor_shader_pre_paint (self, FALSE);
 
       priv->propagated_one_redraw = FALSE;
-      g_signal_emit (self, actor_signals[PAINT], 0);
+      priv->subtree_damaged = FALSE;
+
+      /* if an effect can reuse the result of a previous paint there
+       * is no need to paint the actor and its children again
+       */
+      if (cached_effect == NULL)
+        g_signal_emit (self, actor_signals[PAINT], 0);
 
       if (effect_painted)
-        _clutter_actor_effects_post_paint (self);
+        _clutter_actor_effects_post_paint (self, cached_effect);
       else if (actor_has_shader_data (self))
         clutter_actor_shader_post_paint (self);
 
@@ -4954,6 +4999,9 @@ clutter_actor_init (ClutterActor *self)
 
   priv->transform_valid = FALSE;
 
+  /* nothing has been painted yet */
+  priv->subtree_damaged = TRUE;
+
   memset (priv->clip, 0, sizeof (gfloat) * 4);
 }
 
@@ -10250,6 +10298,24 @@ _clutter_actor_get_opacity_override (ClutterActor *self)
   return self->priv->opacity_override;
 }
 
+/*
+ * _clutter_actor_is_subtree_damaged:
+ * @self: a #ClutterActor
+ *
+ * Checks whether @self or any of its children queued a redraw since
+ * the last time @self was painted. This can be used by effects to
+ * decide whether the result of a previous paint can be reused.
+ *
+ * Return value: %TRUE if the subtree of @self has changed
+ */
+gboolean
+_clutter_actor_is_subtree_damaged (ClutterActor *self)
+{
+  g_return_val_if_fail (CLUTTER_IS_ACTOR (self), TRUE);
+
+  return self->priv->subtree_damaged;
+}
+
 /* Allows you to disable applying the actors model view transform during
  * a paint. Used by ClutterClone. */
 void
@@ -92,6 +92,11 @@ clutter_backend_dispose (GObject *gobject)
   /* clear the events still in the queue of the main context */
   _clutter_clear_events_queue ();
 
+  /* release the idle offscreen targets of the effects, unless the
+   * backend already did it before destroying its GL context
+   */
+  _clutter_context_free_offscreen_pool ();
+
   /* remove all event translators */
   if (priv->event_translators != NULL)
     {
@@ -29,11 +29,6 @@
 
 G_BEGIN_DECLS
 
-/* This is used in _clutter_bezier_advance to represent the full
-   length of the bezier curve. Anything less than that represents a
-   fraction of the length */
-#define CLUTTER_BEZIER_MAX_LENGTH (1 << 18)
-
 typedef struct _ClutterBezier ClutterBezier;
 
 ClutterBezier *_clutter_bezier_new ();
@@ -44,9 +39,10 @@ ClutterBezier *_clutter_bezier_clone_and_move (const ClutterBezier *b,
                                                gint           x,
                                                gint           y);
 
-void           _clutter_bezier_advance (const ClutterBezier *b,
-                                        gint           L,
-                                        ClutterKnot   *knot);
+void           _clutter_bezier_get_point (const ClutterBezier *b,
+                                          gfloat               t,
+                                          gfloat              *x,
+                                          gfloat              *y);
 
 void           _clutter_bezier_init (ClutterBezier *b,
                                      gint x_0, gint y_0,
@@ -58,8 +54,6 @@ void           _clutter_bezier_adjust (ClutterBezier *b,
                                        ClutterKnot   *knot,
                                        guint          indx);
 
-guint          _clutter_bezier_get_length (const ClutterBezier *b);
-
 G_END_DECLS
 
 #endif /* __CLUTTER_BEZIER_H__ */
@@ -30,6 +30,12 @@
  * #ClutterBlurEffect is a sub-class of #ClutterEffect that allows blurring a
  * actor and its contents.
  *
+ * The strength of the blur is controlled by the #ClutterBlurEffect:radius
+ * property. The blur is a gaussian blur applied in two separate passes,
+ * one horizontal and one vertical; for big radii the contents of the
+ * actor are first scaled down, so that the cost of the blur does not
+ * depend on the radius.
+ *
  * #ClutterBlurEffect is available since Clutter 1.4
  */
 
@@ -43,41 +49,59 @@
 
 #include "clutter-blur-effect.h"
 
+#include <math.h>
+
 #include "cogl/cogl.h"
 
 #include "clutter-debug.h"
-#include "clutter-offscreen-effect.h"
+#include "clutter-offscreen-effect-private.h"
 #include "clutter-private.h"
 
-#define BLUR_PADDING    2
+/* the number of texels sampled on each side of the centre of the
+ * kernel, plus one for the centre
+ */
+#define KERNEL_SIZE             5
+
+/* the blur is computed on a scaled down copy of the actor whenever
+ * the radius does not fit in the kernel; each downsample halves the
+ * resolution
+ */
+#define MAX_DOWNSAMPLES         5
+
+#define DEFAULT_RADIUS          3.0
 
-/* FIXME - lame shader; we should really have a decoupled
- * horizontal/vertical two pass shader for the gaussian blur
+/* the same shader is used for the horizontal and vertical passes,
+ * with @pixel_step being the size of a texel in that direction
  */
-static const gchar *box_blur_glsl_shader =
+static const gchar *gaussian_blur_glsl_shader =
 "uniform sampler2D tex;\n"
-"uniform float x_step, y_step;\n"
-"\n"
-"vec4 get_rgba_rel (sampler2D source, float dx, float dy)\n"
-"{\n"
-"  return texture2D (tex, cogl_tex_coord_in[0].st + vec2 (dx, dy) * 2.0);\n"
-"}\n"
+"uniform vec2 pixel_step;\n"
+"uniform float weights[" G_STRINGIFY (KERNEL_SIZE) "];\n"
 "\n"
 "void main ()\n"
 "{\n"
-"  vec4 color = cogl_color_in * texture2D (tex, vec2 (cogl_tex_coord_in[0].xy));\n"
-"  color += get_rgba_rel (tex, -x_step, -y_step);\n"
-"  color += get_rgba_rel (tex,  0.0,    -y_step);\n"
-"  color += get_rgba_rel (tex,  x_step, -y_step);\n"
-"  color += get_rgba_rel (tex, -x_step,  0.0);\n"
-"  color += get_rgba_rel (tex,  0.0,     0.0);\n"
-"  color += get_rgba_rel (tex,  x_step,  0.0);\n"
-"  color += get_rgba_rel (tex, -x_step,  y_step);\n"
-"  color += get_rgba_rel (tex,  0.0,     y_step);\n"
-"  color += get_rgba_rel (tex,  x_step,  y_step);\n"
-"  cogl_color_out = color / 9.0;\n"
+"  vec2 coord = cogl_tex_coord_in[0].st;\n"
+"  vec4 color = texture2D (tex, coord) * weights[0];\n"
+"\n"
+"  for (int i = 1; i < " G_STRINGIFY (KERNEL_SIZE) "; i++)\n"
+"    {\n"
+"      vec2 offset = pixel_step * float (i);\n"
+"\n"
+"      color += texture2D (tex, coord + offset) * weights[i];\n"
+"      color += texture2D (tex, coord - offset) * weights[i];\n"
+"    }\n"
+"\n"
+"  cogl_color_out = color * cogl_color_in;\n"
 "}";
 
+enum
+{
+  BLUR_HORIZONTAL,
+  BLUR_VERTICAL,
+
+  N_BLUR_PASSES
+};
+
 struct _ClutterBlurEffect
 {
   ClutterOffscreenEffect parent_instance;
@@ -85,18 +109,33 @@ struct _ClutterBlurEffect
   /* a back pointer to our actor, so that we can query it */
   ClutterActor *actor;
 
-  /* the parameters; x_step and y_step depend on
-   * the actor's allocation
+  gdouble radius;
+
+  /* the weights of the kernel, from the centre outwards, at the
+   * resolution of the blurred texture
    */
-  gfloat x_step;
-  gfloat y_step;
+  gfloat weights[KERNEL_SIZE];
 
   CoglHandle shader;
-  CoglHandle program;
 
-  gint tex_uniform;
-  gint x_step_uniform;
-  gint y_step_uniform;
+  /* we use a program for each pass, so that changing the uniforms
+   * of a pass does not affect the other one before it is drawn
+   */
+  CoglHandle programs[N_BLUR_PASSES];
+  gint tex_uniforms[N_BLUR_PASSES];
+  gint pixel_step_uniforms[N_BLUR_PASSES];
+  gint weights_uniforms[N_BLUR_PASSES];
+
+  CoglMaterial *downsample_material;
+  CoglMaterial *blur_materials[N_BLUR_PASSES];
+
+  /* the scaled down and horizontally blurred contents of the actor;
+   * the vertical pass is drawn straight on the stage. The texture is
+   * kept for as long as the actor is not redirected again
+   */
+  ClutterOffscreenTarget *blurred;
+  gfloat blurred_width;
+  gfloat blurred_height;
 
   guint is_compiled : 1;
 };
@@ -106,19 +145,107 @@ struct _ClutterBlurEffectClass
   ClutterOffscreenEffectClass parent_class;
 };
 
+enum
+{
+  PROP_0,
+
+  PROP_RADIUS,
+
+  PROP_LAST
+};
+
+static GParamSpec *obj_props[PROP_LAST];
+
 G_DEFINE_TYPE (ClutterBlurEffect,
                clutter_blur_effect,
                CLUTTER_TYPE_OFFSCREEN_EFFECT);
 
-static int
-next_p2 (int a)
+static void
+clutter_blur_effect_release_blurred (ClutterBlurEffect *self)
 {
-  int rval = 1;
+  if (self->blurred == NULL)
+    return;
+
+  _clutter_offscreen_pool_return (_clutter_context_get_offscreen_pool (),
+                                  self->blurred);
+  self->blurred = NULL;
+}
+
+static CoglMaterial *
+create_pass_material (CoglHandle program,
+                      gboolean   replace)
+{
+  CoglMaterial *material = cogl_material_new ();
+
+  /* the passes drawn offscreen replace the contents of their target */
+  if (replace)
+    cogl_material_set_blend (material, "RGBA = ADD (SRC_COLOR, 0)", NULL);
+
+  cogl_material_set_layer_filters (material, 0,
+                                   COGL_MATERIAL_FILTER_LINEAR,
+                                   COGL_MATERIAL_FILTER_LINEAR);
+
+  /* the kernel samples outside of the contents at the edges */
+  cogl_material_set_layer_wrap_mode (material, 0,
+                                     COGL_MATERIAL_WRAP_MODE_CLAMP_TO_EDGE);
 
-  while (rval < a)
-    rval <<= 1;
+  if (program != COGL_INVALID_HANDLE)
+    cogl_material_set_user_program (material, program);
 
-  return rval;
+  return material;
+}
+
+static gboolean
+clutter_blur_effect_compile (ClutterBlurEffect *self)
+{
+  gint i;
+
+  self->shader = cogl_create_shader (COGL_SHADER_TYPE_FRAGMENT);
+  cogl_shader_source (self->shader, gaussian_blur_glsl_shader);
+
+  cogl_shader_compile (self->shader);
+  if (!cogl_shader_is_compiled (self->shader))
+    {
+      gchar *log_buf = cogl_shader_get_info_log (self->shader);
+
+      g_warning (G_STRLOC ": Unable to compile the gaussian blur shader: %s",
+                 log_buf);
+      g_free (log_buf);
+
+      cogl_handle_unref (self->shader);
+      self->shader = COGL_INVALID_HANDLE;
+
+      return FALSE;
+    }
+
+  for (i = 0; i < N_BLUR_PASSES; i++)
+    {
+      CoglHandle program = cogl_create_program ();
+
+      cogl_program_attach_shader (program, self->shader);
+      cogl_program_link (program);
+
+      self->programs[i] = program;
+      self->tex_uniforms[i] =
+        cogl_program_get_uniform_location (program, "tex");
+      self->pixel_step_uniforms[i] =
+        cogl_program_get_uniform_location (program, "pixel_step");
+      self->weights_uniforms[i] =
+        cogl_program_get_uniform_location (program, "weights");
+
+      self->blur_materials[i] =
+        create_pass_material (program, i != BLUR_VERTICAL);
+    }
+
+  /* the downsampling relies on the linear filtering to average the
+   * texels, so it does not need a program
+   */
+  self->downsample_material = create_pass_material (COGL_INVALID_HANDLE,
+                                                    TRUE);
+
+  cogl_handle_unref (self->shader);
+
+  return TRUE;
 }
 
 static gboolean
@@ -126,8 +253,6 @@ clutter_blur_effect_pre_paint (ClutterEffect *effect)
 {
   ClutterBlurEffect *self = CLUTTER_BLUR_EFFECT (effect);
   ClutterEffectClass *parent_class;
-  ClutterActorBox allocation;
-  gfloat width, height;
 
   if (!clutter_actor_meta_get_enabled (CLUTTER_ACTOR_META (effect)))
     return FALSE;
@@ -148,77 +273,192 @@ clutter_blur_effect_pre_paint (ClutterEffect *effect)
       return FALSE;
     }
 
-  clutter_actor_get_allocation_box (self->actor, &allocation);
-  clutter_actor_box_get_size (&allocation, &width, &height);
+  /* if the compilation fails we still paint the actor, unblurred */
+  if (!self->is_compiled)
+    {
+      clutter_blur_effect_compile (self);
+      self->is_compiled = TRUE;
+    }
+
+  parent_class = CLUTTER_EFFECT_CLASS (clutter_blur_effect_parent_class);
+  return parent_class->pre_paint (effect);
+}
+
+/* computes the normalized weights of a gaussian kernel with standard
+ * deviation @sigma, in texels
+ */
+static void
+compute_weights (gfloat  sigma,
+                 gfloat *weights)
+{
+  gfloat sum;
+  gint i;
 
-  self->x_step = 1.0f / (float) next_p2 (width);
-  self->y_step = 1.0f / (float) next_p2 (height);
+  weights[0] = sum = 1.0f;
 
-  if (self->shader == COGL_INVALID_HANDLE)
+  for (i = 1; i < KERNEL_SIZE; i++)
     {
-      self->shader = cogl_create_shader (COGL_SHADER_TYPE_FRAGMENT);
-      cogl_shader_source (self->shader, box_blur_glsl_shader);
+      if (sigma > 0.0f)
+        weights[i] = expf (-(i * i) / (2.0f * sigma * sigma));
+      else
+        weights[i] = 0.0f;
 
-      self->is_compiled = FALSE;
-      self->tex_uniform = -1;
-      self->x_step_uniform = -1;
-      self->y_step_uniform = -1;
+      sum += 2.0f * weights[i];
     }
 
-  if (self->program == COGL_INVALID_HANDLE)
-    self->program = cogl_create_program ();
-
-  if (!self->is_compiled)
-    {
-      g_assert (self->shader != COGL_INVALID_HANDLE);
-      g_assert (self->program != COGL_INVALID_HANDLE);
+  for (i = 0; i < KERNEL_SIZE; i++)
+    weights[i] /= sum;
+}
 
-      cogl_shader_compile (self->shader);
-      if (!cogl_shader_is_compiled (self->shader))
-        {
-          gchar *log_buf = cogl_shader_get_info_log (self->shader);
+/* draws the area between (0, 0) and (@s_2, @t_2) of @texture using
+ * @material into the top left @width x @height pixels of @target
+ */
+static void
+draw_pass (ClutterOffscreenTarget *target,
+           CoglMaterial           *material,
+           CoglHandle              texture,
+           gfloat                  width,
+           gfloat                  height,
+           gfloat                  s_2,
+           gfloat                  t_2)
+{
+  CoglColor transparent;
+  CoglMatrix modelview;
 
-          g_warning (G_STRLOC ": Unable to compile the box blur shader: %s",
-                     log_buf);
-          g_free (log_buf);
+  cogl_material_set_layer (material, 0, texture);
 
-          cogl_handle_unref (self->shader);
-          cogl_handle_unref (self->program);
+  cogl_push_framebuffer (target->offscreen);
 
-          self->shader = COGL_INVALID_HANDLE;
-          self->program = COGL_INVALID_HANDLE;
-        }
-      else
-        {
-          cogl_program_attach_shader (self->program, self->shader);
-          cogl_program_link (self->program);
+  /* the target might have been used by someone else */
+  cogl_set_viewport (0, 0, target->width, target->height);
+  cogl_ortho (0, target->width, target->height, 0, -1, 1);
+  cogl_matrix_init_identity (&modelview);
+  cogl_set_modelview_matrix (&modelview);
 
-          cogl_handle_unref (self->shader);
+  /* the kernel samples the unused part of the target at the edges,
+   * so it must be transparent
+   */
+  cogl_color_init_from_4ub (&transparent, 0, 0, 0, 0);
+  cogl_clear (&transparent, COGL_BUFFER_BIT_COLOR);
 
-          self->is_compiled = TRUE;
+  cogl_set_source (material);
+  cogl_rectangle_with_texture_coords (0, 0, width, height,
+                                      0.0f, 0.0f,
+                                      s_2, t_2);
 
-          self->tex_uniform =
-            cogl_program_get_uniform_location (self->program, "tex");
-          self->x_step_uniform =
-            cogl_program_get_uniform_location (self->program, "x_step");
-          self->y_step_uniform =
-            cogl_program_get_uniform_location (self->program, "y_step");
-        }
-    }
+  cogl_pop_framebuffer ();
+}
 
-  parent_class = CLUTTER_EFFECT_CLASS (clutter_blur_effect_parent_class);
-  return parent_class->pre_paint (effect);
+static void
+set_pass_uniforms (ClutterBlurEffect *self,
+                   gint               pass,
+                   gfloat             x_step,
+                   gfloat             y_step)
+{
+  CoglHandle program = self->programs[pass];
+  gfloat pixel_step[2] = { x_step, y_step };
+
+  if (self->tex_uniforms[pass] > -1)
+    cogl_program_set_uniform_1i (program, self->tex_uniforms[pass], 0);
+
+  if (self->pixel_step_uniforms[pass] > -1)
+    cogl_program_set_uniform_float (program,
+                                    self->pixel_step_uniforms[pass],
+                                    2, 1,
+                                    pixel_step);
+
+  if (self->weights_uniforms[pass] > -1)
+    cogl_program_set_uniform_float (program,
+                                    self->weights_uniforms[pass],
+                                    1, KERNEL_SIZE,
+                                    self->weights);
 }
 
-static CoglHandle
-clutter_blur_effect_create_texture (ClutterOffscreenEffect *effect,
-                                    gfloat                  min_width,
-                                    gfloat                  min_height)
+/* scales the contents of the offscreen buffer down until the radius
+ * fits in the kernel, and blurs them horizontally
+ */
+static gboolean
+clutter_blur_effect_update_blurred (ClutterBlurEffect *self,
+                                    gfloat             width,
+                                    gfloat             height)
 {
-  return cogl_texture_new_with_size (min_width + (2 * BLUR_PADDING),
-                                     min_height + (2 * BLUR_PADDING),
-                                     COGL_TEXTURE_NO_SLICING,
-                                     COGL_PIXEL_FORMAT_RGBA_8888_PRE);
+  ClutterOffscreenEffect *effect = CLUTTER_OFFSCREEN_EFFECT (self);
+  ClutterOffscreenPool *pool = _clutter_context_get_offscreen_pool ();
+  ClutterOffscreenTarget *source = NULL;
+  CoglHandle texture;
+  gfloat radius = self->radius;
+  gfloat s_2, t_2;
+  gint n_downsamples = 0;
+
+  clutter_blur_effect_release_blurred (self);
+
+  texture = _clutter_offscreen_effect_get_target_texture (effect);
+  if (texture == COGL_INVALID_HANDLE)
+    return FALSE;
+
+  _clutter_offscreen_effect_get_target_coords (effect, &s_2, &t_2);
+
+  while (radius > KERNEL_SIZE - 1 && n_downsamples < MAX_DOWNSAMPLES)
+    {
+      ClutterOffscreenTarget *level;
+      gfloat level_width = ceilf (width / 2.0f);
+      gfloat level_height = ceilf (height / 2.0f);
+
+      level = _clutter_offscreen_pool_lease (pool,
+                                             level_width, level_height,
+                                             COGL_PIXEL_FORMAT_RGBA_8888_PRE);
+
+      /* if we can't scale down any further we blur what we have */
+      if (level == NULL)
+        break;
+
+      draw_pass (level, self->downsample_material, texture,
+                 level_width, level_height,
+                 s_2, t_2);
+
+      if (source != NULL)
+        _clutter_offscreen_pool_return (pool, source);
+
+      source = level;
+      texture = level->texture;
+      width = level_width;
+      height = level_height;
+      s_2 = width / level->width;
+      t_2 = height / level->height;
+
+      radius /= 2.0f;
+      n_downsamples += 1;
+    }
+
+  CLUTTER_NOTE (PAINT, "Blurring a %.0fx%.0f target with a radius of %.2f "
+                "after %d downsamples",
+                width, height,
+                radius,
+                n_downsamples);
+
+  /* the kernel spans two standard deviations on each side */
+  compute_weights (radius / 2.0f, self->weights);
+
+  self->blurred = _clutter_offscreen_pool_lease (pool,
+                                                 width, height,
+                                                 COGL_PIXEL_FORMAT_RGBA_8888_PRE);
+  if (self->blurred != NULL)
+    {
+      set_pass_uniforms (self, BLUR_HORIZONTAL, s_2 / width, 0.0f);
+
+      draw_pass (self->blurred, self->blur_materials[BLUR_HORIZONTAL],
+                 texture,
+                 width, height,
+                 s_2, t_2);
+
+      self->blurred_width = width;
+      self->blurred_height = height;
+    }
+
+  if (source != NULL)
+    _clutter_offscreen_pool_return (pool, source);
+
+  return self->blurred != NULL;
 }
 
 static void
@@ -226,26 +466,50 @@ clutter_blur_effect_paint_target (ClutterOffscreenEffect *effect)
 {
   ClutterBlurEffect *self = CLUTTER_BLUR_EFFECT (effect);
   ClutterOffscreenEffectClass *parent;
-  CoglHandle material;
+  CoglMaterial *material;
+  gfloat width, height;
+  guint8 paint_opacity;
 
-  if (self->program == COGL_INVALID_HANDLE)
+  if (self->programs[BLUR_VERTICAL] == COGL_INVALID_HANDLE ||
+      self->radius <= 0.0)
     goto out;
 
-  if (self->tex_uniform > -1)
-    cogl_program_set_uniform_1i (self->program, self->tex_uniform, 0);
+  if (!clutter_offscreen_effect_get_target_size (effect, &width, &height))
+    goto out;
 
-  if (self->x_step_uniform > -1)
-    cogl_program_set_uniform_1f (self->program,
-                                 self->x_step_uniform,
-                                 self->x_step);
+  /* the blurred texture is still valid if the actor was not redirected
+   * again since it was created
+   */
+  if (self->blurred == NULL ||
+      !_clutter_offscreen_effect_is_cached (effect))
+    {
+      if (!clutter_blur_effect_update_blurred (self, width, height))
+        goto out;
+    }
 
-  if (self->y_step_uniform > -1)
-    cogl_program_set_uniform_1f (self->program,
-                                 self->y_step_uniform,
-                                 self->y_step);
+  /* the vertical pass scales the blurred texture back up, on the
+   * area the actor would have been painted on
+   */
+  set_pass_uniforms (self, BLUR_VERTICAL,
+                     0.0f, 1.0f / self->blurred->height);
 
-  material = clutter_offscreen_effect_get_target (effect);
-  cogl_material_set_user_program (material, self->program);
+  paint_opacity = clutter_actor_get_paint_opacity (self->actor);
+
+  material = self->blur_materials[BLUR_VERTICAL];
+  cogl_material_set_color4ub (material,
+                              paint_opacity,
+                              paint_opacity,
+                              paint_opacity,
+                              paint_opacity);
+  cogl_material_set_layer (material, 0, self->blurred->texture);
+  cogl_set_source (material);
+
+  cogl_rectangle_with_texture_coords (0, 0, width, height,
+                                      0.0f, 0.0f,
+                                      self->blurred_width / self->blurred->width,
+                                      self->blurred_height / self->blurred->height);
+
+  return;
 
 out:
   parent = CLUTTER_OFFSCREEN_EFFECT_CLASS (clutter_blur_effect_parent_class);
@@ -256,17 +520,24 @@ static gboolean
 clutter_blur_effect_get_paint_volume (ClutterEffect      *effect,
                                       ClutterPaintVolume *volume)
 {
+  ClutterBlurEffect *self = CLUTTER_BLUR_EFFECT (effect);
   gfloat cur_width, cur_height;
   ClutterVertex origin;
+  gfloat padding;
+
+  /* the blur spreads the contents of the actor by the radius in
+   * every direction
+   */
+  padding = ceilf (self->radius);
 
   clutter_paint_volume_get_origin (volume, &origin);
   cur_width = clutter_paint_volume_get_width (volume);
   cur_height = clutter_paint_volume_get_height (volume);
 
-  origin.x -= BLUR_PADDING;
-  origin.y -= BLUR_PADDING;
-  cur_width += 2 * BLUR_PADDING;
-  cur_height += 2 * BLUR_PADDING;
+  origin.x -= padding;
+  origin.y -= padding;
+  cur_width += 2 * padding;
+  cur_height += 2 * padding;
   clutter_paint_volume_set_origin (volume, &origin);
   clutter_paint_volume_set_width (volume, cur_width);
   clutter_paint_volume_set_height (volume, cur_height);
@@ -274,42 +545,145 @@ clutter_blur_effect_get_paint_volume (ClutterEffect      *effect,
   return TRUE;
 }
 
+static void
+clutter_blur_effect_set_actor (ClutterActorMeta *meta,
+                               ClutterActor     *actor)
+{
+  ClutterBlurEffect *self = CLUTTER_BLUR_EFFECT (meta);
+
+  CLUTTER_ACTOR_META_CLASS (clutter_blur_effect_parent_class)->set_actor (meta, actor);
+
+  clutter_blur_effect_release_blurred (self);
+}
+
 static void
 clutter_blur_effect_dispose (GObject *gobject)
 {
   ClutterBlurEffect *self = CLUTTER_BLUR_EFFECT (gobject);
+  gint i;
+
+  clutter_blur_effect_release_blurred (self);
 
-  if (self->program != COGL_INVALID_HANDLE)
+  for (i = 0; i < N_BLUR_PASSES; i++)
     {
-      cogl_handle_unref (self->program);
+      if (self->programs[i] != COGL_INVALID_HANDLE)
+        {
+          cogl_handle_unref (self->programs[i]);
+          self->programs[i] = COGL_INVALID_HANDLE;
+        }
 
-      self->program = COGL_INVALID_HANDLE;
-      self->shader = COGL_INVALID_HANDLE;
+      if (self->blur_materials[i] != NULL)
+        {
+          cogl_handle_unref (self->blur_materials[i]);
+          self->blur_materials[i] = NULL;
+        }
     }
 
+  if (self->downsample_material != NULL)
+    {
+      cogl_handle_unref (self->downsample_material);
+      self->downsample_material = NULL;
+    }
+
+  self->shader = COGL_INVALID_HANDLE;
+
   G_OBJECT_CLASS (clutter_blur_effect_parent_class)->dispose (gobject);
 }
 
+static void
+clutter_blur_effect_set_property (GObject      *gobject,
+                                  guint         prop_id,
+                                  const GValue *value,
+                                  GParamSpec   *pspec)
+{
+  ClutterBlurEffect *effect = CLUTTER_BLUR_EFFECT (gobject);
+
+  switch (prop_id)
+    {
+    case PROP_RADIUS:
+      clutter_blur_effect_set_radius (effect, g_value_get_double (value));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+clutter_blur_effect_get_property (GObject    *gobject,
+                                  guint       prop_id,
+                                  GValue     *value,
+                                  GParamSpec *pspec)
+{
+  ClutterBlurEffect *effect = CLUTTER_BLUR_EFFECT (gobject);
+
+  switch (prop_id)
+    {
+    case PROP_RADIUS:
+      g_value_set_double (value, effect->radius);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
+      break;
+    }
+}
+
 static void
 clutter_blur_effect_class_init (ClutterBlurEffectClass *klass)
 {
+  ClutterActorMetaClass *meta_class = CLUTTER_ACTOR_META_CLASS (klass);
   ClutterEffectClass *effect_class = CLUTTER_EFFECT_CLASS (klass);
   GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   ClutterOffscreenEffectClass *offscreen_class;
 
   gobject_class->dispose = clutter_blur_effect_dispose;
+  gobject_class->set_property = clutter_blur_effect_set_property;
+  gobject_class->get_property = clutter_blur_effect_get_property;
+
+  meta_class->set_actor = clutter_blur_effect_set_actor;
 
   effect_class->pre_paint = clutter_blur_effect_pre_paint;
   effect_class->get_paint_volume = clutter_blur_effect_get_paint_volume;
 
   offscreen_class = CLUTTER_OFFSCREEN_EFFECT_CLASS (klass);
-  offscreen_class->create_texture = clutter_blur_effect_create_texture;
   offscreen_class->paint_target = clutter_blur_effect_paint_target;
+
+  /**
+   * ClutterBlurEffect:radius:
+   *
+   * The radius of the blur, in pixels. A radius of 0.0 disables
+   * the blur.
+   *
+   * Since: 1.8
+   */
+  obj_props[PROP_RADIUS] =
+    g_param_spec_double ("radius",
+                         P_("Radius"),
+                         P_("The radius of the blur, in pixels"),
+                         0.0, G_MAXDOUBLE,
+                         DEFAULT_RADIUS,
+                         CLUTTER_PARAM_READWRITE);
+
+  g_object_class_install_properties (gobject_class,
+                                     PROP_LAST,
+                                     obj_props);
 }
 
 static void
 clutter_blur_effect_init (ClutterBlurEffect *self)
 {
+  gint i;
+
+  self->radius = DEFAULT_RADIUS;
+
+  for (i = 0; i < N_BLUR_PASSES; i++)
+    {
+      self->tex_uniforms[i] = -1;
+      self->pixel_step_uniforms[i] = -1;
+      self->weights_uniforms[i] = -1;
+    }
 }
 
 /**
@@ -327,3 +701,50 @@ clutter_blur_effect_new (void)
 {
   return g_object_new (CLUTTER_TYPE_BLUR_EFFECT, NULL);
 }
+
+/**
+ * clutter_blur_effect_set_radius:
+ * @effect: a #ClutterBlurEffect
+ * @radius: the radius of the blur, in pixels
+ *
+ * Sets the radius of the blur applied by @effect. Big radii do not
+ * cost more than small ones, since the contents of the actor are
+ * scaled down before being blurred.
+ *
+ * Since: 1.8
+ */
+void
+clutter_blur_effect_set_radius (ClutterBlurEffect *effect,
+                                gdouble            radius)
+{
+  g_return_if_fail (CLUTTER_IS_BLUR_EFFECT (effect));
+  g_return_if_fail (radius >= 0.0);
+
+  if (fabs (effect->radius - radius) >= 0.00001)
+    {
+      effect->radius = radius;
+
+      if (effect->actor != NULL)
+        clutter_actor_queue_redraw (effect->actor);
+
+      g_object_notify_by_pspec (G_OBJECT (effect), obj_props[PROP_RADIUS]);
+    }
+}
+
+/**
+ * clutter_blur_effect_get_radius:
+ * @effect: a #ClutterBlurEffect
+ *
+ * Retrieves the radius of the blur applied by @effect
+ *
+ * Return value: the radius of the blur, in pixels
+ *
+ * Since: 1.8
+ */
+gdouble
+clutter_blur_effect_get_radius (ClutterBlurEffect *effect)
+{
+  g_return_val_if_fail (CLUTTER_IS_BLUR_EFFECT (effect), 0.0);
+
+  return effect->radius;
+}
@@ -79,6 +79,7 @@
 #include "clutter-debug.h"
 #include "clutter-enum-types.h"
 #include "clutter-layout-meta.h"
+#include "clutter-layout-virtual-private.h"
 #include "clutter-private.h"
 #include "clutter-types.h"
 
@@ -100,6 +101,12 @@ struct _ClutterBoxLayoutPrivate
   gulong easing_mode;
   guint easing_duration;
 
+  /* the children bound to a model, and the estimated size of a
+   * row alongside the orientation of the layout
+   */
+  ClutterLayoutVirtual *virt;
+  gfloat virtual_extent;
+
   guint is_vertical    : 1;
   guint is_pack_start  : 1;
   guint is_animating   : 1;
@@ -470,6 +477,9 @@ clutter_box_layout_set_container (ClutterLayoutManager *layout,
                                       request_mode);
     }
 
+  if (priv->virt != NULL)
+    _clutter_layout_virtual_set_container (priv->virt, container);
+
   parent_class = CLUTTER_LAYOUT_MANAGER_CLASS (clutter_box_layout_parent_class);
   parent_class->set_container (layout, container);
 }
@@ -758,6 +768,201 @@ do_allocate:
     *position += (child_nat + priv->spacing);
 }
 
+static inline gboolean
+box_layout_is_virtual (ClutterBoxLayout *self)
+{
+  return self->priv->virt != NULL && self->priv->virt->model != NULL;
+}
+
+static void
+box_layout_virtual_window (ClutterLayoutManager  *manager,
+                           guint                  n_items,
+                           const ClutterActorBox *viewport,
+                           guint                 *first_p,
+                           guint                 *last_p)
+{
+  ClutterBoxLayoutPrivate *priv = CLUTTER_BOX_LAYOUT (manager)->priv;
+  gfloat start, end, stride;
+
+  /* we need at least one child to estimate the size of the rows */
+  if (priv->virtual_extent <= 0)
+    {
+      ClutterActor *sample;
+
+      sample = _clutter_layout_virtual_get_sample (priv->virt);
+      if (sample != NULL)
+        {
+          if (priv->is_vertical)
+            clutter_actor_get_preferred_height (sample, -1,
+                                                NULL,
+                                                &priv->virtual_extent);
+          else
+            clutter_actor_get_preferred_width (sample, -1,
+                                               NULL,
+                                               &priv->virtual_extent);
+        }
+    }
+
+  stride = MAX (priv->virtual_extent + priv->spacing, 1.0f);
+
+  if (priv->is_vertical)
+    {
+      start = viewport->y1;
+      end = viewport->y2;
+    }
+  else
+    {
+      start = viewport->x1;
+      end = viewport->x2;
+    }
+
+  *first_p = start > 0 ? (guint) floorf (start / stride) : 0;
+  *last_p = end > 0 ? (guint) ceilf (end / stride) : 0;
+}
+
+/* the size of a layout bound to a model is estimated alongside its
+ * orientation, while on the other axis it is the size of the largest
+ * child inside the window
+ */
+static void
+get_preferred_size_virtual (ClutterBoxLayout *self,
+                            gboolean          along_orientation,
+                            gboolean          is_width,
+                            gfloat           *min_size_p,
+                            gfloat           *natural_size_p)
+{
+  ClutterBoxLayoutPrivate *priv = self->priv;
+  ClutterLayoutVirtual *virt = priv->virt;
+  gfloat minimum, natural;
+  guint i;
+
+  minimum = natural = 0;
+
+  if (along_orientation)
+    {
+      if (virt->n_items > 0)
+        {
+          natural = virt->n_items * priv->virtual_extent
+                  + (virt->n_items - 1) * priv->spacing;
+          minimum = natural;
+        }
+    }
+  else
+    {
+      for (i = 0; i < virt->items->len; i++)
+        {
+          ClutterActor *child = g_ptr_array_index (virt->items, i);
+          gfloat child_min, child_nat;
+
+          if (child == NULL || !CLUTTER_ACTOR_IS_VISIBLE (child))
+            continue;
+
+          if (is_width)
+            clutter_actor_get_preferred_width (child, -1,
+                                               &child_min,
+                                               &child_nat);
+          else
+            clutter_actor_get_preferred_height (child, -1,
+                                                &child_min,
+                                                &child_nat);
+
+          minimum = MAX (minimum, child_min);
+          natural = MAX (natural, child_nat);
+        }
+    }
+
+  if (min_size_p)
+    *min_size_p = minimum;
+
+  if (natural_size_p)
+    *natural_size_p = natural;
+}
+
+/* lays out the children inside the window, starting from the estimated
+ * position of the first row, and updates the estimated size of a row
+ */
+static void
+allocate_virtual (ClutterBoxLayout       *self,
+                  ClutterContainer       *container,
+                  const ClutterActorBox  *box,
+                  ClutterAllocationFlags  flags)
+{
+  ClutterBoxLayoutPrivate *priv = self->priv;
+  ClutterLayoutVirtual *virt = priv->virt;
+  gfloat avail_width, avail_height;
+  gfloat position, total;
+  guint i, n_measured;
+
+  clutter_actor_box_get_size (box, &avail_width, &avail_height);
+
+  position = virt->first_item * (priv->virtual_extent + priv->spacing);
+  total = 0;
+  n_measured = 0;
+
+  for (i = 0; i < virt->items->len; i++)
+    {
+      ClutterActor *child = g_ptr_array_index (virt->items, i);
+      ClutterActorBox child_box;
+      ClutterBoxChild *box_child;
+      ClutterLayoutMeta *meta;
+      gfloat child_nat;
+
+      if (child == NULL || !CLUTTER_ACTOR_IS_VISIBLE (child))
+        continue;
+
+      meta = clutter_layout_manager_get_child_meta (CLUTTER_LAYOUT_MANAGER (self),
+                                                    container,
+                                                    child);
+      box_child = CLUTTER_BOX_CHILD (meta);
+
+      if (priv->is_vertical)
+        {
+          clutter_actor_get_preferred_height (child, avail_width,
+                                              NULL, &child_nat);
+
+          child_box.y1 = floorf (position + 0.5);
+          child_box.y2 = floorf (position + child_nat + 0.5);
+          child_box.x1 = 0;
+          child_box.x2 = floorf (avail_width + 0.5);
+        }
+      else
+        {
+          clutter_actor_get_preferred_width (child, avail_height,
+                                             NULL, &child_nat);
+
+          child_box.x1 = floorf (position + 0.5);
+          child_box.x2 = floorf (position + child_nat + 0.5);
+          child_box.y1 = 0;
+          child_box.y2 = floorf (avail_height + 0.5);
+        }
+
+      clutter_actor_allocate_align_fill (child, &child_box,
+                                         get_box_alignment_factor (box_child->x_align),
+                                         get_box_alignment_factor (box_child->y_align),
+                                         box_child->x_fill,
+                                         box_child->y_fill,
+                                         flags);
+
+      position += child_nat + priv->spacing;
+      total += child_nat;
+      n_measured += 1;
+    }
+
+  /* the window and the preferred size depend on the estimate, so we
+   * need to update them if it changed; we cannot do it while the
+   * container is being allocated
+   */
+  if (n_measured > 0 &&
+      fabsf (total / n_measured - priv->virtual_extent) >= 0.5f)
+    {
+      priv->virtual_extent = total / n_measured;
+
+      _clutter_layout_virtual_queue_refresh (virt);
+    }
+
+  _clutter_layout_virtual_allocated (virt, box);
+}
+
 static void
 clutter_box_layout_get_preferred_width (ClutterLayoutManager *layout,
                                         ClutterContainer     *container,
@@ -768,6 +973,14 @@ clutter_box_layout_get_preferred_width (ClutterLayoutManager *layout,
   ClutterBoxLayout *self = CLUTTER_BOX_LAYOUT (layout);
   GList *children;
 
+  if (box_layout_is_virtual (self))
+    {
+      get_preferred_size_virtual (self, !self->priv->is_vertical, TRUE,
+                                  min_width_p,
+                                  natural_width_p);
+      return;
+    }
+
   children = clutter_container_get_children (container);
 
   get_preferred_width (self, container, children, for_height,
@@ -787,6 +1000,14 @@ clutter_box_layout_get_preferred_height (ClutterLayoutManager *layout,
   ClutterBoxLayout *self = CLUTTER_BOX_LAYOUT (layout);
   GList *children;
 
+  if (box_layout_is_virtual (self))
+    {
+      get_preferred_size_virtual (self, self->priv->is_vertical, FALSE,
+                                  min_height_p,
+                                  natural_height_p);
+      return;
+    }
+
   children = clutter_container_get_children (container);
 
   get_preferred_height (self, container, children, for_width,
@@ -809,6 +1030,12 @@ clutter_box_layout_allocate (ClutterLayoutManager   *layout,
   gfloat position;
   gboolean is_rtl;
 
+  if (box_layout_is_virtual (CLUTTER_BOX_LAYOUT (layout)))
+    {
+      allocate_virtual (CLUTTER_BOX_LAYOUT (layout), container, box, flags);
+      return;
+    }
+
   children = clutter_container_get_children (container);
   if (children == NULL)
     return;
@@ -1040,6 +1267,16 @@ clutter_box_layout_get_property (GObject    *gobject,
     }
 }
 
+static void
+clutter_box_layout_finalize (GObject *gobject)
+{
+  ClutterBoxLayoutPrivate *priv = CLUTTER_BOX_LAYOUT (gobject)->priv;
+
+  _clutter_layout_virtual_free (priv->virt);
+
+  G_OBJECT_CLASS (clutter_box_layout_parent_class)->finalize (gobject);
+}
+
 static void
 clutter_box_layout_class_init (ClutterBoxLayoutClass *klass)
 {
@@ -1051,6 +1288,7 @@ clutter_box_layout_class_init (ClutterBoxLayoutClass *klass)
 
   gobject_class->set_property = clutter_box_layout_set_property;
   gobject_class->get_property = clutter_box_layout_get_property;
+  gobject_class->finalize = clutter_box_layout_finalize;
 
   layout_class->get_preferred_width =
     clutter_box_layout_get_preferred_width;
@@ -1240,6 +1478,9 @@ clutter_box_layout_set_spacing (ClutterBoxLayout *layout,
 
       priv->spacing = spacing;
 
+      if (priv->virt != NULL)
+        _clutter_layout_virtual_queue_refresh (priv->virt);
+
       manager = CLUTTER_LAYOUT_MANAGER (layout);
 
       if (priv->use_animations)
@@ -1299,6 +1540,12 @@ clutter_box_layout_set_vertical (ClutterBoxLayout *layout,
 
       priv->is_vertical = vertical ? TRUE : FALSE;
 
+      if (priv->virt != NULL)
+        {
+          priv->virtual_extent = 0;
+          _clutter_layout_virtual_queue_refresh (priv->virt);
+        }
+
       manager = CLUTTER_LAYOUT_MANAGER (layout);
 
       if (priv->use_animations)
@@ -1985,3 +2232,150 @@ clutter_box_layout_get_easing_duration (ClutterBoxLayout *layout)
 
   return layout->priv->easing_duration;
 }
+
+static void
+box_layout_ensure_virtual (ClutterBoxLayout *layout)
+{
+  ClutterBoxLayoutPrivate *priv = layout->priv;
+
+  if (priv->virt != NULL)
+    return;
+
+  priv->virt = _clutter_layout_virtual_new (CLUTTER_LAYOUT_MANAGER (layout),
+                                            box_layout_virtual_window);
+  _clutter_layout_virtual_set_container (priv->virt, priv->container);
+}
+
+/**
+ * clutter_box_layout_set_model:
+ * @layout: a #ClutterBoxLayout
+ * @model: (allow-none): a #ClutterModel, or %NULL
+ * @func: (allow-none): the function creating the children for the rows
+ *   of @model
+ * @data: data to pass to @func
+ * @notify: function to call when @func is not needed any more
+ *
+ * Binds @layout to @model.
+ *
+ * A #ClutterBoxLayout bound to a #ClutterModel only keeps and lays out
+ * the children for the rows of @model intersecting the viewport set
+ * using clutter_box_layout_set_viewport(), plus a margin; the children
+ * are created using @func, and the size of the other rows is estimated
+ * from the size of the children. The children of the rows leaving the
+ * viewport are hidden and passed again to @func when another row
+ * enters the viewport.
+ *
+ * While @layout is bound to a model the children added to the container
+ * by other means are not laid out, and the #ClutterBoxLayout:homogeneous
+ * and #ClutterBoxLayout:pack-start properties, as well as the expand
+ * child property, are ignored.
+ *
+ * Passing %NULL for @model destroys the children created by @func
+ * and lays out the children of the container again.
+ *
+ * Since: 1.8
+ */
+void
+clutter_box_layout_set_model (ClutterBoxLayout       *layout,
+                              ClutterModel           *model,
+                              ClutterLayoutModelFunc  func,
+                              gpointer                data,
+                              GDestroyNotify          notify)
+{
+  ClutterBoxLayoutPrivate *priv;
+
+  g_return_if_fail (CLUTTER_IS_BOX_LAYOUT (layout));
+  g_return_if_fail (model == NULL || CLUTTER_IS_MODEL (model));
+  g_return_if_fail (model == NULL || func != NULL);
+
+  priv = layout->priv;
+
+  box_layout_ensure_virtual (layout);
+
+  priv->virtual_extent = 0;
+  _clutter_layout_virtual_set_model (priv->virt, model, func, data, notify);
+
+  clutter_layout_manager_layout_changed (CLUTTER_LAYOUT_MANAGER (layout));
+}
+
+/**
+ * clutter_box_layout_get_model:
+ * @layout: a #ClutterBoxLayout
+ *
+ * Retrieves the model set using clutter_box_layout_set_model()
+ *
+ * Return value: (transfer none): the #ClutterModel bound to @layout,
+ *   or %NULL
+ *
+ * Since: 1.8
+ */
+ClutterModel *
+clutter_box_layout_get_model (ClutterBoxLayout *layout)
+{
+  g_return_val_if_fail (CLUTTER_IS_BOX_LAYOUT (layout), NULL);
+
+  if (layout->priv->virt == NULL)
+    return NULL;
+
+  return layout->priv->virt->model;
+}
+
+/**
+ * clutter_box_layout_set_viewport:
+ * @layout: a #ClutterBoxLayout
+ * @x: the X coordinate of the viewport
+ * @y: the Y coordinate of the viewport
+ * @width: the width of the viewport, or -1
+ * @height: the height of the viewport, or -1
+ *
+ * Sets the area of the container using @layout that is visible, in
+ * the coordinate space of the container; this is usually updated when
+ * scrolling the container.
+ *
+ * If @width or @height are negative, the allocation of the container
+ * is used instead.
+ *
+ * The viewport is only used if @layout is bound to a #ClutterModel;
+ * see clutter_box_layout_set_model()
+ *
+ * Since: 1.8
+ */
+void
+clutter_box_layout_set_viewport (ClutterBoxLayout *layout,
+                                 gfloat            x,
+                                 gfloat            y,
+                                 gfloat            width,
+                                 gfloat            height)
+{
+  g_return_if_fail (CLUTTER_IS_BOX_LAYOUT (layout));
+
+  box_layout_ensure_virtual (layout);
+
+  _clutter_layout_virtual_set_viewport (layout->priv->virt,
+                                        x, y,
+                                        width, height);
+}
+
+/**
+ * clutter_box_layout_set_viewport_margin:
+ * @layout: a #ClutterBoxLayout
+ * @margin: the margin around the viewport, in pixels, or -1
+ *
+ * Sets the size of the area around the viewport for which @layout
+ * keeps the children of a model, to avoid creating them while
+ * scrolling. A negative value uses the size of the viewport.
+ *
+ * See also clutter_box_layout_set_model()
+ *
+ * Since: 1.8
+ */
+void
+clutter_box_layout_set_viewport_margin (ClutterBoxLayout *layout,
+                                        gfloat            margin)
+{
+  g_return_if_fail (CLUTTER_IS_BOX_LAYOUT (layout));
+
+  box_layout_ensure_virtual (layout);
+
+  _clutter_layout_virtual_set_margin (layout->priv->virt, margin);
+}
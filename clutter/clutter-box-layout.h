@@ -151,6 +151,20 @@ void                  clutter_box_layout_set_easing_duration (ClutterBoxLayout
                                                               guint                msecs);
 guint                 clutter_box_layout_get_easing_duration (ClutterBoxLayout    *layout);
 
+void                  clutter_box_layout_set_model           (ClutterBoxLayout       *layout,
+                                                              ClutterModel           *model,
+                                                              ClutterLayoutModelFunc  func,
+                                                              gpointer                data,
+                                                              GDestroyNotify          notify);
+ClutterModel *        clutter_box_layout_get_model           (ClutterBoxLayout       *layout);
+void                  clutter_box_layout_set_viewport        (ClutterBoxLayout       *layout,
+                                                              gfloat                  x,
+                                                              gfloat                  y,
+                                                              gfloat                  width,
+                                                              gfloat                  height);
+void                  clutter_box_layout_set_viewport_margin (ClutterBoxLayout       *layout,
+                                                              gfloat                  margin);
+
 G_END_DECLS
 
 #endif /* __CLUTTER_BOX_LAYOUT_H__ */
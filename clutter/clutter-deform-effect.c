@@ -47,6 +47,18 @@
  *   Each passed vertex is an in-out parameter that initially contains the
  *   position of the vertex and should be modified according to a specific
  *   deformation algorithm.</para>
+ *   <para>The vertices are passed to the <function>deform_vertices()</function>
+ *   virtual function, whose default implementation calls
+ *   <function>deform_vertex()</function> on each of them, in the thread
+ *   painting the actor. Sub-classes can override
+ *   <function>deform_vertices()</function> instead, to deform the whole
+ *   array at once.</para>
+ *   <para>Sub-classes whose <function>deform_vertex()</function> does not
+ *   call into Clutter and only reads the state of the effect can set the
+ *   #ClutterDeformEffect:threaded property; the rows of big meshes are
+ *   then split between a pool of worker threads.</para>
+ *   <para>Only the rows of the mesh that changed since the previous
+ *   deformation are uploaded to the GPU.</para>
  * </refsect2>
  *
  * #ClutterDeformEffect is available since Clutter 1.4
@@ -58,6 +70,8 @@
 
 #include "clutter-deform-effect.h"
 
+#include <string.h>
+
 #include <cogl/cogl.h>
 
 #include "clutter-debug.h"
@@ -67,6 +81,11 @@
 
 #define DEFAULT_N_TILES         32
 
+/* below this number of vertices, splitting the deformation between
+ * threads costs more than it saves
+ */
+#define THREADED_MIN_VERTICES   4096
+
 struct _ClutterDeformEffectPrivate
 {
   CoglHandle back_material;
@@ -74,19 +93,52 @@ struct _ClutterDeformEffectPrivate
   gint x_tiles;
   gint y_tiles;
 
-  CoglHandle vbo;
+  CoglVertexArray *array;
+  CoglAttribute *attributes[4];
 
-  CoglHandle indices;
-  CoglHandle back_indices;
+  CoglIndices *indices;
+  CoglIndices *back_indices;
   gint n_indices;
 
+  /* the vertices being deformed, and a copy of the vertices in the
+   * vertex array; comparing the two gives the rows to upload
+   */
   CoglTextureVertex *vertices;
+  CoglTextureVertex *uploaded;
 
   gulong allocation_id;
 
   guint is_dirty : 1;
+  guint upload_all : 1;
+  guint threaded : 1;
+};
+
+typedef struct _DeformJob       DeformJob;
+typedef struct _DeformTask      DeformTask;
+
+/* a call to deform_vertices() split between the worker threads */
+struct _DeformJob
+{
+  ClutterDeformEffect *effect;
+
+  gfloat width;
+  gfloat height;
+
+  GMutex *mutex;
+  GCond *cond;
+  gint n_pending;
 };
 
+struct _DeformTask
+{
+  DeformJob *job;
+
+  CoglTextureVertex *vertices;
+  guint n_vertices;
+};
+
+static GThreadPool *deform_thread_pool = NULL;
+
 enum
 {
   PROP_0,
@@ -96,6 +148,8 @@ enum
 
   PROP_BACK_MATERIAL,
 
+  PROP_THREADED,
+
   PROP_LAST
 };
 
@@ -129,6 +183,177 @@ _clutter_deform_effect_deform_vertex (ClutterDeformEffect *effect,
                                                            vertex);
 }
 
+static void
+deform_vertices_range (ClutterDeformEffect *effect,
+                       gfloat               width,
+                       gfloat               height,
+                       CoglTextureVertex   *vertices,
+                       guint                n_vertices)
+{
+  ClutterDeformEffectClass *klass = CLUTTER_DEFORM_EFFECT_GET_CLASS (effect);
+  guint i;
+
+  for (i = 0; i < n_vertices; i++)
+    klass->deform_vertex (effect, width, height, &vertices[i]);
+}
+
+static void
+deform_task_run (gpointer data,
+                 gpointer user_data)
+{
+  DeformTask *task = data;
+  DeformJob *job = task->job;
+
+  deform_vertices_range (job->effect,
+                         job->width, job->height,
+                         task->vertices,
+                         task->n_vertices);
+
+  g_mutex_lock (job->mutex);
+
+  job->n_pending -= 1;
+  if (job->n_pending == 0)
+    g_cond_signal (job->cond);
+
+  g_mutex_unlock (job->mutex);
+
+  g_slice_free (DeformTask, task);
+}
+
+static void
+clutter_deform_effect_real_deform_vertices (ClutterDeformEffect *effect,
+                                            gfloat               width,
+                                            gfloat               height,
+                                            CoglTextureVertex   *vertices,
+                                            guint                n_vertices)
+{
+  ClutterDeformEffectPrivate *priv = effect->priv;
+  DeformJob job;
+  guint n_workers, row_length, chunk_size;
+
+  n_workers = _clutter_get_n_workers ();
+
+  /* deform_vertex() can only be called from other threads if the
+   * sub-class said it is safe to do so
+   */
+  if (!priv->threaded ||
+      n_vertices < THREADED_MIN_VERTICES ||
+      n_workers < 2 ||
+      !g_thread_supported ())
+    {
+      deform_vertices_range (effect, width, height, vertices, n_vertices);
+      return;
+    }
+
+  if (deform_thread_pool == NULL)
+    deform_thread_pool = g_thread_pool_new (deform_task_run,
+                                            NULL,
+                                            n_workers - 1,
+                                            FALSE,
+                                            NULL);
+
+  /* we split the mesh at row boundaries, one chunk per worker plus
+   * one for the calling thread
+   */
+  row_length = priv->x_tiles + 1;
+  chunk_size = (n_vertices + n_workers - 1) / n_workers;
+  chunk_size = ((chunk_size + row_length - 1) / row_length) * row_length;
+
+  job.effect = effect;
+  job.width = width;
+  job.height = height;
+  job.mutex = g_mutex_new ();
+  job.cond = g_cond_new ();
+  job.n_pending = 0;
+
+  g_mutex_lock (job.mutex);
+
+  while (n_vertices > chunk_size)
+    {
+      DeformTask *task = g_slice_new (DeformTask);
+
+      task->job = &job;
+      task->vertices = vertices;
+      task->n_vertices = chunk_size;
+
+      job.n_pending += 1;
+      g_thread_pool_push (deform_thread_pool, task, NULL);
+
+      vertices += chunk_size;
+      n_vertices -= chunk_size;
+    }
+
+  g_mutex_unlock (job.mutex);
+
+  /* the last chunk is deformed while the workers run */
+  deform_vertices_range (effect, width, height, vertices, n_vertices);
+
+  g_mutex_lock (job.mutex);
+
+  while (job.n_pending > 0)
+    g_cond_wait (job.cond, job.mutex);
+
+  g_mutex_unlock (job.mutex);
+
+  g_cond_free (job.cond);
+  g_mutex_free (job.mutex);
+}
+
+/* copies the rows of the mesh that changed since the last upload
+ * into the vertex array
+ */
+static void
+clutter_deform_effect_upload_vertices (ClutterDeformEffect *self)
+{
+  ClutterDeformEffectPrivate *priv = self->priv;
+  gsize row_size = sizeof (CoglTextureVertex) * (priv->x_tiles + 1);
+  CoglTextureVertex *tmp;
+  gint first_row, last_row, i;
+
+  if (priv->upload_all)
+    {
+      first_row = 0;
+      last_row = priv->y_tiles;
+
+      priv->upload_all = FALSE;
+    }
+  else
+    {
+      first_row = G_MAXINT;
+      last_row = -1;
+
+      for (i = 0; i < priv->y_tiles + 1; i++)
+        {
+          gsize offset = i * (priv->x_tiles + 1);
+
+          if (memcmp (priv->vertices + offset,
+                      priv->uploaded + offset,
+                      row_size) != 0)
+            {
+              first_row = MIN (first_row, i);
+              last_row = i;
+            }
+        }
+    }
+
+  if (first_row <= last_row)
+    {
+      CLUTTER_NOTE (MISC, "Uploading rows %d to %d of the deformed mesh",
+                    first_row,
+                    last_row);
+
+      cogl_buffer_set_data (COGL_BUFFER (priv->array),
+                            first_row * row_size,
+                            (guint8 *) priv->vertices + first_row * row_size,
+                            (last_row - first_row + 1) * row_size);
+    }
+
+  /* the deformed vertices are now the ones in the vertex array */
+  tmp = priv->uploaded;
+  priv->uploaded = priv->vertices;
+  priv->vertices = tmp;
+}
+
 static void
 vbo_invalidate (ClutterActor           *actor,
                 const ClutterActorBox  *allocation,
@@ -174,6 +399,8 @@ clutter_deform_effect_paint_target (ClutterOffscreenEffect *effect)
   CoglHandle material;
   gint n_tiles;
 
+  n_tiles = (priv->x_tiles + 1) * (priv->y_tiles + 1);
+
   if (priv->is_dirty)
     {
       ClutterActor *actor;
@@ -206,34 +433,15 @@ clutter_deform_effect_paint_target (ClutterOffscreenEffect *effect)
               vertex->z = 0.0f;
 
               cogl_color_init_from_4ub (&vertex->color, 255, 255, 255, opacity);
-
-              _clutter_deform_effect_deform_vertex (self, width, height, vertex);
             }
         }
 
-      /* XXX in theory, the sub-classes should tell us what they changed
-       * in the texture vertices; we then would be able to avoid resubmitting
-       * the same data, if it did not change. for the time being, we resubmit
-       * everything
-       */
-      cogl_vertex_buffer_add (priv->vbo, "gl_Vertex",
-                              3,
-                              COGL_ATTRIBUTE_TYPE_FLOAT,
-                              FALSE,
-                              sizeof (CoglTextureVertex),
-                              &priv->vertices->x);
-      cogl_vertex_buffer_add (priv->vbo, "gl_MultiTexCoord0",
-                              2,
-                              COGL_ATTRIBUTE_TYPE_FLOAT,
-                              FALSE,
-                              sizeof (CoglTextureVertex),
-                              &priv->vertices->tx);
-      cogl_vertex_buffer_add (priv->vbo, "gl_Color",
-                              4,
-                              COGL_ATTRIBUTE_TYPE_UNSIGNED_BYTE,
-                              FALSE,
-                              sizeof (CoglTextureVertex),
-                              &priv->vertices->color);
+      CLUTTER_DEFORM_EFFECT_GET_CLASS (self)->deform_vertices (self,
+                                                               width, height,
+                                                               priv->vertices,
+                                                               n_tiles);
+
+      clutter_deform_effect_upload_vertices (self);
 
       priv->is_dirty = FALSE;
     }
@@ -252,20 +460,16 @@ clutter_deform_effect_paint_target (ClutterOffscreenEffect *effect)
   else if (priv->back_material == COGL_INVALID_HANDLE && is_cull_enabled)
     cogl_set_backface_culling_enabled (FALSE);
 
-  n_tiles = (priv->x_tiles + 1) * (priv->y_tiles + 1);
-
   /* draw the front */
   material = clutter_offscreen_effect_get_target (effect);
   if (material != COGL_INVALID_HANDLE)
     {
       cogl_set_source (material);
-      cogl_vertex_buffer_draw_elements (priv->vbo,
-                                        COGL_VERTICES_MODE_TRIANGLE_STRIP,
-                                        priv->indices,
-                                        0,
-                                        n_tiles,
-                                        0,
-                                        priv->n_indices);
+      cogl_draw_indexed_attributes_array (COGL_VERTICES_MODE_TRIANGLE_STRIP,
+                                          0,
+                                          priv->n_indices,
+                                          priv->indices,
+                                          priv->attributes);
     }
 
   /* draw the back */
@@ -273,13 +477,11 @@ clutter_deform_effect_paint_target (ClutterOffscreenEffect *effect)
   if (material != COGL_INVALID_HANDLE)
     {
       cogl_set_source (priv->back_material);
-      cogl_vertex_buffer_draw_elements (priv->vbo,
-                                        COGL_VERTICES_MODE_TRIANGLE_STRIP,
-                                        priv->back_indices,
-                                        0,
-                                        n_tiles,
-                                        0,
-                                        priv->n_indices);
+      cogl_draw_indexed_attributes_array (COGL_VERTICES_MODE_TRIANGLE_STRIP,
+                                          0,
+                                          priv->n_indices,
+                                          priv->back_indices,
+                                          priv->attributes);
     }
 
   /* restore the previous state */
@@ -297,39 +499,58 @@ clutter_deform_effect_free_arrays (ClutterDeformEffect *self)
 {
   ClutterDeformEffectPrivate *priv = self->priv;
 
-  if (priv->vbo != COGL_INVALID_HANDLE)
+  if (priv->array != NULL)
     {
-      cogl_handle_unref (priv->vbo);
-      priv->vbo = COGL_INVALID_HANDLE;
+      gint i;
+
+      for (i = 0; priv->attributes[i] != NULL; i++)
+        {
+          cogl_object_unref (priv->attributes[i]);
+          priv->attributes[i] = NULL;
+        }
+
+      cogl_object_unref (priv->array);
+      priv->array = NULL;
+    }
+
+  if (priv->indices != NULL)
+    {
+      cogl_object_unref (priv->indices);
+      priv->indices = NULL;
     }
 
-  if (priv->indices != COGL_INVALID_HANDLE)
+  if (priv->back_indices != NULL)
     {
-      cogl_handle_unref (priv->indices);
-      priv->indices = COGL_INVALID_HANDLE;
+      cogl_object_unref (priv->back_indices);
+      priv->back_indices = NULL;
     }
 
   g_free (priv->vertices);
   priv->vertices = NULL;
+
+  g_free (priv->uploaded);
+  priv->uploaded = NULL;
 }
 
 static void
 clutter_deform_effect_init_arrays (ClutterDeformEffect *self)
 {
   ClutterDeformEffectPrivate *priv = self->priv;
-  GLushort *static_indices, *static_back_indices;
-  GLushort *idx, *back_idx;
+  guint32 *static_indices, *static_back_indices;
+  guint32 *idx, *back_idx;
   gint x, y, direction;
   gint n_tiles;
 
   clutter_deform_effect_free_arrays (self);
 
+  n_tiles = (priv->x_tiles + 1) * (priv->y_tiles + 1);
+
   priv->n_indices = (2 + 2 * priv->x_tiles)
                   * priv->y_tiles
                   + (priv->y_tiles - 1);
 
-  static_indices = g_new (GLushort, priv->n_indices);
-  static_back_indices = g_new (GLushort, priv->n_indices);
+  static_indices = g_new (guint32, priv->n_indices);
+  static_back_indices = g_new (guint32, priv->n_indices);
 
 #define MESH_INDEX(x,y) ((y) * (priv->x_tiles + 1) + (x))
 
@@ -403,23 +624,80 @@ clutter_deform_effect_init_arrays (ClutterDeformEffect *self)
 
 #undef MESH_INDEX
 
-  priv->indices =
-    cogl_vertex_buffer_indices_new (COGL_INDICES_TYPE_UNSIGNED_SHORT,
-                                    static_indices,
-                                    priv->n_indices);
-  priv->back_indices =
-    cogl_vertex_buffer_indices_new (COGL_INDICES_TYPE_UNSIGNED_SHORT,
-                                    static_back_indices,
-                                    priv->n_indices);
+  /* 16-bit indices are enough unless the mesh is really big, in which
+   * case clutter_deform_effect_set_n_tiles() already checked that the
+   * GPU supports 32-bit indices
+   */
+  if (n_tiles > G_MAXUSHORT)
+    {
+      priv->indices = cogl_indices_new (COGL_INDICES_TYPE_UNSIGNED_INT,
+                                        static_indices,
+                                        priv->n_indices);
+      priv->back_indices = cogl_indices_new (COGL_INDICES_TYPE_UNSIGNED_INT,
+                                             static_back_indices,
+                                             priv->n_indices);
+    }
+  else
+    {
+      GLushort *short_indices, *short_back_indices;
+      gint i;
+
+      short_indices = g_new (GLushort, priv->n_indices);
+      short_back_indices = g_new (GLushort, priv->n_indices);
+
+      for (i = 0; i < priv->n_indices; i++)
+        {
+          short_indices[i] = static_indices[i];
+          short_back_indices[i] = static_back_indices[i];
+        }
+
+      priv->indices = cogl_indices_new (COGL_INDICES_TYPE_UNSIGNED_SHORT,
+                                        short_indices,
+                                        priv->n_indices);
+      priv->back_indices = cogl_indices_new (COGL_INDICES_TYPE_UNSIGNED_SHORT,
+                                             short_back_indices,
+                                             priv->n_indices);
+
+      g_free (short_indices);
+      g_free (short_back_indices);
+    }
 
   g_free (static_indices);
   g_free (static_back_indices);
 
-  n_tiles = (priv->x_tiles + 1) * (priv->y_tiles + 1);
-  priv->vertices = g_new (CoglTextureVertex, n_tiles);
-  priv->vbo = cogl_vertex_buffer_new (n_tiles);
+  /* the vertices are compared row by row, so the padding of the
+   * colors must be initialized
+   */
+  priv->vertices = g_new0 (CoglTextureVertex, n_tiles);
+  priv->uploaded = g_new0 (CoglTextureVertex, n_tiles);
+
+  priv->array = cogl_vertex_array_new (n_tiles * sizeof (CoglTextureVertex),
+                                       NULL);
+  cogl_buffer_set_update_hint (COGL_BUFFER (priv->array),
+                               COGL_BUFFER_UPDATE_HINT_DYNAMIC);
+
+  priv->attributes[0] =
+    cogl_attribute_new (priv->array, "cogl_position_in",
+                        sizeof (CoglTextureVertex),
+                        G_STRUCT_OFFSET (CoglTextureVertex, x),
+                        3,
+                        COGL_ATTRIBUTE_TYPE_FLOAT);
+  priv->attributes[1] =
+    cogl_attribute_new (priv->array, "cogl_tex_coord0_in",
+                        sizeof (CoglTextureVertex),
+                        G_STRUCT_OFFSET (CoglTextureVertex, tx),
+                        2,
+                        COGL_ATTRIBUTE_TYPE_FLOAT);
+  priv->attributes[2] =
+    cogl_attribute_new (priv->array, "cogl_color_in",
+                        sizeof (CoglTextureVertex),
+                        G_STRUCT_OFFSET (CoglTextureVertex, color),
+                        4,
+                        COGL_ATTRIBUTE_TYPE_UNSIGNED_BYTE);
+  priv->attributes[3] = NULL;
 
   priv->is_dirty = TRUE;
+  priv->upload_all = TRUE;
 }
 
 static inline void
@@ -469,6 +747,10 @@ clutter_deform_effect_set_property (GObject      *gobject,
       clutter_deform_effect_set_back_material (self, g_value_get_boxed (value));
       break;
 
+    case PROP_THREADED:
+      clutter_deform_effect_set_threaded (self, g_value_get_boolean (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
       break;
@@ -497,6 +779,10 @@ clutter_deform_effect_get_property (GObject    *gobject,
       g_value_set_boxed (value, priv->back_material);
       break;
 
+    case PROP_THREADED:
+      g_value_set_boolean (value, priv->threaded);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
       break;
@@ -513,6 +799,7 @@ clutter_deform_effect_class_init (ClutterDeformEffectClass *klass)
   g_type_class_add_private (klass, sizeof (ClutterDeformEffectPrivate));
 
   klass->deform_vertex = clutter_deform_effect_real_deform_vertex;
+  klass->deform_vertices = clutter_deform_effect_real_deform_vertices;
 
   /**
    * ClutterDeformEffect:x-tiles:
@@ -563,6 +850,26 @@ clutter_deform_effect_class_init (ClutterDeformEffectClass *klass)
                         COGL_TYPE_HANDLE,
                         CLUTTER_PARAM_READWRITE);
 
+  /**
+   * ClutterDeformEffect:threaded:
+   *
+   * Whether the default implementation of the deform_vertices()
+   * virtual function can split the vertices of big meshes between
+   * worker threads
+   *
+   * This should only be set if the deform_vertex() virtual function
+   * does not call any Clutter API and only reads the state of the
+   * effect
+   *
+   * Since: 1.8
+   */
+  obj_props[PROP_THREADED] =
+    g_param_spec_boolean ("threaded",
+                          P_("Threaded"),
+                          P_("Whether the vertices can be deformed from worker threads"),
+                          FALSE,
+                          CLUTTER_PARAM_READWRITE);
+
   gobject_class->finalize = clutter_deform_effect_finalize;
   gobject_class->set_property = clutter_deform_effect_set_property;
   gobject_class->get_property = clutter_deform_effect_get_property;
@@ -652,6 +959,12 @@ clutter_deform_effect_get_back_material (ClutterDeformEffect *effect)
  * More tiles allow a finer grained deformation at the expenses
  * of computation
  *
+ * Meshes with more than 65535 vertices, that is when
+ * (@x_tiles + 1) * (@y_tiles + 1) is bigger than 65535, need
+ * support for %COGL_FEATURE_UNSIGNED_INT_INDICES; if the GPU
+ * does not support 32-bit indices the number of tiles is not
+ * changed
+ *
  * Since: 1.4
  */
 void
@@ -661,10 +974,23 @@ clutter_deform_effect_set_n_tiles (ClutterDeformEffect *effect,
 {
   ClutterDeformEffectPrivate *priv;
   gboolean tiles_changed = FALSE;
+  guint64 n_vertices;
 
   g_return_if_fail (CLUTTER_IS_DEFORM_EFFECT (effect));
   g_return_if_fail (x_tiles > 0 && y_tiles > 0);
 
+  n_vertices = ((guint64) x_tiles + 1) * ((guint64) y_tiles + 1);
+  if (n_vertices > G_MAXUSHORT &&
+      !cogl_features_available (COGL_FEATURE_UNSIGNED_INT_INDICES))
+    {
+      g_warning ("%s: A mesh of %ux%u tiles has more vertices than "
+                 "can be addressed with 16-bit indices, and 32-bit "
+                 "indices are not supported",
+                 G_STRLOC,
+                 x_tiles, y_tiles);
+      return;
+    }
+
   priv = effect->priv;
 
   g_object_freeze_notify (G_OBJECT (effect));
@@ -748,3 +1074,56 @@ clutter_deform_effect_invalidate (ClutterDeformEffect *effect)
   if (actor != NULL)
     clutter_actor_queue_redraw (actor);
 }
+
+/**
+ * clutter_deform_effect_set_threaded:
+ * @effect: a #ClutterDeformEffect
+ * @threaded: whether the vertices can be deformed from worker threads
+ *
+ * Sets whether the default implementation of the deform_vertices()
+ * virtual function can call deform_vertex() from worker threads
+ *
+ * Sub-classes should only set this if their deform_vertex()
+ * implementation does not call any Clutter API and only reads the
+ * state of the effect
+ *
+ * Since: 1.8
+ */
+void
+clutter_deform_effect_set_threaded (ClutterDeformEffect *effect,
+                                    gboolean             threaded)
+{
+  ClutterDeformEffectPrivate *priv;
+
+  g_return_if_fail (CLUTTER_IS_DEFORM_EFFECT (effect));
+
+  priv = effect->priv;
+
+  threaded = !!threaded;
+
+  if (priv->threaded != threaded)
+    {
+      priv->threaded = threaded;
+
+      g_object_notify_by_pspec (G_OBJECT (effect), obj_props[PROP_THREADED]);
+    }
+}
+
+/**
+ * clutter_deform_effect_get_threaded:
+ * @effect: a #ClutterDeformEffect
+ *
+ * Retrieves whether the vertices of @effect can be deformed from
+ * worker threads
+ *
+ * Return value: %TRUE if the vertices can be deformed from worker threads
+ *
+ * Since: 1.8
+ */
+gboolean
+clutter_deform_effect_get_threaded (ClutterDeformEffect *effect)
+{
+  g_return_val_if_fail (CLUTTER_IS_DEFORM_EFFECT (effect), FALSE);
+
+  return effect->priv->threaded;
+}
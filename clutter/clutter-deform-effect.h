@@ -65,6 +65,10 @@ struct _ClutterDeformEffect
  * ClutterDeformEffectClass:
  * @deform_vertex: virtual function; sub-classes should override this
  *   function to compute the deformation of each vertex
+ * @deform_vertices: virtual function; computes the deformation of an
+ *   array of vertices. The default implementation calls @deform_vertex
+ *   on each vertex, from worker threads if #ClutterDeformEffect:threaded
+ *   is set. Since: 1.8
  *
  * The <structname>ClutterDeformEffectClass</structname> structure contains
  * only private data
@@ -82,8 +86,13 @@ struct _ClutterDeformEffectClass
                           gfloat               height,
                           CoglTextureVertex   *vertex);
 
+  void (* deform_vertices) (ClutterDeformEffect *effect,
+                            gfloat               width,
+                            gfloat               height,
+                            CoglTextureVertex   *vertices,
+                            guint                n_vertices);
+
   /*< private >*/
-  void (*_clutter_deform1) (void);
   void (*_clutter_deform2) (void);
   void (*_clutter_deform3) (void);
   void (*_clutter_deform4) (void);
@@ -106,6 +115,10 @@ void       clutter_deform_effect_get_n_tiles       (ClutterDeformEffect *effect,
 
 void       clutter_deform_effect_invalidate        (ClutterDeformEffect *effect);
 
+void       clutter_deform_effect_set_threaded      (ClutterDeformEffect *effect,
+                                                    gboolean             threaded);
+gboolean   clutter_deform_effect_get_threaded      (ClutterDeformEffect *effect);
+
 G_END_DECLS
 
 #endif /* __CLUTTER_DEFORM_EFFECT_H__ */
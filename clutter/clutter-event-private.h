@@ -8,6 +8,9 @@ G_BEGIN_DECLS
 /* Reinjecting queued events for processing */
 void            _clutter_process_event                  (ClutterEvent       *event);
 
+/* Forwarding an event to its stage, transferring ownership */
+void            _clutter_do_event_take                  (ClutterEvent       *event);
+
 /* clears the event queue inside the main context */
 void            _clutter_clear_events_queue             (void);
 void            _clutter_clear_events_queue_for_stage   (ClutterStage       *stage);
@@ -15,10 +18,15 @@ void            _clutter_clear_events_queue_for_stage   (ClutterStage       *sta
 void            _clutter_event_set_platform_data        (ClutterEvent       *event,
                                                          gpointer            data);
 gpointer        _clutter_event_get_platform_data        (const ClutterEvent *event);
+gpointer        _clutter_event_alloc_platform_data      (ClutterEvent       *event,
+                                                         gsize               size);
 
 void            _clutter_event_push                     (const ClutterEvent *event,
                                                          gboolean            do_copy);
 
+void            _clutter_event_push_motion_history      (ClutterEvent       *event,
+                                                         ClutterEvent       *previous);
+
 G_END_DECLS
 
 #endif /* __CLUTTER_EVENT_PRIVATE_H__ */
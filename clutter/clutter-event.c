@@ -27,6 +27,8 @@
 #include "config.h"
 #endif
 
+#include <string.h>
+
 #include "clutter-backend-private.h"
 #include "clutter-debug.h"
 #include "clutter-event-private.h"
@@ -43,6 +45,25 @@
  * be synthesized by Clutter itself or by the application code.
  */
 
+/* the size of the platform data that can be stored inside the event
+ * itself; see _clutter_event_alloc_platform_data()
+ */
+#define PLATFORM_STORAGE_SIZE   2
+
+typedef union _ClutterEventStorage {
+  gpointer p;
+  gint64 i;
+  gdouble d;
+} ClutterEventStorage;
+
+/* a motion event coalesced into a following one */
+typedef struct _ClutterMotionHistory {
+  gfloat x;
+  gfloat y;
+  guint32 time;
+  gdouble *axes;
+} ClutterMotionHistory;
+
 typedef struct _ClutterEventPrivate {
   ClutterEvent base;
 
@@ -50,10 +71,37 @@ typedef struct _ClutterEventPrivate {
   ClutterInputDevice *source_device;
 
   gpointer platform_data;
+
+  /* the size of the platform data, if it has been allocated using
+   * _clutter_event_alloc_platform_data() and it did not fit inside
+   * the platform_storage
+   */
+  gsize platform_data_size;
+
+  ClutterEventStorage platform_storage[PLATFORM_STORAGE_SIZE];
+
+  /* the motion events coalesced into this one, oldest first */
+  GArray *motion_history;
+
+  /* the next event in the pool */
+  struct _ClutterEventPrivate *next_free;
 } ClutterEventPrivate;
 
+/* all the events allocated using clutter_event_new(); the events inside
+ * the pool keep their key, with a NULL value, to avoid resizing the
+ * table for each event
+ */
 static GHashTable *all_events = NULL;
 
+/* the events are only created and freed from the main thread, so we
+ * can keep the freed events in a pool and re-use them, instead of
+ * going through the slice allocator
+ */
+#define EVENT_POOL_MAX_SIZE     256
+
+static ClutterEventPrivate *event_pool = NULL;
+static guint event_pool_size = 0;
+
 G_DEFINE_BOXED_TYPE (ClutterEvent, clutter_event,
                      clutter_event_copy,
                      clutter_event_free);
@@ -105,6 +153,55 @@ _clutter_event_set_platform_data (ClutterEvent *event,
   ((ClutterEventPrivate *) event)->platform_data = data;
 }
 
+/*< private >
+ * _clutter_event_alloc_platform_data:
+ * @event: a #ClutterEvent
+ * @size: the size of the platform data
+ *
+ * Allocates @size bytes of zeroed platform-specific data for @event.
+ *
+ * The data is owned by @event: it is copied by clutter_event_copy()
+ * and released by clutter_event_free(), so the backends do not need
+ * to implement the #ClutterBackendClass.copy_event_data and
+ * #ClutterBackendClass.free_event_data virtual functions for it. Small
+ * platform data is stored inside the event, and does not require any
+ * allocation.
+ *
+ * Return value: a pointer to the platform data, or %NULL if @event
+ *   was not allocated using clutter_event_new()
+ */
+gpointer
+_clutter_event_alloc_platform_data (ClutterEvent *event,
+                                    gsize         size)
+{
+  ClutterEventPrivate *real_event;
+
+  if (!is_event_allocated (event))
+    return NULL;
+
+  real_event = (ClutterEventPrivate *) event;
+
+  if (real_event->platform_data_size > 0)
+    g_slice_free1 (real_event->platform_data_size,
+                   real_event->platform_data);
+
+  if (size <= sizeof (real_event->platform_storage))
+    {
+      memset (real_event->platform_storage, 0,
+              sizeof (real_event->platform_storage));
+
+      real_event->platform_data = real_event->platform_storage;
+      real_event->platform_data_size = 0;
+    }
+  else
+    {
+      real_event->platform_data = g_slice_alloc0 (size);
+      real_event->platform_data_size = size;
+    }
+
+  return real_event->platform_data;
+}
+
 /**
  * clutter_event_type:
  * @event: a #ClutterEvent
@@ -928,7 +1025,17 @@ clutter_event_new (ClutterEventType type)
   ClutterEvent *new_event;
   ClutterEventPrivate *priv;
 
-  priv = g_slice_new0 (ClutterEventPrivate);
+  if (event_pool != NULL)
+    {
+      priv = event_pool;
+
+      event_pool = priv->next_free;
+      event_pool_size -= 1;
+
+      memset (priv, 0, sizeof (ClutterEventPrivate));
+    }
+  else
+    priv = g_slice_new0 (ClutterEventPrivate);
 
   new_event = (ClutterEvent *) priv;
   new_event->type = new_event->any.type = type;
@@ -970,12 +1077,59 @@ clutter_event_copy (const ClutterEvent *event)
 
       new_real_event->device = real_event->device;
       new_real_event->source_device = real_event->source_device;
+
+      /* the platform data allocated by _clutter_event_alloc_platform_data()
+       * is owned by the event, so we copy it here
+       */
+      if (real_event->platform_data == real_event->platform_storage)
+        {
+          memcpy (new_real_event->platform_storage,
+                  real_event->platform_storage,
+                  sizeof (real_event->platform_storage));
+          new_real_event->platform_data = new_real_event->platform_storage;
+        }
+      else if (real_event->platform_data_size > 0)
+        {
+          new_real_event->platform_data =
+            g_slice_copy (real_event->platform_data_size,
+                          real_event->platform_data);
+          new_real_event->platform_data_size =
+            real_event->platform_data_size;
+        }
     }
 
   device = clutter_event_get_device (event);
   if (device != NULL)
     n_axes = clutter_input_device_get_n_axes (device);
 
+  if (is_event_allocated (event))
+    {
+      ClutterEventPrivate *real_event = (ClutterEventPrivate *) event;
+
+      if (real_event->motion_history != NULL)
+        {
+          GArray *history = real_event->motion_history;
+          GArray *new_history;
+          guint i;
+
+          new_history = g_array_sized_new (FALSE, FALSE,
+                                           sizeof (ClutterMotionHistory),
+                                           history->len);
+          g_array_append_vals (new_history, history->data, history->len);
+
+          for (i = 0; i < new_history->len; i++)
+            {
+              ClutterMotionHistory *entry;
+
+              entry = &g_array_index (new_history, ClutterMotionHistory, i);
+              if (entry->axes != NULL)
+                entry->axes = g_memdup (entry->axes, sizeof (gdouble) * n_axes);
+            }
+
+          new_real_event->motion_history = new_history;
+        }
+    }
+
   switch (event->type)
     {
     case CLUTTER_BUTTON_PRESS:
@@ -1041,6 +1195,37 @@ clutter_event_free (ClutterEvent *event)
           break;
         }
 
+      if (is_event_allocated (event))
+        {
+          ClutterEventPrivate *real_event = (ClutterEventPrivate *) event;
+
+          if (real_event->platform_data_size > 0)
+            g_slice_free1 (real_event->platform_data_size,
+                           real_event->platform_data);
+
+          if (real_event->motion_history != NULL)
+            {
+              GArray *history = real_event->motion_history;
+              guint i;
+
+              for (i = 0; i < history->len; i++)
+                g_free (g_array_index (history, ClutterMotionHistory, i).axes);
+
+              g_array_free (history, TRUE);
+            }
+
+          if (event_pool_size < EVENT_POOL_MAX_SIZE)
+            {
+              g_hash_table_insert (all_events, event, NULL);
+
+              real_event->next_free = event_pool;
+              event_pool = real_event;
+              event_pool_size += 1;
+
+              return;
+            }
+        }
+
       g_hash_table_remove (all_events, event);
       g_slice_free (ClutterEventPrivate, (ClutterEventPrivate *) event);
     }
@@ -1333,3 +1518,148 @@ clutter_event_get_axes (const ClutterEvent *event,
 
   return retval;
 }
+
+/*< private >
+ * _clutter_event_push_motion_history:
+ * @event: a #ClutterEvent of type %CLUTTER_MOTION
+ * @previous: the motion event preceding @event
+ *
+ * Coalesces @previous into @event: the history of @previous and its
+ * coordinates, time and axes are moved to the beginning of the motion
+ * history of @event. The axes of @previous are stolen, so @previous
+ * should only be freed afterwards.
+ */
+void
+_clutter_event_push_motion_history (ClutterEvent *event,
+                                    ClutterEvent *previous)
+{
+  ClutterEventPrivate *real_event, *real_previous;
+  ClutterMotionHistory entry;
+  GArray *history;
+
+  g_return_if_fail (event->type == CLUTTER_MOTION);
+  g_return_if_fail (previous->type == CLUTTER_MOTION);
+
+  if (!is_event_allocated (event) || !is_event_allocated (previous))
+    return;
+
+  real_event = (ClutterEventPrivate *) event;
+  real_previous = (ClutterEventPrivate *) previous;
+
+  /* the history of @previous is older than @previous itself, which is
+   * older than the current history of @event
+   */
+  history = real_previous->motion_history;
+  real_previous->motion_history = NULL;
+
+  if (history == NULL)
+    history = g_array_new (FALSE, FALSE, sizeof (ClutterMotionHistory));
+
+  entry.x = previous->motion.x;
+  entry.y = previous->motion.y;
+  entry.time = previous->motion.time;
+  entry.axes = previous->motion.axes;
+  g_array_append_val (history, entry);
+
+  previous->motion.axes = NULL;
+
+  if (real_event->motion_history != NULL)
+    {
+      g_array_append_vals (history,
+                           real_event->motion_history->data,
+                           real_event->motion_history->len);
+      g_array_free (real_event->motion_history, TRUE);
+    }
+
+  real_event->motion_history = history;
+}
+
+/**
+ * clutter_event_get_motion_history_size:
+ * @event: a #ClutterEvent
+ *
+ * Retrieves the number of motion events that have been coalesced
+ * into @event; see clutter_stage_set_keep_motion_history()
+ *
+ * Return value: the size of the motion history of @event
+ *
+ * Since: 1.8
+ */
+guint
+clutter_event_get_motion_history_size (const ClutterEvent *event)
+{
+  ClutterEventPrivate *real_event;
+
+  g_return_val_if_fail (event != NULL, 0);
+
+  if (event->type != CLUTTER_MOTION || !is_event_allocated (event))
+    return 0;
+
+  real_event = (ClutterEventPrivate *) event;
+
+  if (real_event->motion_history == NULL)
+    return 0;
+
+  return real_event->motion_history->len;
+}
+
+/**
+ * clutter_event_get_motion_history:
+ * @event: a #ClutterEvent of type %CLUTTER_MOTION
+ * @index_: the index of the motion event, between 0 and the value
+ *   returned by clutter_event_get_motion_history_size()
+ * @x: (out) (allow-none): return location for the X coordinate
+ * @y: (out) (allow-none): return location for the Y coordinate
+ * @time_: (out) (allow-none): return location for the time
+ * @axes: (out) (allow-none) (transfer none): return location for the
+ *   array of axis values, or %NULL
+ *
+ * Retrieves the motion event at @index_ in the history of @event.
+ *
+ * When the motion events are throttled, the consecutive motion events
+ * of a device are coalesced into the last one, and only the last one
+ * is delivered; if clutter_stage_set_keep_motion_history() was called
+ * on the stage, the coalesced motion events can be retrieved using
+ * this function. The history is sorted from the oldest to the most
+ * recent event, and it does not include @event itself.
+ *
+ * The number of axis values is the same as the one returned by
+ * clutter_event_get_axes() for @event.
+ *
+ * Return value: %TRUE if there is a motion event at @index_
+ *
+ * Since: 1.8
+ */
+gboolean
+clutter_event_get_motion_history (const ClutterEvent  *event,
+                                  guint                index_,
+                                  gfloat              *x,
+                                  gfloat              *y,
+                                  guint32             *time_,
+                                  gdouble            **axes)
+{
+  ClutterMotionHistory *entry;
+
+  g_return_val_if_fail (event != NULL, FALSE);
+
+  if (index_ >= clutter_event_get_motion_history_size (event))
+    return FALSE;
+
+  entry = &g_array_index (((ClutterEventPrivate *) event)->motion_history,
+                          ClutterMotionHistory,
+                          index_);
+
+  if (x)
+    *x = entry->x;
+
+  if (y)
+    *y = entry->y;
+
+  if (time_)
+    *time_ = entry->time;
+
+  if (axes)
+    *axes = entry->axes;
+
+  return TRUE;
+}
@@ -428,6 +428,14 @@ void                    clutter_event_get_coords                (const ClutterEv
 gdouble *               clutter_event_get_axes                  (const ClutterEvent     *event,
                                                                  guint                  *n_axes);
 
+guint                   clutter_event_get_motion_history_size   (const ClutterEvent     *event);
+gboolean                clutter_event_get_motion_history        (const ClutterEvent     *event,
+                                                                 guint                   index_,
+                                                                 gfloat                 *x,
+                                                                 gfloat                 *y,
+                                                                 guint32                *time_,
+                                                                 gdouble               **axes);
+
 void                    clutter_event_set_key_symbol            (ClutterEvent           *event,
                                                                  guint                   key_sym);
 guint                   clutter_event_get_key_symbol            (const ClutterEvent     *event);
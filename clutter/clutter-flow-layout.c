@@ -80,6 +80,7 @@
 #include "clutter-enum-types.h"
 #include "clutter-flow-layout.h"
 #include "clutter-layout-meta.h"
+#include "clutter-layout-virtual-private.h"
 #include "clutter-private.h"
 
 #define CLUTTER_FLOW_LAYOUT_GET_PRIVATE(obj)    (G_TYPE_INSTANCE_GET_PRIVATE ((obj), CLUTTER_TYPE_FLOW_LAYOUT, ClutterFlowLayoutPrivate))
@@ -109,6 +110,14 @@ struct _ClutterFlowLayoutPrivate
 
   guint line_count;
 
+  /* the children bound to a model; the estimated size of a child
+   * alongside the orientation is stored in col_width or row_height,
+   * and the estimated size of a line in virtual_line
+   */
+  ClutterLayoutVirtual *virt;
+  gfloat virtual_line;
+  gfloat virtual_avail;
+
   guint is_homogeneous : 1;
 };
 
@@ -194,6 +203,358 @@ compute_lines (ClutterFlowLayout *self,
     return get_rows (self, avail_height);
 }
 
+static inline gboolean
+flow_layout_is_virtual (ClutterFlowLayout *self)
+{
+  return self->priv->virt != NULL && self->priv->virt->model != NULL;
+}
+
+/* in a layout bound to a model, the "item" size is the size of a child
+ * alongside the orientation, and the "line" size is the size across it
+ */
+static gfloat
+flow_layout_get_item_size (ClutterFlowLayout *self)
+{
+  ClutterFlowLayoutPrivate *priv = self->priv;
+
+  if (priv->orientation == CLUTTER_FLOW_HORIZONTAL)
+    return priv->col_width;
+  else
+    return priv->row_height;
+}
+
+static void
+flow_layout_set_item_size (ClutterFlowLayout *self,
+                           gfloat             size)
+{
+  ClutterFlowLayoutPrivate *priv = self->priv;
+
+  if (priv->orientation == CLUTTER_FLOW_HORIZONTAL)
+    {
+      if (priv->max_col_width > 0 && size > priv->max_col_width)
+        size = priv->max_col_width;
+
+      priv->col_width = MAX (size, priv->min_col_width);
+    }
+  else
+    {
+      if (priv->max_row_height > 0 && size > priv->max_row_height)
+        size = priv->max_row_height;
+
+      priv->row_height = MAX (size, priv->min_row_height);
+    }
+}
+
+static void
+flow_child_get_sizes (ClutterFlowLayout *self,
+                      ClutterActor      *child,
+                      gfloat             for_item_size,
+                      gfloat            *item_nat_p,
+                      gfloat            *line_nat_p)
+{
+  if (self->priv->orientation == CLUTTER_FLOW_HORIZONTAL)
+    {
+      clutter_actor_get_preferred_width (child, -1, NULL, item_nat_p);
+      clutter_actor_get_preferred_height (child, for_item_size,
+                                          NULL, line_nat_p);
+    }
+  else
+    {
+      clutter_actor_get_preferred_height (child, -1, NULL, item_nat_p);
+      clutter_actor_get_preferred_width (child, for_item_size,
+                                         NULL, line_nat_p);
+    }
+}
+
+static void
+flow_layout_virtual_window (ClutterLayoutManager  *manager,
+                            guint                  n_items,
+                            const ClutterActorBox *viewport,
+                            guint                 *first_p,
+                            guint                 *last_p)
+{
+  ClutterFlowLayout *self = CLUTTER_FLOW_LAYOUT (manager);
+  ClutterFlowLayoutPrivate *priv = self->priv;
+  gfloat start, end, stride, avail;
+  gint items_per_line;
+
+  /* we need at least one child to estimate the size of the rows */
+  if (flow_layout_get_item_size (self) <= 0 || priv->virtual_line <= 0)
+    {
+      ClutterActor *sample;
+
+      sample = _clutter_layout_virtual_get_sample (priv->virt);
+      if (sample != NULL)
+        {
+          gfloat item_nat, line_nat;
+
+          flow_child_get_sizes (self, sample, -1, &item_nat, NULL);
+          flow_layout_set_item_size (self, item_nat);
+
+          flow_child_get_sizes (self, sample,
+                                flow_layout_get_item_size (self),
+                                NULL, &line_nat);
+          priv->virtual_line = line_nat;
+        }
+    }
+
+  avail = priv->virtual_avail > 0 ? priv->virtual_avail : -1;
+
+  if (priv->orientation == CLUTTER_FLOW_HORIZONTAL)
+    {
+      items_per_line = get_columns (self, avail);
+      stride = priv->virtual_line + priv->row_spacing;
+      start = viewport->y1;
+      end = viewport->y2;
+    }
+  else
+    {
+      items_per_line = get_rows (self, avail);
+      stride = priv->virtual_line + priv->col_spacing;
+      start = viewport->x1;
+      end = viewport->x2;
+    }
+
+  stride = MAX (stride, 1.0f);
+
+  *first_p = start > 0 ? (guint) floorf (start / stride) : 0;
+  *first_p *= items_per_line;
+
+  *last_p = end > 0 ? (guint) ceilf (end / stride) : 0;
+  *last_p *= items_per_line;
+}
+
+/* the size of a layout bound to a model is estimated using the size
+ * of the children inside the window
+ */
+static void
+get_preferred_size_virtual (ClutterFlowLayout *self,
+                            gboolean           is_width,
+                            gfloat             for_size,
+                            gfloat            *min_size_p,
+                            gfloat            *nat_size_p)
+{
+  ClutterFlowLayoutPrivate *priv = self->priv;
+  gboolean is_horizontal;
+  gfloat minimum, natural;
+  guint n_items;
+
+  is_horizontal = priv->orientation == CLUTTER_FLOW_HORIZONTAL;
+  n_items = priv->virt->n_items;
+  minimum = natural = 0;
+
+  if (n_items > 0 && is_width == is_horizontal)
+    {
+      gfloat item_size, spacing;
+
+      /* alongside the orientation we request enough space to put
+       * all the children on a single line
+       */
+      item_size = flow_layout_get_item_size (self);
+      spacing = is_horizontal ? priv->col_spacing : priv->row_spacing;
+
+      minimum = item_size;
+      natural = n_items * item_size + (n_items - 1) * spacing;
+    }
+  else if (n_items > 0)
+    {
+      gfloat spacing;
+      gint items_per_line;
+      guint n_lines;
+
+      if (is_horizontal)
+        {
+          items_per_line = get_columns (self, for_size);
+          spacing = priv->row_spacing;
+        }
+      else
+        {
+          items_per_line = get_rows (self, for_size);
+          spacing = priv->col_spacing;
+        }
+
+      n_lines = (n_items + items_per_line - 1) / items_per_line;
+
+      natural = n_lines * priv->virtual_line + (n_lines - 1) * spacing;
+      minimum = natural;
+    }
+
+  if (min_size_p)
+    *min_size_p = minimum;
+
+  if (nat_size_p)
+    *nat_size_p = natural;
+}
+
+/* lays out the lines of children inside the window, starting from the
+ * estimated position of the first line, and updates the estimates
+ */
+static void
+allocate_virtual (ClutterFlowLayout      *self,
+                  const ClutterActorBox  *allocation,
+                  ClutterAllocationFlags  flags)
+{
+  ClutterFlowLayoutPrivate *priv = self->priv;
+  ClutterLayoutVirtual *virt = priv->virt;
+  gfloat avail_width, avail_height;
+  gfloat avail_items, item_spacing, line_spacing;
+  gfloat item_size, max_item, line_pos, total_lines;
+  gfloat *line_sizes;
+  gboolean is_horizontal;
+  gint items_per_line;
+  guint first_line, n_lines, current_line, n_measured, i;
+
+  clutter_actor_box_get_size (allocation, &avail_width, &avail_height);
+
+  is_horizontal = priv->orientation == CLUTTER_FLOW_HORIZONTAL;
+
+  if (is_horizontal)
+    {
+      avail_items = avail_width;
+      item_spacing = priv->col_spacing;
+      line_spacing = priv->row_spacing;
+    }
+  else
+    {
+      avail_items = avail_height;
+      item_spacing = priv->row_spacing;
+      line_spacing = priv->col_spacing;
+    }
+
+  priv->virtual_avail = avail_items;
+
+  if (virt->items->len == 0)
+    goto out;
+
+  items_per_line = compute_lines (self, avail_width, avail_height);
+  item_size = (avail_items + item_spacing) / items_per_line - item_spacing;
+
+  first_line = virt->first_item / items_per_line;
+  n_lines = (virt->first_item + virt->items->len - 1) / items_per_line
+          - first_line + 1;
+
+  /* the size of a line is the size of its largest child */
+  line_sizes = g_new0 (gfloat, n_lines);
+  max_item = 0;
+
+  for (i = 0; i < virt->items->len; i++)
+    {
+      ClutterActor *child = g_ptr_array_index (virt->items, i);
+      guint line = (virt->first_item + i) / items_per_line - first_line;
+      gfloat item_nat, line_nat;
+
+      if (child == NULL || !CLUTTER_ACTOR_IS_VISIBLE (child))
+        continue;
+
+      flow_child_get_sizes (self, child, item_size, &item_nat, &line_nat);
+
+      line_sizes[line] = MAX (line_sizes[line], line_nat);
+      max_item = MAX (max_item, item_nat);
+    }
+
+  line_pos = first_line * (priv->virtual_line + line_spacing);
+  current_line = 0;
+
+  for (i = 0; i < virt->items->len; i++)
+    {
+      ClutterActor *child = g_ptr_array_index (virt->items, i);
+      guint row = virt->first_item + i;
+      guint line = row / items_per_line - first_line;
+      gint line_item = row % items_per_line;
+      ClutterActorBox child_alloc;
+      gfloat item_pos, item_width, item_height;
+
+      if (child == NULL || !CLUTTER_ACTOR_IS_VISIBLE (child))
+        continue;
+
+      while (current_line < line)
+        {
+          line_pos += line_sizes[current_line] + line_spacing;
+          current_line += 1;
+        }
+
+      item_pos = (line_item * (avail_items + item_spacing)) / items_per_line;
+
+      if (is_horizontal)
+        {
+          item_width = ((line_item + 1) * (avail_items + item_spacing))
+                     / items_per_line - item_pos - item_spacing;
+          item_height = line_sizes[line];
+        }
+      else
+        {
+          item_height = ((line_item + 1) * (avail_items + item_spacing))
+                      / items_per_line - item_pos - item_spacing;
+          item_width = line_sizes[line];
+        }
+
+      if (!priv->is_homogeneous)
+        {
+          gfloat child_min, child_natural;
+
+          clutter_actor_get_preferred_width (child, item_height,
+                                             &child_min,
+                                             &child_natural);
+          item_width = MIN (item_width, child_natural);
+
+          clutter_actor_get_preferred_height (child, item_width,
+                                              &child_min,
+                                              &child_natural);
+          item_height = MIN (item_height, child_natural);
+        }
+
+      if (is_horizontal)
+        {
+          child_alloc.x1 = ceil (item_pos);
+          child_alloc.y1 = ceil (line_pos);
+        }
+      else
+        {
+          child_alloc.x1 = ceil (line_pos);
+          child_alloc.y1 = ceil (item_pos);
+        }
+
+      child_alloc.x2 = ceil (child_alloc.x1 + item_width);
+      child_alloc.y2 = ceil (child_alloc.y1 + item_height);
+      clutter_actor_allocate (child, &child_alloc, flags);
+    }
+
+  total_lines = 0;
+  n_measured = 0;
+  for (i = 0; i < n_lines; i++)
+    {
+      if (line_sizes[i] > 0)
+        {
+          total_lines += line_sizes[i];
+          n_measured += 1;
+        }
+    }
+
+  g_free (line_sizes);
+
+  /* the window and the preferred size depend on the estimates, so we
+   * need to update them if they changed; we cannot do it while the
+   * container is being allocated
+   */
+  if (n_measured > 0)
+    {
+      gfloat old_item_size = flow_layout_get_item_size (self);
+
+      flow_layout_set_item_size (self, max_item);
+
+      if (fabsf (flow_layout_get_item_size (self) - old_item_size) >= 0.5f ||
+          fabsf (total_lines / n_measured - priv->virtual_line) >= 0.5f)
+        {
+          priv->virtual_line = total_lines / n_measured;
+
+          _clutter_layout_virtual_queue_refresh (virt);
+        }
+    }
+
+out:
+  _clutter_layout_virtual_allocated (virt, allocation);
+}
+
 static void
 clutter_flow_layout_get_preferred_width (ClutterLayoutManager *manager,
                                          ClutterContainer     *container,
@@ -202,13 +563,24 @@ clutter_flow_layout_get_preferred_width (ClutterLayoutManager *manager,
                                          gfloat               *nat_width_p)
 {
   ClutterFlowLayoutPrivate *priv = CLUTTER_FLOW_LAYOUT (manager)->priv;
-  GList *l, *children = clutter_container_get_children (container);
+  GList *l, *children;
   gint n_rows, line_item_count, line_count;
   gfloat total_min_width, total_natural_width;
   gfloat line_min_width, line_natural_width;
   gfloat max_min_width, max_natural_width;
   gfloat item_y;
 
+  if (flow_layout_is_virtual (CLUTTER_FLOW_LAYOUT (manager)))
+    {
+      get_preferred_size_virtual (CLUTTER_FLOW_LAYOUT (manager),
+                                  TRUE, for_height,
+                                  min_width_p,
+                                  nat_width_p);
+      return;
+    }
+
+  children = clutter_container_get_children (container);
+
   n_rows = get_rows (CLUTTER_FLOW_LAYOUT (manager), for_height);
 
   total_min_width = 0;
@@ -379,13 +751,24 @@ clutter_flow_layout_get_preferred_height (ClutterLayoutManager *manager,
                                           gfloat               *nat_height_p)
 {
   ClutterFlowLayoutPrivate *priv = CLUTTER_FLOW_LAYOUT (manager)->priv;
-  GList *l, *children = clutter_container_get_children (container);
+  GList *l, *children;
   gint n_columns, line_item_count, line_count;
   gfloat total_min_height, total_natural_height;
   gfloat line_min_height, line_natural_height;
   gfloat max_min_height, max_natural_height;
   gfloat item_x;
 
+  if (flow_layout_is_virtual (CLUTTER_FLOW_LAYOUT (manager)))
+    {
+      get_preferred_size_virtual (CLUTTER_FLOW_LAYOUT (manager),
+                                  FALSE, for_width,
+                                  min_height_p,
+                                  nat_height_p);
+      return;
+    }
+
+  children = clutter_container_get_children (container);
+
   n_columns = get_columns (CLUTTER_FLOW_LAYOUT (manager), for_width);
 
   total_min_height = 0;
@@ -555,13 +938,20 @@ clutter_flow_layout_allocate (ClutterLayoutManager   *manager,
                               ClutterAllocationFlags  flags)
 {
   ClutterFlowLayoutPrivate *priv = CLUTTER_FLOW_LAYOUT (manager)->priv;
-  GList *l, *children = clutter_container_get_children (container);
+  GList *l, *children;
   gfloat avail_width, avail_height;
   gfloat item_x, item_y;
   gint line_item_count;
   gint items_per_line;
   gint line_index;
 
+  if (flow_layout_is_virtual (CLUTTER_FLOW_LAYOUT (manager)))
+    {
+      allocate_virtual (CLUTTER_FLOW_LAYOUT (manager), allocation, flags);
+      return;
+    }
+
+  children = clutter_container_get_children (container);
   if (children == NULL)
     return;
 
@@ -727,6 +1117,9 @@ clutter_flow_layout_set_container (ClutterLayoutManager *manager,
                                       request_mode);
     }
 
+  if (priv->virt != NULL)
+    _clutter_layout_virtual_set_container (priv->virt, container);
+
   parent_class = CLUTTER_LAYOUT_MANAGER_CLASS (clutter_flow_layout_parent_class);
   parent_class->set_container (manager, container);
 }
@@ -846,6 +1239,8 @@ clutter_flow_layout_finalize (GObject *gobject)
   if (priv->line_natural != NULL)
     g_array_free (priv->line_natural, TRUE);
 
+  _clutter_layout_virtual_free (priv->virt);
+
   G_OBJECT_CLASS (clutter_flow_layout_parent_class)->finalize (gobject);
 }
 
@@ -1070,6 +1465,12 @@ clutter_flow_layout_set_orientation (ClutterFlowLayout      *layout,
 
       priv->orientation = orientation;
 
+      if (priv->virt != NULL)
+        {
+          priv->virtual_line = 0;
+          _clutter_layout_virtual_queue_refresh (priv->virt);
+        }
+
       if (priv->container != NULL)
         {
           ClutterRequestMode request_mode;
@@ -1188,6 +1589,9 @@ clutter_flow_layout_set_column_spacing (ClutterFlowLayout *layout,
 
       priv->col_spacing = spacing;
 
+      if (priv->virt != NULL)
+        _clutter_layout_virtual_queue_refresh (priv->virt);
+
       manager = CLUTTER_LAYOUT_MANAGER (layout);
       clutter_layout_manager_layout_changed (manager);
 
@@ -1240,6 +1644,9 @@ clutter_flow_layout_set_row_spacing (ClutterFlowLayout *layout,
 
       priv->row_spacing = spacing;
 
+      if (priv->virt != NULL)
+        _clutter_layout_virtual_queue_refresh (priv->virt);
+
       manager = CLUTTER_LAYOUT_MANAGER (layout);
       clutter_layout_manager_layout_changed (manager);
 
@@ -1426,3 +1833,148 @@ clutter_flow_layout_get_row_height (ClutterFlowLayout *layout,
   if (max_height)
     *max_height = layout->priv->max_row_height;
 }
+
+static void
+flow_layout_ensure_virtual (ClutterFlowLayout *layout)
+{
+  ClutterFlowLayoutPrivate *priv = layout->priv;
+
+  if (priv->virt != NULL)
+    return;
+
+  priv->virt = _clutter_layout_virtual_new (CLUTTER_LAYOUT_MANAGER (layout),
+                                            flow_layout_virtual_window);
+  _clutter_layout_virtual_set_container (priv->virt, priv->container);
+}
+
+/**
+ * clutter_flow_layout_set_model:
+ * @layout: a #ClutterFlowLayout
+ * @model: (allow-none): a #ClutterModel, or %NULL
+ * @func: (allow-none): the function creating the children for the rows
+ *   of @model
+ * @data: data to pass to @func
+ * @notify: function to call when @func is not needed any more
+ *
+ * Binds @layout to @model.
+ *
+ * A #ClutterFlowLayout bound to a #ClutterModel only keeps and lays out
+ * the children for the rows of @model intersecting the viewport set
+ * using clutter_flow_layout_set_viewport(), plus a margin; the children
+ * are created using @func, and the size of the other lines is estimated
+ * from the size of the children. The children of the rows leaving the
+ * viewport are hidden and passed again to @func when another row
+ * enters the viewport.
+ *
+ * While @layout is bound to a model the children added to the container
+ * by other means are not laid out.
+ *
+ * Passing %NULL for @model destroys the children created by @func
+ * and lays out the children of the container again.
+ *
+ * Since: 1.8
+ */
+void
+clutter_flow_layout_set_model (ClutterFlowLayout      *layout,
+                               ClutterModel           *model,
+                               ClutterLayoutModelFunc  func,
+                               gpointer                data,
+                               GDestroyNotify          notify)
+{
+  ClutterFlowLayoutPrivate *priv;
+
+  g_return_if_fail (CLUTTER_IS_FLOW_LAYOUT (layout));
+  g_return_if_fail (model == NULL || CLUTTER_IS_MODEL (model));
+  g_return_if_fail (model == NULL || func != NULL);
+
+  priv = layout->priv;
+
+  flow_layout_ensure_virtual (layout);
+
+  priv->virtual_line = 0;
+  _clutter_layout_virtual_set_model (priv->virt, model, func, data, notify);
+
+  clutter_layout_manager_layout_changed (CLUTTER_LAYOUT_MANAGER (layout));
+}
+
+/**
+ * clutter_flow_layout_get_model:
+ * @layout: a #ClutterFlowLayout
+ *
+ * Retrieves the model set using clutter_flow_layout_set_model()
+ *
+ * Return value: (transfer none): the #ClutterModel bound to @layout,
+ *   or %NULL
+ *
+ * Since: 1.8
+ */
+ClutterModel *
+clutter_flow_layout_get_model (ClutterFlowLayout *layout)
+{
+  g_return_val_if_fail (CLUTTER_IS_FLOW_LAYOUT (layout), NULL);
+
+  if (layout->priv->virt == NULL)
+    return NULL;
+
+  return layout->priv->virt->model;
+}
+
+/**
+ * clutter_flow_layout_set_viewport:
+ * @layout: a #ClutterFlowLayout
+ * @x: the X coordinate of the viewport
+ * @y: the Y coordinate of the viewport
+ * @width: the width of the viewport, or -1
+ * @height: the height of the viewport, or -1
+ *
+ * Sets the area of the container using @layout that is visible, in
+ * the coordinate space of the container; this is usually updated when
+ * scrolling the container.
+ *
+ * If @width or @height are negative, the allocation of the container
+ * is used instead.
+ *
+ * The viewport is only used if @layout is bound to a #ClutterModel;
+ * see clutter_flow_layout_set_model()
+ *
+ * Since: 1.8
+ */
+void
+clutter_flow_layout_set_viewport (ClutterFlowLayout *layout,
+                                  gfloat             x,
+                                  gfloat             y,
+                                  gfloat             width,
+                                  gfloat             height)
+{
+  g_return_if_fail (CLUTTER_IS_FLOW_LAYOUT (layout));
+
+  flow_layout_ensure_virtual (layout);
+
+  _clutter_layout_virtual_set_viewport (layout->priv->virt,
+                                        x, y,
+                                        width, height);
+}
+
+/**
+ * clutter_flow_layout_set_viewport_margin:
+ * @layout: a #ClutterFlowLayout
+ * @margin: the margin around the viewport, in pixels, or -1
+ *
+ * Sets the size of the area around the viewport for which @layout
+ * keeps the children of a model, to avoid creating them while
+ * scrolling. A negative value uses the size of the viewport.
+ *
+ * See also clutter_flow_layout_set_model()
+ *
+ * Since: 1.8
+ */
+void
+clutter_flow_layout_set_viewport_margin (ClutterFlowLayout *layout,
+                                         gfloat             margin)
+{
+  g_return_if_fail (CLUTTER_IS_FLOW_LAYOUT (layout));
+
+  flow_layout_ensure_virtual (layout);
+
+  _clutter_layout_virtual_set_margin (layout->priv->virt, margin);
+}
@@ -122,6 +122,20 @@ void                   clutter_flow_layout_get_row_height     (ClutterFlowLayout
                                                                gfloat                 *min_height,
                                                                gfloat                 *max_height);
 
+void                   clutter_flow_layout_set_model          (ClutterFlowLayout      *layout,
+                                                               ClutterModel           *model,
+                                                               ClutterLayoutModelFunc  func,
+                                                               gpointer                data,
+                                                               GDestroyNotify          notify);
+ClutterModel *         clutter_flow_layout_get_model          (ClutterFlowLayout      *layout);
+void                   clutter_flow_layout_set_viewport       (ClutterFlowLayout      *layout,
+                                                               gfloat                  x,
+                                                               gfloat                  y,
+                                                               gfloat                  width,
+                                                               gfloat                  height);
+void                   clutter_flow_layout_set_viewport_margin (ClutterFlowLayout     *layout,
+                                                               gfloat                  margin);
+
 G_END_DECLS
 
 #endif /* __CLUTTER_FLOW_LAYOUT_H__ */
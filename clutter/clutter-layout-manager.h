@@ -32,6 +32,7 @@
 #include <clutter/clutter-actor.h>
 #include <clutter/clutter-alpha.h>
 #include <clutter/clutter-container.h>
+#include <clutter/clutter-model.h>
 #include <clutter/clutter-types.h>
 
 G_BEGIN_DECLS
@@ -148,6 +149,32 @@ struct _ClutterLayoutManagerClass
   void (* _clutter_padding_8) (void);
 };
 
+/**
+ * ClutterLayoutModelFunc:
+ * @manager: the #ClutterLayoutManager creating the child
+ * @child: (allow-none): a child previously returned by the function
+ *   that is not used any more, or %NULL
+ * @iter: a #ClutterModelIter pointing to the row of the model
+ * @user_data: data passed to the function
+ *
+ * Function used by layout managers bound to a #ClutterModel to create
+ * the child representing a row of the model.
+ *
+ * If @child is not %NULL the function should update it using the
+ * contents of the row pointed by @iter and return it; otherwise, or
+ * if @child cannot be re-used, it should return a newly created
+ * #ClutterActor. The layout manager will add the returned actor to
+ * its container.
+ *
+ * Return value: (transfer none): the child for the row
+ *
+ * Since: 1.8
+ */
+typedef ClutterActor *(* ClutterLayoutModelFunc) (ClutterLayoutManager *manager,
+                                                  ClutterActor         *child,
+                                                  ClutterModelIter     *iter,
+                                                  gpointer              user_data);
+
 GType clutter_layout_manager_get_type (void) G_GNUC_CONST;
 
 void               clutter_layout_manager_get_preferred_width   (ClutterLayoutManager   *manager,
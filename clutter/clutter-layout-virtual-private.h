@@ -0,0 +1,115 @@
+/*
+ * Clutter.
+ *
+ * An OpenGL based 'interactive canvas' library.
+ *
+ * Copyright (C) 2011 Intel Corporation
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __CLUTTER_LAYOUT_VIRTUAL_PRIVATE_H__
+#define __CLUTTER_LAYOUT_VIRTUAL_PRIVATE_H__
+
+#include <clutter/clutter-layout-manager.h>
+#include <clutter/clutter-model.h>
+
+G_BEGIN_DECLS
+
+typedef struct _ClutterLayoutVirtual    ClutterLayoutVirtual;
+
+/*
+ * ClutterLayoutVirtualWindowFunc:
+ * @manager: the layout manager owning the window
+ * @n_items: the number of rows of the model
+ * @viewport: the visible area, including the margin
+ * @first_p: return location for the first row intersecting @viewport
+ * @last_p: return location for the row following the last one
+ *   intersecting @viewport
+ *
+ * Maps the visible area of the container to a range of rows, using
+ * the size estimates of the layout manager
+ */
+typedef void (* ClutterLayoutVirtualWindowFunc) (ClutterLayoutManager  *manager,
+                                                 guint                  n_items,
+                                                 const ClutterActorBox *viewport,
+                                                 guint                 *first_p,
+                                                 guint                 *last_p);
+
+struct _ClutterLayoutVirtual
+{
+  ClutterLayoutManager *manager;
+  ClutterContainer *container;
+
+  ClutterModel *model;
+  ClutterLayoutModelFunc func;
+  gpointer func_data;
+  GDestroyNotify func_notify;
+
+  ClutterLayoutVirtualWindowFunc window_func;
+
+  /* the number of rows of the model */
+  guint n_items;
+
+  /* the visible area, in the coordinate space of the container;
+   * if no viewport has been set we use the allocation
+   */
+  ClutterActorBox viewport;
+  ClutterActorBox allocation;
+  gfloat margin;
+
+  /* the children for the rows in [first_item, first_item + items->len);
+   * an entry can be NULL if the model function did not return a child
+   */
+  guint first_item;
+  GPtrArray *items;
+
+  /* hidden children that can be bound to another row */
+  GQueue pool;
+
+  guint refresh_id;
+
+  guint has_viewport : 1;
+  guint needs_reset  : 1;
+};
+
+ClutterLayoutVirtual *_clutter_layout_virtual_new           (ClutterLayoutManager           *manager,
+                                                             ClutterLayoutVirtualWindowFunc  window_func);
+void                  _clutter_layout_virtual_free          (ClutterLayoutVirtual           *virt);
+
+void                  _clutter_layout_virtual_set_container (ClutterLayoutVirtual           *virt,
+                                                             ClutterContainer               *container);
+void                  _clutter_layout_virtual_set_model     (ClutterLayoutVirtual           *virt,
+                                                             ClutterModel                   *model,
+                                                             ClutterLayoutModelFunc          func,
+                                                             gpointer                        data,
+                                                             GDestroyNotify                  notify);
+void                  _clutter_layout_virtual_set_viewport  (ClutterLayoutVirtual           *virt,
+                                                             gfloat                          x,
+                                                             gfloat                          y,
+                                                             gfloat                          width,
+                                                             gfloat                          height);
+void                  _clutter_layout_virtual_set_margin    (ClutterLayoutVirtual           *virt,
+                                                             gfloat                          margin);
+
+void                  _clutter_layout_virtual_refresh       (ClutterLayoutVirtual           *virt);
+void                  _clutter_layout_virtual_queue_refresh (ClutterLayoutVirtual           *virt);
+void                  _clutter_layout_virtual_allocated     (ClutterLayoutVirtual           *virt,
+                                                             const ClutterActorBox          *allocation);
+
+ClutterActor *        _clutter_layout_virtual_get_sample    (ClutterLayoutVirtual           *virt);
+
+G_END_DECLS
+
+#endif /* __CLUTTER_LAYOUT_VIRTUAL_PRIVATE_H__ */
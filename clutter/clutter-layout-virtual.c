@@ -0,0 +1,539 @@
+/*
+ * Clutter.
+ *
+ * An OpenGL based 'interactive canvas' library.
+ *
+ * Copyright (C) 2011 Intel Corporation
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Virtualized children for layout managers
+ *
+ * A layout manager bound to a ClutterModel does not lay out the children
+ * added to its container; instead, it only keeps a child for each row of
+ * the model that intersects the visible area of the container (plus a
+ * margin), and uses estimates for the size of the other rows.
+ *
+ * The range of rows, or "window", is computed by the layout manager
+ * through the ClutterLayoutVirtualWindowFunc it passed on construction.
+ * Children that fall outside of the window are hidden and kept in a pool,
+ * so that they can be bound again to the rows entering the window without
+ * creating new actors; the size of the pool is bounded by the size of the
+ * window.
+ *
+ * The window cannot be changed while the container is being allocated,
+ * as adding or showing a child would queue a relayout; the layout
+ * managers update their estimates during the allocation and call
+ * _clutter_layout_virtual_queue_refresh(), which will update the window
+ * before the next frame.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "clutter-layout-virtual-private.h"
+
+#include "clutter-debug.h"
+#include "clutter-main.h"
+#include "clutter-private.h"
+
+/* the size of the pool is bounded by the size of the window, but we
+ * always keep a few children around for small windows
+ */
+#define MIN_POOL_SIZE   4
+
+static void
+layout_virtual_recycle (ClutterLayoutVirtual *virt,
+                        ClutterActor         *child)
+{
+  if (child == NULL)
+    return;
+
+  clutter_actor_hide (child);
+  g_queue_push_head (&virt->pool, child);
+}
+
+static void
+layout_virtual_trim_pool (ClutterLayoutVirtual *virt,
+                          guint                 max_size)
+{
+  while (g_queue_get_length (&virt->pool) > max_size)
+    {
+      ClutterActor *child = g_queue_pop_tail (&virt->pool);
+
+      clutter_actor_destroy (child);
+    }
+}
+
+/* destroys all the children created by the model function */
+static void
+layout_virtual_clear (ClutterLayoutVirtual *virt)
+{
+  GPtrArray *items = virt->items;
+  guint i;
+
+  /* we clear the window before destroying the children, so that
+   * the ::actor-removed handler will not find them
+   */
+  virt->items = g_ptr_array_new ();
+  virt->first_item = 0;
+
+  for (i = 0; i < items->len; i++)
+    {
+      ClutterActor *child = g_ptr_array_index (items, i);
+
+      if (child != NULL)
+        clutter_actor_destroy (child);
+    }
+
+  g_ptr_array_free (items, TRUE);
+
+  layout_virtual_trim_pool (virt, 0);
+}
+
+static void
+on_actor_removed (ClutterContainer     *container,
+                  ClutterActor         *actor,
+                  ClutterLayoutVirtual *virt)
+{
+  guint i;
+
+  /* somebody else removed one of our children, e.g. the container
+   * destroying its children
+   */
+  for (i = 0; i < virt->items->len; i++)
+    {
+      if (g_ptr_array_index (virt->items, i) == actor)
+        {
+          virt->items->pdata[i] = NULL;
+          return;
+        }
+    }
+
+  g_queue_remove (&virt->pool, actor);
+}
+
+static ClutterActor *
+layout_virtual_bind (ClutterLayoutVirtual *virt,
+                     ClutterActor         *child,
+                     ClutterModelIter     *iter)
+{
+  ClutterActor *retval;
+
+  retval = virt->func (virt->manager, child, iter, virt->func_data);
+
+  if (child != NULL && retval != child)
+    clutter_actor_destroy (child);
+
+  if (retval == NULL)
+    return NULL;
+
+  if (clutter_actor_get_parent (retval) == NULL)
+    clutter_container_add_actor (virt->container, retval);
+
+  clutter_actor_show (retval);
+
+  return retval;
+}
+
+static void
+on_row_changed (ClutterModel         *model,
+                ClutterModelIter     *iter,
+                ClutterLayoutVirtual *virt)
+{
+  ClutterActor *child;
+  guint row;
+
+  if (virt->needs_reset)
+    return;
+
+  row = clutter_model_iter_get_row (iter);
+  if (row < virt->first_item || row >= virt->first_item + virt->items->len)
+    return;
+
+  /* the child will queue a relayout if its size changes */
+  child = g_ptr_array_index (virt->items, row - virt->first_item);
+  child = layout_virtual_bind (virt, child, iter);
+  virt->items->pdata[row - virt->first_item] = child;
+}
+
+static void
+on_model_changed (ClutterModel         *model,
+                  ClutterLayoutVirtual *virt)
+{
+  /* the rows have been added, removed or re-ordered, so we need to
+   * bind the whole window again; we defer it, to coalesce bulk
+   * changes to the model
+   */
+  virt->needs_reset = TRUE;
+
+  _clutter_layout_virtual_queue_refresh (virt);
+}
+
+static void
+on_row_added_or_removed (ClutterModel         *model,
+                         ClutterModelIter     *iter,
+                         ClutterLayoutVirtual *virt)
+{
+  on_model_changed (model, virt);
+}
+
+ClutterLayoutVirtual *
+_clutter_layout_virtual_new (ClutterLayoutManager           *manager,
+                             ClutterLayoutVirtualWindowFunc  window_func)
+{
+  ClutterLayoutVirtual *virt;
+
+  virt = g_slice_new0 (ClutterLayoutVirtual);
+  virt->manager = manager;
+  virt->window_func = window_func;
+  virt->items = g_ptr_array_new ();
+  virt->margin = -1;
+
+  g_queue_init (&virt->pool);
+
+  return virt;
+}
+
+void
+_clutter_layout_virtual_free (ClutterLayoutVirtual *virt)
+{
+  if (virt == NULL)
+    return;
+
+  _clutter_layout_virtual_set_model (virt, NULL, NULL, NULL, NULL);
+  _clutter_layout_virtual_set_container (virt, NULL);
+
+  g_ptr_array_free (virt->items, TRUE);
+
+  g_slice_free (ClutterLayoutVirtual, virt);
+}
+
+void
+_clutter_layout_virtual_set_container (ClutterLayoutVirtual *virt,
+                                       ClutterContainer     *container)
+{
+  if (virt->container == container)
+    return;
+
+  if (virt->container != NULL)
+    {
+      layout_virtual_clear (virt);
+
+      g_signal_handlers_disconnect_by_func (virt->container,
+                                            on_actor_removed,
+                                            virt);
+    }
+
+  virt->container = container;
+  virt->needs_reset = TRUE;
+
+  if (virt->container != NULL)
+    {
+      g_signal_connect (virt->container, "actor-removed",
+                        G_CALLBACK (on_actor_removed),
+                        virt);
+
+      _clutter_layout_virtual_refresh (virt);
+    }
+}
+
+void
+_clutter_layout_virtual_set_model (ClutterLayoutVirtual   *virt,
+                                   ClutterModel           *model,
+                                   ClutterLayoutModelFunc  func,
+                                   gpointer                data,
+                                   GDestroyNotify          notify)
+{
+  if (virt->model != NULL)
+    {
+      g_signal_handlers_disconnect_by_func (virt->model,
+                                            on_row_added_or_removed,
+                                            virt);
+      g_signal_handlers_disconnect_by_func (virt->model,
+                                            on_row_changed,
+                                            virt);
+      g_signal_handlers_disconnect_by_func (virt->model,
+                                            on_model_changed,
+                                            virt);
+      g_object_unref (virt->model);
+    }
+
+  /* the children were created by the old function */
+  if (virt->container != NULL)
+    layout_virtual_clear (virt);
+
+  if (virt->func_notify != NULL)
+    virt->func_notify (virt->func_data);
+
+  virt->model = model != NULL ? g_object_ref (model) : NULL;
+  virt->func = func;
+  virt->func_data = data;
+  virt->func_notify = notify;
+  virt->n_items = 0;
+  virt->needs_reset = TRUE;
+
+  if (virt->model != NULL)
+    {
+      g_signal_connect (virt->model, "row-added",
+                        G_CALLBACK (on_row_added_or_removed),
+                        virt);
+      g_signal_connect (virt->model, "row-removed",
+                        G_CALLBACK (on_row_added_or_removed),
+                        virt);
+      g_signal_connect (virt->model, "row-changed",
+                        G_CALLBACK (on_row_changed),
+                        virt);
+      g_signal_connect (virt->model, "sort-changed",
+                        G_CALLBACK (on_model_changed),
+                        virt);
+      g_signal_connect (virt->model, "filter-changed",
+                        G_CALLBACK (on_model_changed),
+                        virt);
+
+      _clutter_layout_virtual_refresh (virt);
+    }
+  else if (virt->refresh_id != 0)
+    {
+      g_source_remove (virt->refresh_id);
+      virt->refresh_id = 0;
+    }
+}
+
+void
+_clutter_layout_virtual_set_viewport (ClutterLayoutVirtual *virt,
+                                      gfloat                x,
+                                      gfloat                y,
+                                      gfloat                width,
+                                      gfloat                height)
+{
+  if (width < 0 || height < 0)
+    virt->has_viewport = FALSE;
+  else
+    {
+      clutter_actor_box_set_origin (&virt->viewport, x, y);
+      clutter_actor_box_set_size (&virt->viewport, width, height);
+      virt->has_viewport = TRUE;
+    }
+
+  _clutter_layout_virtual_refresh (virt);
+}
+
+void
+_clutter_layout_virtual_set_margin (ClutterLayoutVirtual *virt,
+                                    gfloat                margin)
+{
+  virt->margin = margin;
+
+  _clutter_layout_virtual_refresh (virt);
+}
+
+/* updates the window of children to match the viewport */
+void
+_clutter_layout_virtual_refresh (ClutterLayoutVirtual *virt)
+{
+  ClutterModelIter *iter = NULL;
+  ClutterActorBox viewport;
+  GPtrArray *items;
+  guint first, last, iter_row, i;
+  gfloat margin;
+
+  if (virt->refresh_id != 0)
+    {
+      g_source_remove (virt->refresh_id);
+      virt->refresh_id = 0;
+    }
+
+  if (virt->container == NULL || virt->model == NULL)
+    return;
+
+  if (virt->needs_reset)
+    {
+      for (i = 0; i < virt->items->len; i++)
+        layout_virtual_recycle (virt, g_ptr_array_index (virt->items, i));
+
+      g_ptr_array_set_size (virt->items, 0);
+      virt->first_item = 0;
+
+      virt->n_items = clutter_model_get_n_rows (virt->model);
+      virt->needs_reset = FALSE;
+    }
+
+  viewport = virt->has_viewport ? virt->viewport : virt->allocation;
+
+  /* by default, we keep a screenful of children on each side */
+  if (virt->margin < 0)
+    margin = MAX (viewport.x2 - viewport.x1, viewport.y2 - viewport.y1);
+  else
+    margin = virt->margin;
+
+  viewport.x1 -= margin;
+  viewport.y1 -= margin;
+  viewport.x2 += margin;
+  viewport.y2 += margin;
+
+  first = last = 0;
+  if (virt->n_items > 0)
+    virt->window_func (virt->manager, virt->n_items, &viewport, &first, &last);
+
+  last = MIN (last, virt->n_items);
+  first = MIN (first, last);
+
+  items = g_ptr_array_sized_new (last - first);
+  g_ptr_array_set_size (items, last - first);
+
+  /* keep the children of the rows that are still inside the window */
+  for (i = 0; i < virt->items->len; i++)
+    {
+      ClutterActor *child = g_ptr_array_index (virt->items, i);
+      guint row = virt->first_item + i;
+
+      if (row >= first && row < last)
+        items->pdata[row - first] = child;
+      else
+        layout_virtual_recycle (virt, child);
+    }
+
+  g_ptr_array_free (virt->items, TRUE);
+  virt->items = items;
+  virt->first_item = first;
+
+  iter_row = 0;
+  for (i = first; i < last; i++)
+    {
+      ClutterActor *child;
+
+      if (items->pdata[i - first] != NULL)
+        continue;
+
+      /* walking the model is cheaper than looking up each row */
+      if (iter != NULL && iter_row + 1 == i)
+        clutter_model_iter_next (iter);
+      else
+        {
+          if (iter != NULL)
+            g_object_unref (iter);
+
+          iter = clutter_model_get_iter_at_row (virt->model, i);
+          if (iter == NULL)
+            break;
+        }
+
+      iter_row = i;
+
+      child = g_queue_pop_head (&virt->pool);
+      items->pdata[i - first] = layout_virtual_bind (virt, child, iter);
+    }
+
+  if (iter != NULL)
+    g_object_unref (iter);
+
+  layout_virtual_trim_pool (virt, MAX (items->len, MIN_POOL_SIZE));
+
+  CLUTTER_NOTE (LAYOUT, "Virtual layout [%p]: rows [%u, %u) of %u, "
+                "%u recycled children",
+                virt->manager,
+                first, last,
+                virt->n_items,
+                g_queue_get_length (&virt->pool));
+}
+
+static gboolean
+layout_virtual_refresh_idle (gpointer data)
+{
+  ClutterLayoutVirtual *virt = data;
+
+  virt->refresh_id = 0;
+
+  _clutter_layout_virtual_refresh (virt);
+
+  /* the estimates might have changed as well */
+  clutter_layout_manager_layout_changed (virt->manager);
+
+  return FALSE;
+}
+
+void
+_clutter_layout_virtual_queue_refresh (ClutterLayoutVirtual *virt)
+{
+  if (virt->refresh_id != 0)
+    return;
+
+  /* we want to run before the next redraw */
+  virt->refresh_id =
+    clutter_threads_add_idle_full (CLUTTER_PRIORITY_REDRAW - 1,
+                                   layout_virtual_refresh_idle,
+                                   virt,
+                                   NULL);
+}
+
+/* called by the layout managers at the end of the allocation */
+void
+_clutter_layout_virtual_allocated (ClutterLayoutVirtual  *virt,
+                                   const ClutterActorBox *allocation)
+{
+  gfloat width, height;
+
+  clutter_actor_box_get_size (allocation, &width, &height);
+
+  if (width == virt->allocation.x2 && height == virt->allocation.y2)
+    return;
+
+  virt->allocation.x1 = virt->allocation.y1 = 0;
+  virt->allocation.x2 = width;
+  virt->allocation.y2 = height;
+
+  /* the number of rows inside the window can depend on the size
+   * of the container, even when the viewport is set
+   */
+  _clutter_layout_virtual_queue_refresh (virt);
+}
+
+/* returns a child that can be used to estimate the size of the rows,
+ * creating one if needed; it must not be called during the allocation
+ */
+ClutterActor *
+_clutter_layout_virtual_get_sample (ClutterLayoutVirtual *virt)
+{
+  ClutterModelIter *iter;
+  ClutterActor *child;
+  guint i;
+
+  for (i = 0; i < virt->items->len; i++)
+    {
+      child = g_ptr_array_index (virt->items, i);
+      if (child != NULL)
+        return child;
+    }
+
+  if (!g_queue_is_empty (&virt->pool))
+    return g_queue_peek_head (&virt->pool);
+
+  if (virt->container == NULL || virt->model == NULL || virt->n_items == 0)
+    return NULL;
+
+  iter = clutter_model_get_iter_at_row (virt->model, 0);
+  if (iter == NULL)
+    return NULL;
+
+  child = layout_virtual_bind (virt, NULL, iter);
+  g_object_unref (iter);
+
+  layout_virtual_recycle (virt, child);
+
+  return child;
+}
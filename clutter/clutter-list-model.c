@@ -34,6 +34,10 @@
  * values for each row, so it's optimized for insertion and look up
  * in sorted lists.
  *
+ * #ClutterListModel can optionally sort and filter its rows using a pool
+ * of worker threads; see clutter_list_model_set_background_sort() for
+ * the requirements this places on the sorting and filtering functions.
+ *
  * #ClutterListModel is available since Clutter 0.6
  */
 
@@ -76,6 +80,47 @@
 typedef struct _ClutterListModelIter    ClutterListModelIter;
 typedef struct _ClutterModelIterClass   ClutterListModelIterClass;
 
+#define CLUTTER_TYPE_LIST_MODEL_SNAPSHOT_ITER        \
+        (clutter_list_model_snapshot_iter_get_type())
+#define CLUTTER_LIST_MODEL_SNAPSHOT_ITER(obj)        \
+        (G_TYPE_CHECK_INSTANCE_CAST((obj),           \
+         CLUTTER_TYPE_LIST_MODEL_SNAPSHOT_ITER,      \
+         ClutterListModelSnapshotIter))
+
+typedef struct _ClutterListModelSnapshotIter    ClutterListModelSnapshotIter;
+typedef struct _ClutterModelIterClass           ClutterListModelSnapshotIterClass;
+
+typedef struct _SortJob                 SortJob;
+typedef struct _SortEntry               SortEntry;
+typedef struct _SortTask                SortTask;
+
+/* models with fewer rows than this are always sorted synchronously,
+ * as snapshotting them and waking up the worker threads would cost
+ * more than the sort itself
+ */
+#define BACKGROUND_SORT_MIN_ROWS        512
+
+/* number of comparisons between two checks of the abort flag */
+#define BACKGROUND_SORT_ABORT_INTERVAL  256
+
+/* values stored inside the filter cache; we cannot use 0 because
+ * that is what g_hash_table_lookup() returns for missing keys
+ */
+#define FILTER_CACHE_VISIBLE            GINT_TO_POINTER (1)
+#define FILTER_CACHE_HIDDEN             GINT_TO_POINTER (2)
+
+enum
+{
+  PROP_0,
+
+  PROP_BACKGROUND_SORT
+};
+
+typedef enum {
+  SORT_JOB_SORT   = 1 << 0,
+  SORT_JOB_FILTER = 1 << 1
+} SortJobFlags;
+
 #define CLUTTER_LIST_MODEL_GET_PRIVATE(obj)     (G_TYPE_INSTANCE_GET_PRIVATE ((obj), CLUTTER_TYPE_LIST_MODEL, ClutterListModelPrivate))
 
 struct _ClutterListModelPrivate
@@ -83,6 +128,43 @@ struct _ClutterListModelPrivate
   GSequence *sequence;
 
   ClutterModelIter *temp_iter;
+
+  /* bumped every time a row is added, removed or changed; a background
+   * job is only applied if the stamp did not change since the snapshot
+   */
+  guint stamp;
+
+  /* the columns the filter function reads, or NULL for all columns */
+  GArray *filter_columns;
+
+  /* GValueArray -> FILTER_CACHE_VISIBLE or FILTER_CACHE_HIDDEN, filled
+   * by the background filter jobs; rows not inside the cache are
+   * filtered lazily, on the main thread
+   */
+  GHashTable *filter_cache;
+
+  /* the job currently running on the worker threads, if any */
+  SortJob *job;
+
+  /* the number of jobs with tasks still queued or running, including
+   * the cancelled ones, which might still be calling the sorting and
+   * filtering functions; protected by jobs_lock
+   */
+  GMutex *jobs_lock;
+  GCond *jobs_cond;
+  guint n_running_jobs;
+
+  /* the sorting function passed to ::resort, used by the next job */
+  ClutterModelSortFunc sort_func;
+  gpointer sort_data;
+
+  /* the work to be done by the next job, and the idle source that
+   * will snapshot the model and start it
+   */
+  SortJobFlags queued_flags;
+  guint queued_job_id;
+
+  guint background_sort : 1;
 };
 
 struct _ClutterListModelIter
@@ -92,10 +174,114 @@ struct _ClutterListModelIter
   GSequenceIter *seq_iter;
 };
 
+/* A read-only iterator on the copy of a row made by a background job;
+ * it is passed to the filter function on the worker threads
+ */
+struct _ClutterListModelSnapshotIter
+{
+  ClutterModelIter parent_instance;
+
+  const GValue *values;
+};
+
+struct _SortEntry
+{
+  /* only dereferenced on the main thread, when applying the job */
+  GSequenceIter *seq_iter;
+
+  /* the index of the row inside the snapshot */
+  guint index;
+};
+
+struct _SortJob
+{
+  ClutterListModel *model;
+
+  SortJobFlags flags;
+
+  /* the value of the model stamp when the snapshot was taken */
+  guint stamp;
+
+  ClutterModelSortFunc sort_func;
+  gpointer sort_data;
+  gint sort_column;
+
+  /* n_rows * n_columns values, only the sort column and the filter
+   * columns are initialized
+   */
+  GValue *values;
+  guint n_columns;
+  guint n_rows;
+
+  /* the two halves of the merge sort ping-pong buffer; once the job
+   * has completed, the sorted rows are inside sorted
+   */
+  SortEntry *entries;
+  SortEntry *scratch;
+  SortEntry *sorted;
+
+  /* the boundaries of the sorted runs still to be merged */
+  guint *bounds;
+  guint n_runs;
+
+  /* one byte per snapshot row */
+  guint8 *visible;
+
+  volatile gint abort;
+
+  /* protects n_pending and the scheduling of the merge passes */
+  GMutex *mutex;
+  guint n_pending;
+};
+
+typedef enum {
+  SORT_TASK_FILTER,
+  SORT_TASK_SORT,
+  SORT_TASK_MERGE
+} SortTaskType;
+
+struct _SortTask
+{
+  SortJob *job;
+
+  SortTaskType type;
+
+  const SortEntry *src;
+  SortEntry *dest;
+
+  guint start;
+  guint middle;
+  guint end;
+};
+
+static GThreadPool *sort_thread_pool = NULL;
+
+static gboolean clutter_list_model_filter_seq_iter (ClutterListModel *model,
+                                                    GSequenceIter    *seq_iter);
+static void     clutter_list_model_queue_job       (ClutterListModel *model,
+                                                    SortJobFlags      flags);
+static void     clutter_list_model_cancel_job      (ClutterListModel *model,
+                                                    gboolean          wait);
+
 
 
+/* marks the row as modified: any pending background job is now stale,
+ * and the cached filter result for the row cannot be trusted anymore
+ */
+static void
+clutter_list_model_touch_row (ClutterListModel *model,
+                              GValueArray      *row)
+{
+  ClutterListModelPrivate *priv = model->priv;
+
+  priv->stamp += 1;
+
+  if (priv->filter_cache != NULL && row != NULL)
+    g_hash_table_remove (priv->filter_cache, row);
+}
+
 /*
- * ClutterListModel
+ * ClutterListModelIter
  */
 
 G_DEFINE_TYPE (ClutterListModelIter,
@@ -161,6 +347,7 @@ clutter_list_model_iter_set_value (ClutterModelIter *iter,
                                    const GValue     *value)
 {
   ClutterListModelIter *iter_default;
+  ClutterModel *model;
   GValueArray *value_array;
   GValue *iter_value;
   GValue real_value = { 0, };
@@ -206,6 +393,9 @@ clutter_list_model_iter_set_value (ClutterModelIter *iter,
     }
   else
     g_value_copy (value, iter_value);
+
+  model = clutter_model_iter_get_model (iter);
+  clutter_list_model_touch_row (CLUTTER_LIST_MODEL (model), value_array);
 }
 
 static gboolean
@@ -213,7 +403,6 @@ clutter_list_model_iter_is_first (ClutterModelIter *iter)
 {
   ClutterListModelIter *iter_default;
   ClutterModel *model;
-  ClutterModelIter *temp_iter;
   GSequence *sequence;
   GSequenceIter *begin, *end;
 
@@ -227,13 +416,10 @@ clutter_list_model_iter_is_first (ClutterModelIter *iter)
   begin = g_sequence_get_begin_iter (sequence);
   end   = iter_default->seq_iter;
 
-  temp_iter = CLUTTER_LIST_MODEL (model)->priv->temp_iter;
-
   while (!g_sequence_iter_is_begin (begin))
     {
-      CLUTTER_LIST_MODEL_ITER (temp_iter)->seq_iter = begin;
-
-      if (clutter_model_filter_iter (model, temp_iter))
+      if (clutter_list_model_filter_seq_iter (CLUTTER_LIST_MODEL (model),
+                                              begin))
         {
           end = begin;
           break;
@@ -254,7 +440,6 @@ static gboolean
 clutter_list_model_iter_is_last (ClutterModelIter *iter)
 {
   ClutterListModelIter *iter_default;
-  ClutterModelIter *temp_iter;
   ClutterModel *model;
   GSequence *sequence;
   GSequenceIter *begin, *end;
@@ -273,13 +458,10 @@ clutter_list_model_iter_is_last (ClutterModelIter *iter)
   begin = g_sequence_iter_prev (begin);
   end   = iter_default->seq_iter;
 
-  temp_iter = CLUTTER_LIST_MODEL (model)->priv->temp_iter;
-
   while (!g_sequence_iter_is_begin (begin))
     {
-      CLUTTER_LIST_MODEL_ITER (temp_iter)->seq_iter = begin;
-
-      if (clutter_model_filter_iter (model, temp_iter))
+      if (clutter_list_model_filter_seq_iter (CLUTTER_LIST_MODEL (model),
+                                              begin))
         {
           end = begin;
           break;
@@ -300,7 +482,6 @@ static ClutterModelIter *
 clutter_list_model_iter_next (ClutterModelIter *iter)
 {
   ClutterListModelIter *iter_default;
-  ClutterModelIter *temp_iter;
   ClutterModel *model = NULL;
   GSequenceIter *filter_next;
   guint row;
@@ -314,13 +495,10 @@ clutter_list_model_iter_next (ClutterModelIter *iter)
   filter_next = g_sequence_iter_next (iter_default->seq_iter);
   g_assert (filter_next != NULL);
 
-  temp_iter = CLUTTER_LIST_MODEL (model)->priv->temp_iter;
-
   while (!g_sequence_iter_is_end (filter_next))
     {
-      CLUTTER_LIST_MODEL_ITER (temp_iter)->seq_iter = filter_next;
-
-      if (clutter_model_filter_iter (model, temp_iter))
+      if (clutter_list_model_filter_seq_iter (CLUTTER_LIST_MODEL (model),
+                                              filter_next))
         {
           row += 1;
           break;
@@ -343,7 +521,6 @@ static ClutterModelIter *
 clutter_list_model_iter_prev (ClutterModelIter *iter)
 {
   ClutterListModelIter *iter_default;
-  ClutterModelIter *temp_iter;
   ClutterModel *model;
   GSequenceIter *filter_prev;
   guint row;
@@ -357,13 +534,10 @@ clutter_list_model_iter_prev (ClutterModelIter *iter)
   filter_prev = g_sequence_iter_prev (iter_default->seq_iter);
   g_assert (filter_prev != NULL);
 
-  temp_iter = CLUTTER_LIST_MODEL (model)->priv->temp_iter;
-
   while (!g_sequence_iter_is_begin (filter_prev))
     {
-      CLUTTER_LIST_MODEL_ITER (temp_iter)->seq_iter = filter_prev;
-
-      if (clutter_model_filter_iter (model, temp_iter))
+      if (clutter_list_model_filter_seq_iter (CLUTTER_LIST_MODEL (model),
+                                              filter_prev))
         {
           row -= 1;
           break;
@@ -428,6 +602,728 @@ clutter_list_model_iter_init (ClutterListModelIter *iter)
   iter->seq_iter = NULL;
 }
 
+/*
+ * ClutterListModelSnapshotIter
+ */
+
+G_DEFINE_TYPE (ClutterListModelSnapshotIter,
+               clutter_list_model_snapshot_iter,
+               CLUTTER_TYPE_MODEL_ITER);
+
+static void
+clutter_list_model_snapshot_iter_get_value (ClutterModelIter *iter,
+                                            guint             column,
+                                            GValue           *value)
+{
+  ClutterListModelSnapshotIter *iter_snapshot;
+  const GValue *iter_value;
+
+  iter_snapshot = CLUTTER_LIST_MODEL_SNAPSHOT_ITER (iter);
+  g_assert (iter_snapshot->values != NULL);
+
+  iter_value = &iter_snapshot->values[column];
+  if (G_VALUE_TYPE (iter_value) == G_TYPE_INVALID)
+    {
+      g_warning ("%s: The column %u is not one of the filter columns "
+                 "of the model",
+                 G_STRLOC, column);
+      return;
+    }
+
+  if (g_value_type_compatible (G_VALUE_TYPE (iter_value),
+                               G_VALUE_TYPE (value)))
+    g_value_copy (iter_value, value);
+  else if (!g_value_transform (iter_value, value))
+    g_warning ("%s: Unable to make conversion from %s to %s",
+               G_STRLOC,
+               g_type_name (G_VALUE_TYPE (iter_value)),
+               g_type_name (G_VALUE_TYPE (value)));
+}
+
+static void
+clutter_list_model_snapshot_iter_set_value (ClutterModelIter *iter,
+                                            guint             column,
+                                            const GValue     *value)
+{
+  g_warning ("%s: The iterators passed to the filter function of a "
+             "model using background sorting are read-only",
+             G_STRLOC);
+}
+
+static void
+clutter_list_model_snapshot_iter_class_init (ClutterListModelSnapshotIterClass *klass)
+{
+  ClutterModelIterClass *iter_class = CLUTTER_MODEL_ITER_CLASS (klass);
+
+  iter_class->get_value = clutter_list_model_snapshot_iter_get_value;
+  iter_class->set_value = clutter_list_model_snapshot_iter_set_value;
+}
+
+static void
+clutter_list_model_snapshot_iter_init (ClutterListModelSnapshotIter *iter)
+{
+  iter->values = NULL;
+}
+
+/*
+ * Background sorting and filtering
+ *
+ * A job takes a snapshot of the sorting column and of the filter
+ * columns of every row, and splits the work in tasks that are run
+ * by a shared thread pool: the filter tasks and the sort tasks each
+ * handle a slice of the snapshot, and once all of them completed the
+ * sorted runs are merged pairwise, again in parallel, until a single
+ * run is left. The result is applied from an idle handler, in the
+ * main thread, only if the model did not change in the meantime.
+ */
+
+static void
+sort_job_free (SortJob *job)
+{
+  guint i;
+
+  for (i = 0; i < job->n_rows * job->n_columns; i++)
+    {
+      if (G_VALUE_TYPE (&job->values[i]) != G_TYPE_INVALID)
+        g_value_unset (&job->values[i]);
+    }
+
+  g_free (job->values);
+  g_free (job->entries);
+  g_free (job->scratch);
+  g_free (job->bounds);
+  g_free (job->visible);
+
+  g_mutex_free (job->mutex);
+
+  g_object_unref (job->model);
+
+  g_slice_free (SortJob, job);
+}
+
+static inline gint
+sort_job_compare (SortJob         *job,
+                  const SortEntry *a,
+                  const SortEntry *b)
+{
+  const GValue *value_a, *value_b;
+
+  value_a = &job->values[a->index * job->n_columns + job->sort_column];
+  value_b = &job->values[b->index * job->n_columns + job->sort_column];
+
+  return job->sort_func ((ClutterModel *) job->model,
+                         value_a,
+                         value_b,
+                         job->sort_data);
+}
+
+/* merges the sorted runs [start, middle) and [middle, end) of @src
+ * into the same range of @dest; returns %FALSE if the job was aborted
+ */
+static gboolean
+sort_job_merge (SortJob         *job,
+                const SortEntry *src,
+                SortEntry       *dest,
+                guint            start,
+                guint            middle,
+                guint            end)
+{
+  guint i = start, j = middle, k = start;
+  guint n_compares = 0;
+
+  while (i < middle && j < end)
+    {
+      /* only take from the right run if it is strictly smaller, so
+       * that the sort is stable like g_sequence_sort()
+       */
+      if (sort_job_compare (job, &src[j], &src[i]) < 0)
+        dest[k++] = src[j++];
+      else
+        dest[k++] = src[i++];
+
+      if (++n_compares == BACKGROUND_SORT_ABORT_INTERVAL)
+        {
+          if (g_atomic_int_get (&job->abort))
+            return FALSE;
+
+          n_compares = 0;
+        }
+    }
+
+  if (i < middle)
+    memcpy (dest + k, src + i, (middle - i) * sizeof (SortEntry));
+  else if (j < end)
+    memcpy (dest + k, src + j, (end - j) * sizeof (SortEntry));
+
+  return TRUE;
+}
+
+/* bottom-up merge sort of a slice of the entries */
+static void
+sort_job_sort_run (SortJob *job,
+                   guint    start,
+                   guint    end)
+{
+  SortEntry *src = job->entries;
+  SortEntry *dest = job->scratch;
+  guint width;
+
+  for (width = 1; width < end - start; width *= 2)
+    {
+      SortEntry *tmp;
+      guint i;
+
+      for (i = start; i < end; i += 2 * width)
+        {
+          guint middle = MIN (i + width, end);
+          guint run_end = MIN (i + 2 * width, end);
+
+          if (!sort_job_merge (job, src, dest, i, middle, run_end))
+            return;
+        }
+
+      tmp = src;
+      src = dest;
+      dest = tmp;
+    }
+
+  /* the passes alternate between the two buffers, but the merge
+   * passes expect every run to be inside the entries
+   */
+  if (src != job->entries)
+    memcpy (job->entries + start,
+            src + start,
+            (end - start) * sizeof (SortEntry));
+}
+
+static void
+sort_job_filter_rows (SortJob *job,
+                      guint    start,
+                      guint    end)
+{
+  ClutterModel *model = (ClutterModel *) job->model;
+  ClutterListModelSnapshotIter *iter;
+  guint i;
+
+  iter = g_object_new (CLUTTER_TYPE_LIST_MODEL_SNAPSHOT_ITER,
+                       "model", model,
+                       NULL);
+
+  for (i = start; i < end; i++)
+    {
+      if ((i - start) % BACKGROUND_SORT_ABORT_INTERVAL == 0 &&
+          g_atomic_int_get (&job->abort))
+        break;
+
+      iter->values = job->values + i * job->n_columns;
+
+      job->visible[i] = clutter_model_filter_iter (model,
+                                                   CLUTTER_MODEL_ITER (iter));
+    }
+
+  g_object_unref (iter);
+}
+
+/* must be called with the job mutex held */
+static void
+sort_job_push_task (SortJob         *job,
+                    SortTaskType     type,
+                    const SortEntry *src,
+                    SortEntry       *dest,
+                    guint            start,
+                    guint            middle,
+                    guint            end)
+{
+  SortTask *task = g_slice_new (SortTask);
+
+  task->job = job;
+  task->type = type;
+  task->src = src;
+  task->dest = dest;
+  task->start = start;
+  task->middle = middle;
+  task->end = end;
+
+  job->n_pending += 1;
+
+  g_thread_pool_push (sort_thread_pool, task, NULL);
+}
+
+/* schedules the merge of each pair of adjacent runs; must be called
+ * with the job mutex held, once all the tasks of the previous pass
+ * have completed
+ */
+static void
+sort_job_schedule_merge_pass (SortJob *job)
+{
+  const SortEntry *src = job->sorted;
+  SortEntry *dest;
+  guint i, n_runs = 0;
+
+  dest = job->sorted == job->entries ? job->scratch : job->entries;
+
+  for (i = 0; i < job->n_runs; i += 2)
+    {
+      guint start = job->bounds[i];
+      guint middle = job->bounds[i + 1];
+
+      if (i + 1 < job->n_runs)
+        sort_job_push_task (job, SORT_TASK_MERGE, src, dest,
+                            start, middle, job->bounds[i + 2]);
+      else
+        memcpy (dest + start,
+                src + start,
+                (middle - start) * sizeof (SortEntry));
+
+      job->bounds[n_runs++] = start;
+    }
+
+  job->bounds[n_runs] = job->n_rows;
+  job->n_runs = n_runs;
+  job->sorted = dest;
+}
+
+static gboolean sort_job_complete (gpointer data);
+
+static void
+sort_job_task_done (SortJob *job)
+{
+  ClutterListModelPrivate *priv = job->model->priv;
+
+  g_mutex_lock (job->mutex);
+
+  job->n_pending -= 1;
+
+  if (job->n_pending == 0 &&
+      job->n_runs > 1 &&
+      !g_atomic_int_get (&job->abort))
+    sort_job_schedule_merge_pass (job);
+
+  if (job->n_pending == 0)
+    {
+      /* no task of the job will call the sorting or filtering
+       * function anymore
+       */
+      g_mutex_lock (priv->jobs_lock);
+      priv->n_running_jobs -= 1;
+      g_cond_broadcast (priv->jobs_cond);
+      g_mutex_unlock (priv->jobs_lock);
+
+      /* the result must be applied in the main thread, holding the
+       * Clutter lock
+       */
+      clutter_threads_add_idle (sort_job_complete, job);
+    }
+
+  g_mutex_unlock (job->mutex);
+}
+
+static void
+sort_job_run_task (gpointer task_data,
+                   gpointer pool_data)
+{
+  SortTask *task = task_data;
+  SortJob *job = task->job;
+
+  if (!g_atomic_int_get (&job->abort))
+    {
+      switch (task->type)
+        {
+        case SORT_TASK_FILTER:
+          sort_job_filter_rows (job, task->start, task->end);
+          break;
+
+        case SORT_TASK_SORT:
+          sort_job_sort_run (job, task->start, task->end);
+          break;
+
+        case SORT_TASK_MERGE:
+          sort_job_merge (job, task->src, task->dest,
+                          task->start, task->middle, task->end);
+          break;
+        }
+    }
+
+  g_slice_free (SortTask, task);
+
+  sort_job_task_done (job);
+}
+
+static void
+clutter_list_model_apply_job (ClutterListModel *model,
+                              SortJob          *job)
+{
+  ClutterListModelPrivate *priv = model->priv;
+  guint i;
+
+  if (job->flags & SORT_JOB_FILTER)
+    {
+      if (priv->filter_cache == NULL)
+        priv->filter_cache = g_hash_table_new (NULL, NULL);
+      else
+        g_hash_table_remove_all (priv->filter_cache);
+
+      for (i = 0; i < job->n_rows; i++)
+        {
+          const SortEntry *entry = &job->entries[i];
+
+          g_hash_table_insert (priv->filter_cache,
+                               g_sequence_get (entry->seq_iter),
+                               job->visible[entry->index]
+                                 ? FILTER_CACHE_VISIBLE
+                                 : FILTER_CACHE_HIDDEN);
+        }
+    }
+
+  if (job->flags & SORT_JOB_SORT)
+    {
+      GSequenceIter *end = g_sequence_get_end_iter (priv->sequence);
+
+      /* moving the rows instead of building a new sequence keeps
+       * the GSequenceIter of every ClutterModelIter valid
+       */
+      for (i = 0; i < job->n_rows; i++)
+        g_sequence_move (job->sorted[i].seq_iter, end);
+
+      g_signal_emit_by_name (model, "sort-changed");
+    }
+}
+
+static gboolean
+sort_job_complete (gpointer data)
+{
+  SortJob *job = data;
+  ClutterListModel *model = job->model;
+  gboolean aborted;
+
+  /* Grab the mutex so we can be sure the last task has unlocked it
+     before we destroy it */
+  g_mutex_lock (job->mutex);
+  aborted = g_atomic_int_get (&job->abort);
+  g_mutex_unlock (job->mutex);
+
+  if (!aborted)
+    {
+      g_assert (model->priv->job == job);
+
+      model->priv->job = NULL;
+
+      /* if the model changed while the job was running then the
+       * snapshot is stale, and we need to start over
+       */
+      if (job->stamp == model->priv->stamp)
+        clutter_list_model_apply_job (model, job);
+      else
+        clutter_list_model_queue_job (model, job->flags);
+    }
+
+  sort_job_free (job);
+
+  return FALSE;
+}
+
+static void
+clutter_list_model_sort_sequence (ClutterModel         *model,
+                                  ClutterModelSortFunc  func,
+                                  gpointer              data);
+
+static void
+clutter_list_model_run_job (ClutterListModel *model,
+                            SortJobFlags      flags)
+{
+  ClutterModel *base_model = CLUTTER_MODEL (model);
+  ClutterListModelPrivate *priv = model->priv;
+  GSequenceIter *seq_iter;
+  gboolean *copy_column;
+  guint n_rows, n_columns, n_workers, chunk_size, i, j;
+  SortJob *job;
+
+  /* a running job is working on stale data, but we must not lose
+   * the work it was supposed to do
+   */
+  if (priv->job != NULL)
+    {
+      flags |= priv->job->flags;
+      clutter_list_model_cancel_job (model, FALSE);
+    }
+
+  if (priv->sort_func == NULL ||
+      clutter_model_get_sorting_column (base_model) < 0)
+    flags &= ~SORT_JOB_SORT;
+
+  if (!clutter_model_get_filter_set (base_model))
+    flags &= ~SORT_JOB_FILTER;
+
+  n_rows = g_sequence_get_length (priv->sequence);
+  if (n_rows < BACKGROUND_SORT_MIN_ROWS)
+    {
+      /* filtering lazily is cheap enough for small models */
+      if (flags & SORT_JOB_SORT)
+        {
+          clutter_list_model_sort_sequence (base_model,
+                                            priv->sort_func,
+                                            priv->sort_data);
+          g_signal_emit_by_name (model, "sort-changed");
+        }
+
+      return;
+    }
+
+  if (flags == 0)
+    return;
+
+  n_columns = clutter_model_get_n_columns (base_model);
+  n_workers = _clutter_get_n_workers ();
+
+  if (sort_thread_pool == NULL)
+    sort_thread_pool = g_thread_pool_new (sort_job_run_task,
+                                          NULL,
+                                          n_workers,
+                                          FALSE,
+                                          NULL);
+
+  job = g_slice_new0 (SortJob);
+  job->model = g_object_ref (model);
+  job->flags = flags;
+  job->stamp = priv->stamp;
+  job->sort_func = priv->sort_func;
+  job->sort_data = priv->sort_data;
+  job->sort_column = clutter_model_get_sorting_column (base_model);
+  job->n_columns = n_columns;
+  job->n_rows = n_rows;
+  job->values = g_new0 (GValue, n_rows * n_columns);
+  job->entries = g_new (SortEntry, n_rows);
+  job->mutex = g_mutex_new ();
+
+  copy_column = g_newa (gboolean, n_columns);
+  for (j = 0; j < n_columns; j++)
+    copy_column[j] = (flags & SORT_JOB_FILTER) && priv->filter_columns == NULL;
+
+  if (flags & SORT_JOB_SORT)
+    copy_column[job->sort_column] = TRUE;
+
+  if ((flags & SORT_JOB_FILTER) && priv->filter_columns != NULL)
+    {
+      for (j = 0; j < priv->filter_columns->len; j++)
+        copy_column[g_array_index (priv->filter_columns, guint, j)] = TRUE;
+    }
+
+  seq_iter = g_sequence_get_begin_iter (priv->sequence);
+  for (i = 0; i < n_rows; i++)
+    {
+      GValueArray *row = g_sequence_get (seq_iter);
+      GValue *values = job->values + i * n_columns;
+
+      for (j = 0; j < n_columns; j++)
+        {
+          const GValue *row_value;
+
+          if (!copy_column[j])
+            continue;
+
+          row_value = g_value_array_get_nth (row, j);
+
+          g_value_init (&values[j], G_VALUE_TYPE (row_value));
+          g_value_copy (row_value, &values[j]);
+        }
+
+      job->entries[i].seq_iter = seq_iter;
+      job->entries[i].index = i;
+
+      seq_iter = g_sequence_iter_next (seq_iter);
+    }
+
+  chunk_size = (n_rows + n_workers - 1) / n_workers;
+
+  g_mutex_lock (priv->jobs_lock);
+  priv->n_running_jobs += 1;
+  g_mutex_unlock (priv->jobs_lock);
+
+  /* hold the lock while pushing, otherwise the first tasks might
+   * complete before the last ones have been pushed
+   */
+  g_mutex_lock (job->mutex);
+
+  if (flags & SORT_JOB_FILTER)
+    {
+      job->visible = g_new0 (guint8, n_rows);
+
+      for (i = 0; i < n_rows; i += chunk_size)
+        sort_job_push_task (job, SORT_TASK_FILTER, NULL, NULL,
+                            i, i, MIN (i + chunk_size, n_rows));
+    }
+
+  if (flags & SORT_JOB_SORT)
+    {
+      job->scratch = g_new (SortEntry, n_rows);
+      job->bounds = g_new (guint, n_workers + 1);
+      job->sorted = job->entries;
+
+      for (i = 0; i < n_rows; i += chunk_size)
+        {
+          job->bounds[job->n_runs++] = i;
+
+          sort_job_push_task (job, SORT_TASK_SORT, NULL, NULL,
+                              i, i, MIN (i + chunk_size, n_rows));
+        }
+
+      job->bounds[job->n_runs] = n_rows;
+    }
+
+  g_mutex_unlock (job->mutex);
+
+  priv->job = job;
+}
+
+static gboolean
+clutter_list_model_start_job (gpointer data)
+{
+  ClutterListModel *model = data;
+  SortJobFlags flags = model->priv->queued_flags;
+
+  model->priv->queued_flags = 0;
+  model->priv->queued_job_id = 0;
+
+  clutter_list_model_run_job (model, flags);
+
+  return FALSE;
+}
+
+/* jobs are started from an idle handler, so that populating a model
+ * row by row does not take a snapshot for each new row
+ */
+static void
+clutter_list_model_queue_job (ClutterListModel *model,
+                              SortJobFlags      flags)
+{
+  ClutterListModelPrivate *priv = model->priv;
+
+  priv->queued_flags |= flags;
+
+  if (priv->queued_job_id == 0)
+    priv->queued_job_id = clutter_threads_add_idle (clutter_list_model_start_job,
+                                                    model);
+}
+
+/* cancels the running job; if @wait is %TRUE, also waits for the
+ * tasks of every job previously cancelled without waiting
+ */
+static void
+clutter_list_model_cancel_job (ClutterListModel *model,
+                               gboolean          wait)
+{
+  ClutterListModelPrivate *priv = model->priv;
+  SortJob *job = priv->job;
+
+  if (job != NULL)
+    {
+      priv->job = NULL;
+
+      /* the job will be freed by sort_job_complete() */
+      g_atomic_int_set (&job->abort, TRUE);
+    }
+
+  if (wait)
+    {
+      g_mutex_lock (priv->jobs_lock);
+
+      while (priv->n_running_jobs > 0)
+        g_cond_wait (priv->jobs_cond, priv->jobs_lock);
+
+      g_mutex_unlock (priv->jobs_lock);
+    }
+}
+
+static gboolean
+clutter_list_model_filter_seq_iter (ClutterListModel *model,
+                                    GSequenceIter    *seq_iter)
+{
+  ClutterListModelPrivate *priv = model->priv;
+  ClutterModelIter *temp_iter;
+
+  if (!clutter_model_get_filter_set (CLUTTER_MODEL (model)))
+    return TRUE;
+
+  if (priv->filter_cache != NULL)
+    {
+      gpointer res;
+
+      res = g_hash_table_lookup (priv->filter_cache,
+                                 g_sequence_get (seq_iter));
+      if (res != NULL)
+        return res == FILTER_CACHE_VISIBLE;
+    }
+
+  temp_iter = priv->temp_iter;
+  CLUTTER_LIST_MODEL_ITER (temp_iter)->seq_iter = seq_iter;
+
+  return clutter_model_filter_iter (CLUTTER_MODEL (model), temp_iter);
+}
+
+/*
+ * _clutter_list_model_stop_background:
+ * @model: a #ClutterListModel
+ * @filter_changing: %TRUE if the filter function is about to change,
+ *   and %FALSE if the sorting function is
+ *
+ * Waits for the background jobs of @model, including the cancelled
+ * ones, which might be calling the function about to be replaced, and
+ * discards the results that depend on it. Called by #ClutterModel
+ * before releasing the data of the sorting or filtering function.
+ */
+void
+_clutter_list_model_stop_background (ClutterListModel *model,
+                                     gboolean          filter_changing)
+{
+  ClutterListModelPrivate *priv = model->priv;
+  SortJobFlags invalid_flags, flags = 0;
+
+  invalid_flags = filter_changing ? SORT_JOB_FILTER : SORT_JOB_SORT;
+
+  if (priv->job != NULL)
+    flags = priv->job->flags & ~invalid_flags;
+
+  /* jobs cancelled earlier without waiting might still be running
+   * as well, so this always waits
+   */
+  clutter_list_model_cancel_job (model, TRUE);
+
+  if (flags != 0)
+    clutter_list_model_queue_job (model, flags);
+
+  if (filter_changing)
+    {
+      if (priv->filter_cache != NULL)
+        g_hash_table_remove_all (priv->filter_cache);
+    }
+  else
+    {
+      priv->sort_func = NULL;
+      priv->sort_data = NULL;
+    }
+}
+
+/*
+ * _clutter_list_model_get_sort_pending:
+ * @model: a #ClutterListModel
+ *
+ * Checks whether a sort of @model is queued or running in the
+ * background. The #ClutterModel::sort-changed signal is emitted by
+ * @model once the new order has been applied, so #ClutterModel must
+ * not emit it when the sort is requested.
+ *
+ * Return value: %TRUE if the rows of @model will be reordered by a
+ *   background job
+ */
+gboolean
+_clutter_list_model_get_sort_pending (ClutterListModel *model)
+{
+  ClutterListModelPrivate *priv = model->priv;
+
+  return (priv->queued_flags & SORT_JOB_SORT) != 0 ||
+         (priv->job != NULL && (priv->job->flags & SORT_JOB_SORT) != 0);
+}
+
 /*
  * ClutterListModel
  */
@@ -468,7 +1364,7 @@ clutter_list_model_get_iter_at_row (ClutterModel *model,
     {
       retval->seq_iter = filter_next;
 
-      if (clutter_model_filter_iter (model, CLUTTER_MODEL_ITER (retval)))
+      if (clutter_list_model_filter_seq_iter (model_default, filter_next))
         {
           /* We've found a row that is valid under the filter */
           count++;
@@ -511,6 +1407,8 @@ clutter_list_model_insert_row (ClutterModel *model,
       g_value_init (value, clutter_model_get_column_type (model, i));
     }
 
+  clutter_list_model_touch_row (model_default, NULL);
+
   if (index_ < 0)
     {
       seq_iter = g_sequence_append (sequence, array);
@@ -605,9 +1503,9 @@ sort_model_default (gconstpointer a,
 }
 
 static void
-clutter_list_model_resort (ClutterModel         *model,
-                           ClutterModelSortFunc  func,
-                           gpointer              data)
+clutter_list_model_sort_sequence (ClutterModel         *model,
+                                  ClutterModelSortFunc  func,
+                                  gpointer              data)
 {
   SortClosure sort_closure = { NULL, 0, NULL, NULL };
 
@@ -621,6 +1519,32 @@ clutter_list_model_resort (ClutterModel         *model,
                    &sort_closure);
 }
 
+static void
+clutter_list_model_resort (ClutterModel         *model,
+                           ClutterModelSortFunc  func,
+                           gpointer              data)
+{
+  ClutterListModel *list_model = CLUTTER_LIST_MODEL (model);
+  ClutterListModelPrivate *priv = list_model->priv;
+
+  if (priv->background_sort &&
+      func != NULL &&
+      g_thread_supported () &&
+      g_sequence_get_length (priv->sequence) >= BACKGROUND_SORT_MIN_ROWS)
+    {
+      priv->sort_func = func;
+      priv->sort_data = data;
+
+      clutter_list_model_queue_job (list_model, SORT_JOB_SORT);
+      return;
+    }
+
+  /* the order of the rows changes under a running job */
+  priv->stamp += 1;
+
+  clutter_list_model_sort_sequence (model, func, data);
+}
+
 static guint
 clutter_list_model_get_n_rows (ClutterModel *model)
 {
@@ -643,12 +1567,24 @@ clutter_list_model_row_removed (ClutterModel     *model,
   iter_default = CLUTTER_LIST_MODEL_ITER (iter);
 
   array = g_sequence_get (iter_default->seq_iter);
+  clutter_list_model_touch_row (CLUTTER_LIST_MODEL (model), array);
   g_value_array_free (array);
 
   g_sequence_remove (iter_default->seq_iter);
   iter_default->seq_iter = NULL;
 }
 
+static void
+clutter_list_model_filter_changed (ClutterModel *model)
+{
+  ClutterListModel *list_model = CLUTTER_LIST_MODEL (model);
+
+  if (list_model->priv->background_sort &&
+      clutter_model_get_filter_set (model) &&
+      g_thread_supported ())
+    clutter_list_model_queue_job (list_model, SORT_JOB_FILTER);
+}
+
 static void
 clutter_list_model_finalize (GObject *gobject)
 {
@@ -656,6 +1592,15 @@ clutter_list_model_finalize (GObject *gobject)
   GSequence *sequence = model->priv->sequence;
   GSequenceIter *iter;
 
+  if (model->priv->filter_cache != NULL)
+    g_hash_table_destroy (model->priv->filter_cache);
+
+  if (model->priv->filter_columns != NULL)
+    g_array_free (model->priv->filter_columns, TRUE);
+
+  g_mutex_free (model->priv->jobs_lock);
+  g_cond_free (model->priv->jobs_cond);
+
   iter = g_sequence_get_begin_iter (sequence);
   while (!g_sequence_iter_is_end (iter))
     {
@@ -674,6 +1619,14 @@ clutter_list_model_dispose (GObject *gobject)
 {
   ClutterListModel *model = CLUTTER_LIST_MODEL (gobject);
 
+  if (model->priv->queued_job_id != 0)
+    {
+      g_source_remove (model->priv->queued_job_id);
+      model->priv->queued_job_id = 0;
+    }
+
+  clutter_list_model_cancel_job (model, TRUE);
+
   if (model->priv->temp_iter)
     {
       g_object_unref (model->priv->temp_iter);
@@ -683,17 +1636,76 @@ clutter_list_model_dispose (GObject *gobject)
   G_OBJECT_CLASS (clutter_list_model_parent_class)->dispose (gobject);
 }
 
+static void
+clutter_list_model_set_property (GObject      *gobject,
+                                 guint         prop_id,
+                                 const GValue *value,
+                                 GParamSpec   *pspec)
+{
+  ClutterListModel *model = CLUTTER_LIST_MODEL (gobject);
+
+  switch (prop_id)
+    {
+    case PROP_BACKGROUND_SORT:
+      clutter_list_model_set_background_sort (model,
+                                              g_value_get_boolean (value));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+clutter_list_model_get_property (GObject    *gobject,
+                                 guint       prop_id,
+                                 GValue     *value,
+                                 GParamSpec *pspec)
+{
+  ClutterListModel *model = CLUTTER_LIST_MODEL (gobject);
+
+  switch (prop_id)
+    {
+    case PROP_BACKGROUND_SORT:
+      g_value_set_boolean (value, model->priv->background_sort);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
+      break;
+    }
+}
+
 static void
 clutter_list_model_class_init (ClutterListModelClass *klass)
 {
   GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   ClutterModelClass *model_class = CLUTTER_MODEL_CLASS (klass);
+  GParamSpec *pspec;
 
   g_type_class_add_private (klass, sizeof (ClutterListModelPrivate));
 
+  gobject_class->set_property = clutter_list_model_set_property;
+  gobject_class->get_property = clutter_list_model_get_property;
   gobject_class->finalize = clutter_list_model_finalize;
   gobject_class->dispose = clutter_list_model_dispose;
 
+  /**
+   * ClutterListModel:background-sort:
+   *
+   * Whether the model should be sorted and filtered using worker
+   * threads; see clutter_list_model_set_background_sort()
+   *
+   * Since: 1.8
+   */
+  pspec = g_param_spec_boolean ("background-sort",
+                                P_("Background Sort"),
+                                P_("Whether the model should be sorted and filtered in worker threads"),
+                                FALSE,
+                                CLUTTER_PARAM_READWRITE);
+  g_object_class_install_property (gobject_class, PROP_BACKGROUND_SORT, pspec);
+
   model_class->get_iter_at_row = clutter_list_model_get_iter_at_row;
   model_class->insert_row      = clutter_list_model_insert_row;
   model_class->remove_row      = clutter_list_model_remove_row;
@@ -701,6 +1713,7 @@ clutter_list_model_class_init (ClutterListModelClass *klass)
   model_class->get_n_rows      = clutter_list_model_get_n_rows;
 
   model_class->row_removed     = clutter_list_model_row_removed;
+  model_class->filter_changed  = clutter_list_model_filter_changed;
 }
 
 static void
@@ -709,6 +1722,8 @@ clutter_list_model_init (ClutterListModel *model)
   model->priv = CLUTTER_LIST_MODEL_GET_PRIVATE (model);
 
   model->priv->sequence = g_sequence_new (NULL);
+  model->priv->jobs_lock = g_mutex_new ();
+  model->priv->jobs_cond = g_cond_new ();
   model->priv->temp_iter = g_object_new (CLUTTER_TYPE_LIST_MODEL_ITER,
                                          "model",
                                          model,
@@ -820,3 +1835,154 @@ clutter_list_model_newv (guint                n_columns,
 
   return model;
 }
+
+/**
+ * clutter_list_model_set_background_sort:
+ * @model: a #ClutterListModel
+ * @background_sort: whether the model should be sorted and filtered
+ *   using worker threads
+ *
+ * Sets whether @model should sort and filter its rows using a pool of
+ * worker threads, instead of blocking the main loop.
+ *
+ * When enabled, sorting a model with more than a few hundred rows takes
+ * a copy of the sorting column and of the columns read by the filter
+ * function (see clutter_list_model_set_filter_columns()), and sorts the
+ * copy with a parallel merge sort. Once the sort has completed the new
+ * order is applied to @model in one go, and the #ClutterModel::sort-changed
+ * signal is emitted; until then, the rows keep their previous order. The
+ * results of the filter function are computed on the copy as well, and
+ * cached until the row they refer to changes.
+ *
+ * The #ClutterModelSortFunc and the #ClutterModelFilterFunc of @model
+ * will be called from threads other than the one running the main loop,
+ * so they must be thread-safe, and the filter function should only access
+ * the row through the #ClutterModelIter it receives.
+ *
+ * Background sorting requires the GLib threading support to be initialized
+ * with g_thread_init(); if it is not, @model will be sorted synchronously.
+ *
+ * Since: 1.8
+ */
+void
+clutter_list_model_set_background_sort (ClutterListModel *model,
+                                        gboolean          background_sort)
+{
+  ClutterListModelPrivate *priv;
+
+  g_return_if_fail (CLUTTER_IS_LIST_MODEL (model));
+
+  priv = model->priv;
+
+  background_sort = !!background_sort;
+
+  if (priv->background_sort == background_sort)
+    return;
+
+  priv->background_sort = background_sort;
+
+  if (!priv->background_sort)
+    {
+      gboolean sort_pending;
+
+      sort_pending = _clutter_list_model_get_sort_pending (model);
+
+      if (priv->queued_job_id != 0)
+        {
+          g_source_remove (priv->queued_job_id);
+          priv->queued_job_id = 0;
+          priv->queued_flags = 0;
+        }
+
+      clutter_list_model_cancel_job (model, FALSE);
+
+      /* a pending sort is finished synchronously; with the background
+       * sort disabled, resorting doesn't emit ::sort-changed so it is
+       * emitted once here
+       */
+      if (sort_pending)
+        {
+          clutter_model_resort (CLUTTER_MODEL (model));
+          g_signal_emit_by_name (model, "sort-changed");
+        }
+
+      if (priv->filter_cache != NULL)
+        {
+          g_hash_table_destroy (priv->filter_cache);
+          priv->filter_cache = NULL;
+        }
+    }
+
+  g_object_notify (G_OBJECT (model), "background-sort");
+}
+
+/**
+ * clutter_list_model_get_background_sort:
+ * @model: a #ClutterListModel
+ *
+ * Retrieves whether @model is sorted and filtered using worker threads
+ *
+ * Return value: %TRUE if background sorting is enabled
+ *
+ * Since: 1.8
+ */
+gboolean
+clutter_list_model_get_background_sort (ClutterListModel *model)
+{
+  g_return_val_if_fail (CLUTTER_IS_LIST_MODEL (model), FALSE);
+
+  return model->priv->background_sort;
+}
+
+/**
+ * clutter_list_model_set_filter_columns:
+ * @model: a #ClutterListModel
+ * @n_columns: the number of columns in @columns
+ * @columns: (array length=n_columns) (allow-none): the columns read by
+ *   the filter function, or %NULL
+ *
+ * Sets the columns of @model that are read by the filter function.
+ *
+ * When background sorting is enabled, only the values of these columns
+ * are copied for the filter function to use; reading any other column
+ * from the #ClutterModelIter passed to the filter function will fail.
+ * If @columns is %NULL, every column is copied.
+ *
+ * Since: 1.8
+ */
+void
+clutter_list_model_set_filter_columns (ClutterListModel *model,
+                                       guint             n_columns,
+                                       const guint      *columns)
+{
+  ClutterListModelPrivate *priv;
+  guint i;
+
+  g_return_if_fail (CLUTTER_IS_LIST_MODEL (model));
+  g_return_if_fail (n_columns == 0 || columns != NULL);
+
+  priv = model->priv;
+
+  for (i = 0; i < n_columns; i++)
+    {
+      if (columns[i] >= clutter_model_get_n_columns (CLUTTER_MODEL (model)))
+        {
+          g_warning ("%s: Invalid column id value %u\n", G_STRLOC, columns[i]);
+          return;
+        }
+    }
+
+  if (priv->filter_columns != NULL)
+    {
+      g_array_free (priv->filter_columns, TRUE);
+      priv->filter_columns = NULL;
+    }
+
+  if (columns != NULL)
+    {
+      priv->filter_columns = g_array_sized_new (FALSE, FALSE,
+                                                sizeof (guint),
+                                                n_columns);
+      g_array_append_vals (priv->filter_columns, columns, n_columns);
+    }
+}
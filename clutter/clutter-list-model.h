@@ -83,6 +83,13 @@ ClutterModel *clutter_list_model_newv     (guint                n_columns,
                                            GType               *types,
                                            const gchar * const  names[]);
 
+void          clutter_list_model_set_background_sort (ClutterListModel *model,
+                                                      gboolean          background_sort);
+gboolean      clutter_list_model_get_background_sort (ClutterListModel *model);
+void          clutter_list_model_set_filter_columns  (ClutterListModel *model,
+                                                      guint             n_columns,
+                                                      const guint      *columns);
+
 G_END_DECLS
 
 #endif /* __CLUTTER_LIST_MODEL_H__ */
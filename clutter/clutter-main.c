@@ -94,6 +94,10 @@
 #include <glib/gi18n-lib.h>
 #include <locale.h>
 
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
 #ifdef USE_GDKPIXBUF
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #endif
@@ -184,7 +188,8 @@ static const GDebugKey clutter_paint_debug_keys[] = {
   { "disable-clipped-redraws", CLUTTER_DEBUG_DISABLE_CLIPPED_REDRAWS },
   { "redraws", CLUTTER_DEBUG_REDRAWS },
   { "paint-volumes", CLUTTER_DEBUG_PAINT_VOLUMES },
-  { "disable-culling", CLUTTER_DEBUG_DISABLE_CULLING }
+  { "disable-culling", CLUTTER_DEBUG_DISABLE_CULLING },
+  { "disable-offscreen-cache", CLUTTER_DEBUG_DISABLE_OFFSCREEN_CACHE }
 };
 
 #ifdef CLUTTER_ENABLE_PROFILE
@@ -2033,6 +2038,34 @@ _clutter_boolean_handled_accumulator (GSignalInvocationHint *ihint,
   return continue_emission;
 }
 
+/*
+ * _clutter_get_n_workers:
+ *
+ * Retrieves the number of worker threads to use when splitting work,
+ * like the background sorting of #ClutterListModel, between threads.
+ * The number is based on the number of online CPUs.
+ *
+ * Return value: the number of worker threads, between 1 and 8
+ */
+guint
+_clutter_get_n_workers (void)
+{
+  static guint n_workers = 0;
+
+  if (G_UNLIKELY (n_workers == 0))
+    {
+#if defined (HAVE_UNISTD_H) && defined (_SC_NPROCESSORS_ONLN)
+      glong n_cpus = sysconf (_SC_NPROCESSORS_ONLN);
+
+      n_workers = CLAMP (n_cpus, 1, 8);
+#else
+      n_workers = 2;
+#endif
+    }
+
+  return n_workers;
+}
+
 static void
 event_click_count_generate (ClutterEvent *event)
 {
@@ -2266,6 +2299,9 @@ is_off_stage (ClutterActor *stage,
  * The @event must be a valid #ClutterEvent and have a #ClutterStage
  * associated to it.
  *
+ * The @event is only borrowed: it is not retained by Clutter, and the
+ * caller keeps ownership of it.
+ *
  * This function is only useful when embedding Clutter inside another
  * toolkit, and it should never be called by applications.
  *
@@ -2292,7 +2328,34 @@ clutter_do_event (ClutterEvent *event)
    * because we've "looked ahead" and know all motion events that
    * will occur before drawing the frame.
    */
-  _clutter_stage_queue_event (event->any.stage, event);
+  _clutter_stage_queue_event (event->any.stage, event, TRUE);
+}
+
+/*< private >
+ * _clutter_do_event_take:
+ * @event: a #ClutterEvent allocated using clutter_event_new()
+ *
+ * Like clutter_do_event(), but transfers the ownership of @event to
+ * Clutter, avoiding a copy; the backends use this to forward the
+ * events popped off the event queue using clutter_event_get().
+ */
+void
+_clutter_do_event_take (ClutterEvent *event)
+{
+  if (event->any.stage == NULL)
+    {
+      g_warning ("%s: Event does not have a stage: discarding.", G_STRFUNC);
+      clutter_event_free (event);
+      return;
+    }
+
+  if (CLUTTER_ACTOR_IN_DESTRUCTION (event->any.stage))
+    {
+      clutter_event_free (event);
+      return;
+    }
+
+  _clutter_stage_queue_event (event->any.stage, event, FALSE);
 }
 
 static void
@@ -2924,6 +2987,10 @@ clutter_clear_glyph_cache (void)
  * Enabling hinting improves text quality for static text but may
  * introduce some artifacts if the text is animated.
  *
+ * Using distance fields will keep the text sharp and avoid
+ * rasterizing the glyphs again when the scale of the text is
+ * animated, at the cost of slightly softer small text.
+ *
  * Since: 1.0
  */
 void
@@ -2934,7 +3001,7 @@ clutter_set_font_flags (ClutterFontFlags flags)
   ClutterFontFlags old_flags, changed_flags;
   const cairo_font_options_t *font_options;
   cairo_font_options_t *new_font_options;
-  gboolean use_mipmapping;
+  gboolean use_mipmapping, use_distance_field;
   ClutterBackend *backend;
 
   backend = clutter_get_default_backend ();
@@ -2942,6 +3009,8 @@ clutter_set_font_flags (ClutterFontFlags flags)
   font_map = clutter_context_get_pango_fontmap ();
   use_mipmapping = (flags & CLUTTER_FONT_MIPMAPPING) != 0;
   cogl_pango_font_map_set_use_mipmapping (font_map, use_mipmapping);
+  use_distance_field = (flags & CLUTTER_FONT_DISTANCE_FIELD) != 0;
+  cogl_pango_font_map_set_use_distance_field (font_map, use_distance_field);
 
   old_flags = clutter_get_font_flags ();
 
@@ -2988,6 +3057,8 @@ clutter_get_font_flags (void)
   font_map = clutter_context_get_pango_fontmap ();
   if (cogl_pango_font_map_get_use_mipmapping (font_map))
     flags |= CLUTTER_FONT_MIPMAPPING;
+  if (cogl_pango_font_map_get_use_distance_field (font_map))
+    flags |= CLUTTER_FONT_DISTANCE_FIELD;
 
   font_options =
     clutter_backend_get_font_options (clutter_get_default_backend ());
@@ -3317,6 +3388,42 @@ _clutter_clear_events_queue_for_stage (ClutterStage *stage)
     }
 }
 
+/* the amount of texture memory kept around by the idle offscreen
+ * targets; this is enough for a few full screen effects
+ */
+#define OFFSCREEN_POOL_MAX_IDLE_BYTES   (32 * 1024 * 1024)
+
+ClutterOffscreenPool *
+_clutter_context_get_offscreen_pool (void)
+{
+  ClutterMainContext *context = _clutter_context_get_default ();
+
+  if (G_UNLIKELY (context->offscreen_pool == NULL))
+    context->offscreen_pool =
+      _clutter_offscreen_pool_new (OFFSCREEN_POOL_MAX_IDLE_BYTES);
+
+  return context->offscreen_pool;
+}
+
+/*< private >
+ * _clutter_context_free_offscreen_pool:
+ *
+ * Releases the render targets kept around by the offscreen pool of
+ * the main context. Called when the backend goes away, while the
+ * Cogl context is still valid.
+ */
+void
+_clutter_context_free_offscreen_pool (void)
+{
+  ClutterMainContext *context = _clutter_context_get_default ();
+
+  if (context->offscreen_pool != NULL)
+    {
+      _clutter_offscreen_pool_free (context->offscreen_pool);
+      context->offscreen_pool = NULL;
+    }
+}
+
 ClutterPickMode
 _clutter_context_get_pick_mode (void)
 {
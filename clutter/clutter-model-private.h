@@ -3,6 +3,7 @@
 
 #include <glib.h>
 #include "clutter-model.h"
+#include "clutter-list-model.h"
 
 G_BEGIN_DECLS
 
@@ -22,6 +23,10 @@ void     clutter_model_set_column_name (ClutterModel *model,
 void    clutter_model_iter_set_row (ClutterModelIter *iter,
                                     guint             row);
 
+void    _clutter_list_model_stop_background (ClutterListModel *model,
+                                             gboolean          filter_changing);
+gboolean _clutter_list_model_get_sort_pending (ClutterListModel *model);
+
 G_END_DECLS
 
 #endif /* __CLUTTER_MODEL_PRIVATE_H__ */
@@ -1575,7 +1575,16 @@ clutter_model_set_sorting_column (ClutterModel *model,
   priv->sort_column = column;
 
   if (priv->sort_column >= 0)
-    clutter_model_resort (model);
+    {
+      clutter_model_resort (model);
+
+      /* a list model sorting in the background emits ::sort-changed
+       * itself, once the new order has been applied
+       */
+      if (CLUTTER_IS_LIST_MODEL (model) &&
+          _clutter_list_model_get_sort_pending (CLUTTER_LIST_MODEL (model)))
+        return;
+    }
 
   g_signal_emit (model, model_signals[SORT_CHANGED], 0);
 }
@@ -1662,6 +1671,12 @@ clutter_model_set_sort (ClutterModel         *model,
 
   priv = model->priv;
 
+  /* a list model might be sorting in a worker thread using the
+   * function we are about to replace
+   */
+  if (CLUTTER_IS_LIST_MODEL (model))
+    _clutter_list_model_stop_background (CLUTTER_LIST_MODEL (model), FALSE);
+
   if (priv->sort_notify)
     priv->sort_notify (priv->sort_data);
 
@@ -1695,6 +1710,12 @@ clutter_model_set_filter (ClutterModel           *model,
   g_return_if_fail (CLUTTER_IS_MODEL (model));
   priv = model->priv;
 
+  /* a list model might be filtering in a worker thread using the
+   * function we are about to replace
+   */
+  if (CLUTTER_IS_LIST_MODEL (model))
+    _clutter_list_model_stop_background (CLUTTER_LIST_MODEL (model), TRUE);
+
   if (priv->filter_notify)
     priv->filter_notify (priv->filter_data);
 
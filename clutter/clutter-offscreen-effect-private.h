@@ -5,6 +5,12 @@
 
 G_BEGIN_DECLS
 
+void _clutter_offscreen_effect_get_target_coords (ClutterOffscreenEffect *effect,
+                                                  gfloat                 *s_2,
+                                                  gfloat                 *t_2);
+gboolean _clutter_offscreen_effect_is_cached         (ClutterOffscreenEffect *effect);
+CoglHandle _clutter_offscreen_effect_get_target_texture (ClutterOffscreenEffect *effect);
+
 G_END_DECLS
 
 #endif /* __CLUTTER_OFFSCREEN_EFFECT_PRIVATE_H__ */
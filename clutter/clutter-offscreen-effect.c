@@ -56,6 +56,23 @@
  *   <function>create_texture()</function> virtual function; no chain up
  *   to the #ClutterOffscreenEffect implementation is required in this
  *   case.</para>
+ *   <para>Unless the <function>create_texture()</function> virtual
+ *   function is overridden, the offscreen buffers are leased from a pool
+ *   shared by all the effects. The texture of the target material can then be
+ *   bigger than the size returned by
+ *   clutter_offscreen_effect_get_target_size(), in which case the
+ *   target material uses a layer matrix so that the texture coordinates
+ *   between 0 and 1 still map to the contents of the offscreen
+ *   buffer.</para>
+ *   <para>If neither the actor nor any of its children queued a redraw
+ *   since the previous paint, and the actor is painted with the same
+ *   transformation, #ClutterOffscreenEffect does not redirect the actor
+ *   again: the actor is not painted at all, and only the
+ *   <function>paint_target()</function> function is called, with the
+ *   contents of the offscreen buffer left from the previous paint. For
+ *   this reason, sub-classes should change the target material only
+ *   from within <function>paint_target()</function>, or queue a redraw
+ *   on the actor when they need the offscreen buffer to be updated.</para>
  * </refsect2>
  *
  * #ClutterOffscreenEffect is available since Clutter 1.4
@@ -71,6 +88,7 @@
 
 #include "clutter-actor-private.h"
 #include "clutter-debug.h"
+#include "clutter-offscreen-effect-private.h"
 #include "clutter-private.h"
 #include "clutter-stage-private.h"
 
@@ -79,6 +97,12 @@ struct _ClutterOffscreenEffectPrivate
   CoglHandle offscreen;
   CoglMaterial *target;
 
+  /* the render target leased from the pool of the main context, if
+   * the sub-class does not create its own textures; it is held for as
+   * long as its contents can be painted again
+   */
+  ClutterOffscreenTarget *lease;
+
   ClutterActor *actor;
   ClutterActor *stage;
 
@@ -89,12 +113,34 @@ struct _ClutterOffscreenEffectPrivate
   gfloat target_height;
 
   gint old_opacity_override;
+
+  /* the state the offscreen buffer was last rendered with; if it does
+   * not change and the actor was not damaged in the meantime, the
+   * contents of the buffer are still valid and the redirection can be
+   * skipped
+   */
+  CoglMatrix cached_modelview;
+  CoglMatrix cached_projection;
+  gfloat cached_fbo_width;
+  gfloat cached_fbo_height;
+  gfloat cached_stage_width;
+  gfloat cached_stage_height;
+
+  guint cache_valid   : 1;
+
+  /* whether the current paint redirected the actor, or reuses the
+   * contents of the framebuffer
+   */
+  guint is_redirected : 1;
+  guint is_cached     : 1;
 };
 
 G_DEFINE_ABSTRACT_TYPE (ClutterOffscreenEffect,
                         clutter_offscreen_effect,
                         CLUTTER_TYPE_EFFECT);
 
+static void return_fbo (ClutterEffect *effect);
+
 static void
 clutter_offscreen_effect_set_actor (ClutterActorMeta *meta,
                                     ClutterActor     *actor)
@@ -107,6 +153,9 @@ clutter_offscreen_effect_set_actor (ClutterActorMeta *meta,
   meta_class->set_actor (meta, actor);
 
   /* clear out the previous state */
+  return_fbo (CLUTTER_EFFECT (meta));
+  priv->cache_valid = FALSE;
+
   if (priv->offscreen != COGL_INVALID_HANDLE)
     {
       cogl_handle_unref (priv->offscreen);
@@ -127,6 +176,79 @@ clutter_offscreen_effect_real_create_texture (ClutterOffscreenEffect *effect,
                                      COGL_PIXEL_FORMAT_RGBA_8888_PRE);
 }
 
+static gboolean
+lease_fbo (ClutterEffect *effect, int fbo_width, int fbo_height)
+{
+  ClutterOffscreenEffect *self = CLUTTER_OFFSCREEN_EFFECT (effect);
+  ClutterOffscreenEffectPrivate *priv = self->priv;
+  ClutterOffscreenPool *pool = _clutter_context_get_offscreen_pool ();
+  CoglMatrix matrix;
+
+  /* the effect might have been disabled while painting, in which case
+   * post_paint() was not called
+   */
+  return_fbo (effect);
+
+  priv->lease = _clutter_offscreen_pool_lease (pool,
+                                               fbo_width, fbo_height,
+                                               COGL_PIXEL_FORMAT_RGBA_8888_PRE);
+  if (priv->lease == NULL)
+    {
+      g_warning ("%s: Unable to create an Offscreen buffer", G_STRLOC);
+      return FALSE;
+    }
+
+  if (priv->target == COGL_INVALID_HANDLE)
+    priv->target = cogl_material_new ();
+
+  cogl_material_set_layer (priv->target, 0, priv->lease->texture);
+
+  /* the leased texture can be bigger than what we asked for, so we
+   * scale the texture coordinates to only cover the requested area;
+   * this way the sub-classes can keep painting the target using
+   * coordinates between 0 and 1
+   */
+  priv->target_width = MIN (MAX (fbo_width, 1), priv->lease->width);
+  priv->target_height = MIN (MAX (fbo_height, 1), priv->lease->height);
+
+  cogl_matrix_init_identity (&matrix);
+  cogl_matrix_scale (&matrix,
+                     priv->target_width / priv->lease->width,
+                     priv->target_height / priv->lease->height,
+                     1.0f);
+  cogl_material_set_layer_matrix (priv->target, 0, &matrix);
+
+  if (priv->offscreen != COGL_INVALID_HANDLE)
+    cogl_handle_unref (priv->offscreen);
+
+  priv->offscreen = cogl_handle_ref (priv->lease->offscreen);
+
+  return TRUE;
+}
+
+static void
+return_fbo (ClutterEffect *effect)
+{
+  ClutterOffscreenEffect *self = CLUTTER_OFFSCREEN_EFFECT (effect);
+  ClutterOffscreenEffectPrivate *priv = self->priv;
+
+  if (priv->lease == NULL)
+    return;
+
+  cogl_handle_unref (priv->offscreen);
+  priv->offscreen = COGL_INVALID_HANDLE;
+
+  /* the target material keeps a reference on the texture until the
+   * next paint, but the texture can be rendered to by another effect
+   * in the meantime
+   */
+  _clutter_offscreen_pool_return (_clutter_context_get_offscreen_pool (),
+                                  priv->lease);
+  priv->lease = NULL;
+
+  priv->cache_valid = FALSE;
+}
+
 static gboolean
 update_fbo (ClutterEffect *effect, int fbo_width, int fbo_height)
 {
@@ -144,6 +266,13 @@ update_fbo (ClutterEffect *effect, int fbo_width, int fbo_height)
       return FALSE;
     }
 
+  /* sub-classes creating their own textures keep their offscreen
+   * buffer; everyone else shares the pool of the main context
+   */
+  if (CLUTTER_OFFSCREEN_EFFECT_GET_CLASS (self)->create_texture ==
+      clutter_offscreen_effect_real_create_texture)
+    return lease_fbo (effect, fbo_width, fbo_height);
+
   if (priv->target_width == fbo_width &&
       priv->target_height == fbo_height &&
       priv->offscreen != COGL_INVALID_HANDLE)
@@ -187,6 +316,55 @@ update_fbo (ClutterEffect *effect, int fbo_width, int fbo_height)
   return TRUE;
 }
 
+/* checks whether the contents of the offscreen buffer, rendered by a
+ * previous paint, can be painted again instead of redirecting the actor
+ */
+static gboolean
+clutter_offscreen_effect_is_cache_valid (ClutterOffscreenEffect *self,
+                                         gfloat                  fbo_width,
+                                         gfloat                  fbo_height,
+                                         gfloat                  x_offset,
+                                         gfloat                  y_offset,
+                                         const CoglMatrix       *modelview)
+{
+  ClutterOffscreenEffectPrivate *priv = self->priv;
+  CoglMatrix projection;
+  gfloat width, height;
+
+  if (G_UNLIKELY (clutter_paint_debug_flags &
+                  CLUTTER_DEBUG_DISABLE_OFFSCREEN_CACHE))
+    return FALSE;
+
+  if (!priv->cache_valid || priv->offscreen == COGL_INVALID_HANDLE)
+    return FALSE;
+
+  /* the actor or one of its children queued a redraw */
+  if (_clutter_actor_is_subtree_damaged (priv->actor))
+    return FALSE;
+
+  if (priv->stage != _clutter_actor_get_stage_internal (priv->actor))
+    return FALSE;
+
+  if (fbo_width != priv->cached_fbo_width ||
+      fbo_height != priv->cached_fbo_height ||
+      x_offset != priv->x_offset ||
+      y_offset != priv->y_offset)
+    return FALSE;
+
+  clutter_actor_get_size (priv->stage, &width, &height);
+  if (width != priv->cached_stage_width ||
+      height != priv->cached_stage_height)
+    return FALSE;
+
+  if (!cogl_matrix_equal (modelview, &priv->cached_modelview))
+    return FALSE;
+
+  _clutter_stage_get_projection_matrix (CLUTTER_STAGE (priv->stage),
+                                        &projection);
+
+  return cogl_matrix_equal (&projection, &priv->cached_projection);
+}
+
 static gboolean
 clutter_offscreen_effect_pre_paint (ClutterEffect *effect)
 {
@@ -197,9 +375,13 @@ clutter_offscreen_effect_pre_paint (ClutterEffect *effect)
   CoglColor transparent;
   CoglMatrix modelview;
   gfloat fbo_width, fbo_height;
+  gfloat x_offset, y_offset;
   gfloat width, height;
   gfloat xexpand, yexpand;
 
+  priv->is_redirected = FALSE;
+  priv->is_cached = FALSE;
+
   if (!clutter_actor_meta_get_enabled (CLUTTER_ACTOR_META (effect)))
     return FALSE;
 
@@ -213,7 +395,7 @@ clutter_offscreen_effect_pre_paint (ClutterEffect *effect)
   if (clutter_actor_get_paint_box (priv->actor, &box))
     {
       clutter_actor_box_get_size (&box, &fbo_width, &fbo_height);
-      clutter_actor_box_get_origin (&box, &priv->x_offset, &priv->y_offset);
+      clutter_actor_box_get_origin (&box, &x_offset, &y_offset);
     }
   else
     {
@@ -221,26 +403,54 @@ clutter_offscreen_effect_pre_paint (ClutterEffect *effect)
        * creating a full stage size fbo. */
       ClutterActor *stage = _clutter_actor_get_stage_internal (priv->actor);
       clutter_actor_get_size (stage, &fbo_width, &fbo_height);
-      priv->x_offset = 0.0f;
-      priv->y_offset = 0.0f;
+      x_offset = 0.0f;
+      y_offset = 0.0f;
     }
 
-  /* First assert that the framebuffer is the right size... */
-  if (!update_fbo (effect, fbo_width, fbo_height))
-    return FALSE;
-
   /* get the current modelview matrix so that we can copy it
    * to the framebuffer
    */
   cogl_get_modelview_matrix (&modelview);
 
+  /* If nothing changed since the last time the actor was redirected
+   * then we can skip painting it, and post_paint() will only paint
+   * the target material */
+  if (clutter_offscreen_effect_is_cache_valid (self,
+                                               fbo_width, fbo_height,
+                                               x_offset, y_offset,
+                                               &modelview))
+    {
+      priv->is_cached = TRUE;
+      return TRUE;
+    }
+
+  priv->x_offset = x_offset;
+  priv->y_offset = y_offset;
+
+  /* the contents of the framebuffer only become valid again once
+   * post_paint() has been called */
+  priv->cache_valid = FALSE;
+
+  /* First assert that the framebuffer is the right size... */
+  if (!update_fbo (effect, fbo_width, fbo_height))
+    return FALSE;
+
+  /* Keep the state we are rendering with, so that the next paint can
+   * check whether the contents of the framebuffer are still valid */
+  priv->cached_modelview = modelview;
+  priv->cached_fbo_width = fbo_width;
+  priv->cached_fbo_height = fbo_height;
+
   /* let's draw offscreen */
   cogl_push_framebuffer (priv->offscreen);
+  priv->is_redirected = TRUE;
 
   /* Set up the viewport so that it has the same size as the stage,
    * but offset it so that the actor of interest lands on our
    * framebuffer. */
   clutter_actor_get_size (priv->stage, &width, &height);
+  priv->cached_stage_width = width;
+  priv->cached_stage_height = height;
 
   /* Expand the viewport if the actor is partially off-stage,
    * otherwise the actor will end up clipped to the stage viewport
@@ -265,6 +475,7 @@ clutter_offscreen_effect_pre_paint (ClutterEffect *effect)
   _clutter_stage_get_projection_matrix (CLUTTER_STAGE (priv->stage),
                                         &projection);
   cogl_set_projection_matrix (&projection);
+  priv->cached_projection = projection;
 
   /* If we've expanded the viewport, make sure to scale the modelview
    * matrix accordingly (as it's been initialised to work with the
@@ -348,8 +559,25 @@ clutter_offscreen_effect_post_paint (ClutterEffect *effect)
       priv->actor == NULL)
     return;
 
-  cogl_pop_matrix ();
-  cogl_pop_framebuffer ();
+  /* pre_paint() might have failed while another effect of the actor
+   * did not */
+  if (!priv->is_redirected && !priv->is_cached)
+    return;
+
+  if (priv->is_redirected)
+    {
+      cogl_pop_matrix ();
+      cogl_pop_framebuffer ();
+
+      /* Restore the previous opacity override */
+      _clutter_actor_set_opacity_override (priv->actor,
+                                           priv->old_opacity_override);
+
+      /* the contents of the framebuffer can be reused until the
+       * actor is damaged or painted with a different transformation
+       */
+      priv->cache_valid = TRUE;
+    }
 
   cogl_push_matrix ();
 
@@ -362,15 +590,15 @@ clutter_offscreen_effect_post_paint (ClutterEffect *effect)
   cogl_matrix_translate (&modelview, priv->x_offset, priv->y_offset, 0.0f);
   cogl_set_modelview_matrix (&modelview);
 
-  /* Restore the previous opacity override */
-  _clutter_actor_set_opacity_override (priv->actor, priv->old_opacity_override);
-
   /* paint the target material; this is virtualized for
    * sub-classes that require special hand-holding
    */
   clutter_offscreen_effect_paint_target (self);
 
   cogl_pop_matrix ();
+
+  priv->is_redirected = FALSE;
+  priv->is_cached = FALSE;
 }
 
 static void
@@ -379,6 +607,8 @@ clutter_offscreen_effect_finalize (GObject *gobject)
   ClutterOffscreenEffect *self = CLUTTER_OFFSCREEN_EFFECT (gobject);
   ClutterOffscreenEffectPrivate *priv = self->priv;
 
+  return_fbo (CLUTTER_EFFECT (self));
+
   if (priv->offscreen)
     cogl_handle_unref (priv->offscreen);
 
@@ -426,6 +656,11 @@ clutter_offscreen_effect_init (ClutterOffscreenEffect *self)
  * You should only use the returned #CoglMaterial when painting. The
  * returned material might change between different frames.
  *
+ * The texture of the returned material might be bigger than the size
+ * returned by clutter_offscreen_effect_get_target_size(), in which case
+ * the material has a layer matrix mapping the texture coordinates
+ * between 0 and 1 to the contents of the offscreen buffer.
+ *
  * Return value: (transfer none): a #CoglMaterial or %NULL. The
  *   returned material is owned by Clutter and it should not be
  *   modified or freed
@@ -524,3 +759,78 @@ clutter_offscreen_effect_get_target_size (ClutterOffscreenEffect *effect,
 
   return TRUE;
 }
+
+/*
+ * _clutter_offscreen_effect_get_target_coords:
+ * @effect: a #ClutterOffscreenEffect
+ * @s_2: (out): return location for the horizontal texture coordinate
+ *   of the right edge of the offscreen buffer contents
+ * @t_2: (out): return location for the vertical texture coordinate
+ *   of the bottom edge of the offscreen buffer contents
+ *
+ * Retrieves the texture coordinates, after the layer matrix of the
+ * target material has been applied, of the bottom right corner of the
+ * offscreen buffer contents. This is useful for shaders that need the
+ * size of a texel of the target texture
+ */
+void
+_clutter_offscreen_effect_get_target_coords (ClutterOffscreenEffect *effect,
+                                             gfloat                 *s_2,
+                                             gfloat                 *t_2)
+{
+  ClutterOffscreenEffectPrivate *priv = effect->priv;
+
+  *s_2 = *t_2 = 1.0f;
+
+  if (priv->lease == NULL)
+    return;
+
+  *s_2 = priv->target_width / priv->lease->width;
+  *t_2 = priv->target_height / priv->lease->height;
+}
+
+/*
+ * _clutter_offscreen_effect_is_cached:
+ * @effect: a #ClutterOffscreenEffect
+ *
+ * Checks whether the current paint of @effect reuses the contents of
+ * the offscreen buffer rendered by a previous paint. This is only
+ * meaningful between the pre_paint() and the post_paint() of @effect,
+ * and if it returns %TRUE the actor does not need to be painted.
+ *
+ * Return value: %TRUE if the actor was not redirected offscreen
+ */
+gboolean
+_clutter_offscreen_effect_is_cached (ClutterOffscreenEffect *effect)
+{
+  return effect->priv->is_cached;
+}
+
+/*
+ * _clutter_offscreen_effect_get_target_texture:
+ * @effect: a #ClutterOffscreenEffect
+ *
+ * Retrieves the texture the actor is redirected to. The contents of
+ * the offscreen buffer are in the area of the texture going from (0, 0)
+ * to the coordinates returned by _clutter_offscreen_effect_get_target_coords()
+ *
+ * Return value: (transfer none): the target texture, or %COGL_INVALID_HANDLE
+ */
+CoglHandle
+_clutter_offscreen_effect_get_target_texture (ClutterOffscreenEffect *effect)
+{
+  ClutterOffscreenEffectPrivate *priv = effect->priv;
+  const GList *layers;
+
+  if (priv->lease != NULL)
+    return priv->lease->texture;
+
+  if (priv->target == COGL_INVALID_HANDLE)
+    return COGL_INVALID_HANDLE;
+
+  layers = cogl_material_get_layers (priv->target);
+  if (layers == NULL)
+    return COGL_INVALID_HANDLE;
+
+  return cogl_material_layer_get_texture (layers->data);
+}
@@ -0,0 +1,283 @@
+/*
+ * Clutter.
+ *
+ * An OpenGL based 'interactive canvas' library.
+ *
+ * Copyright (C) 2011 Intel Corporation
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ClutterOffscreenPool: pool of reusable offscreen render targets.
+ *
+ * Creating a texture and a framebuffer object is expensive, and effects
+ * redirecting an actor offscreen only need them while the actor is being
+ * painted. The pool keeps the targets that are not in use, and hands
+ * them out again to any effect asking for a target of a similar size,
+ * so that animating the size of an actor or applying effects to many
+ * actors does not allocate new GPU memory on every frame.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "clutter-offscreen-pool.h"
+
+#include "clutter-debug.h"
+#include "clutter-profile.h"
+
+/* the smallest size of a target; below this the bookkeeping costs more
+ * than the wasted memory
+ */
+#define MIN_TARGET_SIZE         16
+
+struct _ClutterOffscreenPool
+{
+  /* the idle targets, the most recently returned first */
+  GQueue idle;
+
+  /* the maximum amount of texture memory held by the idle targets */
+  gsize max_idle_bytes;
+  gsize idle_bytes;
+
+  ClutterOffscreenPoolStats stats;
+};
+
+/* rounds @size up to the next value of the form 2^n or 3 * 2^(n - 2),
+ * so that sizes close to each other share the same targets while at
+ * most a third of each dimension goes unused
+ */
+static gint
+get_bucket_size (gint size)
+{
+  gint p2 = MIN_TARGET_SIZE;
+
+  while (p2 < size)
+    p2 <<= 1;
+
+  if (p2 > MIN_TARGET_SIZE && (p2 / 4) * 3 >= size)
+    return (p2 / 4) * 3;
+
+  return p2;
+}
+
+static void
+clutter_offscreen_target_free (ClutterOffscreenTarget *target)
+{
+  cogl_handle_unref (target->offscreen);
+  cogl_handle_unref (target->texture);
+
+  g_slice_free (ClutterOffscreenTarget, target);
+}
+
+static ClutterOffscreenTarget *
+clutter_offscreen_target_new (gint            width,
+                              gint            height,
+                              CoglPixelFormat format)
+{
+  ClutterOffscreenTarget *target;
+  CoglHandle texture, offscreen;
+
+  texture = cogl_texture_new_with_size (width, height,
+                                        COGL_TEXTURE_NO_SLICING,
+                                        format);
+  if (texture == COGL_INVALID_HANDLE)
+    return NULL;
+
+  offscreen = cogl_offscreen_new_to_texture (texture);
+  if (offscreen == COGL_INVALID_HANDLE)
+    {
+      cogl_handle_unref (texture);
+      return NULL;
+    }
+
+  target = g_slice_new (ClutterOffscreenTarget);
+  target->texture = texture;
+  target->offscreen = offscreen;
+  target->format = format;
+  target->width = cogl_texture_get_width (texture);
+  target->height = cogl_texture_get_height (texture);
+  target->n_bytes = (gsize) cogl_texture_get_rowstride (texture)
+                  * target->height;
+
+  return target;
+}
+
+ClutterOffscreenPool *
+_clutter_offscreen_pool_new (gsize max_idle_bytes)
+{
+  ClutterOffscreenPool *pool;
+
+  pool = g_slice_new0 (ClutterOffscreenPool);
+  g_queue_init (&pool->idle);
+  pool->max_idle_bytes = max_idle_bytes;
+
+  return pool;
+}
+
+void
+_clutter_offscreen_pool_free (ClutterOffscreenPool *pool)
+{
+  g_return_if_fail (pool != NULL);
+
+  if (pool->stats.n_leased != 0)
+    g_warning ("%s: %u offscreen targets are still leased",
+               G_STRLOC,
+               pool->stats.n_leased);
+
+  g_queue_foreach (&pool->idle, (GFunc) clutter_offscreen_target_free, NULL);
+  g_queue_clear (&pool->idle);
+
+  g_slice_free (ClutterOffscreenPool, pool);
+}
+
+/*
+ * _clutter_offscreen_pool_lease:
+ * @pool: a #ClutterOffscreenPool
+ * @width: the minimum width of the target
+ * @height: the minimum height of the target
+ * @format: the pixel format of the target
+ *
+ * Leases a render target at least as big as @width by @height, either
+ * reusing an idle target of the pool or creating a new one. The target
+ * must be given back using _clutter_offscreen_pool_return() as soon as
+ * it is not needed any more.
+ *
+ * The contents of the returned target are undefined.
+ *
+ * Return value: a render target, or %NULL if no target could be created
+ */
+ClutterOffscreenTarget *
+_clutter_offscreen_pool_lease (ClutterOffscreenPool *pool,
+                               gint                  width,
+                               gint                  height,
+                               CoglPixelFormat       format)
+{
+  ClutterOffscreenTarget *target;
+  gint bucket_width, bucket_height;
+  GList *l;
+  CLUTTER_STATIC_COUNTER (offscreen_pool_hits,
+                          "Offscreen pool hits",
+                          "Increments each time an idle offscreen target "
+                          "is reused",
+                          0 /* no application private data */);
+  CLUTTER_STATIC_COUNTER (offscreen_pool_misses,
+                          "Offscreen pool misses",
+                          "Increments each time a new offscreen target "
+                          "is created",
+                          0 /* no application private data */);
+
+  g_return_val_if_fail (pool != NULL, NULL);
+
+  width = MAX (width, 1);
+  height = MAX (height, 1);
+
+  bucket_width = get_bucket_size (width);
+  bucket_height = get_bucket_size (height);
+
+  /* any idle target that fits without being bigger than the bucket
+   * will do, so that the occasional target created with the exact
+   * requested size can be reused as well
+   */
+  for (l = pool->idle.head; l != NULL; l = l->next)
+    {
+      target = l->data;
+
+      if (target->format == format &&
+          target->width >= width && target->width <= bucket_width &&
+          target->height >= height && target->height <= bucket_height)
+        {
+          g_queue_delete_link (&pool->idle, l);
+          pool->idle_bytes -= target->n_bytes;
+
+          pool->stats.n_leased += 1;
+          pool->stats.n_hits += 1;
+          CLUTTER_COUNTER_INC (_clutter_uprof_context, offscreen_pool_hits);
+
+          return target;
+        }
+    }
+
+  target = clutter_offscreen_target_new (bucket_width, bucket_height, format);
+
+  /* the rounded up size might be too big for the GL implementation even
+   * if the requested one is not
+   */
+  if (target == NULL &&
+      (bucket_width != width || bucket_height != height))
+    target = clutter_offscreen_target_new (width, height, format);
+
+  if (target == NULL)
+    return NULL;
+
+  CLUTTER_NOTE (PAINT, "Created a %dx%d offscreen target (%d idle)",
+                target->width,
+                target->height,
+                pool->idle.length);
+
+  pool->stats.n_targets += 1;
+  pool->stats.n_leased += 1;
+  pool->stats.n_misses += 1;
+  pool->stats.n_bytes += target->n_bytes;
+  CLUTTER_COUNTER_INC (_clutter_uprof_context, offscreen_pool_misses);
+
+  return target;
+}
+
+/*
+ * _clutter_offscreen_pool_return:
+ * @pool: a #ClutterOffscreenPool
+ * @target: a target leased from @pool
+ *
+ * Gives @target back to @pool, so that it can be leased again. If the
+ * idle targets use more memory than allowed, the ones that have been
+ * idle for the longest time are destroyed.
+ */
+void
+_clutter_offscreen_pool_return (ClutterOffscreenPool   *pool,
+                                ClutterOffscreenTarget *target)
+{
+  g_return_if_fail (pool != NULL);
+  g_return_if_fail (target != NULL);
+  g_return_if_fail (pool->stats.n_leased > 0);
+
+  g_queue_push_head (&pool->idle, target);
+  pool->idle_bytes += target->n_bytes;
+  pool->stats.n_leased -= 1;
+
+  while (pool->idle_bytes > pool->max_idle_bytes)
+    {
+      ClutterOffscreenTarget *oldest = g_queue_pop_tail (&pool->idle);
+
+      CLUTTER_NOTE (PAINT, "Destroying a %dx%d idle offscreen target",
+                    oldest->width,
+                    oldest->height);
+
+      pool->idle_bytes -= oldest->n_bytes;
+      pool->stats.n_targets -= 1;
+      pool->stats.n_bytes -= oldest->n_bytes;
+
+      clutter_offscreen_target_free (oldest);
+    }
+}
+
+void
+_clutter_offscreen_pool_get_stats (ClutterOffscreenPool      *pool,
+                                   ClutterOffscreenPoolStats *stats)
+{
+  g_return_if_fail (pool != NULL);
+  g_return_if_fail (stats != NULL);
+
+  *stats = pool->stats;
+}
@@ -0,0 +1,84 @@
+/*
+ * Clutter.
+ *
+ * An OpenGL based 'interactive canvas' library.
+ *
+ * Copyright (C) 2011 Intel Corporation
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * ClutterOffscreenPool: pool of reusable offscreen render targets.
+ */
+
+#ifndef __CLUTTER_OFFSCREEN_POOL_H__
+#define __CLUTTER_OFFSCREEN_POOL_H__
+
+#include <glib.h>
+#include <cogl/cogl.h>
+
+G_BEGIN_DECLS
+
+typedef struct _ClutterOffscreenPool            ClutterOffscreenPool;
+typedef struct _ClutterOffscreenTarget          ClutterOffscreenTarget;
+typedef struct _ClutterOffscreenPoolStats       ClutterOffscreenPoolStats;
+
+struct _ClutterOffscreenTarget
+{
+  /* the texture and the framebuffer redirecting to it; the texture
+   * can be bigger than the size requested when leasing the target,
+   * in which case the requested area is at its top left corner
+   */
+  CoglHandle texture;
+  CoglHandle offscreen;
+
+  CoglPixelFormat format;
+  gint width;
+  gint height;
+
+  /* the amount of texture memory used by the target */
+  gsize n_bytes;
+};
+
+struct _ClutterOffscreenPoolStats
+{
+  /* the number of targets, leased or idle */
+  guint n_targets;
+  guint n_leased;
+
+  /* the number of leases that reused an idle target, and the number
+   * of leases that had to create a new one
+   */
+  gulong n_hits;
+  gulong n_misses;
+
+  /* the texture memory held by the targets, leased or idle */
+  gsize n_bytes;
+};
+
+ClutterOffscreenPool *  _clutter_offscreen_pool_new       (gsize                      max_idle_bytes);
+void                    _clutter_offscreen_pool_free      (ClutterOffscreenPool      *pool);
+
+ClutterOffscreenTarget *_clutter_offscreen_pool_lease     (ClutterOffscreenPool      *pool,
+                                                           gint                       width,
+                                                           gint                       height,
+                                                           CoglPixelFormat            format);
+void                    _clutter_offscreen_pool_return    (ClutterOffscreenPool      *pool,
+                                                           ClutterOffscreenTarget    *target);
+
+void                    _clutter_offscreen_pool_get_stats (ClutterOffscreenPool      *pool,
+                                                           ClutterOffscreenPoolStats *stats);
+
+G_END_DECLS
+
+#endif /* __CLUTTER_OFFSCREEN_POOL_H__ */
@@ -271,6 +271,9 @@ clutter_page_turn_effect_init (ClutterPageTurnEffect *self)
   self->period = 0.0;
   self->angle = 0.0;
   self->radius = 24.0f;
+
+  /* deform_vertex() only reads the fields above */
+  clutter_deform_effect_set_threaded (CLUTTER_DEFORM_EFFECT (self), TRUE);
 }
 
 /**
@@ -71,6 +71,13 @@
  * in a string using a subset of the SVG path syntax. See
  * clutter_path_add_string() for details.
  *
+ * Positions along the path are computed from a table of the distance
+ * covered at the end of each node, and curves are sampled into a table
+ * of their arc length, so that the position of an actor moving along
+ * the path advances at a constant speed. Both tables are computed once
+ * every time the path changes; clutter_path_get_positions() can be used
+ * to retrieve many positions, for instance for particles, in one call.
+ *
  * #ClutterPath is available since Clutter 1.0
  */
 
@@ -109,6 +116,11 @@ enum
 
 static GParamSpec *obj_props[PROP_LAST];
 
+/* the number of segments each curve is split into to approximate its
+ * arc length
+ */
+#define CLUTTER_PATH_CURVE_SAMPLES      32
+
 typedef struct _ClutterPathNodeFull ClutterPathNodeFull;
 
 struct _ClutterPathNodeFull
@@ -117,7 +129,10 @@ struct _ClutterPathNodeFull
 
   ClutterBezier *bezier;
 
-  guint length;
+  /* for curves, the length of the curve at each sample */
+  gfloat *arc_lengths;
+
+  gfloat length;
 };
 
 struct _ClutterPathPrivate
@@ -125,7 +140,14 @@ struct _ClutterPathPrivate
   GSList *nodes, *nodes_tail;
   gboolean nodes_dirty;
 
-  guint total_length;
+  /* the nodes in an array, and the distance along the path at the
+   * end of each node, for binary searching the node at a position
+   */
+  ClutterPathNodeFull **node_array;
+  gfloat *node_ends;
+  guint n_node_array;
+
+  gfloat total_length;
 };
 
 /* Character tests that don't pay attention to the locale */
@@ -256,6 +278,9 @@ clutter_path_finalize (GObject *object)
 
   clutter_path_clear (self);
 
+  g_free (self->priv->node_array);
+  g_free (self->priv->node_ends);
+
   G_OBJECT_CLASS (clutter_path_parent_class)->finalize (object);
 }
 
@@ -1244,11 +1269,11 @@ clutter_path_get_description (ClutterPath *path)
   return g_string_free (str, FALSE);
 }
 
-static gint
+static gfloat
 clutter_path_node_distance (const ClutterKnot *start,
                             const ClutterKnot *end)
 {
-  gint t;
+  gfloat dx, dy;
 
   g_return_val_if_fail (start != NULL, 0);
   g_return_val_if_fail (end != NULL, 0);
@@ -1256,21 +1281,42 @@ clutter_path_node_distance (const ClutterKnot *start,
   if (clutter_knot_equal (start, end))
     return 0;
 
-  t = (end->x - start->x) * (end->x - start->x) +
-    (end->y - start->y) * (end->y - start->y);
+  dx = end->x - start->x;
+  dy = end->y - start->y;
 
-  /*
-   * If we are using limited precision sqrti implementation, fallback on
-   * clib sqrt if the precission would be less than 10%
-   */
-#if INT_MAX > COGL_SQRTI_ARG_10_PERCENT
-  if (t <= COGL_SQRTI_ARG_10_PERCENT)
-    return cogl_sqrti (t);
-  else
-    return COGL_FLOAT_TO_INT (sqrtf(t));
-#else
-  return cogl_sqrti (t);
-#endif
+  return sqrtf (dx * dx + dy * dy);
+}
+
+/* samples the bezier of a curve node and stores the length of the
+ * curve at each sample, returning the length of the whole curve
+ */
+static gfloat
+clutter_path_node_update_arc_lengths (ClutterPathNodeFull *node)
+{
+  gfloat x, y, prev_x, prev_y;
+  gint i;
+
+  if (node->arc_lengths == NULL)
+    node->arc_lengths = g_new (gfloat, CLUTTER_PATH_CURVE_SAMPLES + 1);
+
+  _clutter_bezier_get_point (node->bezier, 0.0f, &prev_x, &prev_y);
+  node->arc_lengths[0] = 0.0f;
+
+  for (i = 1; i <= CLUTTER_PATH_CURVE_SAMPLES; i++)
+    {
+      gfloat t = (gfloat) i / CLUTTER_PATH_CURVE_SAMPLES;
+
+      _clutter_bezier_get_point (node->bezier, t, &x, &y);
+
+      node->arc_lengths[i] = node->arc_lengths[i - 1]
+                           + sqrtf ((x - prev_x) * (x - prev_x)
+                                    + (y - prev_y) * (y - prev_y));
+
+      prev_x = x;
+      prev_y = y;
+    }
+
+  return node->arc_lengths[CLUTTER_PATH_CURVE_SAMPLES];
 }
 
 static void
@@ -1285,6 +1331,7 @@ clutter_path_ensure_node_data (ClutterPath *path)
       ClutterKnot last_position = { 0, 0 };
       ClutterKnot loop_start = { 0, 0 };
       ClutterKnot points[3];
+      guint i;
 
       priv->total_length = 0;
 
@@ -1358,7 +1405,7 @@ clutter_path_ensure_node_data (ClutterPath *path)
 
               last_position = points[2];
 
-              node->length = _clutter_bezier_get_length (node->bezier);
+              node->length = clutter_path_node_update_arc_lengths (node);
 
               break;
 
@@ -1376,10 +1423,126 @@ clutter_path_ensure_node_data (ClutterPath *path)
           priv->total_length += node->length;
         }
 
+      /* rebuild the table of the node ends */
+      priv->n_node_array = g_slist_length (priv->nodes);
+      priv->node_array = g_renew (ClutterPathNodeFull *,
+                                  priv->node_array,
+                                  priv->n_node_array);
+      priv->node_ends = g_renew (gfloat,
+                                 priv->node_ends,
+                                 priv->n_node_array);
+
+      for (l = priv->nodes, i = 0; l; l = l->next, i++)
+        {
+          ClutterPathNodeFull *node = l->data;
+
+          priv->node_array[i] = node;
+          priv->node_ends[i] = node->length
+                             + (i > 0 ? priv->node_ends[i - 1] : 0.0f);
+        }
+
       priv->nodes_dirty = FALSE;
     }
 }
 
+/* computes the position at @distance along the path, which must
+ * not be empty, returning the index of the node used
+ */
+static guint
+clutter_path_get_position_at_distance (ClutterPath *path,
+                                       gfloat       distance,
+                                       ClutterKnot *position)
+{
+  ClutterPathPrivate *priv = path->priv;
+  ClutterPathNodeFull *node;
+  guint lo, hi, node_num;
+  gfloat node_start;
+
+  /* Find the first node ending after this point, or the last node */
+  lo = 0;
+  hi = priv->n_node_array - 1;
+  while (lo < hi)
+    {
+      guint mid = (lo + hi) / 2;
+
+      if (distance >= priv->node_ends[mid])
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  node_num = lo;
+  node = priv->node_array[node_num];
+
+  /* Convert the point distance to a distance along the node */
+  node_start = node_num > 0 ? priv->node_ends[node_num - 1] : 0.0f;
+  distance = CLAMP (distance - node_start, 0.0f, node->length);
+
+  switch (node->k.type & ~CLUTTER_PATH_RELATIVE)
+    {
+    case CLUTTER_PATH_MOVE_TO:
+      *position = node->k.points[1];
+      break;
+
+    case CLUTTER_PATH_LINE_TO:
+    case CLUTTER_PATH_CLOSE:
+      if (node->length == 0)
+        *position = node->k.points[1];
+      else
+        {
+          gfloat t = distance / node->length;
+
+          position->x = floorf (node->k.points[1].x
+                                + (node->k.points[2].x - node->k.points[1].x)
+                                * t + 0.5f);
+          position->y = floorf (node->k.points[1].y
+                                + (node->k.points[2].y - node->k.points[1].y)
+                                * t + 0.5f);
+        }
+      break;
+
+    case CLUTTER_PATH_CURVE_TO:
+      if (node->length == 0)
+        *position = node->k.points[2];
+      else
+        {
+          const gfloat *arc_lengths = node->arc_lengths;
+          gfloat x, y, t, segment;
+          guint i;
+
+          /* Find the sample covering this point and interpolate the
+             bezier parameter linearly within it */
+          lo = 1;
+          hi = CLUTTER_PATH_CURVE_SAMPLES;
+          while (lo < hi)
+            {
+              guint mid = (lo + hi) / 2;
+
+              if (distance > arc_lengths[mid])
+                lo = mid + 1;
+              else
+                hi = mid;
+            }
+
+          i = lo;
+          segment = arc_lengths[i] - arc_lengths[i - 1];
+
+          t = i - 1;
+          if (segment > 0)
+            t += (distance - arc_lengths[i - 1]) / segment;
+          t /= CLUTTER_PATH_CURVE_SAMPLES;
+
+          _clutter_bezier_get_point (node->bezier, t, &x, &y);
+
+          position->x = floorf (x + 0.5f);
+          position->y = floorf (y + 0.5f);
+        }
+      break;
+    }
+
+  return node_num;
+}
+
 /**
  * clutter_path_get_position:
  * @path: a #ClutterPath
@@ -1400,9 +1563,6 @@ clutter_path_get_position (ClutterPath *path,
                            ClutterKnot *position)
 {
   ClutterPathPrivate *priv;
-  GSList *l;
-  guint point_distance, length = 0, node_num = 0;
-  ClutterPathNodeFull *node;
 
   g_return_val_if_fail (CLUTTER_IS_PATH (path), 0);
   g_return_val_if_fail (progress >= 0.0 && progress <= 1.0, 0);
@@ -1420,60 +1580,59 @@ clutter_path_get_position (ClutterPath *path,
     }
 
   /* Convert the progress to a length along the path */
-  point_distance = progress * priv->total_length;
+  return clutter_path_get_position_at_distance (path,
+                                                progress * priv->total_length,
+                                                position);
+}
 
-  /* Find the node that covers this point */
-  for (l = priv->nodes;
-       l->next && point_distance >= (((ClutterPathNodeFull *) l->data)->length
-                                     + length);
-       l = l->next)
-    {
-      length += ((ClutterPathNodeFull *) l->data)->length;
-      node_num++;
-    }
+/**
+ * clutter_path_get_positions:
+ * @path: a #ClutterPath
+ * @progress: (array length=n_positions): positions along the path as
+ *   fractions of its length
+ * @n_positions: the number of positions to compute
+ * @positions: (array length=n_positions) (out caller-allocates): return
+ *   location for the positions
+ *
+ * Computes many positions along the path at once; this is equivalent
+ * to calling clutter_path_get_position() on every element of
+ * @progress, but it avoids checking the path every time.
+ *
+ * The values in @progress are clamped between 0.0 and 1.0.
+ *
+ * Since: 1.8
+ */
+void
+clutter_path_get_positions (ClutterPath   *path,
+                            const gdouble *progress,
+                            guint          n_positions,
+                            ClutterKnot   *positions)
+{
+  ClutterPathPrivate *priv;
+  guint i;
 
-  node = l->data;
+  g_return_if_fail (CLUTTER_IS_PATH (path));
+  g_return_if_fail (n_positions == 0 || progress != NULL);
+  g_return_if_fail (n_positions == 0 || positions != NULL);
 
-  /* Convert the point distance to a distance along the node */
-  point_distance -= length;
-  if (point_distance > node->length)
-    point_distance = node->length;
+  priv = path->priv;
 
-  switch (node->k.type & ~CLUTTER_PATH_RELATIVE)
+  clutter_path_ensure_node_data (path);
+
+  if (priv->nodes == NULL)
     {
-    case CLUTTER_PATH_MOVE_TO:
-      *position = node->k.points[1];
-      break;
+      memset (positions, 0, sizeof (ClutterKnot) * n_positions);
+      return;
+    }
 
-    case CLUTTER_PATH_LINE_TO:
-    case CLUTTER_PATH_CLOSE:
-      if (node->length == 0)
-        *position = node->k.points[1];
-      else
-        {
-          position->x = (node->k.points[1].x
-                         + ((node->k.points[2].x - node->k.points[1].x)
-                            * (gint) point_distance / (gint) node->length));
-          position->y = (node->k.points[1].y
-                         + ((node->k.points[2].y - node->k.points[1].y)
-                            * (gint) point_distance / (gint) node->length));
-        }
-      break;
+  for (i = 0; i < n_positions; i++)
+    {
+      gdouble p = CLAMP (progress[i], 0.0, 1.0);
 
-    case CLUTTER_PATH_CURVE_TO:
-      if (node->length == 0)
-        *position = node->k.points[2];
-      else
-        {
-          _clutter_bezier_advance (node->bezier,
-                                   point_distance * CLUTTER_BEZIER_MAX_LENGTH
-                                   / node->length,
-                                   position);
-        }
-      break;
+      clutter_path_get_position_at_distance (path,
+                                             p * priv->total_length,
+                                             positions + i);
     }
-
-  return node_num;
 }
 
 /**
@@ -1493,7 +1652,7 @@ clutter_path_get_length (ClutterPath *path)
 
   clutter_path_ensure_node_data (path);
 
-  return path->priv->total_length;
+  return (guint) (path->priv->total_length + 0.5f);
 }
 
 static ClutterPathNodeFull *
@@ -1508,6 +1667,8 @@ clutter_path_node_full_free (ClutterPathNodeFull *node)
   if (node->bezier)
     _clutter_bezier_free (node->bezier);
 
+  g_free (node->arc_lengths);
+
   g_slice_free (ClutterPathNodeFull, node);
 }
 
@@ -206,6 +206,10 @@ void         clutter_path_to_cairo_path        (ClutterPath           *path,
 guint        clutter_path_get_position         (ClutterPath           *path,
                                                 gdouble                progress,
                                                 ClutterKnot           *position);
+void         clutter_path_get_positions        (ClutterPath           *path,
+                                                const gdouble         *progress,
+                                                guint                  n_positions,
+                                                ClutterKnot           *positions);
 guint        clutter_path_get_length           (ClutterPath           *path);
 
 ClutterPathNode *clutter_path_node_copy  (const ClutterPathNode *node);
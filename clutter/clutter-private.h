@@ -39,6 +39,7 @@
 #include "clutter-id-pool.h"
 #include "clutter-layout-manager.h"
 #include "clutter-master-clock.h"
+#include "clutter-offscreen-pool.h"
 #include "clutter-settings.h"
 #include "clutter-stage.h"
 
@@ -160,6 +161,9 @@ struct _ClutterMainContext
   /* main settings singleton */
   ClutterSettings *settings;
 
+  /* render targets shared by the offscreen effects */
+  ClutterOffscreenPool *offscreen_pool;
+
   /* boolean flags */
   guint is_initialized          : 1;
   guint motion_events_per_actor : 1;
@@ -188,6 +192,8 @@ ClutterActor *          _clutter_context_pop_shader_stack       (ClutterActor *a
 ClutterActor *          _clutter_context_peek_shader_stack      (void);
 guint32                 _clutter_context_acquire_id             (gpointer      key);
 void                    _clutter_context_release_id             (guint32       id_);
+ClutterOffscreenPool *  _clutter_context_get_offscreen_pool     (void);
+void                    _clutter_context_free_offscreen_pool    (void);
 
 G_CONST_RETURN gchar *_clutter_gettext (const gchar *str);
 
@@ -213,6 +219,8 @@ gboolean _clutter_boolean_handled_accumulator (GSignalInvocationHint *ihint,
 
 void _clutter_run_repaint_functions (void);
 
+guint _clutter_get_n_workers (void);
+
 void _clutter_constraint_update_allocation (ClutterConstraint *constraint,
                                             ClutterActor      *actor,
                                             ClutterActorBox   *allocation);
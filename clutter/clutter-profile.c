@@ -2,6 +2,7 @@
 #ifdef CLUTTER_ENABLE_PROFILE
 
 #include "clutter-profile.h"
+#include "clutter-private.h"
 
 #include <stdlib.h>
 
@@ -18,8 +19,25 @@ typedef struct _ClutterUProfReportState
   float fps;
   gulong n_picks;
   float msecs_picking;
+  ClutterOffscreenPoolStats offscreen_pool;
 } ClutterUProfReportState;
 
+/* the histogram of the time between the kernel timestamp of an input
+ * event and its dispatch; the upper bound of bucket N is 2^N msecs,
+ * and the last bucket holds everything else
+ */
+#define N_LATENCY_BUCKETS       8
+
+static const char *latency_bucket_names[N_LATENCY_BUCKETS] = {
+  "<= 1ms", "<= 2ms", "<= 4ms", "<= 8ms",
+  "<= 16ms", "<= 32ms", "<= 64ms", "> 64ms"
+};
+
+static gulong input_latency_buckets[N_LATENCY_BUCKETS];
+static gulong input_latency_count = 0;
+static guint64 input_latency_total = 0;
+static guint32 input_latency_max = 0;
+
 static char *
 timer_per_frame_cb (UProfReport *report,
                     UProfTimerResult *timer,
@@ -104,6 +122,153 @@ get_msecs_per_pick_cb (UProfReport *report,
   return g_strdup_printf ("%3.2f", state->msecs_picking / (float)n_picks);
 }
 
+static char *
+get_input_latency_count_cb (UProfReport *report,
+                            const char *statistic,
+                            const char *attribute,
+                            void *user_data)
+{
+  return g_strdup_printf ("%lu", input_latency_count);
+}
+
+static char *
+get_input_latency_average_cb (UProfReport *report,
+                              const char *statistic,
+                              const char *attribute,
+                              void *user_data)
+{
+  gulong count = input_latency_count ? input_latency_count : 1;
+
+  return g_strdup_printf ("%3.2f", (float) input_latency_total / count);
+}
+
+static char *
+get_input_latency_max_cb (UProfReport *report,
+                          const char *statistic,
+                          const char *attribute,
+                          void *user_data)
+{
+  return g_strdup_printf ("%u", input_latency_max);
+}
+
+static char *
+get_input_latency_bucket_cb (UProfReport *report,
+                             const char *statistic,
+                             const char *attribute,
+                             void *user_data)
+{
+  int bucket = GPOINTER_TO_INT (user_data);
+
+  return g_strdup_printf ("%lu", input_latency_buckets[bucket]);
+}
+
+static void
+add_input_latency_statistic (UProfReport *report)
+{
+  int i;
+
+  uprof_report_add_statistic (report,
+                              "Input Latency",
+                              "Time between the kernel timestamp of an "
+                              "input event and its dispatch");
+  uprof_report_add_statistic_attribute (report, "Input Latency",
+                                        "Count", "Count",
+                                        "The total number of input events",
+                                        UPROF_ATTRIBUTE_TYPE_INT,
+                                        get_input_latency_count_cb,
+                                        NULL);
+  uprof_report_add_statistic_attribute (report, "Input Latency",
+                                        "Average Msecs", "Average\nMsecs",
+                                        "The average latency of an "
+                                        "input event",
+                                        UPROF_ATTRIBUTE_TYPE_FLOAT,
+                                        get_input_latency_average_cb,
+                                        NULL);
+  uprof_report_add_statistic_attribute (report, "Input Latency",
+                                        "Max Msecs", "Max\nMsecs",
+                                        "The maximum latency of an "
+                                        "input event",
+                                        UPROF_ATTRIBUTE_TYPE_INT,
+                                        get_input_latency_max_cb,
+                                        NULL);
+
+  for (i = 0; i < N_LATENCY_BUCKETS; i++)
+    uprof_report_add_statistic_attribute (report, "Input Latency",
+                                          latency_bucket_names[i],
+                                          latency_bucket_names[i],
+                                          "The number of input events "
+                                          "in the latency range",
+                                          UPROF_ATTRIBUTE_TYPE_INT,
+                                          get_input_latency_bucket_cb,
+                                          GINT_TO_POINTER (i));
+}
+
+static char *
+get_offscreen_pool_targets_cb (UProfReport *report,
+                               const char *statistic,
+                               const char *attribute,
+                               void *user_data)
+{
+  ClutterOffscreenPoolStats *stats = user_data;
+
+  return g_strdup_printf ("%u", stats->n_targets);
+}
+
+static char *
+get_offscreen_pool_hit_rate_cb (UProfReport *report,
+                                const char *statistic,
+                                const char *attribute,
+                                void *user_data)
+{
+  ClutterOffscreenPoolStats *stats = user_data;
+  gulong n_leases = stats->n_hits + stats->n_misses;
+
+  return g_strdup_printf ("%3.2f",
+                          100.0f * stats->n_hits / MAX (n_leases, 1));
+}
+
+static char *
+get_offscreen_pool_bytes_cb (UProfReport *report,
+                             const char *statistic,
+                             const char *attribute,
+                             void *user_data)
+{
+  ClutterOffscreenPoolStats *stats = user_data;
+
+  return g_strdup_printf ("%" G_GSIZE_FORMAT, stats->n_bytes);
+}
+
+static void
+add_offscreen_pool_statistic (UProfReport               *report,
+                              ClutterOffscreenPoolStats *stats)
+{
+  uprof_report_add_statistic (report,
+                              "Offscreen Pool",
+                              "Render targets shared by the offscreen "
+                              "effects");
+  uprof_report_add_statistic_attribute (report, "Offscreen Pool",
+                                        "Targets", "Targets",
+                                        "The number of render targets, "
+                                        "leased or idle",
+                                        UPROF_ATTRIBUTE_TYPE_INT,
+                                        get_offscreen_pool_targets_cb,
+                                        stats);
+  uprof_report_add_statistic_attribute (report, "Offscreen Pool",
+                                        "Hit Rate", "Hit\nRate (%)",
+                                        "The percentage of leases reusing "
+                                        "an idle render target",
+                                        UPROF_ATTRIBUTE_TYPE_FLOAT,
+                                        get_offscreen_pool_hit_rate_cb,
+                                        stats);
+  uprof_report_add_statistic_attribute (report, "Offscreen Pool",
+                                        "Bytes Held", "Bytes\nHeld",
+                                        "The texture memory held by the "
+                                        "render targets",
+                                        UPROF_ATTRIBUTE_TYPE_INT,
+                                        get_offscreen_pool_bytes_cb,
+                                        stats);
+}
+
 static gboolean
 _clutter_uprof_report_prepare (UProfReport *report,
                                void **closure_ret,
@@ -113,6 +278,7 @@ _clutter_uprof_report_prepare (UProfReport *report,
   UProfTimerResult        *mainloop_timer;
   UProfTimerResult        *stage_paint_timer;
   UProfTimerResult        *do_pick_timer;
+  ClutterOffscreenPool    *offscreen_pool;
   ClutterUProfReportState *state;
 
   /* NB: uprof provides a shared context for mainloop statistics which allows
@@ -196,6 +362,18 @@ _clutter_uprof_report_prepare (UProfReport *report,
                                             state);
     }
 
+  if (input_latency_count > 0)
+    add_input_latency_statistic (report);
+
+  /* don't create the pool if no effect used it */
+  offscreen_pool = _clutter_context_get_default ()->offscreen_pool;
+  if (offscreen_pool != NULL)
+    {
+      _clutter_offscreen_pool_get_stats (offscreen_pool,
+                                         &state->offscreen_pool);
+      add_offscreen_pool_statistic (report, &state->offscreen_pool);
+    }
+
   uprof_report_add_counters_attribute (clutter_uprof_report,
                                        "Per Frame",
                                        "Per Frame",
@@ -293,5 +471,22 @@ _clutter_profile_trace_message (const char *format, ...)
     uprof_context_vtrace_message (_clutter_uprof_context, format, ap);
 }
 
+/* Records the latency of an input event; the backends should call this
+ * from the main thread, right before dispatching the event
+ */
+void
+_clutter_profile_input_latency (guint32 msecs)
+{
+  int bucket = 0;
+
+  while (bucket < N_LATENCY_BUCKETS - 1 && msecs > (1u << bucket))
+    bucket += 1;
+
+  input_latency_buckets[bucket] += 1;
+  input_latency_count += 1;
+  input_latency_total += msecs;
+  input_latency_max = MAX (input_latency_max, msecs);
+}
+
 #endif
 
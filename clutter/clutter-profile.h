@@ -59,6 +59,9 @@ _clutter_profile_resume (void);
 void
 _clutter_profile_trace_message (const char *format, ...);
 
+void
+_clutter_profile_input_latency (guint32 msecs);
+
 #else /* CLUTTER_ENABLE_PROFILE */
 
 #define CLUTTER_STATIC_TIMER(A,B,C,D,E) extern void _clutter_dummy_decl (void)
@@ -73,6 +76,8 @@ _clutter_profile_trace_message (const char *format, ...);
 
 #define _clutter_profile_trace_message g_message
 
+#define _clutter_profile_input_latency(m) G_STMT_START {} G_STMT_END
+
 #endif /* CLUTTER_ENABLE_PROFILE */
 
 extern guint clutter_profile_flags;
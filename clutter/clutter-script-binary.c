@@ -0,0 +1,1408 @@
+/*
+ * Clutter.
+ *
+ * An OpenGL based 'interactive canvas' library.
+ *
+ * Copyright (C) 2011 Intel Corporation
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The compiled ClutterScript format
+ *
+ * A compiled UI definition is the result of running the JSON parser
+ * over a UI definition file without constructing any object, and then
+ * serializing the object definitions it collected. The file is meant
+ * to be mapped in memory, and it is laid out as:
+ *
+ *   header
+ *   type table        (BinaryType[n_types])
+ *   object table      (BinaryObject[n_objects])
+ *   data              (property, children and signal arrays, and nodes)
+ *   string offsets    (guint32[n_strings])
+ *   string data       (NUL-terminated strings)
+ *
+ * Every offset is an absolute offset from the beginning of the file and
+ * every string is referenced by its index inside the string table. All
+ * values are stored using the host byte order; a file compiled on a host
+ * with a different byte order is rejected.
+ *
+ * Loading a compiled file only registers an ObjectInfo for each object
+ * definition: the properties, children and signals are decoded when the
+ * object is constructed for the first time.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "clutter-actor.h"
+#include "clutter-debug.h"
+#include "clutter-stage.h"
+
+#include "clutter-script.h"
+#include "clutter-script-private.h"
+
+#include "clutter-private.h"
+
+#define BINARY_MAGIC            "CLSCRIPT"
+#define BINARY_MAGIC_LEN        8
+#define BINARY_VERSION          1
+#define BINARY_BYTE_ORDER       0x01020304
+
+#define BINARY_NO_STRING        G_MAXUINT32
+#define BINARY_FAKE_ID          (1u << 31)
+
+/* guards against malformed files with cyclic node offsets */
+#define BINARY_MAX_DEPTH        64
+
+enum
+{
+  NODE_NULL,
+  NODE_BOOLEAN,
+  NODE_INT,
+  NODE_DOUBLE,
+  NODE_STRING,
+  NODE_ARRAY,
+  NODE_OBJECT
+};
+
+enum
+{
+  TYPE_HAS_TYPE_FUNC = 1 << 0
+};
+
+enum
+{
+  OBJECT_HAS_IS_DEFAULT = 1 << 0,
+  OBJECT_IS_DEFAULT     = 1 << 1
+};
+
+typedef struct {
+  gchar magic[BINARY_MAGIC_LEN];
+
+  guint32 version;
+  guint32 byte_order;
+
+  guint32 n_types;
+  guint32 types_offset;
+
+  guint32 n_objects;
+  guint32 objects_offset;
+
+  guint32 n_strings;
+  guint32 strings_offset;
+  guint32 string_data_offset;
+  guint32 string_data_size;
+} BinaryHeader;
+
+typedef struct {
+  guint32 class_name;
+
+  /* either the "type_func" of the definition or the name of the
+   * GType function derived from the class name
+   */
+  guint32 symbol;
+
+  guint32 flags;
+} BinaryType;
+
+typedef struct {
+  guint32 id;
+  guint32 type;
+  guint32 flags;
+
+  /* the id of the container listing this object in its "children" */
+  guint32 parent;
+
+  guint32 n_properties;
+  guint32 properties;   /* BinaryProperty[n_properties] */
+
+  guint32 n_children;
+  guint32 children;     /* guint32[n_children] */
+
+  guint32 n_signals;
+  guint32 signals;      /* BinarySignal[n_signals] */
+} BinaryObject;
+
+typedef struct {
+  guint32 name;
+  guint32 node;
+} BinaryProperty;
+
+typedef struct {
+  guint32 name;
+  guint32 handler;
+  guint32 object;
+  guint32 flags;
+} BinarySignal;
+
+typedef struct {
+  GType gtype;
+
+  guint is_resolved : 1;
+} BinaryTypeCache;
+
+struct _ClutterScriptBinary
+{
+  guint ref_count;
+
+  GMappedFile *mapped_file;
+  gchar *contents;
+
+  const gchar *data;
+  gsize size;
+
+  BinaryHeader header;
+
+  /* the fake ids generated for anonymous objects, indexed by string */
+  gchar **fake_ids;
+
+  BinaryTypeCache *types;
+};
+
+gboolean
+_clutter_script_binary_check (const gchar *data,
+                              gsize        length)
+{
+  return data != NULL &&
+         length >= BINARY_MAGIC_LEN &&
+         memcmp (data, BINARY_MAGIC, BINARY_MAGIC_LEN) == 0;
+}
+
+static inline gboolean
+binary_read (ClutterScriptBinary *binary,
+             guint32              offset,
+             gpointer             dest,
+             gsize                size)
+{
+  if (offset > binary->size || binary->size - offset < size)
+    return FALSE;
+
+  memcpy (dest, binary->data + offset, size);
+
+  return TRUE;
+}
+
+static inline gboolean
+binary_read_u32 (ClutterScriptBinary *binary,
+                 guint32              offset,
+                 guint32             *value)
+{
+  return binary_read (binary, offset, value, sizeof (guint32));
+}
+
+static inline gboolean
+binary_check_range (ClutterScriptBinary *binary,
+                    guint32              offset,
+                    guint32              n_items,
+                    gsize                item_size)
+{
+  guint64 end = (guint64) offset + (guint64) n_items * item_size;
+
+  return end <= binary->size;
+}
+
+static const gchar *
+binary_get_string (ClutterScriptBinary *binary,
+                   guint32              index_)
+{
+  const BinaryHeader *header = &binary->header;
+  guint32 offset;
+
+  if (index_ >= header->n_strings)
+    return NULL;
+
+  if (binary->fake_ids != NULL && binary->fake_ids[index_] != NULL)
+    return binary->fake_ids[index_];
+
+  if (!binary_read_u32 (binary, header->strings_offset + index_ * 4, &offset))
+    return NULL;
+
+  offset &= ~BINARY_FAKE_ID;
+  if (offset >= header->string_data_size)
+    return NULL;
+
+  return binary->data + header->string_data_offset + offset;
+}
+
+static gboolean
+binary_get_object (ClutterScriptBinary *binary,
+                   guint                index_,
+                   BinaryObject        *record)
+{
+  const BinaryHeader *header = &binary->header;
+
+  if (index_ >= header->n_objects)
+    return FALSE;
+
+  return binary_read (binary,
+                      header->objects_offset + index_ * sizeof (BinaryObject),
+                      record,
+                      sizeof (BinaryObject));
+}
+
+static gboolean
+binary_validate (ClutterScriptBinary  *binary,
+                 GError              **error)
+{
+  BinaryHeader *header = &binary->header;
+
+  if (!binary_read (binary, 0, header, sizeof (BinaryHeader)) ||
+      memcmp (header->magic, BINARY_MAGIC, BINARY_MAGIC_LEN) != 0)
+    {
+      g_set_error (error, CLUTTER_SCRIPT_ERROR,
+                   CLUTTER_SCRIPT_ERROR_INVALID_VALUE,
+                   "Not a compiled UI definition");
+      return FALSE;
+    }
+
+  if (header->version != BINARY_VERSION ||
+      header->byte_order != BINARY_BYTE_ORDER)
+    {
+      g_set_error (error, CLUTTER_SCRIPT_ERROR,
+                   CLUTTER_SCRIPT_ERROR_INVALID_VALUE,
+                   "The compiled UI definition has an unsupported "
+                   "version or byte order");
+      return FALSE;
+    }
+
+  if (!binary_check_range (binary, header->types_offset,
+                           header->n_types,
+                           sizeof (BinaryType)) ||
+      !binary_check_range (binary, header->objects_offset,
+                           header->n_objects,
+                           sizeof (BinaryObject)) ||
+      !binary_check_range (binary, header->strings_offset,
+                           header->n_strings,
+                           sizeof (guint32)) ||
+      !binary_check_range (binary, header->string_data_offset,
+                           header->string_data_size, 1) ||
+      header->string_data_size == 0 ||
+      binary->data[header->string_data_offset +
+                   header->string_data_size - 1] != '\0')
+    {
+      g_set_error (error, CLUTTER_SCRIPT_ERROR,
+                   CLUTTER_SCRIPT_ERROR_INVALID_VALUE,
+                   "The compiled UI definition is truncated or corrupted");
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/*
+ * _clutter_script_binary_new:
+ * @mapped_file: (allow-none): a #GMappedFile with the compiled definition
+ * @data: (allow-none): a buffer with the compiled definition, used if
+ *   @mapped_file is %NULL
+ * @length: the length of @data
+ * @error: return location for a #GError, or %NULL
+ *
+ * Creates a new #ClutterScriptBinary for a compiled UI definition. If
+ * @mapped_file is set, a reference is acquired on it; otherwise @data
+ * is copied.
+ *
+ * Return value: the newly created #ClutterScriptBinary, or %NULL if
+ *   the compiled definition is not valid
+ */
+ClutterScriptBinary *
+_clutter_script_binary_new (GMappedFile  *mapped_file,
+                            const gchar  *data,
+                            gsize         length,
+                            GError      **error)
+{
+  ClutterScriptBinary *binary;
+
+  binary = g_slice_new0 (ClutterScriptBinary);
+  binary->ref_count = 1;
+
+  if (mapped_file != NULL)
+    {
+      binary->mapped_file = g_mapped_file_ref (mapped_file);
+      binary->data = g_mapped_file_get_contents (mapped_file);
+      binary->size = g_mapped_file_get_length (mapped_file);
+    }
+  else
+    {
+      binary->contents = g_memdup (data, length);
+      binary->data = binary->contents;
+      binary->size = length;
+    }
+
+  if (!binary_validate (binary, error))
+    {
+      _clutter_script_binary_unref (binary);
+      return NULL;
+    }
+
+  binary->types = g_new0 (BinaryTypeCache, binary->header.n_types);
+
+  return binary;
+}
+
+ClutterScriptBinary *
+_clutter_script_binary_ref (ClutterScriptBinary *binary)
+{
+  binary->ref_count += 1;
+
+  return binary;
+}
+
+void
+_clutter_script_binary_unref (ClutterScriptBinary *binary)
+{
+  guint32 i;
+
+  binary->ref_count -= 1;
+  if (binary->ref_count > 0)
+    return;
+
+  if (binary->fake_ids != NULL)
+    {
+      for (i = 0; i < binary->header.n_strings; i++)
+        g_free (binary->fake_ids[i]);
+
+      g_free (binary->fake_ids);
+    }
+
+  if (binary->mapped_file != NULL)
+    g_mapped_file_unref (binary->mapped_file);
+
+  g_free (binary->contents);
+  g_free (binary->types);
+
+  g_slice_free (ClutterScriptBinary, binary);
+}
+
+static GType
+binary_resolve_type (ClutterScript       *script,
+                     ClutterScriptBinary *binary,
+                     guint32              index_)
+{
+  BinaryTypeCache *cache;
+  BinaryType type;
+  const gchar *class_name, *symbol;
+
+  if (index_ >= binary->header.n_types)
+    return G_TYPE_INVALID;
+
+  cache = &binary->types[index_];
+  if (cache->is_resolved)
+    return cache->gtype;
+
+  cache->is_resolved = TRUE;
+  cache->gtype = G_TYPE_INVALID;
+
+  if (!binary_read (binary,
+                    binary->header.types_offset + index_ * sizeof (BinaryType),
+                    &type,
+                    sizeof (BinaryType)))
+    return G_TYPE_INVALID;
+
+  class_name = binary_get_string (binary, type.class_name);
+  symbol = binary_get_string (binary, type.symbol);
+
+  /* the GType function name has already been derived from the class
+   * name by the compiler, so we can skip the name mangling
+   */
+  if (!(type.flags & TYPE_HAS_TYPE_FUNC) && class_name != NULL)
+    cache->gtype = g_type_from_name (class_name);
+
+  if (cache->gtype == G_TYPE_INVALID && symbol != NULL)
+    cache->gtype = clutter_script_get_type_from_symbol (symbol);
+
+  if (cache->gtype == G_TYPE_INVALID &&
+      !(type.flags & TYPE_HAS_TYPE_FUNC) &&
+      class_name != NULL)
+    cache->gtype = clutter_script_get_type_from_name (script, class_name);
+
+  CLUTTER_NOTE (SCRIPT, "Resolved compiled type '%s' (symbol: %s)",
+                class_name,
+                symbol);
+
+  return cache->gtype;
+}
+
+static JsonNode *
+binary_read_node (ClutterScriptBinary *binary,
+                  guint32              offset,
+                  guint                depth)
+{
+  JsonNode *retval;
+  guint32 tag, n_items, i;
+
+  if (depth > BINARY_MAX_DEPTH || !binary_read_u32 (binary, offset, &tag))
+    return NULL;
+
+  offset += 4;
+
+  switch (tag)
+    {
+    case NODE_NULL:
+      return json_node_new (JSON_NODE_NULL);
+
+    case NODE_BOOLEAN:
+      {
+        guint32 value;
+
+        if (!binary_read_u32 (binary, offset, &value))
+          return NULL;
+
+        retval = json_node_new (JSON_NODE_VALUE);
+        json_node_set_boolean (retval, value != 0);
+
+        return retval;
+      }
+
+    case NODE_INT:
+      {
+        gint64 value;
+
+        if (!binary_read (binary, offset, &value, sizeof (gint64)))
+          return NULL;
+
+        retval = json_node_new (JSON_NODE_VALUE);
+        json_node_set_int (retval, value);
+
+        return retval;
+      }
+
+    case NODE_DOUBLE:
+      {
+        gdouble value;
+
+        if (!binary_read (binary, offset, &value, sizeof (gdouble)))
+          return NULL;
+
+        retval = json_node_new (JSON_NODE_VALUE);
+        json_node_set_double (retval, value);
+
+        return retval;
+      }
+
+    case NODE_STRING:
+      {
+        const gchar *str;
+        guint32 index_;
+
+        if (!binary_read_u32 (binary, offset, &index_))
+          return NULL;
+
+        str = binary_get_string (binary, index_);
+        if (str == NULL)
+          return NULL;
+
+        retval = json_node_new (JSON_NODE_VALUE);
+        json_node_set_string (retval, str);
+
+        return retval;
+      }
+
+    case NODE_ARRAY:
+      {
+        JsonArray *array;
+
+        if (!binary_read_u32 (binary, offset, &n_items) ||
+            !binary_check_range (binary, offset + 4, n_items, 4))
+          return NULL;
+
+        array = json_array_sized_new (n_items);
+
+        for (i = 0; i < n_items; i++)
+          {
+            JsonNode *element;
+            guint32 element_offset;
+
+            binary_read_u32 (binary, offset + 4 + i * 4, &element_offset);
+
+            element = binary_read_node (binary, element_offset, depth + 1);
+            if (element == NULL)
+              {
+                json_array_unref (array);
+                return NULL;
+              }
+
+            json_array_add_element (array, element);
+          }
+
+        retval = json_node_new (JSON_NODE_ARRAY);
+        json_node_take_array (retval, array);
+
+        return retval;
+      }
+
+    case NODE_OBJECT:
+      {
+        JsonObject *object;
+
+        if (!binary_read_u32 (binary, offset, &n_items) ||
+            !binary_check_range (binary, offset + 4, n_items, 8))
+          return NULL;
+
+        object = json_object_new ();
+
+        for (i = 0; i < n_items; i++)
+          {
+            JsonNode *member;
+            const gchar *name;
+            guint32 name_index, member_offset;
+
+            binary_read_u32 (binary, offset + 4 + i * 8, &name_index);
+            binary_read_u32 (binary, offset + 8 + i * 8, &member_offset);
+
+            name = binary_get_string (binary, name_index);
+            member = name != NULL
+                   ? binary_read_node (binary, member_offset, depth + 1)
+                   : NULL;
+
+            if (member == NULL)
+              {
+                json_object_unref (object);
+                return NULL;
+              }
+
+            json_object_set_member (object, name, member);
+          }
+
+        retval = json_node_new (JSON_NODE_OBJECT);
+        json_node_take_object (retval, object);
+
+        return retval;
+      }
+
+    default:
+      break;
+    }
+
+  return NULL;
+}
+
+static GList *
+binary_read_properties (ClutterScriptBinary *binary,
+                        ObjectInfo          *oinfo,
+                        const BinaryObject  *record)
+{
+  GList *retval = NULL;
+  gint i;
+
+  if (!binary_check_range (binary, record->properties,
+                           record->n_properties,
+                           sizeof (BinaryProperty)))
+    return NULL;
+
+  /* prepend in reverse, to keep the order of the definition */
+  for (i = (gint) record->n_properties - 1; i >= 0; i--)
+    {
+      BinaryProperty property;
+      PropertyInfo *pinfo;
+      const gchar *name;
+      JsonNode *node;
+
+      binary_read (binary,
+                   record->properties + i * sizeof (BinaryProperty),
+                   &property,
+                   sizeof (BinaryProperty));
+
+      name = binary_get_string (binary, property.name);
+      node = name != NULL ? binary_read_node (binary, property.node, 0) : NULL;
+      if (node == NULL)
+        {
+          g_warning ("Invalid compiled value for a property of the "
+                     "object '%s' (type: %s)",
+                     oinfo->id,
+                     oinfo->class_name);
+          continue;
+        }
+
+      pinfo = g_slice_new (PropertyInfo);
+
+      pinfo->name = g_strdup (name);
+      pinfo->node = node;
+      pinfo->pspec = NULL;
+      pinfo->is_child = g_str_has_prefix (name, "child::") ? TRUE : FALSE;
+      pinfo->is_layout = g_str_has_prefix (name, "layout::") ? TRUE : FALSE;
+
+      retval = g_list_prepend (retval, pinfo);
+    }
+
+  return retval;
+}
+
+static GList *
+binary_read_children (ClutterScriptBinary *binary,
+                      const BinaryObject  *record)
+{
+  GList *retval = NULL;
+  gint i;
+
+  if (!binary_check_range (binary, record->children, record->n_children, 4))
+    return NULL;
+
+  for (i = (gint) record->n_children - 1; i >= 0; i--)
+    {
+      const gchar *id_;
+      guint32 index_;
+
+      binary_read_u32 (binary, record->children + i * 4, &index_);
+
+      id_ = binary_get_string (binary, index_);
+      if (id_ != NULL)
+        retval = g_list_prepend (retval, g_strdup (id_));
+    }
+
+  return retval;
+}
+
+static GList *
+binary_read_signals (ClutterScriptBinary *binary,
+                     const BinaryObject  *record)
+{
+  GList *retval = NULL;
+  gint i;
+
+  if (!binary_check_range (binary, record->signals,
+                           record->n_signals,
+                           sizeof (BinarySignal)))
+    return NULL;
+
+  for (i = (gint) record->n_signals - 1; i >= 0; i--)
+    {
+      BinarySignal signal;
+      SignalInfo *sinfo;
+      const gchar *name, *handler;
+
+      binary_read (binary,
+                   record->signals + i * sizeof (BinarySignal),
+                   &signal,
+                   sizeof (BinarySignal));
+
+      name = binary_get_string (binary, signal.name);
+      handler = binary_get_string (binary, signal.handler);
+      if (name == NULL || handler == NULL)
+        continue;
+
+      sinfo = g_slice_new0 (SignalInfo);
+      sinfo->name = g_strdup (name);
+      sinfo->handler = g_strdup (handler);
+      sinfo->object = g_strdup (binary_get_string (binary, signal.object));
+      sinfo->flags = signal.flags;
+
+      retval = g_list_prepend (retval, sinfo);
+    }
+
+  return retval;
+}
+
+static void
+binary_expand_record (ClutterScript       *script,
+                      ClutterScriptBinary *binary,
+                      const BinaryObject  *record,
+                      ObjectInfo          *oinfo)
+{
+  GList *properties, *children, *signals;
+
+  properties = binary_read_properties (binary, oinfo, record);
+  children = binary_read_children (binary, record);
+  signals = binary_read_signals (binary, record);
+
+  /* new definitions win over the older ones, like when parsing */
+  oinfo->properties = g_list_concat (properties, oinfo->properties);
+  oinfo->children = g_list_concat (oinfo->children, children);
+  oinfo->signals = g_list_concat (signals, oinfo->signals);
+
+  if (oinfo->gtype == G_TYPE_INVALID)
+    {
+      oinfo->gtype = binary_resolve_type (script, binary, record->type);
+      if (oinfo->gtype != G_TYPE_INVALID)
+        {
+          oinfo->is_actor = g_type_is_a (oinfo->gtype, CLUTTER_TYPE_ACTOR);
+          if (oinfo->is_actor)
+            oinfo->is_stage = g_type_is_a (oinfo->gtype, CLUTTER_TYPE_STAGE);
+        }
+    }
+
+  oinfo->has_unresolved = TRUE;
+
+  CLUTTER_NOTE (SCRIPT,
+                "Expanded compiled object '%s' (type:%s, props:%d, signals:%d)",
+                oinfo->id,
+                oinfo->class_name,
+                g_list_length (oinfo->properties),
+                g_list_length (oinfo->signals));
+}
+
+/*
+ * _clutter_script_binary_expand:
+ * @script: a #ClutterScript
+ * @oinfo: an #ObjectInfo loaded from a compiled definition
+ *
+ * Decodes the properties, children and signals of @oinfo. If @oinfo is
+ * the child of a container defined in the same compiled definition, the
+ * container is constructed as well, so that lazily constructed objects
+ * end up in the same place as if the whole definition had been built.
+ */
+void
+_clutter_script_binary_expand (ClutterScript *script,
+                               ObjectInfo    *oinfo)
+{
+  ClutterScriptBinary *binary = oinfo->binary;
+  ObjectInfo *parent_info = NULL;
+  BinaryObject record;
+
+  g_assert (binary != NULL);
+
+  oinfo->binary = NULL;
+
+  if (binary_get_object (binary, oinfo->binary_index, &record))
+    {
+      const gchar *parent_id;
+
+      binary_expand_record (script, binary, &record, oinfo);
+
+      parent_id = binary_get_string (binary, record.parent);
+      if (parent_id != NULL)
+        parent_info = _clutter_script_get_object_info (script, parent_id);
+    }
+
+  _clutter_script_binary_unref (binary);
+
+  _clutter_script_add_pending_object (script, oinfo);
+
+  if (parent_info != NULL && parent_info->object == NULL)
+    _clutter_script_construct_object (script, parent_info);
+}
+
+/*
+ * _clutter_script_binary_has_signals:
+ * @oinfo: an #ObjectInfo loaded from a compiled definition
+ *
+ * Checks whether the definition of @oinfo has signal handlers, without
+ * expanding it.
+ */
+gboolean
+_clutter_script_binary_has_signals (ObjectInfo *oinfo)
+{
+  BinaryObject record;
+
+  if (oinfo->binary == NULL)
+    return oinfo->signals != NULL;
+
+  if (!binary_get_object (oinfo->binary, oinfo->binary_index, &record))
+    return FALSE;
+
+  return record.n_signals > 0;
+}
+
+/*
+ * _clutter_script_binary_load:
+ * @script: a #ClutterScript
+ * @binary: a #ClutterScriptBinary
+ * @error: return location for a #GError, or %NULL
+ *
+ * Adds the object definitions of @binary to @script. The objects will
+ * be constructed the first time they are needed.
+ */
+gboolean
+_clutter_script_binary_load (ClutterScript        *script,
+                             ClutterScriptBinary  *binary,
+                             GError              **error)
+{
+  const BinaryHeader *header = &binary->header;
+  guint32 i;
+
+  /* anonymous objects need an id that is unique for @script */
+  for (i = 0; i < header->n_strings; i++)
+    {
+      guint32 offset;
+
+      binary_read_u32 (binary, header->strings_offset + i * 4, &offset);
+      if (!(offset & BINARY_FAKE_ID))
+        continue;
+
+      if (binary->fake_ids == NULL)
+        binary->fake_ids = g_new0 (gchar *, header->n_strings);
+
+      binary->fake_ids[i] = _clutter_script_generate_fake_id (script);
+    }
+
+  for (i = 0; i < header->n_objects; i++)
+    {
+      BinaryObject record;
+      BinaryType type;
+      ObjectInfo *oinfo;
+      const gchar *id_, *class_name;
+
+      if (!binary_get_object (binary, i, &record) ||
+          (id_ = binary_get_string (binary, record.id)) == NULL ||
+          !binary_read (binary,
+                        header->types_offset + record.type * sizeof (BinaryType),
+                        &type,
+                        sizeof (BinaryType)) ||
+          (class_name = binary_get_string (binary, type.class_name)) == NULL)
+        {
+          g_set_error (error, CLUTTER_SCRIPT_ERROR,
+                       CLUTTER_SCRIPT_ERROR_INVALID_VALUE,
+                       "Invalid object definition in the compiled "
+                       "UI definition");
+          return FALSE;
+        }
+
+      oinfo = _clutter_script_get_object_info (script, id_);
+      if (oinfo != NULL)
+        {
+          /* merge with an existing definition right away */
+          if (oinfo->binary != NULL)
+            _clutter_script_binary_expand (script, oinfo);
+
+          binary_expand_record (script, binary, &record, oinfo);
+
+          if (oinfo->object != NULL)
+            {
+              _clutter_script_construct_object (script, oinfo);
+              _clutter_script_apply_properties (script, oinfo);
+            }
+
+          continue;
+        }
+
+      oinfo = g_slice_new0 (ObjectInfo);
+      oinfo->merge_id = _clutter_script_get_last_merge_id (script);
+      oinfo->id = g_strdup (id_);
+      oinfo->class_name = g_strdup (class_name);
+
+      if (type.flags & TYPE_HAS_TYPE_FUNC)
+        oinfo->type_func = g_strdup (binary_get_string (binary, type.symbol));
+
+      if (record.flags & OBJECT_HAS_IS_DEFAULT)
+        {
+          oinfo->is_actor = TRUE;
+          oinfo->is_stage = TRUE;
+          oinfo->is_stage_default = (record.flags & OBJECT_IS_DEFAULT) != 0;
+        }
+
+      oinfo->has_unresolved = TRUE;
+
+      oinfo->binary = _clutter_script_binary_ref (binary);
+      oinfo->binary_index = i;
+
+      _clutter_script_add_object_info (script, oinfo);
+    }
+
+  CLUTTER_NOTE (SCRIPT, "Loaded %u compiled object definitions",
+                header->n_objects);
+
+  return TRUE;
+}
+
+/*
+ * Compiler
+ */
+
+typedef struct {
+  ClutterScript *script;
+
+  GHashTable *string_index;
+  GPtrArray *strings;
+  GHashTable *fake_ids;
+
+  GArray *types;
+  GPtrArray *type_keys;
+
+  /* the object table and the data that follows it */
+  GByteArray *data;
+  guint32 data_base;
+
+  /* strings owned by the compiler */
+  GPtrArray *owned;
+} BinaryWriter;
+
+static guint32
+binary_writer_intern (BinaryWriter *writer,
+                      const gchar  *str)
+{
+  gpointer index_;
+
+  if (str == NULL)
+    return BINARY_NO_STRING;
+
+  index_ = g_hash_table_lookup (writer->string_index, str);
+  if (index_ != NULL)
+    return GPOINTER_TO_UINT (index_) - 1;
+
+  g_ptr_array_add (writer->strings, (gpointer) str);
+  g_hash_table_insert (writer->string_index,
+                       (gpointer) str,
+                       GUINT_TO_POINTER (writer->strings->len));
+
+  return writer->strings->len - 1;
+}
+
+static guint32
+binary_writer_add_type (BinaryWriter *writer,
+                        ObjectInfo   *oinfo)
+{
+  BinaryType type;
+  gchar *key;
+  guint i;
+
+  key = g_strconcat (oinfo->class_name, "|", oinfo->type_func, NULL);
+
+  for (i = 0; i < writer->type_keys->len; i++)
+    {
+      if (strcmp (g_ptr_array_index (writer->type_keys, i), key) == 0)
+        {
+          g_free (key);
+          return i;
+        }
+    }
+
+  g_ptr_array_add (writer->type_keys, key);
+
+  type.class_name = binary_writer_intern (writer, oinfo->class_name);
+
+  if (oinfo->type_func != NULL)
+    {
+      type.symbol = binary_writer_intern (writer, oinfo->type_func);
+      type.flags = TYPE_HAS_TYPE_FUNC;
+    }
+  else
+    {
+      gchar *symbol = _clutter_script_get_type_symbol (oinfo->class_name);
+
+      g_ptr_array_add (writer->owned, symbol);
+
+      type.symbol = binary_writer_intern (writer, symbol);
+      type.flags = 0;
+    }
+
+  g_array_append_val (writer->types, type);
+
+  return writer->types->len - 1;
+}
+
+static inline guint32
+binary_writer_tell (BinaryWriter *writer)
+{
+  return writer->data_base + writer->data->len;
+}
+
+static inline void
+binary_writer_append_u32 (BinaryWriter *writer,
+                          guint32       value)
+{
+  g_byte_array_append (writer->data, (const guint8 *) &value, 4);
+}
+
+static guint32
+binary_writer_write_int (BinaryWriter *writer,
+                         gint64        value)
+{
+  guint32 retval = binary_writer_tell (writer);
+
+  binary_writer_append_u32 (writer, NODE_INT);
+  g_byte_array_append (writer->data, (const guint8 *) &value, sizeof (gint64));
+
+  return retval;
+}
+
+static guint32
+binary_writer_write_node (BinaryWriter *writer,
+                          JsonNode     *node)
+{
+  guint32 retval, *offsets;
+  guint32 i, n_items;
+
+  switch (JSON_NODE_TYPE (node))
+    {
+    case JSON_NODE_OBJECT:
+      {
+        JsonObject *object = json_node_get_object (node);
+        GList *members, *l;
+
+        members = json_object_get_members (object);
+        n_items = g_list_length (members);
+
+        /* the members have to be written before the object, since
+         * we need their offsets
+         */
+        offsets = g_new (guint32, n_items * 2);
+        for (l = members, i = 0; l != NULL; l = l->next, i++)
+          {
+            JsonNode *member = json_object_get_member (object, l->data);
+
+            offsets[i * 2] = binary_writer_intern (writer, l->data);
+            offsets[i * 2 + 1] = binary_writer_write_node (writer, member);
+          }
+
+        retval = binary_writer_tell (writer);
+        binary_writer_append_u32 (writer, NODE_OBJECT);
+        binary_writer_append_u32 (writer, n_items);
+        g_byte_array_append (writer->data,
+                             (const guint8 *) offsets,
+                             n_items * 2 * sizeof (guint32));
+
+        g_free (offsets);
+        g_list_free (members);
+      }
+      break;
+
+    case JSON_NODE_ARRAY:
+      {
+        JsonArray *array = json_node_get_array (node);
+
+        n_items = json_array_get_length (array);
+
+        offsets = g_new (guint32, n_items);
+        for (i = 0; i < n_items; i++)
+          {
+            JsonNode *element = json_array_get_element (array, i);
+
+            offsets[i] = binary_writer_write_node (writer, element);
+          }
+
+        retval = binary_writer_tell (writer);
+        binary_writer_append_u32 (writer, NODE_ARRAY);
+        binary_writer_append_u32 (writer, n_items);
+        g_byte_array_append (writer->data,
+                             (const guint8 *) offsets,
+                             n_items * sizeof (guint32));
+
+        g_free (offsets);
+      }
+      break;
+
+    case JSON_NODE_VALUE:
+      switch (json_node_get_value_type (node))
+        {
+        case G_TYPE_INT64:
+          retval = binary_writer_write_int (writer, json_node_get_int (node));
+          break;
+
+        case G_TYPE_DOUBLE:
+          {
+            gdouble value = json_node_get_double (node);
+
+            retval = binary_writer_tell (writer);
+            binary_writer_append_u32 (writer, NODE_DOUBLE);
+            g_byte_array_append (writer->data,
+                                 (const guint8 *) &value,
+                                 sizeof (gdouble));
+          }
+          break;
+
+        case G_TYPE_BOOLEAN:
+          retval = binary_writer_tell (writer);
+          binary_writer_append_u32 (writer, NODE_BOOLEAN);
+          binary_writer_append_u32 (writer, json_node_get_boolean (node));
+          break;
+
+        case G_TYPE_STRING:
+          retval = binary_writer_tell (writer);
+          binary_writer_append_u32 (writer, NODE_STRING);
+          binary_writer_append_u32 (writer,
+                                    binary_writer_intern (writer,
+                                                          json_node_get_string (node)));
+          break;
+
+        default:
+          retval = binary_writer_tell (writer);
+          binary_writer_append_u32 (writer, NODE_NULL);
+          break;
+        }
+      break;
+
+    case JSON_NODE_NULL:
+    default:
+      retval = binary_writer_tell (writer);
+      binary_writer_append_u32 (writer, NODE_NULL);
+      break;
+    }
+
+  return retval;
+}
+
+/* enumeration and flags values are resolved by the compiler, so that
+ * loading a compiled definition does not need to look them up by name
+ */
+static gboolean
+binary_writer_resolve_enum (GObjectClass *klass,
+                            PropertyInfo *pinfo,
+                            gint         *value)
+{
+  GParamSpec *pspec;
+  GType value_type;
+  const gchar *str;
+
+  if (klass == NULL || pinfo->is_child || pinfo->is_layout)
+    return FALSE;
+
+  if (JSON_NODE_TYPE (pinfo->node) != JSON_NODE_VALUE ||
+      json_node_get_value_type (pinfo->node) != G_TYPE_STRING)
+    return FALSE;
+
+  pspec = g_object_class_find_property (klass, pinfo->name);
+  if (pspec == NULL)
+    return FALSE;
+
+  value_type = G_PARAM_SPEC_VALUE_TYPE (pspec);
+  str = json_node_get_string (pinfo->node);
+
+  if (G_TYPE_IS_ENUM (value_type))
+    return clutter_script_enum_from_string (value_type, str, value);
+
+  if (G_TYPE_IS_FLAGS (value_type))
+    return clutter_script_flags_from_string (value_type, str, value);
+
+  return FALSE;
+}
+
+static void
+binary_writer_write_object (BinaryWriter *writer,
+                            ObjectInfo   *oinfo,
+                            GHashTable   *parents,
+                            BinaryObject *record)
+{
+  GObjectClass *klass = NULL;
+  GArray *entries;
+  GType gtype;
+  GList *l;
+
+  gtype = _clutter_script_resolve_type (writer->script,
+                                        oinfo->class_name,
+                                        oinfo->type_func);
+
+  if (G_TYPE_IS_CLASSED (gtype) && g_type_is_a (gtype, G_TYPE_OBJECT))
+    klass = g_type_class_ref (gtype);
+
+  record->id = binary_writer_intern (writer, oinfo->id);
+  record->type = binary_writer_add_type (writer, oinfo);
+  record->parent = binary_writer_intern (writer,
+                                         g_hash_table_lookup (parents,
+                                                              oinfo->id));
+
+  record->flags = 0;
+  /* the definitions are not constructed when compiling, so this is
+   * only set by the parser when the "is-default" member was found
+   */
+  if (oinfo->is_stage)
+    {
+      record->flags |= OBJECT_HAS_IS_DEFAULT;
+      if (oinfo->is_stage_default)
+        record->flags |= OBJECT_IS_DEFAULT;
+    }
+
+  /* properties */
+  entries = g_array_new (FALSE, FALSE, sizeof (BinaryProperty));
+  for (l = oinfo->properties; l != NULL; l = l->next)
+    {
+      PropertyInfo *pinfo = l->data;
+      BinaryProperty property;
+      gint value;
+
+      property.name = binary_writer_intern (writer, pinfo->name);
+
+      if (binary_writer_resolve_enum (klass, pinfo, &value))
+        property.node = binary_writer_write_int (writer, value);
+      else
+        property.node = binary_writer_write_node (writer, pinfo->node);
+
+      g_array_append_val (entries, property);
+    }
+
+  record->n_properties = entries->len;
+  record->properties = binary_writer_tell (writer);
+  g_byte_array_append (writer->data,
+                       (const guint8 *) entries->data,
+                       entries->len * sizeof (BinaryProperty));
+  g_array_free (entries, TRUE);
+
+  /* children */
+  record->n_children = g_list_length (oinfo->children);
+  record->children = binary_writer_tell (writer);
+  for (l = oinfo->children; l != NULL; l = l->next)
+    binary_writer_append_u32 (writer, binary_writer_intern (writer, l->data));
+
+  /* signals */
+  entries = g_array_new (FALSE, FALSE, sizeof (BinarySignal));
+  for (l = oinfo->signals; l != NULL; l = l->next)
+    {
+      SignalInfo *sinfo = l->data;
+      BinarySignal signal;
+
+      signal.name = binary_writer_intern (writer, sinfo->name);
+      signal.handler = binary_writer_intern (writer, sinfo->handler);
+      signal.object = binary_writer_intern (writer, sinfo->object);
+      signal.flags = sinfo->flags;
+
+      g_array_append_val (entries, signal);
+    }
+
+  record->n_signals = entries->len;
+  record->signals = binary_writer_tell (writer);
+  g_byte_array_append (writer->data,
+                       (const guint8 *) entries->data,
+                       entries->len * sizeof (BinarySignal));
+  g_array_free (entries, TRUE);
+
+  if (oinfo->has_fake_id)
+    g_hash_table_insert (writer->fake_ids, oinfo->id, oinfo->id);
+
+  if (klass != NULL)
+    g_type_class_unref (klass);
+}
+
+/*
+ * _clutter_script_binary_write:
+ * @script: the #ClutterScript that parsed the definitions
+ * @objects: (element-type ObjectInfo): the object definitions
+ * @filename: the path of the compiled file
+ * @error: return location for a #GError, or %NULL
+ *
+ * Compiles @objects and saves the result into @filename. The object
+ * definitions must not have been constructed.
+ */
+gboolean
+_clutter_script_binary_write (ClutterScript  *script,
+                              GList          *objects,
+                              const gchar    *filename,
+                              GError        **error)
+{
+  BinaryWriter writer;
+  BinaryHeader header;
+  BinaryObject *records;
+  GHashTable *parents;
+  GByteArray *strings;
+  GByteArray *output;
+  guint32 n_objects, i;
+  gboolean retval;
+  GList *l;
+
+  writer.script = script;
+  writer.string_index = g_hash_table_new (g_str_hash, g_str_equal);
+  writer.strings = g_ptr_array_new ();
+  writer.fake_ids = g_hash_table_new (g_str_hash, g_str_equal);
+  writer.types = g_array_new (FALSE, FALSE, sizeof (BinaryType));
+  writer.type_keys = g_ptr_array_new_with_free_func (g_free);
+  writer.data = g_byte_array_new ();
+  writer.owned = g_ptr_array_new_with_free_func (g_free);
+
+  n_objects = g_list_length (objects);
+
+  /* the type table sits between the header and the object table, so
+   * we need to know its size before writing any offset
+   */
+  parents = g_hash_table_new (g_str_hash, g_str_equal);
+  for (l = objects; l != NULL; l = l->next)
+    {
+      ObjectInfo *oinfo = l->data;
+      GList *c;
+
+      binary_writer_add_type (&writer, oinfo);
+
+      for (c = oinfo->children; c != NULL; c = c->next)
+        g_hash_table_insert (parents, c->data, oinfo->id);
+    }
+
+  writer.data_base = sizeof (BinaryHeader)
+                   + writer.types->len * sizeof (BinaryType)
+                   + n_objects * sizeof (BinaryObject);
+
+  records = g_new0 (BinaryObject, n_objects);
+  for (l = objects, i = 0; l != NULL; l = l->next, i++)
+    binary_writer_write_object (&writer, l->data, parents, &records[i]);
+
+  /* string table */
+  strings = g_byte_array_new ();
+
+  memset (&header, 0, sizeof (BinaryHeader));
+  memcpy (header.magic, BINARY_MAGIC, BINARY_MAGIC_LEN);
+  header.version = BINARY_VERSION;
+  header.byte_order = BINARY_BYTE_ORDER;
+  header.n_types = writer.types->len;
+  header.types_offset = sizeof (BinaryHeader);
+  header.n_objects = n_objects;
+  header.objects_offset = header.types_offset
+                        + header.n_types * sizeof (BinaryType);
+  header.n_strings = writer.strings->len;
+  header.strings_offset = binary_writer_tell (&writer);
+  header.string_data_offset = header.strings_offset
+                            + header.n_strings * sizeof (guint32);
+
+  output = g_byte_array_sized_new (header.string_data_offset);
+  g_byte_array_append (output, (const guint8 *) &header, sizeof (BinaryHeader));
+  g_byte_array_append (output,
+                       (const guint8 *) writer.types->data,
+                       header.n_types * sizeof (BinaryType));
+  g_byte_array_append (output,
+                       (const guint8 *) records,
+                       n_objects * sizeof (BinaryObject));
+  g_byte_array_append (output, writer.data->data, writer.data->len);
+
+  for (i = 0; i < header.n_strings; i++)
+    {
+      const gchar *str = g_ptr_array_index (writer.strings, i);
+      guint32 offset = strings->len;
+
+      if (g_hash_table_lookup (writer.fake_ids, str) != NULL)
+        offset |= BINARY_FAKE_ID;
+
+      g_byte_array_append (output, (const guint8 *) &offset, 4);
+      g_byte_array_append (strings, (const guint8 *) str, strlen (str) + 1);
+    }
+
+  /* an empty string table still needs a terminator */
+  if (strings->len == 0)
+    g_byte_array_append (strings, (const guint8 *) "", 1);
+
+  g_byte_array_append (output, strings->data, strings->len);
+
+  /* now that the string data size is known, patch the header */
+  header.string_data_size = strings->len;
+  memcpy (output->data, &header, sizeof (BinaryHeader));
+
+  retval = g_file_set_contents (filename,
+                                (const gchar *) output->data,
+                                output->len,
+                                error);
+
+  CLUTTER_NOTE (SCRIPT,
+                "Compiled %u objects (%u types, %u strings) into '%s' "
+                "(%u bytes)",
+                n_objects,
+                header.n_types,
+                header.n_strings,
+                filename,
+                output->len);
+
+  g_byte_array_free (output, TRUE);
+  g_byte_array_free (strings, TRUE);
+  g_free (records);
+  g_hash_table_destroy (parents);
+
+  g_hash_table_destroy (writer.string_index);
+  g_ptr_array_free (writer.strings, TRUE);
+  g_hash_table_destroy (writer.fake_ids);
+  g_array_free (writer.types, TRUE);
+  g_ptr_array_free (writer.type_keys, TRUE);
+  g_byte_array_free (writer.data, TRUE);
+  g_ptr_array_free (writer.owned, TRUE);
+
+  return retval;
+}
@@ -81,19 +81,20 @@ clutter_script_get_type_from_symbol (const gchar *symbol)
   return gtype;
 }
 
-GType
-clutter_script_get_type_from_class (const gchar *name)
+/*
+ * _clutter_script_get_type_symbol:
+ * @name: the name of a class
+ *
+ * Derives the name of the GType function of the class @name.
+ *
+ * Return value: a newly allocated string
+ */
+gchar *
+_clutter_script_get_type_symbol (const gchar *name)
 {
-  static GModule *module = NULL;
   GString *symbol_name = g_string_sized_new (64);
-  GType gtype = G_TYPE_INVALID;
-  GTypeGetFunc func;
-  gchar *symbol;
   gint i;
 
-  if (G_UNLIKELY (!module))
-    module = g_module_open (NULL, 0);
-  
   for (i = 0; name[i] != '\0'; i++)
     {
       gchar c = name[i];
@@ -131,8 +132,22 @@ clutter_script_get_type_from_class (const gchar *name)
     }
 
   g_string_append (symbol_name, "_get_type");
-  
-  symbol = g_string_free (symbol_name, FALSE);
+
+  return g_string_free (symbol_name, FALSE);
+}
+
+GType
+clutter_script_get_type_from_class (const gchar *name)
+{
+  static GModule *module = NULL;
+  GType gtype = G_TYPE_INVALID;
+  GTypeGetFunc func;
+  gchar *symbol;
+
+  if (G_UNLIKELY (!module))
+    module = g_module_open (NULL, 0);
+
+  symbol = _clutter_script_get_type_symbol (name);
 
   if (g_module_symbol (module, symbol, (gpointer)&func))
     {
@@ -145,6 +160,97 @@ clutter_script_get_type_from_class (const gchar *name)
   return gtype;
 }
 
+/*
+ * Resolved type information
+ *
+ * Constructing the objects of a UI definition requires looking up the
+ * class of each object, its Scriptable implementation and the GParamSpec
+ * of each one of its properties. UI definitions tend to have many objects
+ * of the same type, so the results are cached for the whole process; the
+ * child and layout properties are cached on the type of the child meta.
+ *
+ * The class references are never released.
+ */
+typedef struct {
+  GType gtype;
+
+  GObjectClass *klass;
+  ClutterScriptableIface *scriptable;
+
+  /* property name -> GParamSpec, or NULL for custom properties */
+  GHashTable *properties;
+
+  guint is_actor : 1;
+  guint is_stage : 1;
+} ScriptTypeInfo;
+
+static GHashTable *script_type_infos = NULL;
+
+static ScriptTypeInfo *
+script_type_info_get (GType gtype)
+{
+  ScriptTypeInfo *info;
+
+  if (G_UNLIKELY (script_type_infos == NULL))
+    script_type_infos = g_hash_table_new (NULL, NULL);
+
+  info = g_hash_table_lookup (script_type_infos, GSIZE_TO_POINTER (gtype));
+  if (G_LIKELY (info != NULL))
+    return info;
+
+  info = g_slice_new0 (ScriptTypeInfo);
+  info->gtype = gtype;
+  info->klass = g_type_class_ref (gtype);
+  info->scriptable = g_type_interface_peek (info->klass,
+                                            CLUTTER_TYPE_SCRIPTABLE);
+  info->properties = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                            g_free,
+                                            NULL);
+  info->is_actor = g_type_is_a (gtype, CLUTTER_TYPE_ACTOR);
+  info->is_stage = g_type_is_a (gtype, CLUTTER_TYPE_STAGE);
+
+  CLUTTER_NOTE (SCRIPT, "Caching type information for '%s'",
+                g_type_name (gtype));
+
+  g_hash_table_insert (script_type_infos, GSIZE_TO_POINTER (gtype), info);
+
+  return info;
+}
+
+static GParamSpec *
+script_type_info_find_property (ScriptTypeInfo *info,
+                                const gchar    *name)
+{
+  gpointer pspec;
+
+  if (g_hash_table_lookup_extended (info->properties, name, NULL, &pspec))
+    return pspec;
+
+  /* we also cache the misses, since custom properties are as
+   * common as regular ones
+   */
+  pspec = g_object_class_find_property (info->klass, name);
+  g_hash_table_insert (info->properties, g_strdup (name), pspec);
+
+  return pspec;
+}
+
+/* replaces the GParamSpec of @pinfo, which might have been resolved
+ * against a different class in a previous pass
+ */
+static inline void
+property_info_set_pspec (PropertyInfo *pinfo,
+                         GParamSpec   *pspec)
+{
+  if (pinfo->pspec == pspec)
+    return;
+
+  if (pinfo->pspec != NULL)
+    g_param_spec_unref (pinfo->pspec);
+
+  pinfo->pspec = pspec != NULL ? g_param_spec_ref (pspec) : NULL;
+}
+
 /*
  * clutter_script_enum_from_string:
  * @type: a #GType for an enumeration type
@@ -886,6 +992,7 @@ clutter_script_parser_object_end (JsonParser *json_parser,
   JsonNode *val;
   const gchar *id_;
   GList *members, *l;
+  gboolean has_fake_id = FALSE;
 
   /* if the object definition does not have an 'id' field we'll
    * fake one for it...
@@ -910,6 +1017,8 @@ clutter_script_parser_object_end (JsonParser *json_parser,
                     json_object_get_string_member (object, "type"));
 
       g_free (fake);
+
+      has_fake_id = TRUE;
     }
 
   if (!json_object_has_member (object, "type"))
@@ -933,6 +1042,7 @@ clutter_script_parser_object_end (JsonParser *json_parser,
       oinfo = g_slice_new0 (ObjectInfo);
       oinfo->merge_id = _clutter_script_get_last_merge_id (script);
       oinfo->id = g_strdup (id_);
+      oinfo->has_fake_id = has_fake_id;
 
       class_name = json_object_get_string_member (object, "type");
       oinfo->class_name = g_strdup (class_name);
@@ -1038,13 +1148,19 @@ clutter_script_parser_object_end (JsonParser *json_parser,
                 g_list_length (oinfo->signals));
 
   _clutter_script_add_object_info (script, oinfo);
-  _clutter_script_construct_object (script, oinfo);
+
+  /* when compiling we only collect the definitions */
+  if (!_clutter_script_is_compiling (script))
+    _clutter_script_construct_object (script, oinfo);
 }
 
 static void
 clutter_script_parser_parse_end (JsonParser *parser)
 {
-  clutter_script_ensure_objects (CLUTTER_SCRIPT_PARSER (parser)->script);
+  ClutterScript *script = CLUTTER_SCRIPT_PARSER (parser)->script;
+
+  if (!_clutter_script_is_compiling (script))
+    clutter_script_ensure_objects (script);
 }
 
 gboolean
@@ -1097,7 +1213,14 @@ clutter_script_parse_node (ClutterScript *script,
                 return FALSE;
 
               oinfo = _clutter_script_get_object_info (script, id_);
-              if (oinfo == NULL || oinfo->gtype == G_TYPE_INVALID )
+              if (oinfo == NULL)
+                return FALSE;
+
+              /* compiled definitions are constructed lazily */
+              if (oinfo->gtype == G_TYPE_INVALID && oinfo->binary != NULL)
+                _clutter_script_construct_object (script, oinfo);
+
+              if (oinfo->gtype == G_TYPE_INVALID)
                 return FALSE;
 
               if (g_type_is_a (oinfo->gtype, p_type))
@@ -1387,16 +1510,16 @@ clutter_script_translate_parameters (ClutterScript  *script,
                                      GArray        **params)
 {
   ClutterScriptable *scriptable = NULL;
-  ClutterScriptableIface *iface = NULL;
+  ClutterScriptableIface *iface;
   GList *l, *unparsed;
   gboolean parse_custom = FALSE;
 
   *params = g_array_new (FALSE, FALSE, sizeof (GParameter));
 
-  if (CLUTTER_IS_SCRIPTABLE (object))
+  iface = script_type_info_get (G_OBJECT_TYPE (object))->scriptable;
+  if (iface != NULL)
     {
       scriptable = CLUTTER_SCRIPTABLE (object);
-      iface = CLUTTER_SCRIPTABLE_GET_IFACE (scriptable);
 
       if (iface->parse_custom_node)
         parse_custom = TRUE;
@@ -1460,11 +1583,11 @@ clutter_script_construct_parameters (ClutterScript  *script,
                                      GList          *properties,
                                      GArray        **construct_params)
 {
-  GObjectClass *klass;
+  ScriptTypeInfo *info;
   GList *l, *unparsed;
 
-  klass = g_type_class_ref (gtype);
-  g_assert (klass != NULL);
+  info = script_type_info_get (gtype);
+  g_assert (info->klass != NULL);
 
   *construct_params = g_array_new (FALSE, FALSE, sizeof (GParameter));
 
@@ -1481,12 +1604,10 @@ clutter_script_construct_parameters (ClutterScript  *script,
        * class we just skip it and let the class itself deal
        * with it later on
        */
-      pspec = g_object_class_find_property (klass, pinfo->name);
-      if (pspec)
-        pinfo->pspec = g_param_spec_ref (pspec);
-      else
+      pspec = script_type_info_find_property (info, pinfo->name);
+      property_info_set_pspec (pinfo, pspec);
+      if (pspec == NULL)
         {
-          pinfo->pspec = NULL;
           unparsed = g_list_prepend (unparsed, pinfo);
           continue;
         }
@@ -1515,8 +1636,6 @@ clutter_script_construct_parameters (ClutterScript  *script,
 
   g_list_free (properties);
 
-  g_type_class_unref (klass);
-
   return unparsed;
 }
 
@@ -1532,6 +1651,7 @@ apply_layout_properties (ClutterScript    *script,
   gboolean parse_custom_node = FALSE;
   GList *l, *unresolved, *properties;
   ClutterLayoutManager *manager;
+  ScriptTypeInfo *meta_info;
   GType meta_type;
 
   manager = g_object_get_data (G_OBJECT (container), "clutter-layout-manager");
@@ -1546,11 +1666,13 @@ apply_layout_properties (ClutterScript    *script,
                 G_OBJECT_TYPE_NAME (manager),
                 g_type_name (meta_type));
 
+  meta_info = script_type_info_get (meta_type);
+
   /* shortcut, to avoid typechecking every time */
-  if (CLUTTER_IS_SCRIPTABLE (manager))
+  iface = script_type_info_get (G_OBJECT_TYPE (manager))->scriptable;
+  if (iface != NULL)
     {
       scriptable = CLUTTER_SCRIPTABLE (manager);
-      iface = CLUTTER_SCRIPTABLE_GET_IFACE (scriptable);
 
       parse_custom_node = iface->parse_custom_node != NULL ? TRUE : FALSE;
       set_custom_property = iface->set_custom_property != NULL ? TRUE : FALSE;
@@ -1575,11 +1697,9 @@ apply_layout_properties (ClutterScript    *script,
 
       name = pinfo->name + strlen ("layout::");
 
-      pinfo->pspec =
-        clutter_layout_manager_find_child_property (manager, name);
-
-      if (pinfo->pspec != NULL)
-        g_param_spec_ref (pinfo->pspec);
+      property_info_set_pspec (pinfo,
+                               script_type_info_find_property (meta_info,
+                                                               name));
 
       CLUTTER_NOTE (SCRIPT, "Parsing %s layout property (id:%s)",
                     pinfo->pspec != NULL ? "regular" : "custom",
@@ -1637,20 +1757,21 @@ apply_child_properties (ClutterScript    *script,
   gboolean set_custom_property = FALSE;
   gboolean parse_custom_node = FALSE;
   GList *l, *unresolved, *properties;
-  GObjectClass *klass;
+  ScriptTypeInfo *meta_info;
   GType meta_type;
 
   meta_type = CLUTTER_CONTAINER_GET_IFACE (container)->child_meta_type;
   if (meta_type == G_TYPE_INVALID)
     return;
 
-  klass = G_OBJECT_GET_CLASS (container);
+  /* the child properties are the properties of the child meta */
+  meta_info = script_type_info_get (meta_type);
 
   /* shortcut, to avoid typechecking every time */
-  if (CLUTTER_IS_SCRIPTABLE (container))
+  iface = script_type_info_get (G_OBJECT_TYPE (container))->scriptable;
+  if (iface != NULL)
     {
       scriptable = CLUTTER_SCRIPTABLE (container);
-      iface = CLUTTER_SCRIPTABLE_GET_IFACE (scriptable);
 
       parse_custom_node = iface->parse_custom_node != NULL ? TRUE : FALSE;
       set_custom_property = iface->set_custom_property != NULL ? TRUE : FALSE;
@@ -1675,11 +1796,9 @@ apply_child_properties (ClutterScript    *script,
 
       name = pinfo->name + strlen ("child::");
 
-      pinfo->pspec =
-        clutter_container_class_find_child_property (klass, name);
-
-      if (pinfo->pspec != NULL)
-        g_param_spec_ref (pinfo->pspec);
+      property_info_set_pspec (pinfo,
+                               script_type_info_find_property (meta_info,
+                                                               name));
 
       CLUTTER_NOTE (SCRIPT, "Parsing %s child property (id:%s)",
                     pinfo->pspec != NULL ? "regular" : "custom",
@@ -1850,10 +1969,10 @@ _clutter_script_apply_properties (ClutterScript *script,
     return;
 
   /* shortcut, to avoid typechecking every time */
-  if (CLUTTER_IS_SCRIPTABLE (object))
+  iface = script_type_info_get (G_OBJECT_TYPE (object))->scriptable;
+  if (iface != NULL)
     {
       scriptable = CLUTTER_SCRIPTABLE (object);
-      iface = CLUTTER_SCRIPTABLE_GET_IFACE (scriptable);
 
       if (iface->set_custom_property)
         set_custom_property = TRUE;
@@ -1905,6 +2024,10 @@ _clutter_script_construct_object (ClutterScript *script,
   GArray *params;
   guint i;
 
+  /* decode the compiled definition the first time it is needed */
+  if (oinfo->binary != NULL)
+    _clutter_script_binary_expand (script, oinfo);
+
   /* we have completely updated the object */
   if (oinfo->object != NULL)
     {
@@ -1916,17 +2039,20 @@ _clutter_script_construct_object (ClutterScript *script,
 
   if (oinfo->gtype == G_TYPE_INVALID)
     {
-      if (G_UNLIKELY (oinfo->type_func))
-        oinfo->gtype = clutter_script_get_type_from_symbol (oinfo->type_func);
-      else
-        oinfo->gtype = clutter_script_get_type_from_name (script, oinfo->class_name);
+      ScriptTypeInfo *info;
+
+      oinfo->gtype = _clutter_script_resolve_type (script,
+                                                   oinfo->class_name,
+                                                   oinfo->type_func);
 
       if (G_UNLIKELY (oinfo->gtype == G_TYPE_INVALID))
         return;
 
-      oinfo->is_actor = g_type_is_a (oinfo->gtype, CLUTTER_TYPE_ACTOR);
+      info = script_type_info_get (oinfo->gtype);
+
+      oinfo->is_actor = info->is_actor;
       if (oinfo->is_actor)
-        oinfo->is_stage = g_type_is_a (oinfo->gtype, CLUTTER_TYPE_STAGE);
+        oinfo->is_stage = info->is_stage;
     }
 
   if (oinfo->is_stage && oinfo->is_stage_default)
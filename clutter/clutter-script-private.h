@@ -52,6 +52,8 @@ struct _ClutterScriptParser
 
 typedef GType (* GTypeGetFunc) (void);
 
+typedef struct _ClutterScriptBinary     ClutterScriptBinary;
+
 typedef struct {
   gchar *id;
   gchar *class_name;
@@ -66,11 +68,18 @@ typedef struct {
 
   guint merge_id;
 
+  /* set for definitions loaded from a compiled file which
+   * have not been expanded yet
+   */
+  ClutterScriptBinary *binary;
+  guint binary_index;
+
   guint is_actor         : 1;
   guint is_stage         : 1;
   guint is_stage_default : 1;
   guint has_unresolved   : 1;
   guint is_unmerged      : 1;
+  guint has_fake_id      : 1;
 } ObjectInfo;
 
 void object_info_free (gpointer data);
@@ -104,6 +113,11 @@ gboolean clutter_script_parse_node        (ClutterScript *script,
 
 GType    clutter_script_get_type_from_symbol (const gchar *symbol);
 GType    clutter_script_get_type_from_class  (const gchar *name);
+gchar *  _clutter_script_get_type_symbol     (const gchar *name);
+
+GType    _clutter_script_resolve_type (ClutterScript *script,
+                                       const gchar   *class_name,
+                                       const gchar   *type_func);
 
 gulong   clutter_script_resolve_animation_mode (JsonNode *node);
 
@@ -152,6 +166,30 @@ void _clutter_script_add_object_info (ClutterScript *script,
 
 const gchar *_clutter_script_get_id_from_node (JsonNode *node);
 
+gboolean _clutter_script_is_compiling (ClutterScript *script);
+
+void _clutter_script_add_pending_object (ClutterScript *script,
+                                         ObjectInfo    *oinfo);
+
+gboolean             _clutter_script_binary_check       (const gchar          *data,
+                                                         gsize                 length);
+ClutterScriptBinary *_clutter_script_binary_new         (GMappedFile          *mapped_file,
+                                                         const gchar          *data,
+                                                         gsize                 length,
+                                                         GError              **error);
+ClutterScriptBinary *_clutter_script_binary_ref         (ClutterScriptBinary  *binary);
+void                 _clutter_script_binary_unref       (ClutterScriptBinary  *binary);
+gboolean             _clutter_script_binary_load        (ClutterScript        *script,
+                                                         ClutterScriptBinary  *binary,
+                                                         GError              **error);
+void                 _clutter_script_binary_expand      (ClutterScript        *script,
+                                                         ObjectInfo           *oinfo);
+gboolean             _clutter_script_binary_has_signals (ObjectInfo           *oinfo);
+gboolean             _clutter_script_binary_write       (ClutterScript        *script,
+                                                         GList                *objects,
+                                                         const gchar          *filename,
+                                                         GError              **error);
+
 G_END_DECLS
 
 #endif /* __CLUTTER_SCRIPT_PRIVATE_H__ */
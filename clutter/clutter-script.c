@@ -237,7 +237,17 @@ struct _ClutterScriptPrivate
   gchar **search_paths;
 
   gchar *filename;
+
+  /* class name or type function -> GType */
+  GHashTable *types;
+
+  /* ids of the compiled definitions that have been constructed
+   * but still need their properties applied
+   */
+  GSList *pending_ids;
+
   guint is_filename : 1;
+  guint is_compiling : 1;
 };
 
 G_DEFINE_TYPE (ClutterScript, clutter_script, G_TYPE_OBJECT);
@@ -310,6 +320,9 @@ object_info_free (gpointer data)
       g_list_foreach (oinfo->children, (GFunc) g_free, NULL);
       g_list_free (oinfo->children);
 
+      if (oinfo->binary != NULL)
+        _clutter_script_binary_unref (oinfo->binary);
+
       /* we unref top-level objects and leave the actors alone,
        * unless we are unmerging in which case we have to destroy
        * the actor to unparent them
@@ -341,6 +354,11 @@ clutter_script_finalize (GObject *gobject)
   g_strfreev (priv->search_paths);
   g_free (priv->filename);
 
+  g_hash_table_destroy (priv->types);
+
+  g_slist_foreach (priv->pending_ids, (GFunc) g_free, NULL);
+  g_slist_free (priv->pending_ids);
+
   G_OBJECT_CLASS (clutter_script_parent_class)->finalize (gobject);
 }
 
@@ -430,6 +448,9 @@ clutter_script_init (ClutterScript *script)
   priv->objects = g_hash_table_new_full (g_str_hash, g_str_equal,
                                          NULL,
                                          object_info_free);
+  priv->types = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                       g_free,
+                                       NULL);
 }
 
 /**
@@ -461,6 +482,11 @@ clutter_script_new (void)
  * Loads the definitions from @filename into @script and merges with
  * the currently loaded ones, if any.
  *
+ * Since Clutter 1.8, @filename can also point to a compiled UI
+ * definition created by clutter_script_compile_file(); the objects
+ * of a compiled definition are constructed the first time they are
+ * retrieved.
+ *
  * Return value: on error, zero is returned and @error is set
  *   accordingly. On success, the merge id for the UI definitions is
  *   returned. You can use the merge id with clutter_script_unmerge_objects().
@@ -473,6 +499,7 @@ clutter_script_load_from_file (ClutterScript  *script,
                                GError        **error)
 {
   ClutterScriptPrivate *priv;
+  GMappedFile *mapped_file;
   GError *internal_error;
 
   g_return_val_if_fail (CLUTTER_IS_SCRIPT (script), 0);
@@ -486,9 +513,31 @@ clutter_script_load_from_file (ClutterScript  *script,
   priv->last_merge_id += 1;
 
   internal_error = NULL;
-  json_parser_load_from_file (JSON_PARSER (priv->parser),
-                              filename,
-                              &internal_error);
+
+  /* compiled definitions are mapped in memory, instead of parsed */
+  mapped_file = g_mapped_file_new (filename, FALSE, NULL);
+  if (mapped_file != NULL &&
+      _clutter_script_binary_check (g_mapped_file_get_contents (mapped_file),
+                                    g_mapped_file_get_length (mapped_file)))
+    {
+      ClutterScriptBinary *binary;
+
+      binary = _clutter_script_binary_new (mapped_file, NULL, 0,
+                                           &internal_error);
+      if (binary != NULL)
+        {
+          _clutter_script_binary_load (script, binary, &internal_error);
+          _clutter_script_binary_unref (binary);
+        }
+    }
+  else
+    json_parser_load_from_file (JSON_PARSER (priv->parser),
+                                filename,
+                                &internal_error);
+
+  if (mapped_file != NULL)
+    g_mapped_file_unref (mapped_file);
+
   if (internal_error)
     {
       g_propagate_error (error, internal_error);
@@ -510,6 +559,10 @@ clutter_script_load_from_file (ClutterScript  *script,
  * Loads the definitions from @data into @script and merges with
  * the currently loaded ones, if any.
  *
+ * Since Clutter 1.8, @data can also contain a compiled UI definition
+ * created by clutter_script_compile_file(); in that case @length must
+ * be set.
+ *
  * Return value: on error, zero is returned and @error is set
  *   accordingly. On success, the merge id for the UI definitions is
  *   returned. You can use the merge id with clutter_script_unmerge_objects().
@@ -539,9 +592,24 @@ clutter_script_load_from_data (ClutterScript  *script,
   priv->last_merge_id += 1;
 
   internal_error = NULL;
-  json_parser_load_from_data (JSON_PARSER (priv->parser),
-                              data, length,
-                              &internal_error);
+
+  if (_clutter_script_binary_check (data, length))
+    {
+      ClutterScriptBinary *binary;
+
+      binary = _clutter_script_binary_new (NULL, data, length,
+                                           &internal_error);
+      if (binary != NULL)
+        {
+          _clutter_script_binary_load (script, binary, &internal_error);
+          _clutter_script_binary_unref (binary);
+        }
+    }
+  else
+    json_parser_load_from_data (JSON_PARSER (priv->parser),
+                                data, length,
+                                &internal_error);
+
   if (internal_error)
     {
       g_propagate_error (error, internal_error);
@@ -552,6 +620,130 @@ clutter_script_load_from_data (ClutterScript  *script,
   return priv->last_merge_id;
 }
 
+/**
+ * clutter_script_compile_file:
+ * @script: a #ClutterScript
+ * @filename: the full path to the definition file
+ * @output: the full path of the compiled file
+ * @error: return location for a #GError, or %NULL
+ *
+ * Compiles the UI definitions inside @filename into @output.
+ *
+ * A compiled UI definition can be loaded using
+ * clutter_script_load_from_file() or clutter_script_load_from_data()
+ * without parsing the JSON data again; the type names and enumeration
+ * values are resolved while compiling, and each object is constructed
+ * the first time it is retrieved, instead of when loading.
+ *
+ * The objects defined in @filename are not constructed, and they are
+ * not merged into @script. The compiled file is specific to the byte
+ * order of the host, and it should be regenerated when @filename
+ * changes.
+ *
+ * Return value: %TRUE if the file was compiled, and %FALSE otherwise
+ *
+ * Since: 1.8
+ */
+gboolean
+clutter_script_compile_file (ClutterScript  *script,
+                             const gchar    *filename,
+                             const gchar    *output,
+                             GError        **error)
+{
+  ClutterScript *compiler;
+  ClutterScriptPrivate *priv;
+  GList *objects;
+  gboolean retval;
+
+  g_return_val_if_fail (CLUTTER_IS_SCRIPT (script), FALSE);
+  g_return_val_if_fail (filename != NULL, FALSE);
+  g_return_val_if_fail (output != NULL, FALSE);
+
+  /* we use a scratch instance of the same class, so that the
+   * types are resolved like @script would
+   */
+  compiler = g_object_new (G_OBJECT_TYPE (script), NULL);
+
+  priv = compiler->priv;
+  priv->filename = g_strdup (filename);
+  priv->is_filename = TRUE;
+  priv->is_compiling = TRUE;
+  priv->last_merge_id = 1;
+
+  if (!json_parser_load_from_file (JSON_PARSER (priv->parser),
+                                   filename,
+                                   error))
+    {
+      g_object_unref (compiler);
+      return FALSE;
+    }
+
+  objects = g_hash_table_get_values (priv->objects);
+  retval = _clutter_script_binary_write (compiler, objects, output, error);
+
+  g_list_free (objects);
+  g_object_unref (compiler);
+
+  return retval;
+}
+
+/*
+ * _clutter_script_is_compiling:
+ * @script: a #ClutterScript
+ *
+ * Checks whether @script is only collecting the object definitions
+ * for clutter_script_compile_file()
+ */
+gboolean
+_clutter_script_is_compiling (ClutterScript *script)
+{
+  return script->priv->is_compiling;
+}
+
+/*
+ * _clutter_script_add_pending_object:
+ * @script: a #ClutterScript
+ * @oinfo: a #ObjectInfo
+ *
+ * Queues the compiled definition @oinfo, so that its properties will
+ * be applied once the object that needed it has been retrieved.
+ */
+void
+_clutter_script_add_pending_object (ClutterScript *script,
+                                    ObjectInfo    *oinfo)
+{
+  ClutterScriptPrivate *priv = script->priv;
+
+  priv->pending_ids = g_slist_prepend (priv->pending_ids,
+                                       g_strdup (oinfo->id));
+}
+
+/* the compiled definitions are constructed on demand, which also
+ * constructs the objects they reference and their children; those
+ * objects need their properties applied too, like they would if
+ * the whole definition had been built when loading
+ */
+static void
+clutter_script_apply_pending (ClutterScript *script)
+{
+  ClutterScriptPrivate *priv = script->priv;
+
+  while (priv->pending_ids != NULL)
+    {
+      gchar *id_ = priv->pending_ids->data;
+      ObjectInfo *oinfo;
+
+      priv->pending_ids = g_slist_delete_link (priv->pending_ids,
+                                               priv->pending_ids);
+
+      oinfo = g_hash_table_lookup (priv->objects, id_);
+      if (oinfo != NULL && oinfo->object != NULL)
+        _clutter_script_apply_properties (script, oinfo);
+
+      g_free (id_);
+    }
+}
+
 /**
  * clutter_script_get_object:
  * @script: a #ClutterScript
@@ -581,6 +773,8 @@ clutter_script_get_object (ClutterScript *script,
   _clutter_script_construct_object (script, oinfo);
   _clutter_script_apply_properties (script, oinfo);
 
+  clutter_script_apply_pending (script);
+
   return oinfo->object;
 }
 
@@ -761,6 +955,8 @@ clutter_script_ensure_objects (ClutterScript *script)
 
   priv = script->priv;
   g_hash_table_foreach (priv->objects, construct_each_objects, script);
+
+  clutter_script_apply_pending (script);
 }
 
 /**
@@ -787,6 +983,42 @@ clutter_script_get_type_from_name (ClutterScript *script,
   return CLUTTER_SCRIPT_GET_CLASS (script)->get_type_from_name (script, type_name);
 }
 
+/*
+ * _clutter_script_resolve_type:
+ * @script: a #ClutterScript
+ * @class_name: the name of the class
+ * @type_func: (allow-none): the name of the GType function, or %NULL
+ *
+ * Resolves the type of an object definition, using @type_func if
+ * set and clutter_script_get_type_from_name() otherwise. The result
+ * is cached, so that the objects sharing a class only resolve it once.
+ *
+ * Return value: the #GType, or %G_TYPE_INVALID
+ */
+GType
+_clutter_script_resolve_type (ClutterScript *script,
+                              const gchar   *class_name,
+                              const gchar   *type_func)
+{
+  ClutterScriptPrivate *priv = script->priv;
+  const gchar *key = type_func != NULL ? type_func : class_name;
+  GType gtype;
+
+  gtype = GPOINTER_TO_SIZE (g_hash_table_lookup (priv->types, key));
+  if (gtype != G_TYPE_INVALID)
+    return gtype;
+
+  if (G_UNLIKELY (type_func != NULL))
+    gtype = clutter_script_get_type_from_symbol (type_func);
+  else
+    gtype = clutter_script_get_type_from_name (script, class_name);
+
+  if (gtype != G_TYPE_INVALID)
+    g_hash_table_insert (priv->types, g_strdup (key), GSIZE_TO_POINTER (gtype));
+
+  return gtype;
+}
+
 /**
  * clutter_get_script_id:
  * @gobject: a #GObject
@@ -986,6 +1218,7 @@ clutter_script_connect_signals_full (ClutterScript            *script,
                                      gpointer                  user_data)
 {
   SignalConnectData data;
+  GList *objects, *l;
 
   g_return_if_fail (CLUTTER_IS_SCRIPT (script));
   g_return_if_fail (func != NULL);
@@ -994,6 +1227,18 @@ clutter_script_connect_signals_full (ClutterScript            *script,
   data.func = func;
   data.user_data = user_data;
 
+  /* the compiled definitions with signals need their object */
+  objects = g_hash_table_get_values (script->priv->objects);
+  for (l = objects; l != NULL; l = l->next)
+    {
+      ObjectInfo *oinfo = l->data;
+
+      if (oinfo->binary != NULL && _clutter_script_binary_has_signals (oinfo))
+        clutter_script_get_object (script, oinfo->id);
+    }
+
+  g_list_free (objects);
+
   g_hash_table_foreach (script->priv->objects, connect_each_object, &data);
 }
 
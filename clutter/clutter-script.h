@@ -153,6 +153,10 @@ guint          clutter_script_load_from_data       (ClutterScript  *script,
                                                     const gchar    *data,
                                                     gssize          length,
                                                     GError        **error);
+gboolean       clutter_script_compile_file         (ClutterScript  *script,
+                                                    const gchar    *filename,
+                                                    const gchar    *output,
+                                                    GError        **error);
 
 GObject *      clutter_script_get_object           (ClutterScript  *script,
                                                     const gchar    *name);
@@ -125,7 +125,13 @@ struct _ClutterStagePrivate
   gchar              *title;
   ClutterActor       *key_focused_actor;
 
-  GQueue             *event_queue;
+  /* the events queued for the next frame, as a ring buffer; the
+   * ring only grows if more events than its size are queued
+   */
+  ClutterEvent      **event_ring;
+  guint               event_ring_size;
+  guint               event_ring_head;
+  guint               event_ring_length;
 
   ClutterStageHint    stage_hints;
 
@@ -155,6 +161,7 @@ struct _ClutterStagePrivate
   guint is_user_resizable      : 1;
   guint use_fog                : 1;
   guint throttle_motion_events : 1;
+  guint keep_motion_history    : 1;
   guint use_alpha              : 1;
   guint min_size_changed       : 1;
   guint dirty_viewport         : 1;
@@ -763,9 +770,89 @@ clutter_stage_real_fullscreen (ClutterStage *stage)
                           CLUTTER_ALLOCATION_NONE);
 }
 
+/* the initial size of the event ring; must be a power of two */
+#define EVENT_RING_SIZE         64
+
+static void
+clutter_stage_event_ring_push (ClutterStagePrivate *priv,
+                               ClutterEvent        *event)
+{
+  guint mask;
+
+  if (G_UNLIKELY (priv->event_ring_length == priv->event_ring_size))
+    {
+      ClutterEvent **ring;
+      guint i, new_size;
+
+      new_size = priv->event_ring_size > 0
+               ? priv->event_ring_size * 2
+               : EVENT_RING_SIZE;
+
+      /* unwrap the events at the beginning of the new ring */
+      ring = g_new (ClutterEvent *, new_size);
+      for (i = 0; i < priv->event_ring_length; i++)
+        {
+          guint pos = (priv->event_ring_head + i)
+                    & (priv->event_ring_size - 1);
+
+          ring[i] = priv->event_ring[pos];
+        }
+
+      g_free (priv->event_ring);
+
+      priv->event_ring = ring;
+      priv->event_ring_size = new_size;
+      priv->event_ring_head = 0;
+    }
+
+  mask = priv->event_ring_size - 1;
+  priv->event_ring[(priv->event_ring_head + priv->event_ring_length) & mask] =
+    event;
+  priv->event_ring_length += 1;
+}
+
+static ClutterEvent *
+clutter_stage_event_ring_pop (ClutterStagePrivate *priv)
+{
+  ClutterEvent *event;
+
+  if (priv->event_ring_length == 0)
+    return NULL;
+
+  event = priv->event_ring[priv->event_ring_head];
+
+  priv->event_ring_head = (priv->event_ring_head + 1)
+                        & (priv->event_ring_size - 1);
+  priv->event_ring_length -= 1;
+
+  return event;
+}
+
+static ClutterEvent *
+clutter_stage_event_ring_peek (ClutterStagePrivate *priv)
+{
+  if (priv->event_ring_length == 0)
+    return NULL;
+
+  return priv->event_ring[priv->event_ring_head];
+}
+
+/*< private >
+ * _clutter_stage_queue_event:
+ * @stage: a #ClutterStage
+ * @event: a #ClutterEvent
+ * @copy_event: whether @event should be copied
+ *
+ * Queues @event for processing before the next frame.
+ *
+ * If @copy_event is %FALSE the stage takes ownership of @event, which
+ * must have been allocated using clutter_event_new(); otherwise @event
+ * is only borrowed, and the caller keeps ownership of it.
+ */
 void
 _clutter_stage_queue_event (ClutterStage *stage,
-			    ClutterEvent *event)
+			    ClutterEvent *event,
+                            gboolean      copy_event)
 {
   ClutterStagePrivate *priv;
   gboolean first_event;
@@ -775,9 +862,12 @@ _clutter_stage_queue_event (ClutterStage *stage,
 
   priv = stage->priv;
 
-  first_event = priv->event_queue->length == 0;
+  first_event = priv->event_ring_length == 0;
 
-  g_queue_push_tail (priv->event_queue, clutter_event_copy (event));
+  if (copy_event)
+    clutter_stage_event_ring_push (priv, clutter_event_copy (event));
+  else
+    clutter_stage_event_ring_push (priv, event);
 
   if (first_event)
     {
@@ -813,33 +903,32 @@ _clutter_stage_has_queued_events (ClutterStage *stage)
 
   priv = stage->priv;
 
-  return priv->event_queue->length > 0;
+  return priv->event_ring_length > 0;
 }
 
 void
 _clutter_stage_process_queued_events (ClutterStage *stage)
 {
   ClutterStagePrivate *priv;
-  GList *events, *l;
+  guint n_events;
 
   g_return_if_fail (CLUTTER_IS_STAGE (stage));
 
   priv = stage->priv;
 
-  if (priv->event_queue->length == 0)
+  if (priv->event_ring_length == 0)
     return;
 
   /* In case the stage gets destroyed during event processing */
   g_object_ref (stage);
 
-  /* Steal events before starting processing to avoid reentrancy
-   * issues */
-  events = priv->event_queue->head;
-  priv->event_queue->head =  NULL;
-  priv->event_queue->tail = NULL;
-  priv->event_queue->length = 0;
+  /* Only process the events queued so far, to avoid reentrancy
+   * issues; the events queued by the handlers are going to be
+   * processed on the next frame
+   */
+  n_events = priv->event_ring_length;
 
-  for (l = events; l != NULL; l = l->next)
+  while (n_events > 0)
     {
       ClutterEvent *event;
       ClutterEvent *next_event;
@@ -847,8 +936,10 @@ _clutter_stage_process_queued_events (ClutterStage *stage)
       ClutterInputDevice *next_device;
       gboolean check_device = FALSE;
 
-      event = l->data;
-      next_event = l->next ? l->next->data : NULL;
+      event = clutter_stage_event_ring_pop (priv);
+      n_events -= 1;
+
+      next_event = n_events > 0 ? clutter_stage_event_ring_peek (priv) : NULL;
 
       device = clutter_event_get_device (event);
 
@@ -872,17 +963,26 @@ _clutter_stage_process_queued_events (ClutterStage *stage)
                         "Omitting motion event at %d, %d",
                         (int) event->motion.x,
                         (int) event->motion.y);
+
+          /* the delivered event carries the omitted ones, but we still
+           * pick only once for all of them
+           */
+          if (priv->keep_motion_history &&
+              next_event->type == CLUTTER_MOTION)
+            _clutter_event_push_motion_history (next_event, event);
+
           goto next_event;
 	}
 
+      /* the handlers only borrow the event; it goes back to the
+       * pool of events as soon as it has been processed
+       */
       _clutter_process_event (event);
 
     next_event:
       clutter_event_free (event);
     }
 
-  g_list_free (events);
-
   g_object_unref (stage);
 }
 
@@ -1327,8 +1427,10 @@ clutter_stage_finalize (GObject *object)
   ClutterStage *stage = CLUTTER_STAGE (object);
   ClutterStagePrivate *priv = stage->priv;
 
-  g_queue_foreach (priv->event_queue, (GFunc) clutter_event_free, NULL);
-  g_queue_free (priv->event_queue);
+  while (priv->event_ring_length > 0)
+    clutter_event_free (clutter_stage_event_ring_pop (priv));
+
+  g_free (priv->event_ring);
 
   g_free (priv->title);
 
@@ -1711,8 +1813,6 @@ clutter_stage_init (ClutterStage *self)
       g_assert (priv->impl != NULL);
     }
 
-  priv->event_queue = g_queue_new ();
-
   priv->is_fullscreen          = FALSE;
   priv->is_user_resizable      = FALSE;
   priv->is_cursor_visible      = TRUE;
@@ -3035,6 +3135,52 @@ clutter_stage_get_throttle_motion_events (ClutterStage *stage)
   return stage->priv->throttle_motion_events;
 }
 
+/**
+ * clutter_stage_set_keep_motion_history:
+ * @stage: a #ClutterStage
+ * @keep_history: %TRUE to keep the history of the throttled motion events
+ *
+ * Sets whether the motion events compressed when throttling the motion
+ * events should be kept inside the motion event that is propagated.
+ *
+ * This allows applications that need every intermediate position of
+ * the pointer, like drawing applications, to retrieve them using
+ * clutter_event_get_motion_history(), while still only picking once
+ * for all the motion events received between two redraws.
+ *
+ * This function has no effect unless the motion events are throttled;
+ * see clutter_stage_set_throttle_motion_events()
+ *
+ * Since: 1.8
+ */
+void
+clutter_stage_set_keep_motion_history (ClutterStage *stage,
+                                       gboolean      keep_history)
+{
+  g_return_if_fail (CLUTTER_IS_STAGE (stage));
+
+  stage->priv->keep_motion_history = keep_history ? TRUE : FALSE;
+}
+
+/**
+ * clutter_stage_get_keep_motion_history:
+ * @stage: a #ClutterStage
+ *
+ * Retrieves the value set with clutter_stage_set_keep_motion_history()
+ *
+ * Return value: %TRUE if the history of the throttled motion events
+ *   is kept
+ *
+ * Since: 1.8
+ */
+gboolean
+clutter_stage_get_keep_motion_history (ClutterStage *stage)
+{
+  g_return_val_if_fail (CLUTTER_IS_STAGE (stage), FALSE);
+
+  return stage->priv->keep_motion_history;
+}
+
 /**
  * clutter_stage_set_use_alpha:
  * @stage: a #ClutterStage
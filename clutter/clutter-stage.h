@@ -242,6 +242,9 @@ void                  clutter_stage_ensure_redraw      (ClutterStage *stage);
 void     clutter_stage_set_throttle_motion_events (ClutterStage *stage,
                                                    gboolean      throttle);
 gboolean clutter_stage_get_throttle_motion_events (ClutterStage *stage);
+void     clutter_stage_set_keep_motion_history    (ClutterStage *stage,
+                                                   gboolean      keep_history);
+gboolean clutter_stage_get_keep_motion_history    (ClutterStage *stage);
 
 void                  clutter_stage_set_use_alpha      (ClutterStage *stage,
                                                         gboolean      use_alpha);
@@ -75,6 +75,7 @@
 #endif
 
 #include <math.h>
+#include <string.h>
 
 #include "clutter-table-layout.h"
 
@@ -98,9 +99,10 @@ typedef struct _DimensionData {
   gfloat pref_size;
   gfloat final_size;
 
-  guint expand  : 1;
-  guint shrink  : 1;
-  guint visible : 1;
+  guint expand       : 1;
+  guint shrink       : 1;
+  guint visible      : 1;
+  guint needs_update : 1;
 } DimensionData;
 
 struct _ClutterTableLayoutPrivate
@@ -120,11 +122,37 @@ struct _ClutterTableLayoutPrivate
   GArray *columns;
   GArray *rows;
 
+  /* the requests of the non-spanning children of each column and
+   * row; an entry is only computed again when one of the children
+   * occupying it queues a relayout
+   */
+  GArray *col_requests;
+  GArray *row_requests;
+
+  /* the width of each column used to compute the row requests */
+  GArray *row_col_sizes;
+
+  /* the children anchored to each column and row, as a GSList of
+   * ClutterTableChild, and the children spanning multiple columns
+   * or rows; rebuilt only when the structure of the table changes
+   */
+  GPtrArray *col_cells;
+  GPtrArray *row_cells;
+  GSList *col_spanning;
+  GSList *row_spanning;
+
+  /* the size used to compute the current solution */
+  gint cols_for_width;
+  gint rows_for_height;
+
   gulong easing_mode;
   guint easing_duration;
 
   guint is_animating   : 1;
   guint use_animations : 1;
+  guint needs_rebuild  : 1;
+  guint cols_valid     : 1;
+  guint rows_valid     : 1;
 };
 
 struct _ClutterTableChild
@@ -188,6 +216,46 @@ G_DEFINE_TYPE (ClutterTableLayout,
                clutter_table_layout,
                CLUTTER_TYPE_LAYOUT_MANAGER);
 
+/* discards the cached children index, which will be rebuilt by
+ * table_layout_update_cells() the next time it is needed
+ */
+static void
+table_layout_invalidate_cells (ClutterTableLayout *self)
+{
+  self->priv->needs_rebuild = TRUE;
+}
+
+/* marks the requests of the columns and rows occupied by @meta
+ * as needing to be computed again
+ */
+static void
+table_layout_invalidate_child (ClutterTableLayout *self,
+                               ClutterTableChild  *meta)
+{
+  ClutterTableLayoutPrivate *priv = self->priv;
+  DimensionData *requests;
+  gint i;
+
+  if (priv->needs_rebuild)
+    return;
+
+  requests = (DimensionData *) priv->col_requests->data;
+  for (i = meta->col;
+       i < meta->col + meta->col_span && i < (gint) priv->col_requests->len;
+       i++)
+    {
+      requests[i].needs_update = TRUE;
+    }
+
+  requests = (DimensionData *) priv->row_requests->data;
+  for (i = meta->row;
+       i < meta->row + meta->row_span && i < (gint) priv->row_requests->len;
+       i++)
+    {
+      requests[i].needs_update = TRUE;
+    }
+}
+
 /*
  * ClutterBoxChild
  */
@@ -221,6 +289,8 @@ table_child_set_position (ClutterTableChild *self,
       layout = clutter_layout_meta_get_manager (CLUTTER_LAYOUT_META (self));
       priv = CLUTTER_TABLE_LAYOUT (layout)->priv;
 
+      table_layout_invalidate_cells (CLUTTER_TABLE_LAYOUT (layout));
+
       g_object_freeze_notify (G_OBJECT (self));
 
       if (priv->use_animations)
@@ -271,6 +341,8 @@ table_child_set_span (ClutterTableChild  *self,
       layout = clutter_layout_meta_get_manager (CLUTTER_LAYOUT_META (self));
       table = CLUTTER_TABLE_LAYOUT (layout);
 
+      table_layout_invalidate_cells (table);
+
       if (table->priv->use_animations)
         {
           clutter_layout_manager_begin_animation (layout,
@@ -419,6 +491,8 @@ table_child_set_expand (ClutterTableChild *self,
       layout = clutter_layout_meta_get_manager (CLUTTER_LAYOUT_META (self));
       priv = CLUTTER_TABLE_LAYOUT (layout)->priv;
 
+      table_layout_invalidate_child (CLUTTER_TABLE_LAYOUT (layout), self);
+
       g_object_freeze_notify (G_OBJECT (self));
 
       if (priv->use_animations)
@@ -696,15 +770,115 @@ clutter_table_layout_get_child_meta_type (ClutterLayoutManager *manager)
   return CLUTTER_TYPE_TABLE_CHILD;
 }
 
+static void
+table_layout_child_queue_relayout (ClutterActor       *actor,
+                                   ClutterTableLayout *self)
+{
+  ClutterTableLayoutPrivate *priv = self->priv;
+  ClutterLayoutMeta *meta;
+
+  if (priv->needs_rebuild || priv->container == NULL)
+    return;
+
+  meta = clutter_layout_manager_get_child_meta (CLUTTER_LAYOUT_MANAGER (self),
+                                                priv->container,
+                                                actor);
+  if (meta != NULL)
+    table_layout_invalidate_child (self, CLUTTER_TABLE_CHILD (meta));
+}
+
+static void
+table_layout_child_notify_visible (ClutterActor       *actor,
+                                   GParamSpec         *pspec,
+                                   ClutterTableLayout *self)
+{
+  /* hiding a child only queues a relayout on its parent */
+  table_layout_child_queue_relayout (actor, self);
+}
+
+static void
+table_layout_track_child (ClutterActor *actor,
+                          gpointer      user_data)
+{
+  g_signal_connect (actor, "queue-relayout",
+                    G_CALLBACK (table_layout_child_queue_relayout),
+                    user_data);
+  g_signal_connect (actor, "notify::visible",
+                    G_CALLBACK (table_layout_child_notify_visible),
+                    user_data);
+}
+
+static void
+table_layout_untrack_child (ClutterActor *actor,
+                            gpointer      user_data)
+{
+  g_signal_handlers_disconnect_by_func (actor,
+                                        table_layout_child_queue_relayout,
+                                        user_data);
+  g_signal_handlers_disconnect_by_func (actor,
+                                        table_layout_child_notify_visible,
+                                        user_data);
+}
+
+static void
+table_layout_actor_added (ClutterContainer   *container,
+                          ClutterActor       *actor,
+                          ClutterTableLayout *self)
+{
+  table_layout_track_child (actor, self);
+  table_layout_invalidate_cells (self);
+}
+
+static void
+table_layout_actor_removed (ClutterContainer   *container,
+                            ClutterActor       *actor,
+                            ClutterTableLayout *self)
+{
+  table_layout_untrack_child (actor, self);
+  table_layout_invalidate_cells (self);
+}
+
 static void
 clutter_table_layout_set_container (ClutterLayoutManager *layout,
                                     ClutterContainer     *container)
 {
-  ClutterTableLayoutPrivate *priv = CLUTTER_TABLE_LAYOUT (layout)->priv;
+  ClutterTableLayout *self = CLUTTER_TABLE_LAYOUT (layout);
+  ClutterTableLayoutPrivate *priv = self->priv;
+  ClutterLayoutManagerClass *parent_class;
+
+  if (priv->container != NULL)
+    {
+      g_signal_handlers_disconnect_by_func (priv->container,
+                                            table_layout_actor_added,
+                                            self);
+      g_signal_handlers_disconnect_by_func (priv->container,
+                                            table_layout_actor_removed,
+                                            self);
+      clutter_container_foreach (priv->container,
+                                 table_layout_untrack_child,
+                                 self);
+    }
 
   priv->container = container;
-}
 
+  if (priv->container != NULL)
+    {
+      g_signal_connect (priv->container, "actor-added",
+                        G_CALLBACK (table_layout_actor_added),
+                        self);
+      g_signal_connect (priv->container, "actor-removed",
+                        G_CALLBACK (table_layout_actor_removed),
+                        self);
+      clutter_container_foreach (priv->container,
+                                 table_layout_track_child,
+                                 self);
+    }
+
+  table_layout_invalidate_cells (self);
+
+  parent_class = CLUTTER_LAYOUT_MANAGER_CLASS (clutter_table_layout_parent_class);
+  parent_class->set_container (layout, container);
+}
 
 static void
 update_row_col (ClutterTableLayout *layout,
@@ -737,78 +911,204 @@ update_row_col (ClutterTableLayout *layout,
 }
 
 static void
-calculate_col_widths (ClutterTableLayout *self,
-                      ClutterContainer   *container,
-                      gint                for_width)
+table_layout_clear_cells (ClutterTableLayout *self)
+{
+  ClutterTableLayoutPrivate *priv = self->priv;
+  guint i;
+
+  for (i = 0; i < priv->col_cells->len; i++)
+    g_slist_free (g_ptr_array_index (priv->col_cells, i));
+
+  for (i = 0; i < priv->row_cells->len; i++)
+    g_slist_free (g_ptr_array_index (priv->row_cells, i));
+
+  g_ptr_array_set_size (priv->col_cells, 0);
+  g_ptr_array_set_size (priv->row_cells, 0);
+
+  g_slist_free (priv->col_spanning);
+  priv->col_spanning = NULL;
+
+  g_slist_free (priv->row_spanning);
+  priv->row_spanning = NULL;
+}
+
+/* rebuilds the index of the children by column and row, if the
+ * structure of the table changed since the last time; this also
+ * discards all the cached requests
+ */
+static void
+table_layout_update_cells (ClutterTableLayout *self)
 {
   ClutterTableLayoutPrivate *priv = self->priv;
   ClutterLayoutManager *manager = CLUTTER_LAYOUT_MANAGER (self);
+  DimensionData *requests;
+  GList *children, *l;
   gint i;
-  DimensionData *columns;
-  GList *l, *children;
 
-  update_row_col (self, container);
-  g_array_set_size (priv->columns, 0);
-  g_array_set_size (priv->columns, priv->n_cols);
-  columns = (DimensionData *) priv->columns->data;
+  if (!priv->needs_rebuild)
+    return;
 
-  /* reset the visibility of all columns */
-  priv->visible_cols = 0;
-  for (i = 0; i < priv->n_cols; i++)
-    columns[i].visible = FALSE;
+  table_layout_clear_cells (self);
+  update_row_col (self, priv->container);
 
-  children = clutter_container_get_children (container);
+  CLUTTER_NOTE (LAYOUT, "Rebuilding the cells of the table layout [%p] "
+                "(%d columns, %d rows)",
+                self,
+                priv->n_cols,
+                priv->n_rows);
 
-  /* STAGE ONE: calculate column widths for non-spanned children */
-  for (l = children; l; l = g_list_next (l))
+  g_ptr_array_set_size (priv->col_cells, priv->n_cols);
+  g_ptr_array_set_size (priv->row_cells, priv->n_rows);
+
+  children = priv->container != NULL
+           ? clutter_container_get_children (priv->container)
+           : NULL;
+
+  /* we walk the children backwards, so that prepending keeps the
+   * order of the container; the spanning children are processed
+   * in order, and the order affects the solution
+   */
+  for (l = g_list_last (children); l != NULL; l = l->prev)
     {
-      ClutterActor *child = l->data;
       ClutterTableChild *meta;
-      DimensionData *col;
-      gfloat c_min, c_pref;
-
-      if (!CLUTTER_ACTOR_IS_VISIBLE (child))
-        continue;
 
       meta = (ClutterTableChild *)
-        clutter_layout_manager_get_child_meta (manager, container, child);
+        clutter_layout_manager_get_child_meta (manager, priv->container, l->data);
+
+      priv->col_cells->pdata[meta->col] =
+        g_slist_prepend (priv->col_cells->pdata[meta->col], meta);
+      priv->row_cells->pdata[meta->row] =
+        g_slist_prepend (priv->row_cells->pdata[meta->row], meta);
 
       if (meta->col_span > 1)
+        priv->col_spanning = g_slist_prepend (priv->col_spanning, meta);
+
+      if (meta->row_span > 1)
+        priv->row_spanning = g_slist_prepend (priv->row_spanning, meta);
+    }
+
+  g_list_free (children);
+
+  g_array_set_size (priv->col_requests, 0);
+  g_array_set_size (priv->col_requests, priv->n_cols);
+  requests = (DimensionData *) priv->col_requests->data;
+  for (i = 0; i < priv->n_cols; i++)
+    requests[i].needs_update = TRUE;
+
+  g_array_set_size (priv->row_requests, 0);
+  g_array_set_size (priv->row_requests, priv->n_rows);
+  requests = (DimensionData *) priv->row_requests->data;
+  for (i = 0; i < priv->n_rows; i++)
+    requests[i].needs_update = TRUE;
+
+  g_array_set_size (priv->row_col_sizes, 0);
+
+  priv->cols_valid = FALSE;
+  priv->rows_valid = FALSE;
+  priv->needs_rebuild = FALSE;
+}
+
+/* STAGE ONE: calculate column widths for non-spanned children; only
+ * the columns that have been invalidated are computed again. Returns
+ * %TRUE if any column was updated
+ */
+static gboolean
+update_col_requests (ClutterTableLayout *self)
+{
+  ClutterTableLayoutPrivate *priv = self->priv;
+  DimensionData *requests;
+  gboolean retval = FALSE;
+  gint i;
+
+  requests = (DimensionData *) priv->col_requests->data;
+
+  for (i = 0; i < priv->n_cols; i++)
+    {
+      DimensionData *col = &requests[i];
+      GSList *l;
+
+      if (!col->needs_update)
         continue;
 
-      col = &columns[meta->col];
+      memset (col, 0, sizeof (DimensionData));
 
-      if (!col->visible)
+      for (l = g_ptr_array_index (priv->col_cells, i); l != NULL; l = l->next)
         {
+          ClutterTableChild *meta = l->data;
+          ClutterActor *child;
+          gfloat c_min, c_pref;
+
+          child = clutter_child_meta_get_actor (CLUTTER_CHILD_META (meta));
+
+          if (!CLUTTER_ACTOR_IS_VISIBLE (child))
+            continue;
+
+          if (meta->col_span > 1)
+            continue;
+
           col->visible = TRUE;
-          priv->visible_cols += 1;
+
+          clutter_actor_get_preferred_width (child, -1, &c_min, &c_pref);
+
+          col->min_size = MAX (col->min_size, c_min);
+          col->pref_size = MAX (col->pref_size, c_pref);
+          col->expand = MAX (col->expand, meta->x_expand);
         }
 
-      clutter_actor_get_preferred_width (child, -1, &c_min, &c_pref);
+      retval = TRUE;
+    }
+
+  return retval;
+}
 
-      col->min_size = MAX (col->min_size, c_min);
-      col->pref_size = MAX (col->pref_size, c_pref);
-      col->expand = MAX (col->expand, meta->x_expand);
+static void
+calculate_col_widths (ClutterTableLayout *self,
+                      ClutterContainer   *container,
+                      gint                for_width)
+{
+  ClutterTableLayoutPrivate *priv = self->priv;
+  gint i;
+  DimensionData *columns;
+  GSList *l;
+  gboolean changed;
+
+  table_layout_update_cells (self);
+  changed = update_col_requests (self);
+
+  /* nothing changed since the last solution */
+  if (!changed && priv->cols_valid && priv->cols_for_width == for_width)
+    return;
+
+  priv->cols_valid = TRUE;
+  priv->cols_for_width = for_width;
+
+  /* start from the requests of the non-spanned children */
+  g_array_set_size (priv->columns, priv->n_cols);
+  columns = (DimensionData *) priv->columns->data;
+  memcpy (columns, priv->col_requests->data,
+          priv->n_cols * sizeof (DimensionData));
+
+  priv->visible_cols = 0;
+  for (i = 0; i < priv->n_cols; i++)
+    {
+      if (columns[i].visible)
+        priv->visible_cols += 1;
     }
 
   /* STAGE TWO: take spanning children into account */
-  for (l = children; l; l = g_list_next (l))
+  for (l = priv->col_spanning; l != NULL; l = l->next)
     {
-      ClutterActor *child = l->data;
-      ClutterTableChild *meta;
+      ClutterTableChild *meta = l->data;
+      ClutterActor *child;
       DimensionData *col;
       gfloat c_min, c_pref;
       gfloat min_width, pref_width;
       gint start_col, end_col;
       gint n_expand;
 
-      if (!CLUTTER_ACTOR_IS_VISIBLE (child))
-        continue;
-
-      meta = (ClutterTableChild *)
-        clutter_layout_manager_get_child_meta (manager, container, child);
+      child = clutter_child_meta_get_actor (CLUTTER_CHILD_META (meta));
 
-      if (meta->col_span < 2)
+      if (!CLUTTER_ACTOR_IS_VISIBLE (child))
         continue;
 
       col = &columns[meta->col];
@@ -887,10 +1187,7 @@ calculate_col_widths (ClutterTableLayout *self,
                 }
             }
         }
-
-
     }
-  g_list_free (children);
 
   /* calculate final widths */
   if (for_width >= 0)
@@ -996,82 +1293,164 @@ calculate_col_widths (ClutterTableLayout *self,
 
 }
 
-static void
-calculate_row_heights (ClutterTableLayout *self,
-                       ClutterContainer   *container,
-                       gint                for_height)
+/* STAGE ONE: calculate row heights for non-spanned children; see
+ * update_col_requests()
+ */
+static gboolean
+update_row_requests (ClutterTableLayout *self)
 {
   ClutterTableLayoutPrivate *priv = self->priv;
-  ClutterLayoutManager *manager = CLUTTER_LAYOUT_MANAGER (self);
-  GList *l, *children;
+  DimensionData *requests, *columns;
+  gboolean retval = FALSE;
   gint i;
-  DimensionData *rows, *columns;
 
-  update_row_col (self, container);
-  g_array_set_size (priv->rows, 0);
-  g_array_set_size (priv->rows, self->priv->n_rows);
-
-  rows = (DimensionData*) priv->rows->data;
-  columns = (DimensionData*) priv->columns->data;
+  requests = (DimensionData *) priv->row_requests->data;
+  columns = (DimensionData *) priv->columns->data;
 
-  /* reset the visibility of all rows */
-  priv->visible_rows = 0;
   for (i = 0; i < priv->n_rows; i++)
-    rows[i].visible = FALSE;
-
-  children = clutter_container_get_children (container);
-  /* STAGE ONE: calculate row heights for non-spanned children */
-  for (l = children; l; l = g_list_next (l))
     {
-      ClutterActor *child = l->data;
-      ClutterTableChild *meta;
-      DimensionData *row;
-      gfloat c_min, c_pref;
+      DimensionData *row = &requests[i];
+      GSList *l;
 
-      if (!CLUTTER_ACTOR_IS_VISIBLE (child))
+      if (!row->needs_update)
         continue;
 
-      meta = (ClutterTableChild *)
-        clutter_layout_manager_get_child_meta (manager, container, child);
+      memset (row, 0, sizeof (DimensionData));
 
-      if (meta->row_span > 1)
-        continue;
+      for (l = g_ptr_array_index (priv->row_cells, i); l != NULL; l = l->next)
+        {
+          ClutterTableChild *meta = l->data;
+          ClutterActor *child;
+          gfloat c_min, c_pref;
 
-      row = &rows[meta->row];
+          child = clutter_child_meta_get_actor (CLUTTER_CHILD_META (meta));
+
+          if (!CLUTTER_ACTOR_IS_VISIBLE (child))
+            continue;
+
+          if (meta->row_span > 1)
+            continue;
 
-      if (!row->visible)
-        {
           row->visible = TRUE;
-          priv->visible_rows += 1;
+
+          clutter_actor_get_preferred_height (child,
+                                              columns[meta->col].final_size,
+                                              &c_min, &c_pref);
+
+          row->min_size = MAX (row->min_size, c_min);
+          row->pref_size = MAX (row->pref_size, c_pref);
+          row->expand = MAX (row->expand, meta->y_expand);
         }
 
-      clutter_actor_get_preferred_height (child, columns[meta->col].final_size,
-                                          &c_min, &c_pref);
+      retval = TRUE;
+    }
+
+  return retval;
+}
 
-      row->min_size = MAX (row->min_size, c_min);
-      row->pref_size = MAX (row->pref_size, c_pref);
-      row->expand = MAX (row->expand, meta->y_expand);
+/* the height of a child depends on the width of its column, so the
+ * rows occupied by the children of a column that changed size since
+ * the last time have to be requested again
+ */
+static void
+invalidate_resized_columns (ClutterTableLayout *self)
+{
+  ClutterTableLayoutPrivate *priv = self->priv;
+  DimensionData *columns, *requests;
+  gfloat *col_sizes;
+  gint i, j;
+
+  columns = (DimensionData *) priv->columns->data;
+  requests = (DimensionData *) priv->row_requests->data;
+
+  if (priv->row_col_sizes->len != (guint) priv->n_cols)
+    {
+      g_array_set_size (priv->row_col_sizes, priv->n_cols);
+      col_sizes = (gfloat *) priv->row_col_sizes->data;
+
+      for (i = 0; i < priv->n_cols; i++)
+        col_sizes[i] = columns[i].final_size;
+
+      for (i = 0; i < priv->n_rows; i++)
+        requests[i].needs_update = TRUE;
+
+      return;
     }
 
+  col_sizes = (gfloat *) priv->row_col_sizes->data;
 
+  for (i = 0; i < priv->n_cols; i++)
+    {
+      GSList *l;
+
+      if (col_sizes[i] == columns[i].final_size)
+        continue;
+
+      col_sizes[i] = columns[i].final_size;
+
+      for (l = g_ptr_array_index (priv->col_cells, i); l != NULL; l = l->next)
+        {
+          ClutterTableChild *meta = l->data;
+
+          for (j = meta->row;
+               j < meta->row + meta->row_span && j < priv->n_rows;
+               j++)
+            {
+              requests[j].needs_update = TRUE;
+            }
+        }
+    }
+}
+
+static void
+calculate_row_heights (ClutterTableLayout *self,
+                       ClutterContainer   *container,
+                       gint                for_height)
+{
+  ClutterTableLayoutPrivate *priv = self->priv;
+  GSList *l;
+  gint i;
+  DimensionData *rows, *columns;
+  gboolean changed;
+
+  table_layout_update_cells (self);
+  invalidate_resized_columns (self);
+  changed = update_row_requests (self);
+
+  /* nothing changed since the last solution */
+  if (!changed && priv->rows_valid && priv->rows_for_height == for_height)
+    return;
+
+  priv->rows_valid = TRUE;
+  priv->rows_for_height = for_height;
+
+  /* start from the requests of the non-spanned children */
+  g_array_set_size (priv->rows, priv->n_rows);
+  rows = (DimensionData *) priv->rows->data;
+  columns = (DimensionData *) priv->columns->data;
+  memcpy (rows, priv->row_requests->data,
+          priv->n_rows * sizeof (DimensionData));
+
+  priv->visible_rows = 0;
+  for (i = 0; i < priv->n_rows; i++)
+    {
+      if (rows[i].visible)
+        priv->visible_rows += 1;
+    }
 
   /* STAGE TWO: take spanning children into account */
-  for (l = children; l; l = g_list_next (l))
+  for (l = priv->row_spanning; l != NULL; l = l->next)
     {
-      ClutterActor *child = l->data;
-      ClutterTableChild *meta;
+      ClutterTableChild *meta = l->data;
+      ClutterActor *child;
       gfloat c_min, c_pref;
       gfloat min_height, pref_height;
       gint start_row, end_row;
       gint n_expand;
 
-      if (!CLUTTER_ACTOR_IS_VISIBLE (child))
-        continue;
+      child = clutter_child_meta_get_actor (CLUTTER_CHILD_META (meta));
 
-      meta = (ClutterTableChild *)
-        clutter_layout_manager_get_child_meta (manager, container, child);
-
-      if (meta->row_span < 2)
+      if (!CLUTTER_ACTOR_IS_VISIBLE (child))
         continue;
 
       start_row = meta->row;
@@ -1080,7 +1459,6 @@ calculate_row_heights (ClutterTableLayout *self,
       clutter_actor_get_preferred_height (child, columns[meta->col].final_size,
                                          &c_min, &c_pref);
 
-
       /* check there is enough room for this actor */
       min_height = 0;
       pref_height = 0;
@@ -1162,11 +1540,8 @@ calculate_row_heights (ClutterTableLayout *self,
                 }
             }
         }
-
     }
 
-  g_list_free (children);
-
   /* calculate final heights */
   if (for_height >= 0)
     {
@@ -1294,7 +1669,7 @@ clutter_table_layout_get_preferred_width (ClutterLayoutManager *layout,
   DimensionData *columns;
   gint i;
 
-  update_row_col (self, container);
+  table_layout_update_cells (self);
   if (priv->n_cols < 1)
     {
       *min_width_p = 0;
@@ -1302,7 +1677,8 @@ clutter_table_layout_get_preferred_width (ClutterLayoutManager *layout,
       return;
     }
 
-  calculate_table_dimensions (self, container, -1, for_height);
+  /* the row heights do not contribute to the preferred width */
+  calculate_col_widths (self, container, -1);
   columns = (DimensionData *) priv->columns->data;
 
   total_min_width = (priv->visible_cols - 1) * (float) priv->col_spacing;
@@ -1334,7 +1710,7 @@ clutter_table_layout_get_preferred_height (ClutterLayoutManager *layout,
   DimensionData *rows;
   gint i;
 
-  update_row_col (self, container);
+  table_layout_update_cells (self);
   if (priv->n_rows < 1)
     {
       *min_height_p = 0;
@@ -1391,8 +1767,9 @@ clutter_table_layout_allocate (ClutterLayoutManager   *layout,
   gint row_spacing, col_spacing;
   gint i;
   DimensionData *rows, *columns;
+  gint *col_offsets, *row_offsets;
 
-  update_row_col (self, container);
+  table_layout_update_cells (self);
   if (priv->n_cols < 1 || priv->n_rows < 1)
     return;
 
@@ -1408,6 +1785,35 @@ clutter_table_layout_allocate (ClutterLayoutManager   *layout,
   rows = (DimensionData *) priv->rows->data;
   columns = (DimensionData *) priv->columns->data;
 
+  /* the position of each column and row, so that placing a child
+   * does not need to walk all the columns and rows before it
+   */
+  col_offsets = g_new (gint, priv->n_cols);
+  col_offsets[0] = 0;
+  for (i = 1; i < priv->n_cols; i++)
+    {
+      col_offsets[i] = col_offsets[i - 1];
+
+      if (columns[i - 1].visible)
+        {
+          col_offsets[i] += columns[i - 1].final_size;
+          col_offsets[i] += col_spacing;
+        }
+    }
+
+  row_offsets = g_new (gint, priv->n_rows);
+  row_offsets[0] = 0;
+  for (i = 1; i < priv->n_rows; i++)
+    {
+      row_offsets[i] = row_offsets[i - 1];
+
+      if (rows[i - 1].visible)
+        {
+          row_offsets[i] += rows[i - 1].final_size;
+          row_offsets[i] += row_spacing;
+        }
+    }
+
   for (list = children; list; list = g_list_next (list))
     {
       ClutterActor *child = list->data;
@@ -1471,27 +1877,8 @@ clutter_table_layout_allocate (ClutterLayoutManager   *layout,
             }
         }
 
-      /* calculate child x */
-      child_x = 0.0f;
-      for (i = 0; i < col; i++)
-        {
-          if (columns[i].visible)
-            {
-              child_x += columns[i].final_size;
-              child_x += col_spacing;
-            }
-        }
-
-      /* calculate child y */
-      child_y = 0.0f;
-      for (i = 0; i < row; i++)
-        {
-          if (rows[i].visible)
-            {
-              child_y += rows[i].final_size;
-              child_y += row_spacing;
-            }
-        }
+      child_x = col_offsets[col];
+      child_y = row_offsets[row];
 
       /* set up childbox */
       childbox.x1 = (float) child_x;
@@ -1559,6 +1946,9 @@ clutter_table_layout_allocate (ClutterLayoutManager   *layout,
       clutter_actor_allocate (child, &childbox, flags);
     }
 
+  g_free (col_offsets);
+  g_free (row_offsets);
+
   g_list_free (children);
 }
 
@@ -1668,8 +2058,15 @@ clutter_table_layout_finalize (GObject *gobject)
 {
   ClutterTableLayoutPrivate *priv = CLUTTER_TABLE_LAYOUT (gobject)->priv;
 
+  table_layout_clear_cells (CLUTTER_TABLE_LAYOUT (gobject));
+
   g_array_free (priv->columns, TRUE);
   g_array_free (priv->rows, TRUE);
+  g_array_free (priv->col_requests, TRUE);
+  g_array_free (priv->row_requests, TRUE);
+  g_array_free (priv->row_col_sizes, TRUE);
+  g_ptr_array_free (priv->col_cells, TRUE);
+  g_ptr_array_free (priv->row_cells, TRUE);
 
   G_OBJECT_CLASS (clutter_table_layout_parent_class)->finalize (gobject);
 }
@@ -1801,6 +2198,14 @@ clutter_table_layout_init (ClutterTableLayout *layout)
 
   priv->columns = g_array_new (FALSE, TRUE, sizeof (DimensionData));
   priv->rows = g_array_new (FALSE, TRUE, sizeof (DimensionData));
+
+  priv->col_requests = g_array_new (FALSE, TRUE, sizeof (DimensionData));
+  priv->row_requests = g_array_new (FALSE, TRUE, sizeof (DimensionData));
+  priv->row_col_sizes = g_array_new (FALSE, TRUE, sizeof (gfloat));
+  priv->col_cells = g_ptr_array_new ();
+  priv->row_cells = g_ptr_array_new ();
+
+  priv->needs_rebuild = TRUE;
 }
 
 /**
@@ -1842,6 +2247,8 @@ clutter_table_layout_set_column_spacing (ClutterTableLayout *layout,
       ClutterLayoutManager *manager;
 
       priv->col_spacing = spacing;
+      priv->cols_valid = FALSE;
+      priv->rows_valid = FALSE;
 
       manager = CLUTTER_LAYOUT_MANAGER (layout);
 
@@ -1900,6 +2307,7 @@ clutter_table_layout_set_row_spacing (ClutterTableLayout *layout,
       ClutterLayoutManager *manager;
 
       priv->row_spacing = spacing;
+      priv->rows_valid = FALSE;
 
       manager = CLUTTER_LAYOUT_MANAGER (layout);
 
@@ -1969,7 +2377,7 @@ clutter_table_layout_pack (ClutterTableLayout  *layout,
       return;
     }
 
-  update_row_col (CLUTTER_TABLE_LAYOUT (layout), priv->container);
+  table_layout_update_cells (layout);
 
   clutter_container_add_actor (priv->container, actor);
 
@@ -2606,7 +3014,7 @@ clutter_table_layout_get_row_count (ClutterTableLayout *layout)
 {
   g_return_val_if_fail (CLUTTER_IS_TABLE_LAYOUT (layout), -1);
 
-  update_row_col (layout, layout->priv->container);
+  table_layout_update_cells (layout);
   return CLUTTER_TABLE_LAYOUT (layout)->priv->n_rows;
 }
 
@@ -2625,6 +3033,6 @@ clutter_table_layout_get_column_count (ClutterTableLayout *layout)
 {
   g_return_val_if_fail (CLUTTER_IS_TABLE_LAYOUT (layout), -1);
 
-  update_row_col (layout, layout->priv->container);
+  table_layout_update_cells (layout);
   return CLUTTER_TABLE_LAYOUT (layout)->priv->n_cols;
 }
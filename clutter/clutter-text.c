@@ -75,9 +75,25 @@
  */
 #define N_CACHED_LAYOUTS        6
 
+/* The maximum number of shared layouts that are kept around while no
+ * ClutterText is using them
+ */
+#define N_UNUSED_SHARED_LAYOUTS 128
+
+/* Editable text is laid out one paragraph at a time, so that an edit
+ * only needs to shape the paragraphs it touched. We need the layouts
+ * for the unconstrained width, used by the size requests, and for the
+ * allocated width, used when painting
+ */
+#define N_PARAGRAPH_SETS        2
+
 #define CLUTTER_TEXT_GET_PRIVATE(obj)   (G_TYPE_INSTANCE_GET_PRIVATE ((obj), CLUTTER_TYPE_TEXT, ClutterTextPrivate))
 
 typedef struct _LayoutCache     LayoutCache;
+typedef struct _LayoutJob       LayoutJob;
+typedef struct _SharedLayout    SharedLayout;
+typedef struct _TextParagraph   TextParagraph;
+typedef struct _ParagraphSet    ParagraphSet;
 
 static const ClutterColor default_cursor_color    = {   0,   0,   0, 255 };
 static const ClutterColor default_selection_color = {   0,   0,   0, 255 };
@@ -97,6 +113,123 @@ struct _LayoutCache
    * new layout is needed the last used cache is replaced)
    */
   guint age;
+
+  /* Layouts created by the worker thread have their extents computed
+   * by the worker and stored here, so that querying them does not
+   * need to measure the layout again
+   */
+  PangoRectangle logical_rect;
+  PangoRectangle line_rect;
+
+  /* if the layout comes from the shared cache, this holds the
+   * reference on it instead of the layout
+   */
+  SharedLayout *shared;
+
+  guint is_async : 1;
+};
+
+/* A paragraph of an editable text, laid out on its own */
+struct _TextParagraph
+{
+  PangoLayout *layout;
+
+  /* the offset of the paragraph in the text, and its length,
+   * not including the paragraph separator, in bytes
+   */
+  gint start;
+  gint length;
+
+  /* the position of the paragraph inside the actor, and its
+   * logical extents; in Pango units
+   */
+  gint y;
+  PangoRectangle logical_rect;
+};
+
+struct _ParagraphSet
+{
+  /* the paragraphs of the whole text, laid out using the same
+   * width; NULL if the set is not used
+   */
+  GArray *paragraphs;
+
+  gint width;
+  guint age;
+
+  /* set when the text changed, and the paragraphs need to be
+   * matched against the new contents
+   */
+  guint needs_sync : 1;
+};
+
+/* An entry of the process-wide cache of layouts, shared by the
+ * ClutterText actors with the same contents; see the
+ * ClutterText:shared-layout property
+ */
+struct _SharedLayout
+{
+  /* the key */
+  gchar *contents;
+  PangoFontDescription *font_desc;
+  PangoAttrList *attrs;
+  gint width;
+  gint height;
+  gdouble resolution;
+  PangoDirection base_dir;
+  guint alignment        : 2;
+  guint ellipsize        : 3;
+  guint wrap_mode        : 3;
+  guint single_line_mode : 1;
+  guint justify          : 1;
+
+  guint hash;
+
+  PangoLayout *layout;
+
+  /* the number of LayoutCache slots using the layout; unused entries
+   * are kept in the shared_layouts_lru queue
+   */
+  gint ref_count;
+  GList *lru_link;
+
+  /* entries are removed from the cache when the font options change,
+   * and freed once they are not used anymore
+   */
+  guint in_cache : 1;
+};
+
+/* A snapshot of the state needed to create a layout on the worker
+ * thread; only the result fields are written by the worker
+ */
+struct _LayoutJob
+{
+  ClutterText *text;
+  gint serial;
+
+  gchar *contents;
+  PangoAttrList *attrs;
+  PangoFontDescription *font_desc;
+
+  PangoAlignment alignment;
+  PangoWrapMode wrap_mode;
+  PangoEllipsizeMode ellipsize;
+  gint width;
+  gint height;
+  guint single_line_mode : 1;
+  guint justify          : 1;
+
+  /* the configuration of the PangoContext */
+  PangoDirection base_dir;
+  PangoFontDescription *context_font_desc;
+  cairo_font_options_t *font_options;
+  gdouble resolution;
+  PangoLanguage *language;
+
+  /* results */
+  PangoLayout *layout;
+  PangoRectangle logical_rect;
+  PangoRectangle line_rect;
 };
 
 struct _ClutterTextPrivate
@@ -115,6 +248,21 @@ struct _ClutterTextPrivate
   LayoutCache cached_layouts[N_CACHED_LAYOUTS];
   guint cache_age;
 
+  /* incremented each time the cache is dirtied, to discard the
+   * results of the asynchronous layouts queued before that
+   */
+  volatile gint layout_serial;
+
+  /* the pending asynchronous layouts */
+  GSList *layout_jobs;
+
+  ParagraphSet paragraph_sets[N_PARAGRAPH_SETS];
+
+  /* the height of the first line of the last asynchronous layout,
+   * used when estimating the size
+   */
+  gfloat async_line_height;
+
   /* These are the attributes set by the attributes property */
   PangoAttrList *attrs;
   /* These are the attributes derived from the text when the
@@ -147,6 +295,8 @@ struct _ClutterTextPrivate
   guint preedit_set         : 1;
   guint is_default_font     : 1;
   guint has_focus           : 1;
+  guint async_layout        : 1;
+  guint shared_layout       : 1;
 
   /* current cursor position */
   gint position;
@@ -221,6 +371,8 @@ enum
   PROP_PASSWORD_CHAR,
   PROP_MAX_LENGTH,
   PROP_SINGLE_LINE_MODE,
+  PROP_ASYNC_LAYOUT,
+  PROP_SHARED_LAYOUT,
 
   PROP_LAST
 };
@@ -240,6 +392,20 @@ enum
 
 static guint text_signals[LAST_SIGNAL] = { 0, };
 
+/* The asynchronous layouts are created by a single worker thread.
+ * Pango font maps are not thread safe, so each job shapes its layout
+ * using a font map of its own, which is kept alive by the layout; once
+ * the job completed, the layout and its font map are only used by the
+ * main thread, and can be painted without any locking
+ */
+static GThreadPool *async_layout_pool = NULL;
+
+/* the process-wide layout cache; see the ClutterText:shared-layout
+ * property. The hash table uses the entries as keys
+ */
+static GHashTable *shared_layouts = NULL;
+static GQueue      shared_layouts_lru = G_QUEUE_INIT;
+
 static void clutter_text_font_changed_cb (ClutterText *text);
 
 #define offset_real(t,p)        ((p) == -1 ? g_utf8_strlen ((t), -1) : (p))
@@ -437,8 +603,255 @@ clutter_text_create_layout_no_cache (ClutterText       *text,
   return layout;
 }
 
+static gboolean
+attr_list_equal (PangoAttrList *a,
+                 PangoAttrList *b)
+{
+  PangoAttrIterator *iter_a, *iter_b;
+  gboolean retval = TRUE;
+
+  if (a == b)
+    return TRUE;
+
+  if (a == NULL || b == NULL)
+    return FALSE;
+
+  iter_a = pango_attr_list_get_iterator (a);
+  iter_b = pango_attr_list_get_iterator (b);
+
+  while (TRUE)
+    {
+      GSList *attrs_a, *attrs_b, *l_a, *l_b;
+      gint start_a, end_a, start_b, end_b;
+      gboolean has_next;
+
+      pango_attr_iterator_range (iter_a, &start_a, &end_a);
+      pango_attr_iterator_range (iter_b, &start_b, &end_b);
+
+      if (start_a != start_b || end_a != end_b)
+        {
+          retval = FALSE;
+          break;
+        }
+
+      attrs_a = pango_attr_iterator_get_attrs (iter_a);
+      attrs_b = pango_attr_iterator_get_attrs (iter_b);
+
+      for (l_a = attrs_a, l_b = attrs_b;
+           l_a != NULL && l_b != NULL;
+           l_a = l_a->next, l_b = l_b->next)
+        {
+          if (!pango_attribute_equal (l_a->data, l_b->data))
+            break;
+        }
+
+      if (l_a != NULL || l_b != NULL)
+        retval = FALSE;
+
+      g_slist_foreach (attrs_a, (GFunc) pango_attribute_destroy, NULL);
+      g_slist_free (attrs_a);
+      g_slist_foreach (attrs_b, (GFunc) pango_attribute_destroy, NULL);
+      g_slist_free (attrs_b);
+
+      if (!retval)
+        break;
+
+      has_next = pango_attr_iterator_next (iter_a);
+      if (has_next != pango_attr_iterator_next (iter_b))
+        {
+          retval = FALSE;
+          break;
+        }
+
+      if (!has_next)
+        break;
+    }
+
+  pango_attr_iterator_destroy (iter_a);
+  pango_attr_iterator_destroy (iter_b);
+
+  return retval;
+}
+
+static guint
+clutter_text_shared_layout_hash (gconstpointer data)
+{
+  const SharedLayout *shared = data;
+
+  return shared->hash;
+}
+
+static gboolean
+clutter_text_shared_layout_equal (gconstpointer data_a,
+                                  gconstpointer data_b)
+{
+  const SharedLayout *a = data_a;
+  const SharedLayout *b = data_b;
+
+  return a->hash == b->hash &&
+         a->width == b->width &&
+         a->height == b->height &&
+         a->ellipsize == b->ellipsize &&
+         a->wrap_mode == b->wrap_mode &&
+         a->alignment == b->alignment &&
+         a->single_line_mode == b->single_line_mode &&
+         a->justify == b->justify &&
+         a->base_dir == b->base_dir &&
+         a->resolution == b->resolution &&
+         strcmp (a->contents, b->contents) == 0 &&
+         pango_font_description_equal (a->font_desc, b->font_desc) &&
+         attr_list_equal (a->attrs, b->attrs);
+}
+
 static void
-clutter_text_dirty_cache (ClutterText *text)
+clutter_text_shared_layout_free (SharedLayout *shared)
+{
+  g_object_unref (shared->layout);
+
+  g_free (shared->contents);
+  pango_font_description_free (shared->font_desc);
+
+  if (shared->attrs != NULL)
+    pango_attr_list_unref (shared->attrs);
+
+  g_slice_free (SharedLayout, shared);
+}
+
+static void
+clutter_text_shared_layout_unref (SharedLayout *shared)
+{
+  shared->ref_count -= 1;
+  if (shared->ref_count > 0)
+    return;
+
+  if (!shared->in_cache)
+    {
+      clutter_text_shared_layout_free (shared);
+      return;
+    }
+
+  /* keep the unused layout around, in case another actor needs it,
+   * evicting the least recently used ones
+   */
+  g_queue_push_head (&shared_layouts_lru, shared);
+  shared->lru_link = shared_layouts_lru.head;
+
+  while (shared_layouts_lru.length > N_UNUSED_SHARED_LAYOUTS)
+    {
+      SharedLayout *old = g_queue_pop_tail (&shared_layouts_lru);
+
+      g_hash_table_remove (shared_layouts, old);
+      clutter_text_shared_layout_free (old);
+    }
+}
+
+static gboolean
+clutter_text_shared_layout_flush (gpointer key,
+                                  gpointer value,
+                                  gpointer user_data)
+{
+  SharedLayout *shared = value;
+
+  shared->in_cache = FALSE;
+
+  if (shared->ref_count == 0)
+    {
+      g_queue_delete_link (&shared_layouts_lru, shared->lru_link);
+      clutter_text_shared_layout_free (shared);
+    }
+
+  return TRUE;
+}
+
+static void
+clutter_text_shared_layouts_flush (ClutterBackend *backend)
+{
+  /* the layouts still in use are freed once the ClutterText actors
+   * using them dirty their cache, which they do in response to the
+   * same signals
+   */
+  g_hash_table_foreach_remove (shared_layouts,
+                               clutter_text_shared_layout_flush,
+                               NULL);
+}
+
+static void
+clutter_text_layout_cache_clear (LayoutCache *cache)
+{
+  if (cache->layout == NULL)
+    return;
+
+  if (cache->shared != NULL)
+    {
+      clutter_text_shared_layout_unref (cache->shared);
+      cache->shared = NULL;
+    }
+  else
+    g_object_unref (cache->layout);
+
+  cache->layout = NULL;
+  cache->is_async = FALSE;
+}
+
+static void
+clutter_text_layout_cache_get_extents (LayoutCache    *cache,
+                                       PangoRectangle *logical_rect,
+                                       PangoRectangle *line_rect)
+{
+  if (cache->is_async)
+    {
+      if (logical_rect != NULL)
+        *logical_rect = cache->logical_rect;
+
+      if (line_rect != NULL)
+        *line_rect = cache->line_rect;
+    }
+  else
+    {
+      if (logical_rect != NULL)
+        pango_layout_get_extents (cache->layout, NULL, logical_rect);
+
+      if (line_rect != NULL)
+        {
+          PangoLayoutLine *line;
+
+          line = pango_layout_get_line_readonly (cache->layout, 0);
+          pango_layout_line_get_extents (line, NULL, line_rect);
+        }
+    }
+}
+
+static void
+clutter_text_paragraph_set_clear (ParagraphSet *set)
+{
+  guint i;
+
+  if (set->paragraphs == NULL)
+    return;
+
+  for (i = 0; i < set->paragraphs->len; i++)
+    {
+      TextParagraph *paragraph;
+
+      paragraph = &g_array_index (set->paragraphs, TextParagraph, i);
+      if (paragraph->layout != NULL)
+        g_object_unref (paragraph->layout);
+    }
+
+  g_array_free (set->paragraphs, TRUE);
+  set->paragraphs = NULL;
+}
+
+/*
+ * clutter_text_dirty_layouts:
+ * @text: a #ClutterText
+ *
+ * Evicts the layout cache after the contents of @text changed. The
+ * paragraph layouts are kept, and updated the next time they are
+ * needed.
+ */
+static void
+clutter_text_dirty_layouts (ClutterText *text)
 {
   ClutterTextPrivate *priv = text->priv;
   int i;
@@ -446,11 +859,25 @@ clutter_text_dirty_cache (ClutterText *text)
   /* Delete the cached layouts so they will be recreated the next time
      they are needed */
   for (i = 0; i < N_CACHED_LAYOUTS; i++)
-    if (priv->cached_layouts[i].layout)
-      {
-	g_object_unref (priv->cached_layouts[i].layout);
-	priv->cached_layouts[i].layout = NULL;
-      }
+    clutter_text_layout_cache_clear (priv->cached_layouts + i);
+
+  for (i = 0; i < N_PARAGRAPH_SETS; i++)
+    priv->paragraph_sets[i].needs_sync = TRUE;
+
+  /* Any pending asynchronous layout is now stale */
+  g_atomic_int_inc (&priv->layout_serial);
+}
+
+static void
+clutter_text_dirty_cache (ClutterText *text)
+{
+  ClutterTextPrivate *priv = text->priv;
+  int i;
+
+  clutter_text_dirty_layouts (text);
+
+  for (i = 0; i < N_PARAGRAPH_SETS; i++)
+    clutter_text_paragraph_set_clear (priv->paragraph_sets + i);
 }
 
 /*
@@ -529,37 +956,30 @@ clutter_text_direction_changed_cb (GObject    *gobject,
 }
 
 /*
- * clutter_text_create_layout:
+ * clutter_text_get_layout_params:
  * @text: a #ClutterText
  * @allocation_width: the allocation width
  * @allocation_height: the allocation height
+ * @width_p: return location for the width of the layout
+ * @height_p: return location for the height of the layout
+ * @ellipsize_p: return location for the ellipsize mode of the layout
  *
- * Like clutter_text_create_layout_no_cache(), but will also ensure
- * the glyphs cache. If a previously cached layout generated using the
- * same width is available then that will be used instead of
- * generating a new one.
+ * Computes the parameters of the PangoLayout needed for the
+ * given allocation size.
  */
-static PangoLayout *
-clutter_text_create_layout (ClutterText *text,
-                            gfloat       allocation_width,
-                            gfloat       allocation_height)
+static void
+clutter_text_get_layout_params (ClutterText        *text,
+                                gfloat              allocation_width,
+                                gfloat              allocation_height,
+                                gint               *width_p,
+                                gint               *height_p,
+                                PangoEllipsizeMode *ellipsize_p)
 {
   ClutterTextPrivate *priv = text->priv;
-  LayoutCache *oldest_cache = priv->cached_layouts;
-  gboolean found_free_cache = FALSE;
-  gint width = -1;
-  gint height = -1;
-  PangoEllipsizeMode ellipsize = PANGO_ELLIPSIZE_NONE;
-  int i;
 
-  CLUTTER_STATIC_COUNTER (text_cache_hit_counter,
-                          "Text layout cache hit counter",
-                          "Increments for each layout cache hit",
-                          0);
-  CLUTTER_STATIC_COUNTER (text_cache_miss_counter,
-                          "Text layout cache miss counter",
-                          "Increments for each layout cache miss",
-                          0);
+  *width_p = -1;
+  *height_p = -1;
+  *ellipsize_p = PANGO_ELLIPSIZE_NONE;
 
   /* First determine the width, height, and ellipsize mode that
    * we need for the layout. The ellipsize mode depends on
@@ -586,7 +1006,7 @@ clutter_text_create_layout (ClutterText *text,
       else
         {
           if (!priv->editable)
-            ellipsize = priv->ellipsize;
+            *ellipsize_p = priv->ellipsize;
         }
     }
 
@@ -604,7 +1024,7 @@ clutter_text_create_layout (ClutterText *text,
        !((priv->editable && priv->single_line_mode) ||
          (priv->ellipsize == PANGO_ELLIPSIZE_NONE && !priv->wrap))))
     {
-      width = allocation_width * 1024 + 0.5f;
+      *width_p = allocation_width * 1024 + 0.5f;
     }
 
   /* Pango only uses height if ellipsization is enabled, so don't set
@@ -621,109 +1041,1176 @@ clutter_text_create_layout (ClutterText *text,
       priv->ellipsize != PANGO_ELLIPSIZE_NONE &&
       !priv->single_line_mode)
     {
-      height = allocation_height * 1024 + 0.5f;
+      *height_p = allocation_height * 1024 + 0.5f;
+    }
+}
+
+/*
+ * clutter_text_find_cached_layout:
+ * @text: a #ClutterText
+ * @allocation_width: the allocation width
+ * @allocation_height: the allocation height
+ * @width: the width of the layout
+ * @height: the height of the layout
+ * @ellipsize: the ellipsize mode of the layout
+ * @allow_async: whether layouts created by the worker thread can be
+ *   returned
+ * @oldest_p: return location for the cache slot to replace if no
+ *   layout was found
+ *
+ * Searches for a cached layout that can be used for the given
+ * parameters.
+ *
+ * Return value: the cache slot of the layout, or %NULL
+ */
+static LayoutCache *
+clutter_text_find_cached_layout (ClutterText        *text,
+                                 gfloat              allocation_width,
+                                 gfloat              allocation_height,
+                                 gint                width,
+                                 gint                height,
+                                 PangoEllipsizeMode  ellipsize,
+                                 gboolean            allow_async,
+                                 LayoutCache       **oldest_p)
+{
+  ClutterTextPrivate *priv = text->priv;
+  LayoutCache *oldest_cache = priv->cached_layouts;
+  gboolean found_free_cache = FALSE;
+  int i;
+
+  CLUTTER_STATIC_COUNTER (text_cache_hit_counter,
+                          "Text layout cache hit counter",
+                          "Increments for each layout cache hit",
+                          0);
+  CLUTTER_STATIC_COUNTER (text_cache_miss_counter,
+                          "Text layout cache miss counter",
+                          "Increments for each layout cache miss",
+                          0);
+
+  /* Search for a cached layout with the same width and keep
+   * track of the oldest one
+   */
+  for (i = 0; i < N_CACHED_LAYOUTS; i++)
+    {
+      if (priv->cached_layouts[i].layout == NULL)
+	{
+	  /* Always prefer free cache spaces */
+	  found_free_cache = TRUE;
+	  oldest_cache = priv->cached_layouts + i;
+	}
+      else if (!allow_async && priv->cached_layouts[i].is_async)
+        {
+	  if (!found_free_cache &&
+	      (priv->cached_layouts[i].age < oldest_cache->age))
+	    {
+	      oldest_cache = priv->cached_layouts + i;
+	    }
+        }
+      else
+        {
+          PangoLayout *cached = priv->cached_layouts[i].layout;
+          gint cached_width = pango_layout_get_width (cached);
+	  gint cached_height = pango_layout_get_height (cached);
+	  gint cached_ellipsize = pango_layout_get_ellipsize (cached);
+
+	  if (cached_width == width &&
+	      cached_height == height &&
+	      cached_ellipsize == ellipsize)
+	    {
+              /* If this cached layout is using the same size then we can
+               * just return that directly
+               */
+              CLUTTER_NOTE (ACTOR,
+                            "ClutterText: %p: cache hit for size %.2fx%.2f",
+                            text,
+                            allocation_width,
+                            allocation_height);
+
+              CLUTTER_COUNTER_INC (_clutter_uprof_context,
+                                   text_cache_hit_counter);
+
+              return priv->cached_layouts + i;
+	    }
+
+	  /* When getting the preferred height for a specific width,
+	   * we might be able to reuse the layout from getting the
+	   * preferred width. If the width that the layout gives
+	   * unconstrained is less than the width that we are using
+	   * than the height will be unaffected by that width.
+	   */
+	  if (allocation_height < 0 &&
+              cached_width == -1 &&
+              cached_ellipsize == ellipsize)
+	    {
+	      PangoRectangle logical_rect;
+
+              clutter_text_layout_cache_get_extents (priv->cached_layouts + i,
+                                                     &logical_rect,
+                                                     NULL);
+
+	      if (logical_rect.width <= width)
+		{
+		  /* We've been asked for our height for the width we gave as a result
+		   * of a _get_preferred_width call
+		   */
+		  CLUTTER_NOTE (ACTOR,
+                                "ClutterText: %p: cache hit for size %.2fx%.2f "
+				"(unwrapped width narrower than given width)",
+				text,
+				allocation_width,
+				allocation_height);
+
+                  CLUTTER_COUNTER_INC (_clutter_uprof_context,
+                                       text_cache_hit_counter);
+
+		  return priv->cached_layouts + i;
+		}
+	    }
+
+	  if (!found_free_cache &&
+	      (priv->cached_layouts[i].age < oldest_cache->age))
+	    {
+	      oldest_cache = priv->cached_layouts + i;
+	    }
+        }
+    }
+
+  CLUTTER_NOTE (ACTOR, "ClutterText: %p: cache miss for size %.2fx%.2f",
+		text,
+                allocation_width,
+                allocation_height);
+
+  CLUTTER_COUNTER_INC (_clutter_uprof_context, text_cache_miss_counter);
+
+  if (oldest_p != NULL)
+    *oldest_p = oldest_cache;
+
+  return NULL;
+}
+
+/*
+ * clutter_text_ref_shared_layout:
+ * @text: a #ClutterText
+ * @width: the width of the layout
+ * @height: the height of the layout
+ * @ellipsize: the ellipsize mode of the layout
+ *
+ * Retrieves a layout from the process-wide cache, creating it if no
+ * other #ClutterText with the same contents and parameters is using
+ * it. The layouts share their glyph caches and display lists as well.
+ *
+ * Return value: a reference on the cache entry, to be released with
+ *   clutter_text_shared_layout_unref()
+ */
+static SharedLayout *
+clutter_text_ref_shared_layout (ClutterText        *text,
+                                gint                width,
+                                gint                height,
+                                PangoEllipsizeMode  ellipsize)
+{
+  ClutterTextPrivate *priv = text->priv;
+  PangoContext *context;
+  SharedLayout key, *shared;
+
+  CLUTTER_STATIC_COUNTER (text_shared_hit_counter,
+                          "Text shared layout hit counter",
+                          "Increments for each shared layout cache hit",
+                          0);
+
+  if (G_UNLIKELY (shared_layouts == NULL))
+    {
+      ClutterBackend *backend = clutter_get_default_backend ();
+
+      shared_layouts = g_hash_table_new (clutter_text_shared_layout_hash,
+                                         clutter_text_shared_layout_equal);
+
+      g_signal_connect (backend, "font-changed",
+                        G_CALLBACK (clutter_text_shared_layouts_flush),
+                        NULL);
+      g_signal_connect (backend, "resolution-changed",
+                        G_CALLBACK (clutter_text_shared_layouts_flush),
+                        NULL);
+    }
+
+  /* This will merge the markup attributes and the attributes
+     property if needed */
+  clutter_text_ensure_effective_attributes (text);
+
+  context = clutter_actor_get_pango_context (CLUTTER_ACTOR (text));
+
+  memset (&key, 0, sizeof (SharedLayout));
+  key.contents = clutter_text_get_display_text (text);
+  key.font_desc = priv->font_desc;
+  key.attrs = priv->effective_attrs;
+  key.width = width;
+  key.height = height;
+  key.resolution = pango_cairo_context_get_resolution (context);
+  key.base_dir = pango_context_get_base_dir (context);
+  key.alignment = priv->alignment;
+  key.ellipsize = ellipsize;
+  key.wrap_mode = priv->wrap_mode;
+  key.single_line_mode = priv->single_line_mode;
+  key.justify = priv->justify;
+
+  /* the attributes are only compared when the rest of the key matches */
+  key.hash = g_str_hash (key.contents)
+           ^ pango_font_description_hash (key.font_desc)
+           ^ (guint) (width * 31 + height)
+           ^ (ellipsize << 24)
+           ^ (priv->wrap_mode << 27);
+
+  shared = g_hash_table_lookup (shared_layouts, &key);
+  if (shared != NULL)
+    {
+      CLUTTER_COUNTER_INC (_clutter_uprof_context, text_shared_hit_counter);
+
+      if (shared->ref_count == 0)
+        {
+          g_queue_delete_link (&shared_layouts_lru, shared->lru_link);
+          shared->lru_link = NULL;
+        }
+
+      shared->ref_count += 1;
+
+      g_free (key.contents);
+
+      return shared;
+    }
+
+  shared = g_slice_dup (SharedLayout, &key);
+  shared->font_desc = pango_font_description_copy (priv->font_desc);
+
+  /* the attributes might be modified by the application after being
+   * set on another actor, so we need a copy
+   */
+  if (priv->effective_attrs != NULL)
+    shared->attrs = pango_attr_list_copy (priv->effective_attrs);
+
+  shared->layout =
+    clutter_text_create_layout_no_cache (text, width, height, ellipsize);
+  cogl_pango_ensure_glyph_cache_for_layout (shared->layout);
+
+  shared->ref_count = 1;
+  shared->in_cache = TRUE;
+
+  g_hash_table_insert (shared_layouts, shared, shared);
+
+  return shared;
+}
+
+/*
+ * clutter_text_create_layout:
+ * @text: a #ClutterText
+ * @allocation_width: the allocation width
+ * @allocation_height: the allocation height
+ *
+ * Like clutter_text_create_layout_no_cache(), but will also ensure
+ * the glyphs cache. If a previously cached layout generated using the
+ * same width is available then that will be used instead of
+ * generating a new one.
+ *
+ * The layouts created by the worker thread are never returned by
+ * this function.
+ */
+static PangoLayout *
+clutter_text_create_layout (ClutterText *text,
+                            gfloat       allocation_width,
+                            gfloat       allocation_height)
+{
+  ClutterTextPrivate *priv = text->priv;
+  LayoutCache *cache, *oldest_cache = NULL;
+  gint width, height;
+  PangoEllipsizeMode ellipsize;
+
+  clutter_text_get_layout_params (text,
+                                  allocation_width,
+                                  allocation_height,
+                                  &width, &height,
+                                  &ellipsize);
+
+  cache = clutter_text_find_cached_layout (text,
+                                           allocation_width,
+                                           allocation_height,
+                                           width, height,
+                                           ellipsize,
+                                           FALSE,
+                                           &oldest_cache);
+  if (cache != NULL)
+    return cache->layout;
+
+  /* If we make it here then we didn't have a cached version so we
+     need to recreate the layout */
+  clutter_text_layout_cache_clear (oldest_cache);
+
+  if (priv->shared_layout && !priv->editable)
+    {
+      oldest_cache->shared =
+        clutter_text_ref_shared_layout (text, width, height, ellipsize);
+      oldest_cache->layout = oldest_cache->shared->layout;
+    }
+  else
+    {
+      oldest_cache->layout =
+        clutter_text_create_layout_no_cache (text, width, height, ellipsize);
+
+      cogl_pango_ensure_glyph_cache_for_layout (oldest_cache->layout);
+    }
+
+  /* Mark the 'time' this cache was created and advance the time */
+  oldest_cache->age = priv->cache_age++;
+  return oldest_cache->layout;
+}
+
+static inline gboolean
+clutter_text_use_async_layout (ClutterText *text)
+{
+  ClutterTextPrivate *priv = text->priv;
+
+  /* editable actors need to query the layout for the cursor and the
+   * selection on every event, so they are always laid out in the
+   * main thread
+   */
+  return priv->async_layout && !priv->editable && g_thread_supported ();
+}
+
+static void
+clutter_text_layout_job_free (LayoutJob *job)
+{
+  if (job->layout != NULL)
+    g_object_unref (job->layout);
+
+  g_free (job->contents);
+
+  if (job->attrs != NULL)
+    pango_attr_list_unref (job->attrs);
+
+  pango_font_description_free (job->font_desc);
+
+  if (job->context_font_desc != NULL)
+    pango_font_description_free (job->context_font_desc);
+
+  if (job->font_options != NULL)
+    cairo_font_options_destroy (job->font_options);
+
+  g_object_unref (job->text);
+
+  g_slice_free (LayoutJob, job);
+}
+
+static gboolean
+clutter_text_layout_job_complete (gpointer data)
+{
+  LayoutJob *job = data;
+  ClutterText *text = job->text;
+  ClutterTextPrivate *priv = text->priv;
+
+  priv->layout_jobs = g_slist_remove (priv->layout_jobs, job);
+
+  /* the cache might have been dirtied while the worker was running */
+  if (job->layout != NULL && job->serial == priv->layout_serial)
+    {
+      LayoutCache *cache = priv->cached_layouts;
+      ClutterFontFlags font_flags;
+      CoglPangoFontMap *font_map;
+      PangoContext *context;
+      int i;
+
+      /* replace the oldest cached layout, or a free slot */
+      for (i = 0; i < N_CACHED_LAYOUTS; i++)
+        {
+          if (priv->cached_layouts[i].layout == NULL)
+            {
+              cache = priv->cached_layouts + i;
+              break;
+            }
+
+          if (priv->cached_layouts[i].age < cache->age)
+            cache = priv->cached_layouts + i;
+        }
+
+      clutter_text_layout_cache_clear (cache);
+
+      cache->layout = job->layout;
+      cache->logical_rect = job->logical_rect;
+      cache->line_rect = job->line_rect;
+      cache->is_async = TRUE;
+      cache->age = priv->cache_age++;
+
+      job->layout = NULL;
+
+      font_flags = clutter_get_font_flags ();
+      context = pango_layout_get_context (cache->layout);
+      font_map = COGL_PANGO_FONT_MAP (pango_context_get_font_map (context));
+
+      cogl_pango_font_map_set_use_mipmapping (font_map,
+                                              (font_flags & CLUTTER_FONT_MIPMAPPING) != 0);
+      cogl_pango_font_map_set_use_distance_field (font_map,
+                                                  (font_flags & CLUTTER_FONT_DISTANCE_FIELD) != 0);
+      cogl_pango_ensure_glyph_cache_for_layout (cache->layout);
+
+      priv->async_line_height =
+        ceilf ((job->line_rect.y + job->line_rect.height) / 1024.0f);
+
+      CLUTTER_NOTE (ACTOR, "ClutterText: %p: asynchronous layout for "
+                    "size %dx%d completed",
+                    text,
+                    job->width,
+                    job->height);
+
+      clutter_actor_queue_relayout (CLUTTER_ACTOR (text));
+    }
+
+  clutter_text_layout_job_free (job);
+
+  return FALSE;
+}
+
+static void
+clutter_text_layout_job_run (gpointer data,
+                             gpointer pool_data)
+{
+  LayoutJob *job = data;
+  CoglPangoFontMap *font_map;
+  PangoContext *context;
+  PangoLayout *layout;
+  PangoLayoutLine *line;
+
+  /* skip the jobs that were queued before the cache was dirtied */
+  if (job->serial != g_atomic_int_get (&job->text->priv->layout_serial))
+    goto out;
+
+  font_map = COGL_PANGO_FONT_MAP (cogl_pango_font_map_new ());
+  cogl_pango_font_map_set_resolution (font_map, job->resolution);
+
+  context = cogl_pango_font_map_create_context (font_map);
+  pango_context_set_base_dir (context, job->base_dir);
+  pango_context_set_font_description (context, job->context_font_desc);
+  pango_context_set_language (context, job->language);
+  pango_cairo_context_set_font_options (context, job->font_options);
+  pango_cairo_context_set_resolution (context, job->resolution);
+
+  /* the layout keeps a reference on the context and the font map */
+  layout = pango_layout_new (context);
+  g_object_unref (context);
+  g_object_unref (font_map);
+
+  pango_layout_set_font_description (layout, job->font_desc);
+  pango_layout_set_text (layout, job->contents, -1);
+
+  if (job->attrs != NULL)
+    pango_layout_set_attributes (layout, job->attrs);
+
+  pango_layout_set_alignment (layout, job->alignment);
+  pango_layout_set_single_paragraph_mode (layout, job->single_line_mode);
+  pango_layout_set_justify (layout, job->justify);
+  pango_layout_set_wrap (layout, job->wrap_mode);
+
+  pango_layout_set_ellipsize (layout, job->ellipsize);
+  pango_layout_set_width (layout, job->width);
+  pango_layout_set_height (layout, job->height);
+
+  /* this is where the shaping happens */
+  pango_layout_get_extents (layout, NULL, &job->logical_rect);
+
+  line = pango_layout_get_line_readonly (layout, 0);
+  if (line != NULL)
+    pango_layout_line_get_extents (line, NULL, &job->line_rect);
+
+  job->layout = layout;
+
+out:
+  /* the layout is handed back to the main thread, which owns the
+   * layout cache
+   */
+  clutter_threads_add_idle_full (G_PRIORITY_HIGH_IDLE,
+                                 clutter_text_layout_job_complete,
+                                 job,
+                                 NULL);
+}
+
+static void
+clutter_text_queue_layout_job (ClutterText        *text,
+                               gint                width,
+                               gint                height,
+                               PangoEllipsizeMode  ellipsize)
+{
+  ClutterTextPrivate *priv = text->priv;
+  PangoContext *context;
+  const cairo_font_options_t *font_options;
+  LayoutJob *job;
+
+  /* This apparently can't fail if exclusive == FALSE */
+  if (G_UNLIKELY (async_layout_pool == NULL))
+    async_layout_pool =
+      g_thread_pool_new (clutter_text_layout_job_run, NULL, 1, FALSE, NULL);
+
+  job = g_slice_new0 (LayoutJob);
+  job->text = g_object_ref (text);
+  job->serial = priv->layout_serial;
+
+  job->contents = clutter_text_get_display_text (text);
+
+  /* This will merge the markup attributes and the attributes
+     property if needed */
+  clutter_text_ensure_effective_attributes (text);
+
+  if (priv->effective_attrs != NULL)
+    job->attrs = pango_attr_list_copy (priv->effective_attrs);
+
+  job->font_desc = pango_font_description_copy (priv->font_desc);
+  job->alignment = priv->alignment;
+  job->wrap_mode = priv->wrap_mode;
+  job->single_line_mode = priv->single_line_mode;
+  job->justify = priv->justify;
+  job->ellipsize = ellipsize;
+  job->width = width;
+  job->height = height;
+
+  context = clutter_actor_get_pango_context (CLUTTER_ACTOR (text));
+  job->base_dir = pango_context_get_base_dir (context);
+  job->context_font_desc =
+    pango_font_description_copy (pango_context_get_font_description (context));
+  job->language = pango_context_get_language (context);
+  job->resolution = pango_cairo_context_get_resolution (context);
+
+  font_options = pango_cairo_context_get_font_options (context);
+  if (font_options != NULL)
+    job->font_options = cairo_font_options_copy (font_options);
+
+  priv->layout_jobs = g_slist_prepend (priv->layout_jobs, job);
+
+  g_thread_pool_push (async_layout_pool, job, NULL);
+}
+
+/*
+ * clutter_text_ensure_async_layout:
+ * @text: a #ClutterText
+ * @allocation_width: the allocation width
+ * @allocation_height: the allocation height
+ *
+ * Like clutter_text_create_layout(), but if no cached layout can be
+ * used the layout is created by the worker thread, and a relayout is
+ * queued once it is available.
+ *
+ * Return value: the cache slot of the layout, or %NULL if the layout
+ *   is not available yet
+ */
+static LayoutCache *
+clutter_text_ensure_async_layout (ClutterText *text,
+                                  gfloat       allocation_width,
+                                  gfloat       allocation_height)
+{
+  ClutterTextPrivate *priv = text->priv;
+  LayoutCache *cache;
+  gint width, height;
+  PangoEllipsizeMode ellipsize;
+  GSList *l;
+
+  clutter_text_get_layout_params (text,
+                                  allocation_width,
+                                  allocation_height,
+                                  &width, &height,
+                                  &ellipsize);
+
+  cache = clutter_text_find_cached_layout (text,
+                                           allocation_width,
+                                           allocation_height,
+                                           width, height,
+                                           ellipsize,
+                                           TRUE,
+                                           NULL);
+  if (cache != NULL)
+    return cache;
+
+  for (l = priv->layout_jobs; l != NULL; l = l->next)
+    {
+      LayoutJob *job = l->data;
+
+      if (job->serial == priv->layout_serial &&
+          job->width == width &&
+          job->height == height &&
+          job->ellipsize == ellipsize)
+        return NULL;
+    }
+
+  clutter_text_queue_layout_job (text, width, height, ellipsize);
+
+  return NULL;
+}
+
+/*
+ * clutter_text_estimate_size:
+ * @text: a #ClutterText
+ * @for_width: the available width, or -1
+ * @logical_rect: return location for the estimated extents
+ * @line_rect: return location for the estimated extents of
+ *   the first line
+ *
+ * Estimates the size of the layout from the size of the font, while
+ * the actual layout is being created by the worker thread.
+ */
+static void
+clutter_text_estimate_size (ClutterText    *text,
+                            gfloat          for_width,
+                            PangoRectangle *logical_rect,
+                            PangoRectangle *line_rect)
+{
+  ClutterTextPrivate *priv = text->priv;
+  const gchar *p;
+  gfloat font_size, char_width, line_height;
+  gfloat max_width = 0;
+  gint n_lines = 0, n_chars = 0;
+
+  font_size = (gfloat) pango_font_description_get_size (priv->font_desc)
+            / PANGO_SCALE;
+
+  if (!pango_font_description_get_size_is_absolute (priv->font_desc))
+    {
+      gdouble resolution;
+
+      resolution = clutter_backend_get_resolution (clutter_get_default_backend ());
+      if (resolution < 0)
+        resolution = 96.0;
+
+      font_size = font_size * resolution / 72.0;
+    }
+
+  char_width = font_size * 0.5f;
+
+  if (priv->async_line_height > 0)
+    line_height = priv->async_line_height;
+  else
+    line_height = ceilf (font_size * 1.2f);
+
+  /* count the paragraphs, and the lines they wrap to */
+  for (p = priv->text; ; p = g_utf8_next_char (p))
+    {
+      if (*p == '\0' || (*p == '\n' && !priv->single_line_mode))
+        {
+          gfloat width = n_chars * char_width;
+
+          if (for_width > 0 && priv->wrap && width > for_width)
+            {
+              n_lines += ceilf (width / for_width);
+              width = for_width;
+            }
+          else
+            n_lines += 1;
+
+          max_width = MAX (max_width, width);
+          n_chars = 0;
+
+          if (*p == '\0')
+            break;
+        }
+      else
+        n_chars += 1;
+    }
+
+  logical_rect->x = logical_rect->y = 0;
+  logical_rect->width = max_width * PANGO_SCALE;
+  logical_rect->height = n_lines * line_height * PANGO_SCALE;
+
+  if (line_rect != NULL)
+    {
+      *line_rect = *logical_rect;
+      line_rect->height = line_height * PANGO_SCALE;
+    }
+}
+
+static inline gboolean
+clutter_text_use_paragraphs (ClutterText *text)
+{
+  ClutterTextPrivate *priv = text->priv;
+
+  /* the password characters and the pre-edit string do not map
+   * to the paragraphs of the text, so we lay out the whole text
+   * in those cases
+   */
+  return priv->editable &&
+         !priv->single_line_mode &&
+         !priv->preedit_set &&
+         priv->password_char == 0;
+}
+
+static void
+clutter_text_paragraph_layout (ClutterText   *text,
+                               TextParagraph *paragraph,
+                               gint           width)
+{
+  ClutterTextPrivate *priv = text->priv;
+  PangoLayout *layout;
+
+  CLUTTER_STATIC_COUNTER (text_paragraph_counter,
+                          "Text paragraph layout counter",
+                          "Increments for each paragraph laid out",
+                          0);
+
+  CLUTTER_COUNTER_INC (_clutter_uprof_context, text_paragraph_counter);
+
+  layout = clutter_actor_create_pango_layout (CLUTTER_ACTOR (text), NULL);
+  pango_layout_set_font_description (layout, priv->font_desc);
+  pango_layout_set_text (layout,
+                         priv->text + paragraph->start,
+                         paragraph->length);
+
+  pango_layout_set_alignment (layout, priv->alignment);
+  pango_layout_set_justify (layout, priv->justify);
+  pango_layout_set_wrap (layout, priv->wrap_mode);
+  pango_layout_set_width (layout, width);
+
+  pango_layout_get_extents (layout, NULL, &paragraph->logical_rect);
+
+  cogl_pango_ensure_glyph_cache_for_layout (layout);
+
+  paragraph->layout = layout;
+}
+
+static inline gboolean
+clutter_text_paragraph_matches (ClutterText         *text,
+                                const TextParagraph *old,
+                                const TextParagraph *new)
+{
+  return old->length == new->length &&
+         memcmp (pango_layout_get_text (old->layout),
+                 text->priv->text + new->start,
+                 new->length) == 0;
+}
+
+/* gives every paragraph the width of the widest one, so that the
+ * lines are aligned against it; the paragraphs already laid out for
+ * that width are kept
+ */
+static void
+clutter_text_paragraphs_set_common_width (GArray *paragraphs)
+{
+  gint max_width = 0;
+  guint i;
+
+  /* the layouts are never wrapped, so the logical width of each
+   * paragraph is its natural width, whatever the layout width
+   */
+  for (i = 0; i < paragraphs->len; i++)
+    {
+      TextParagraph *paragraph;
+
+      paragraph = &g_array_index (paragraphs, TextParagraph, i);
+      max_width = MAX (max_width, paragraph->logical_rect.width);
+    }
+
+  for (i = 0; i < paragraphs->len; i++)
+    {
+      TextParagraph *paragraph;
+
+      paragraph = &g_array_index (paragraphs, TextParagraph, i);
+      if (pango_layout_get_width (paragraph->layout) == max_width)
+        continue;
+
+      pango_layout_set_width (paragraph->layout, max_width);
+      pango_layout_get_extents (paragraph->layout,
+                                NULL,
+                                &paragraph->logical_rect);
+    }
+}
+
+/*
+ * clutter_text_paragraph_set_sync:
+ * @text: a #ClutterText
+ * @set: a #ParagraphSet
+ *
+ * Splits the contents of @text into paragraphs, reusing the layouts
+ * of @set for the paragraphs at the beginning and at the end of the
+ * text that did not change, and laying out the others.
+ */
+static void
+clutter_text_paragraph_set_sync (ClutterText  *text,
+                                 ParagraphSet *set)
+{
+  ClutterTextPrivate *priv = text->priv;
+  GArray *old_paragraphs = set->paragraphs;
+  GArray *paragraphs;
+  const gchar *p, *end;
+  guint n_old, n_new, prefix, suffix, i;
+  gint y;
+
+  n_old = old_paragraphs != NULL ? old_paragraphs->len : 0;
+
+  paragraphs = g_array_sized_new (FALSE, TRUE,
+                                  sizeof (TextParagraph),
+                                  MAX (n_old, 1));
+
+  /* split the text */
+  p = priv->text;
+  end = priv->text + priv->n_bytes;
+
+  while (TRUE)
+    {
+      TextParagraph paragraph = { NULL, };
+      const gchar *separator;
+
+      separator = memchr (p, '\n', end - p);
+
+      paragraph.start = p - priv->text;
+      paragraph.length = (separator != NULL ? separator : end) - p;
+      g_array_append_val (paragraphs, paragraph);
+
+      if (separator == NULL)
+        break;
+
+      p = separator + 1;
+    }
+
+  n_new = paragraphs->len;
+
+  /* reuse the unchanged paragraphs at the beginning... */
+  for (prefix = 0; prefix < n_old && prefix < n_new; prefix++)
+    {
+      TextParagraph *old, *new;
+
+      old = &g_array_index (old_paragraphs, TextParagraph, prefix);
+      new = &g_array_index (paragraphs, TextParagraph, prefix);
+
+      if (!clutter_text_paragraph_matches (text, old, new))
+        break;
+
+      new->layout = old->layout;
+      new->logical_rect = old->logical_rect;
+      old->layout = NULL;
+    }
+
+  /* ...and at the end of the text */
+  for (suffix = 0;
+       suffix < n_old - prefix && suffix < n_new - prefix;
+       suffix++)
+    {
+      TextParagraph *old, *new;
+
+      old = &g_array_index (old_paragraphs, TextParagraph, n_old - 1 - suffix);
+      new = &g_array_index (paragraphs, TextParagraph, n_new - 1 - suffix);
+
+      if (!clutter_text_paragraph_matches (text, old, new))
+        break;
+
+      new->layout = old->layout;
+      new->logical_rect = old->logical_rect;
+      old->layout = NULL;
+    }
+
+  CLUTTER_NOTE (ACTOR, "ClutterText: %p: %u paragraphs, %u changed",
+                text,
+                n_new,
+                n_new - prefix - suffix);
+
+  clutter_text_paragraph_set_clear (set);
+
+  /* lay out the changed paragraphs */
+  for (i = 0; i < n_new; i++)
+    {
+      TextParagraph *paragraph;
+
+      paragraph = &g_array_index (paragraphs, TextParagraph, i);
+      if (paragraph->layout == NULL)
+        clutter_text_paragraph_layout (text, paragraph, set->width);
+    }
+
+  /* without a width, a single layout aligns its lines against the
+   * widest one; the paragraphs need to share that width to be aligned
+   * the same way
+   */
+  if (set->width < 0 && priv->alignment != PANGO_ALIGN_LEFT)
+    clutter_text_paragraphs_set_common_width (paragraphs);
+
+  /* and shift the paragraphs to their position */
+  for (i = 0, y = 0; i < n_new; i++)
+    {
+      TextParagraph *paragraph;
+
+      paragraph = &g_array_index (paragraphs, TextParagraph, i);
+      paragraph->y = y;
+      y += paragraph->logical_rect.height;
+    }
+
+  set->paragraphs = paragraphs;
+  set->needs_sync = FALSE;
+}
+
+/*
+ * clutter_text_ensure_paragraphs:
+ * @text: a #ClutterText
+ * @allocation_width: the allocation width
+ * @allocation_height: the allocation height
+ *
+ * Retrieves the paragraphs of @text laid out for the given
+ * allocation size.
+ */
+static ParagraphSet *
+clutter_text_ensure_paragraphs (ClutterText *text,
+                                gfloat       allocation_width,
+                                gfloat       allocation_height)
+{
+  ClutterTextPrivate *priv = text->priv;
+  ParagraphSet *set = NULL;
+  PangoEllipsizeMode ellipsize;
+  gint width, height;
+  int i;
+
+  /* we only care about the width, as editable actors are
+   * never ellipsized
+   */
+  clutter_text_get_layout_params (text,
+                                  allocation_width,
+                                  allocation_height,
+                                  &width, &height,
+                                  &ellipsize);
+
+  for (i = 0; i < N_PARAGRAPH_SETS; i++)
+    {
+      ParagraphSet *cur = priv->paragraph_sets + i;
+
+      if (cur->paragraphs != NULL && cur->width == width)
+        {
+          set = cur;
+          break;
+        }
+
+      /* otherwise replace a free set, or the oldest one */
+      if (set == NULL ||
+          (set->paragraphs != NULL &&
+           (cur->paragraphs == NULL || cur->age < set->age)))
+        set = cur;
+    }
+
+  if (set->paragraphs == NULL || set->width != width)
+    {
+      clutter_text_paragraph_set_clear (set);
+
+      set->width = width;
+      set->needs_sync = TRUE;
+    }
+
+  if (set->needs_sync)
+    clutter_text_paragraph_set_sync (text, set);
+
+  set->age = priv->cache_age++;
+
+  return set;
+}
+
+/* returns the paragraph containing the given byte index */
+static TextParagraph *
+clutter_text_paragraph_at_index (ParagraphSet *set,
+                                 gint          index_)
+{
+  guint lo = 0, hi = set->paragraphs->len;
+
+  while (hi - lo > 1)
+    {
+      guint mid = (lo + hi) / 2;
+
+      if (g_array_index (set->paragraphs, TextParagraph, mid).start <= index_)
+        lo = mid;
+      else
+        hi = mid;
+    }
+
+  return &g_array_index (set->paragraphs, TextParagraph, lo);
+}
+
+/* returns the paragraph at the given Y coordinate, in Pango units */
+static TextParagraph *
+clutter_text_paragraph_at_y (ParagraphSet *set,
+                             gint          y)
+{
+  guint lo = 0, hi = set->paragraphs->len;
+
+  while (hi - lo > 1)
+    {
+      guint mid = (lo + hi) / 2;
+
+      if (g_array_index (set->paragraphs, TextParagraph, mid).y <= y)
+        lo = mid;
+      else
+        hi = mid;
+    }
+
+  return &g_array_index (set->paragraphs, TextParagraph, lo);
+}
+
+static void
+clutter_text_paragraph_set_get_extents (ParagraphSet   *set,
+                                        PangoRectangle *logical_rect,
+                                        PangoRectangle *line_rect)
+{
+  TextParagraph *last;
+  gint width = 0;
+  guint i;
+
+  for (i = 0; i < set->paragraphs->len; i++)
+    {
+      TextParagraph *paragraph;
+
+      paragraph = &g_array_index (set->paragraphs, TextParagraph, i);
+      width = MAX (width,
+                   paragraph->logical_rect.x + paragraph->logical_rect.width);
+    }
+
+  last = &g_array_index (set->paragraphs, TextParagraph,
+                         set->paragraphs->len - 1);
+
+  logical_rect->x = 0;
+  logical_rect->y = 0;
+  logical_rect->width = width;
+  logical_rect->height = last->y + last->logical_rect.height;
+
+  if (line_rect != NULL)
+    {
+      TextParagraph *first;
+      PangoLayoutLine *line;
+
+      first = &g_array_index (set->paragraphs, TextParagraph, 0);
+      line = pango_layout_get_line_readonly (first->layout, 0);
+      pango_layout_line_get_extents (line, NULL, line_rect);
     }
+}
 
-  /* Search for a cached layout with the same width and keep
-   * track of the oldest one
-   */
-  for (i = 0; i < N_CACHED_LAYOUTS; i++)
-    {
-      if (priv->cached_layouts[i].layout == NULL)
-	{
-	  /* Always prefer free cache spaces */
-	  found_free_cache = TRUE;
-	  oldest_cache = priv->cached_layouts + i;
-	}
-      else
-        {
-          PangoLayout *cached = priv->cached_layouts[i].layout;
-          gint cached_width = pango_layout_get_width (cached);
-	  gint cached_height = pango_layout_get_height (cached);
-	  gint cached_ellipsize = pango_layout_get_ellipsize (cached);
+/*
+ * clutter_text_get_visible_range:
+ * @y1_p: return location for the top of the visible range
+ * @y2_p: return location for the bottom of the visible range
+ *
+ * Computes the range of Y coordinates of the actor being painted, in
+ * Pango units, that can be visible in the current viewport, by
+ * intersecting the rays through the corners of the viewport with the
+ * plane of the actor.
+ *
+ * Return value: %FALSE if the range could not be computed, for
+ *   instance because the actor is seen edge-on
+ */
+static gboolean
+clutter_text_get_visible_range (gint *y1_p,
+                                gint *y2_p)
+{
+  static const float corners[4][2] = {
+    { -1, -1 }, { 1, -1 }, { -1, 1 }, { 1, 1 }
+  };
+  CoglMatrix modelview, projection, transform, inverse;
+  float y_min = G_MAXFLOAT, y_max = -G_MAXFLOAT;
+  int i;
 
-	  if (cached_width == width &&
-	      cached_height == height &&
-	      cached_ellipsize == ellipsize)
-	    {
-              /* If this cached layout is using the same size then we can
-               * just return that directly
-               */
-              CLUTTER_NOTE (ACTOR,
-                            "ClutterText: %p: cache hit for size %.2fx%.2f",
-                            text,
-                            allocation_width,
-                            allocation_height);
+  cogl_get_modelview_matrix (&modelview);
+  cogl_get_projection_matrix (&projection);
+  cogl_matrix_multiply (&transform, &projection, &modelview);
 
-              CLUTTER_COUNTER_INC (_clutter_uprof_context,
-                                   text_cache_hit_counter);
+  if (!cogl_matrix_get_inverse (&transform, &inverse))
+    return FALSE;
 
-              return priv->cached_layouts[i].layout;
-	    }
+  for (i = 0; i < 4; i++)
+    {
+      float near[4] = { corners[i][0], corners[i][1], -1, 1 };
+      float far[4] = { corners[i][0], corners[i][1], 1, 1 };
+      float t, y;
 
-	  /* When getting the preferred height for a specific width,
-	   * we might be able to reuse the layout from getting the
-	   * preferred width. If the width that the layout gives
-	   * unconstrained is less than the width that we are using
-	   * than the height will be unaffected by that width.
-	   */
-	  if (allocation_height < 0 &&
-              cached_width == -1 &&
-              cached_ellipsize == ellipsize)
-	    {
-	      PangoRectangle logical_rect;
+      cogl_matrix_transform_point (&inverse,
+                                   &near[0], &near[1], &near[2], &near[3]);
+      cogl_matrix_transform_point (&inverse,
+                                   &far[0], &far[1], &far[2], &far[3]);
 
-	      pango_layout_get_extents (priv->cached_layouts[i].layout,
-                                        NULL,
-                                        &logical_rect);
+      if (near[3] == 0 || far[3] == 0)
+        return FALSE;
 
-	      if (logical_rect.width <= width)
-		{
-		  /* We've been asked for our height for the width we gave as a result
-		   * of a _get_preferred_width call
-		   */
-		  CLUTTER_NOTE (ACTOR,
-                                "ClutterText: %p: cache hit for size %.2fx%.2f "
-				"(unwrapped width narrower than given width)",
-				text,
-				allocation_width,
-				allocation_height);
+      near[1] /= near[3];
+      near[2] /= near[3];
+      far[1] /= far[3];
+      far[2] /= far[3];
 
-                  CLUTTER_COUNTER_INC (_clutter_uprof_context,
-                                       text_cache_hit_counter);
+      if (fabsf (far[2] - near[2]) < 1e-6)
+        return FALSE;
 
-		  return priv->cached_layouts[i].layout;
-		}
-	    }
+      /* intersect with the z = 0 plane; if the intersection is
+       * outside of the view volume we cannot bound the range
+       */
+      t = -near[2] / (far[2] - near[2]);
+      if (t < 0 || t > 1)
+        return FALSE;
 
-	  if (!found_free_cache &&
-	      (priv->cached_layouts[i].age < oldest_cache->age))
-	    {
-	      oldest_cache = priv->cached_layouts + i;
-	    }
-        }
+      y = near[1] + t * (far[1] - near[1]);
+
+      y_min = MIN (y_min, y);
+      y_max = MAX (y_max, y);
     }
 
-  CLUTTER_NOTE (ACTOR, "ClutterText: %p: cache miss for size %.2fx%.2f",
-		text,
-                allocation_width,
-                allocation_height);
+  /* avoid overflowing the Pango units */
+  y_min = MAX (y_min, -(G_MAXINT / PANGO_SCALE));
+  y_max = MIN (y_max, G_MAXINT / PANGO_SCALE);
 
-  CLUTTER_COUNTER_INC (_clutter_uprof_context, text_cache_miss_counter);
+  *y1_p = floorf (y_min) * PANGO_SCALE;
+  *y2_p = ceilf (y_max) * PANGO_SCALE;
 
-  /* If we make it here then we didn't have a cached version so we
-     need to recreate the layout */
-  if (oldest_cache->layout)
-    g_object_unref (oldest_cache->layout);
+  return TRUE;
+}
 
-  oldest_cache->layout =
-    clutter_text_create_layout_no_cache (text, width, height, ellipsize);
+/*
+ * clutter_text_get_layout_extents:
+ * @text: a #ClutterText
+ * @allocation_width: the allocation width
+ * @allocation_height: the allocation height
+ * @logical_rect: return location for the logical extents
+ * @line_rect: (allow-none): return location for the logical extents
+ *   of the first line
+ *
+ * Retrieves the extents of the layout for the given allocation. If
+ * the layout is being created asynchronously, the extents will be
+ * estimated.
+ */
+static void
+clutter_text_get_layout_extents (ClutterText    *text,
+                                 gfloat          allocation_width,
+                                 gfloat          allocation_height,
+                                 PangoRectangle *logical_rect,
+                                 PangoRectangle *line_rect)
+{
+  if (clutter_text_use_paragraphs (text))
+    {
+      ParagraphSet *set;
 
-  cogl_pango_ensure_glyph_cache_for_layout (oldest_cache->layout);
+      set = clutter_text_ensure_paragraphs (text,
+                                            allocation_width,
+                                            allocation_height);
+      clutter_text_paragraph_set_get_extents (set, logical_rect, line_rect);
+    }
+  else if (clutter_text_use_async_layout (text))
+    {
+      LayoutCache *cache;
 
-  /* Mark the 'time' this cache was created and advance the time */
-  oldest_cache->age = priv->cache_age++;
-  return oldest_cache->layout;
+      cache = clutter_text_ensure_async_layout (text,
+                                                allocation_width,
+                                                allocation_height);
+      if (cache != NULL)
+        clutter_text_layout_cache_get_extents (cache, logical_rect, line_rect);
+      else
+        clutter_text_estimate_size (text,
+                                    allocation_width,
+                                    logical_rect,
+                                    line_rect);
+    }
+  else
+    {
+      PangoLayout *layout;
+
+      layout = clutter_text_create_layout (text,
+                                           allocation_width,
+                                           allocation_height);
+
+      pango_layout_get_extents (layout, NULL, logical_rect);
+
+      if (line_rect != NULL)
+        {
+          PangoLayoutLine *line;
+
+          line = pango_layout_get_line_readonly (layout, 0);
+          pango_layout_line_get_extents (line, NULL, line_rect);
+        }
+    }
 }
 
 static gint
@@ -743,6 +2230,23 @@ clutter_text_coords_to_position (ClutterText *text,
   px = x * PANGO_SCALE;
   py = y * PANGO_SCALE;
 
+  if (clutter_text_use_paragraphs (text))
+    {
+      TextParagraph *paragraph;
+      ParagraphSet *set;
+      gfloat width, height;
+
+      clutter_actor_get_size (CLUTTER_ACTOR (text), &width, &height);
+      set = clutter_text_ensure_paragraphs (text, width, height);
+
+      paragraph = clutter_text_paragraph_at_y (set, py);
+      pango_layout_xy_to_index (paragraph->layout,
+                                px, py - paragraph->y,
+                                &index_, &trailing);
+
+      return paragraph->start + index_ + trailing;
+    }
+
   pango_layout_xy_to_index (clutter_text_get_layout (text),
                             px, py,
                             &index_, &trailing);
@@ -828,9 +2332,25 @@ clutter_text_position_to_coords (ClutterText *self,
       g_string_free (tmp, TRUE);
     }
 
-  pango_layout_get_cursor_pos (clutter_text_get_layout (self),
-                               index_,
-                               &rect, NULL);
+  if (clutter_text_use_paragraphs (self))
+    {
+      TextParagraph *paragraph;
+      ParagraphSet *set;
+      gfloat width, height;
+
+      clutter_actor_get_size (CLUTTER_ACTOR (self), &width, &height);
+      set = clutter_text_ensure_paragraphs (self, width, height);
+
+      paragraph = clutter_text_paragraph_at_index (set, index_);
+      pango_layout_get_cursor_pos (paragraph->layout,
+                                   index_ - paragraph->start,
+                                   &rect, NULL);
+      rect.y += paragraph->y;
+    }
+  else
+    pango_layout_get_cursor_pos (clutter_text_get_layout (self),
+                                 index_,
+                                 &rect, NULL);
 
   if (x)
     {
@@ -1017,7 +2537,7 @@ clutter_text_set_text_internal (ClutterText *self,
   if (priv->n_bytes == 0)
     clutter_text_set_positions (self, -1, -1);
 
-  clutter_text_dirty_cache (self);
+  clutter_text_dirty_layouts (self);
 
   clutter_actor_queue_relayout (CLUTTER_ACTOR (self));
 
@@ -1189,6 +2709,14 @@ clutter_text_set_property (GObject      *gobject,
       clutter_text_set_single_line_mode (self, g_value_get_boolean (value));
       break;
 
+    case PROP_ASYNC_LAYOUT:
+      clutter_text_set_async_layout (self, g_value_get_boolean (value));
+      break;
+
+    case PROP_SHARED_LAYOUT:
+      clutter_text_set_shared_layout (self, g_value_get_boolean (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
     }
@@ -1280,6 +2808,14 @@ clutter_text_get_property (GObject    *gobject,
       g_value_set_boolean (value, priv->single_line_mode);
       break;
 
+    case PROP_ASYNC_LAYOUT:
+      g_value_set_boolean (value, priv->async_layout);
+      break;
+
+    case PROP_SHARED_LAYOUT:
+      g_value_set_boolean (value, priv->shared_layout);
+      break;
+
     case PROP_ELLIPSIZE:
       g_value_set_enum (value, priv->ellipsize);
       break;
@@ -1823,7 +3359,8 @@ clutter_text_paint (ClutterActor *self)
 {
   ClutterText *text = CLUTTER_TEXT (self);
   ClutterTextPrivate *priv = text->priv;
-  PangoLayout *layout;
+  PangoLayout *layout = NULL;
+  ParagraphSet *paragraphs = NULL;
   ClutterActorBox alloc = { 0, };
   CoglColor color = { 0, };
   guint8 real_opacity;
@@ -1842,6 +3379,40 @@ clutter_text_paint (ClutterActor *self)
 
   if (priv->editable && priv->single_line_mode)
     layout = clutter_text_create_layout (text, -1, -1);
+  else if (clutter_text_use_paragraphs (text))
+    paragraphs = clutter_text_ensure_paragraphs (text,
+                                                 alloc.x2 - alloc.x1,
+                                                 alloc.y2 - alloc.y1);
+  else if (clutter_text_use_async_layout (text))
+    {
+      LayoutCache *cache;
+
+      cache = clutter_text_ensure_async_layout (text,
+                                                alloc.x2 - alloc.x1,
+                                                alloc.y2 - alloc.y1);
+
+      /* until the layout for the current allocation is available
+       * we paint the most recent one, if any
+       */
+      if (cache == NULL)
+        {
+          int i;
+
+          for (i = 0; i < N_CACHED_LAYOUTS; i++)
+            {
+              LayoutCache *slot = priv->cached_layouts + i;
+
+              if (slot->layout != NULL &&
+                  (cache == NULL || slot->age > cache->age))
+                cache = slot;
+            }
+        }
+
+      if (cache == NULL)
+        return;
+
+      layout = cache->layout;
+    }
   else
     layout = clutter_text_create_layout (text,
                                          alloc.x2 - alloc.x1,
@@ -1918,7 +3489,39 @@ clutter_text_paint (ClutterActor *self)
                             priv->text_color.green,
                             priv->text_color.blue,
                             real_opacity);
-  cogl_pango_render_layout (layout, text_x, 0, &color, 0);
+
+  if (paragraphs != NULL)
+    {
+      TextParagraph *paragraph;
+      gint y1, y2;
+      guint i;
+
+      /* only paint the paragraphs that can be visible */
+      if (clutter_text_get_visible_range (&y1, &y2))
+        {
+          paragraph = clutter_text_paragraph_at_y (paragraphs, y1);
+          i = paragraph - (TextParagraph *) paragraphs->paragraphs->data;
+        }
+      else
+        {
+          i = 0;
+          y2 = G_MAXINT;
+        }
+
+      for (; i < paragraphs->paragraphs->len; i++)
+        {
+          paragraph = &g_array_index (paragraphs->paragraphs, TextParagraph, i);
+          if (paragraph->y > y2)
+            break;
+
+          cogl_pango_render_layout_subpixel (paragraph->layout,
+                                             text_x * PANGO_SCALE,
+                                             paragraph->y,
+                                             &color, 0);
+        }
+    }
+  else
+    cogl_pango_render_layout (layout, text_x, 0, &color, 0);
 
   if (clip_set)
     cogl_clip_pop ();
@@ -1943,13 +3546,10 @@ clutter_text_get_preferred_width (ClutterActor *self,
   ClutterText *text = CLUTTER_TEXT (self);
   ClutterTextPrivate *priv = text->priv;
   PangoRectangle logical_rect = { 0, };
-  PangoLayout *layout;
   gint logical_width;
   gfloat layout_width;
 
-  layout = clutter_text_create_layout (text, -1, -1);
-
-  pango_layout_get_extents (layout, NULL, &logical_rect);
+  clutter_text_get_layout_extents (text, -1, -1, &logical_rect, NULL);
 
   /* the X coordinate of the logical rectangle might be non-zero
    * according to the Pango documentation; hence, we need to offset
@@ -1996,18 +3596,18 @@ clutter_text_get_preferred_height (ClutterActor *self,
     }
   else
     {
-      PangoLayout *layout;
       PangoRectangle logical_rect = { 0, };
+      PangoRectangle line_rect = { 0, };
       gint logical_height;
       gfloat layout_height;
 
       if (priv->single_line_mode)
         for_width = -1;
 
-      layout = clutter_text_create_layout (CLUTTER_TEXT (self),
-                                           for_width, -1);
-
-      pango_layout_get_extents (layout, NULL, &logical_rect);
+      clutter_text_get_layout_extents (CLUTTER_TEXT (self),
+                                       for_width, -1,
+                                       &logical_rect,
+                                       &line_rect);
 
       /* the Y coordinate of the logical rectangle might be non-zero
        * according to the Pango documentation; hence, we need to offset
@@ -2023,13 +3623,9 @@ clutter_text_get_preferred_height (ClutterActor *self,
            */
           if ((priv->ellipsize && priv->wrap) && !priv->single_line_mode)
             {
-              PangoLayoutLine *line;
               gfloat line_height;
 
-              line = pango_layout_get_line_readonly (layout, 0);
-              pango_layout_line_get_extents (line, NULL, &logical_rect);
-
-              logical_height = logical_rect.y + logical_rect.height;
+              logical_height = line_rect.y + line_rect.height;
               line_height = ceilf (logical_height / 1024.0f);
 
               *min_height_p = line_height;
@@ -2060,6 +3656,14 @@ clutter_text_allocate (ClutterActor           *self,
    */
   if (text->priv->editable && text->priv->single_line_mode)
     clutter_text_create_layout (text, -1, -1);
+  else if (clutter_text_use_paragraphs (text))
+    clutter_text_ensure_paragraphs (text,
+                                    box->x2 - box->x1,
+                                    box->y2 - box->y1);
+  else if (clutter_text_use_async_layout (text))
+    clutter_text_ensure_async_layout (text,
+                                      box->x2 - box->x1,
+                                      box->y2 - box->y1);
   else
     clutter_text_create_layout (text,
                                 box->x2 - box->x1,
@@ -2956,6 +4560,48 @@ clutter_text_class_init (ClutterTextClass *klass)
   obj_props[PROP_SINGLE_LINE_MODE] = pspec;
   g_object_class_install_property (gobject_class, PROP_SINGLE_LINE_MODE, pspec);
 
+  /**
+   * ClutterText:async-layout:
+   *
+   * Whether the #ClutterText actor should create its layout in a
+   * separate thread. While the layout is being created the actor will
+   * report an estimated size, and it will queue a relayout once the
+   * layout is available.
+   *
+   * The #ClutterText:async-layout property is ignored if the
+   * #ClutterText:editable property is set to %TRUE, or if threading
+   * has not been enabled.
+   *
+   * Since: 1.8
+   */
+  pspec = g_param_spec_boolean ("async-layout",
+                                P_("Asynchronous Layout"),
+                                P_("Whether the text should be laid out in a separate thread"),
+                                FALSE,
+                                CLUTTER_PARAM_READWRITE);
+  obj_props[PROP_ASYNC_LAYOUT] = pspec;
+  g_object_class_install_property (gobject_class, PROP_ASYNC_LAYOUT, pspec);
+
+  /**
+   * ClutterText:shared-layout:
+   *
+   * Whether the #ClutterText actor should share its layouts with the
+   * other #ClutterText actors displaying the same contents, using the
+   * same font and layout parameters.
+   *
+   * The #ClutterText:shared-layout property is ignored if the
+   * #ClutterText:editable property is set to %TRUE.
+   *
+   * Since: 1.8
+   */
+  pspec = g_param_spec_boolean ("shared-layout",
+                                P_("Shared Layout"),
+                                P_("Whether the layout should be shared with identical texts"),
+                                FALSE,
+                                CLUTTER_PARAM_READWRITE);
+  obj_props[PROP_SHARED_LAYOUT] = pspec;
+  g_object_class_install_property (gobject_class, PROP_SHARED_LAYOUT, pspec);
+
   /**
    * ClutterText::text-changed:
    * @self: the #ClutterText that emitted the signal
@@ -5080,6 +6726,130 @@ clutter_text_get_single_line_mode (ClutterText *self)
   return self->priv->single_line_mode;
 }
 
+/**
+ * clutter_text_set_async_layout:
+ * @self: a #ClutterText
+ * @async_layout: whether the layout should be created asynchronously
+ *
+ * Sets whether a #ClutterText actor should create its #PangoLayout in
+ * a separate thread, instead of blocking the size negotiation while
+ * the text is shaped. This is useful for long paragraphs, or for
+ * scripts that are expensive to shape.
+ *
+ * Until the layout is available the actor will report a size estimated
+ * from its font, and it will paint the last layout it created, if any.
+ * Once the layout is available a relayout will be queued.
+ *
+ * Editable #ClutterText<!-- -->s are always laid out synchronously.
+ *
+ * Since: 1.8
+ */
+void
+clutter_text_set_async_layout (ClutterText *self,
+                               gboolean     async_layout)
+{
+  ClutterTextPrivate *priv;
+
+  g_return_if_fail (CLUTTER_IS_TEXT (self));
+
+  priv = self->priv;
+
+  async_layout = !!async_layout;
+
+  if (priv->async_layout != async_layout)
+    {
+      priv->async_layout = async_layout;
+
+      clutter_text_dirty_cache (self);
+      clutter_actor_queue_relayout (CLUTTER_ACTOR (self));
+
+      g_object_notify_by_pspec (G_OBJECT (self), obj_props[PROP_ASYNC_LAYOUT]);
+    }
+}
+
+/**
+ * clutter_text_get_async_layout:
+ * @self: a #ClutterText
+ *
+ * Retrieves whether the #ClutterText actor creates its layout in a
+ * separate thread.
+ *
+ * Return value: %TRUE if the layout is created asynchronously
+ *
+ * Since: 1.8
+ */
+gboolean
+clutter_text_get_async_layout (ClutterText *self)
+{
+  g_return_val_if_fail (CLUTTER_IS_TEXT (self), FALSE);
+
+  return self->priv->async_layout;
+}
+
+/**
+ * clutter_text_set_shared_layout:
+ * @self: a #ClutterText
+ * @shared_layout: whether the layout should be shared
+ *
+ * Sets whether a #ClutterText actor should share its #PangoLayout<!-- -->s
+ * with the other #ClutterText actors using the same text, font,
+ * attributes and layout parameters, instead of creating its own.
+ *
+ * Sharing the layouts avoids shaping the same text, and storing its
+ * glyphs geometry, more than once, which is useful in user interfaces
+ * that display the same strings many times, like the labels of a long
+ * list. The shared layouts that are not used by any actor are kept in
+ * a cache of limited size.
+ *
+ * The layout returned by clutter_text_get_layout() for an actor using
+ * a shared layout must not be modified.
+ *
+ * Editable #ClutterText<!-- -->s never share their layouts.
+ *
+ * Since: 1.8
+ */
+void
+clutter_text_set_shared_layout (ClutterText *self,
+                                gboolean     shared_layout)
+{
+  ClutterTextPrivate *priv;
+
+  g_return_if_fail (CLUTTER_IS_TEXT (self));
+
+  priv = self->priv;
+
+  shared_layout = !!shared_layout;
+
+  if (priv->shared_layout != shared_layout)
+    {
+      priv->shared_layout = shared_layout;
+
+      clutter_text_dirty_cache (self);
+      clutter_actor_queue_relayout (CLUTTER_ACTOR (self));
+
+      g_object_notify_by_pspec (G_OBJECT (self), obj_props[PROP_SHARED_LAYOUT]);
+    }
+}
+
+/**
+ * clutter_text_get_shared_layout:
+ * @self: a #ClutterText
+ *
+ * Retrieves whether the #ClutterText actor shares its layouts with
+ * the other #ClutterText actors displaying the same contents.
+ *
+ * Return value: %TRUE if the layouts are shared
+ *
+ * Since: 1.8
+ */
+gboolean
+clutter_text_get_shared_layout (ClutterText *self)
+{
+  g_return_val_if_fail (CLUTTER_IS_TEXT (self), FALSE);
+
+  return self->priv->shared_layout;
+}
+
 /**
  * clutter_text_set_preedit_string:
  * @self: a #ClutterText
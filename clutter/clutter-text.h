@@ -199,6 +199,12 @@ gint                  clutter_text_get_max_length       (ClutterText          *s
 void                  clutter_text_set_single_line_mode (ClutterText          *self,
                                                          gboolean              single_line);
 gboolean              clutter_text_get_single_line_mode (ClutterText          *self);
+void                  clutter_text_set_async_layout     (ClutterText          *self,
+                                                         gboolean              async_layout);
+gboolean              clutter_text_get_async_layout     (ClutterText          *self);
+void                  clutter_text_set_shared_layout    (ClutterText          *self,
+                                                         gboolean              shared_layout);
+gboolean              clutter_text_get_shared_layout    (ClutterText          *self);
 
 gboolean              clutter_text_activate             (ClutterText          *self);
 gboolean              clutter_text_position_to_coords   (ClutterText          *self,
@@ -422,6 +422,9 @@ typedef enum {
  * ClutterFontFlags:
  * @CLUTTER_FONT_MIPMAPPING: Set to use mipmaps for the glyph cache textures.
  * @CLUTTER_FONT_HINTING: Set to enable hinting on the glyphs.
+ * @CLUTTER_FONT_DISTANCE_FIELD: Set to store the glyphs as signed
+ *   distance fields, so that they can be scaled without being
+ *   rasterized again. Since 1.8
  *
  * Runtime flags to change the font quality. To be used with
  * clutter_set_font_flags().
@@ -430,8 +433,9 @@ typedef enum {
  */
 typedef enum
 {
-  CLUTTER_FONT_MIPMAPPING = (1 << 0),
-  CLUTTER_FONT_HINTING    = (1 << 1)
+  CLUTTER_FONT_MIPMAPPING     = (1 << 0),
+  CLUTTER_FONT_HINTING        = (1 << 1),
+  CLUTTER_FONT_DISTANCE_FIELD = (1 << 2)
 } ClutterFontFlags;
 
 /**
@@ -263,6 +263,11 @@ _cogl_atlas_texture_remove_from_atlas (CoglAtlasTexture *atlas_tex)
     }
 }
 
+/* Atlas textures are used for small images, which are typically
+   created and destroyed often, so their storage is recycled */
+static CoglObjectPool _cogl_atlas_texture_pool =
+  COGL_OBJECT_POOL_INIT (CoglAtlasTexture, 32);
+
 static void
 _cogl_atlas_texture_free (CoglAtlasTexture *atlas_tex)
 {
@@ -270,8 +275,9 @@ _cogl_atlas_texture_free (CoglAtlasTexture *atlas_tex)
 
   cogl_handle_unref (atlas_tex->sub_texture);
 
-  /* Chain up */
-  _cogl_texture_free (COGL_TEXTURE (atlas_tex));
+  /* The storage comes from the pool so it isn't freed by chaining up
+     to _cogl_texture_free */
+  _cogl_object_pool_free (&_cogl_atlas_texture_pool, atlas_tex);
 }
 
 static int
@@ -642,7 +648,7 @@ _cogl_atlas_texture_new_from_bitmap (CoglBitmap      *bmp,
 
   /* We need to allocate the texture now because we need the pointer
      to set as the data for the rectangle in the atlas */
-  atlas_tex = g_new (CoglAtlasTexture, 1);
+  atlas_tex = _cogl_object_pool_alloc (&_cogl_atlas_texture_pool);
   /* Mark it as having no atlas so we don't try to unref it in
      _cogl_atlas_texture_post_reorganize_cb */
   atlas_tex->atlas = NULL;
@@ -676,7 +682,7 @@ _cogl_atlas_texture_new_from_bitmap (CoglBitmap      *bmp,
         {
           /* Ok, this means we really can't add it to the atlas */
           cogl_object_unref (atlas);
-          g_free (atlas_tex);
+          _cogl_object_pool_free (&_cogl_atlas_texture_pool, atlas_tex);
           return COGL_INVALID_HANDLE;
         }
     }
@@ -692,7 +698,7 @@ _cogl_atlas_texture_new_from_bitmap (CoglBitmap      *bmp,
     {
       _cogl_atlas_remove (atlas, &atlas_tex->rectangle);
       cogl_object_unref (atlas);
-      g_free (atlas_tex);
+      _cogl_object_pool_free (&_cogl_atlas_texture_pool, atlas_tex);
       return COGL_INVALID_HANDLE;
     }
   atlas_tex->format = internal_format;
@@ -38,6 +38,7 @@
 #include "cogl-framebuffer-private.h"
 #include "cogl-journal-private.h"
 #include "cogl-util.h"
+#include "cogl-object-private.h"
 #include "cogl-path-private.h"
 #include "cogl-matrix-private.h"
 #include "cogl-primitives-private.h"
@@ -287,12 +288,41 @@ disable_clip_planes (void)
   GE( glDisable (GL_CLIP_PLANE0) );
 }
 
+/* The entries are pushed and popped at a high rate so their storage
+   is recycled through a pool for each type of entry */
+static CoglObjectPool _cogl_clip_stack_rect_pool =
+  COGL_OBJECT_POOL_INIT (CoglClipStackRect, 64);
+static CoglObjectPool _cogl_clip_stack_window_rect_pool =
+  COGL_OBJECT_POOL_INIT (CoglClipStackWindowRect, 64);
+static CoglObjectPool _cogl_clip_stack_path_pool =
+  COGL_OBJECT_POOL_INIT (CoglClipStackPath, 64);
+
+static CoglObjectPool *
+_cogl_clip_stack_get_pool (CoglClipStackType type)
+{
+  switch (type)
+    {
+    case COGL_CLIP_STACK_RECT:
+      return &_cogl_clip_stack_rect_pool;
+
+    case COGL_CLIP_STACK_WINDOW_RECT:
+      return &_cogl_clip_stack_window_rect_pool;
+
+    case COGL_CLIP_STACK_PATH:
+      return &_cogl_clip_stack_path_pool;
+    }
+
+  g_assert_not_reached ();
+
+  return NULL;
+}
+
 static gpointer
 _cogl_clip_stack_push_entry (CoglClipStack *clip_stack,
-                             size_t size,
                              CoglClipStackType type)
 {
-  CoglClipStack *entry = g_slice_alloc (size);
+  CoglClipStack *entry =
+    _cogl_object_pool_alloc (_cogl_clip_stack_get_pool (type));
 
   /* The new entry starts with a ref count of 1 because the stack
      holds a reference to it as it is the top entry */
@@ -358,9 +388,7 @@ _cogl_clip_stack_push_window_rectangle (CoglClipStack *stack,
 {
   CoglClipStack *entry;
 
-  entry = _cogl_clip_stack_push_entry (stack,
-                                       sizeof (CoglClipStackWindowRect),
-                                       COGL_CLIP_STACK_WINDOW_RECT);
+  entry = _cogl_clip_stack_push_entry (stack, COGL_CLIP_STACK_WINDOW_RECT);
 
   entry->bounds_x0 = x_offset;
   entry->bounds_x1 = x_offset + width;
@@ -383,9 +411,7 @@ _cogl_clip_stack_push_rectangle (CoglClipStack *stack,
   float v[4];
 
   /* Make a new entry */
-  entry = _cogl_clip_stack_push_entry (stack,
-                                       sizeof (CoglClipStackRect),
-                                       COGL_CLIP_STACK_RECT);
+  entry = _cogl_clip_stack_push_entry (stack, COGL_CLIP_STACK_RECT);
 
   entry->x0 = x_1;
   entry->y0 = y_1;
@@ -461,9 +487,7 @@ _cogl_clip_stack_push_from_path (CoglClipStack *stack,
     {
       CoglClipStackPath *entry;
 
-      entry = _cogl_clip_stack_push_entry (stack,
-                                           sizeof (CoglClipStackPath),
-                                           COGL_CLIP_STACK_PATH);
+      entry = _cogl_clip_stack_push_entry (stack, COGL_CLIP_STACK_PATH);
 
       entry->path = cogl_path_copy (path);
 
@@ -496,24 +520,11 @@ _cogl_clip_stack_unref (CoglClipStack *entry)
     {
       CoglClipStack *parent = entry->parent;
 
-      switch (entry->type)
-        {
-        case COGL_CLIP_STACK_RECT:
-          g_slice_free1 (sizeof (CoglClipStackRect), entry);
-          break;
-
-        case COGL_CLIP_STACK_WINDOW_RECT:
-          g_slice_free1 (sizeof (CoglClipStackWindowRect), entry);
-          break;
-
-        case COGL_CLIP_STACK_PATH:
-          cogl_object_unref (((CoglClipStackPath *) entry)->path);
-          g_slice_free1 (sizeof (CoglClipStackPath), entry);
-          break;
+      if (entry->type == COGL_CLIP_STACK_PATH)
+        cogl_object_unref (((CoglClipStackPath *) entry)->path);
 
-        default:
-          g_assert_not_reached ();
-        }
+      _cogl_object_pool_free (_cogl_clip_stack_get_pool (entry->type),
+                              entry);
 
       entry = parent;
     }
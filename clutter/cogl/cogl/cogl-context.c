@@ -36,6 +36,7 @@
 #include "cogl-pipeline-opengl-private.h"
 #include "cogl-framebuffer-private.h"
 #include "cogl2-path.h"
+#include "cogl-matrix-private.h"
 
 #include <string.h>
 
@@ -122,6 +123,7 @@ cogl_create_context (void)
   /* TODO: combine these two into one function */
   _cogl_create_context_driver (_context);
   _cogl_features_init ();
+  _cogl_matrix_init_funcs ();
   _cogl_init_feature_overrides (_context);
 
   _cogl_create_context_winsys (_context);
@@ -288,6 +290,8 @@ cogl_create_context (void)
 
   _context->atlases = NULL;
 
+  _cogl_callback_list_init (&_context->journal_pre_flush_callbacks);
+
   _context->buffer_map_fallback_array = g_byte_array_new ();
   _context->buffer_map_fallback_in_use = FALSE;
 
@@ -370,6 +374,8 @@ _cogl_destroy_context (void)
 
   g_slist_free (_context->atlases);
 
+  _cogl_callback_list_destroy (&_context->journal_pre_flush_callbacks);
+
   _cogl_bitmask_destroy (&_context->arrays_enabled);
   _cogl_bitmask_destroy (&_context->temp_bitmask);
   _cogl_bitmask_destroy (&_context->arrays_to_change);
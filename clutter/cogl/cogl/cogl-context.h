@@ -42,6 +42,7 @@
 #include "cogl-buffer-private.h"
 #include "cogl-bitmask.h"
 #include "cogl-atlas.h"
+#include "cogl-callback-list.h"
 
 typedef struct
 {
@@ -116,6 +117,9 @@ typedef struct
   /* Global journal buffers */
   GArray           *journal_flush_attributes_array;
   GArray           *journal_clip_bounds;
+  /* Callbacks invoked before anything is logged to or flushed from a
+   * journal */
+  CoglCallbackList  journal_pre_flush_callbacks;
 
   GArray           *polygon_vertices;
 
@@ -179,3 +179,16 @@ OPT (CLIPPING,
      "clipping",
      "Trace clipping",
      "Logs information about how Cogl is implementing clipping")
+OPT (DISABLE_SIMD,
+     "Root Cause",
+     "disable-simd",
+     "Disable SIMD optimizations",
+     "Use the plain C implementations of the matrix functions instead "
+     "of the SSE ones")
+OPT (OBJECTS,
+     "Cogl Tracing",
+     "objects",
+     "Trace object allocations",
+     "Logs the number of live objects of each type, their high-water "
+     "mark, how many were allocated and how many were recycled from "
+     "the free lists, after every frame in which they changed")
@@ -63,6 +63,8 @@ typedef enum {
   COGL_DEBUG_DISABLE_PROGRAM_CACHES,
   COGL_DEBUG_DISABLE_FAST_READ_PIXEL,
   COGL_DEBUG_CLIPPING,
+  COGL_DEBUG_DISABLE_SIMD,
+  COGL_DEBUG_OBJECTS,
 
   COGL_DEBUG_N_FLAGS
 } CoglDebugFlags;
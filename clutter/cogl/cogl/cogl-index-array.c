@@ -37,13 +37,18 @@ static void _cogl_index_array_free (CoglIndexArray *indices);
 
 COGL_BUFFER_DEFINE (IndexArray, index_array);
 
+/* Like vertex arrays, index arrays are often created for a single
+   draw so their storage is recycled */
+static CoglObjectPool _cogl_index_array_pool =
+  COGL_OBJECT_POOL_INIT (CoglIndexArray, 32);
+
 /* XXX: Unlike the wiki design this just takes a size. A single
  * indices buffer should be able to contain multiple ranges of indices
  * which the wiki design doesn't currently consider. */
 CoglIndexArray *
 cogl_index_array_new (gsize bytes)
 {
-  CoglIndexArray *indices = g_slice_new (CoglIndexArray);
+  CoglIndexArray *indices = _cogl_object_pool_alloc (&_cogl_index_array_pool);
   gboolean use_malloc;
 
   if (!cogl_features_available (COGL_FEATURE_VBOS))
@@ -68,7 +73,7 @@ _cogl_index_array_free (CoglIndexArray *indices)
   /* parent's destructor */
   _cogl_buffer_fini (COGL_BUFFER (indices));
 
-  g_slice_free (CoglIndexArray, indices);
+  _cogl_object_pool_free (&_cogl_index_array_pool, indices);
 }
 
 gboolean
@@ -25,7 +25,36 @@
 #define __COGL_JOURNAL_PRIVATE_H
 
 #include "cogl-handle.h"
+#include "cogl-pipeline-private.h"
 #include "cogl-clip-stack.h"
+#include "cogl-matrix-stack.h"
+#include "cogl-callback-list.h"
+
+#define COGL_JOURNAL_N_OVERRIDE_PIPELINES 8
+
+/* When a quad is logged with overrides or while some legacy state is
+ * set the journal needs a pipeline derived from the one given with
+ * those changes applied. The derived pipelines are cached until the
+ * journal is flushed so that consecutive quads needing the same
+ * changes can share one pipeline. That way they can also be batched
+ * together because the pipelines are compared by pointer first. */
+typedef struct _CoglJournalOverride
+{
+  /* The cache holds a reference on both pipelines. The parent is
+   * referenced so that its address can't be reused by a new pipeline
+   * while the entry is in the cache */
+  CoglPipeline            *parent;
+  unsigned long            parent_age;
+
+  guint32                  disable_layers;
+  CoglHandle               layer0_override_texture;
+
+  CoglHandle               legacy_program;
+  gboolean                 legacy_depth_test_enabled;
+  CoglPipelineFogState     legacy_fog_state;
+
+  CoglPipeline            *derived;
+} CoglJournalOverride;
 
 typedef struct _CoglJournal
 {
@@ -37,6 +66,11 @@ typedef struct _CoglJournal
 
   int fast_read_pixel_count;
 
+  CoglJournalOverride overrides[COGL_JOURNAL_N_OVERRIDE_PIPELINES];
+  int n_overrides;
+  /* The entry to replace next once the cache is full */
+  int next_override;
+
 } CoglJournal;
 
 /* To improve batching of geometry when submitting vertices to OpenGL we
@@ -46,13 +80,13 @@ typedef struct _CoglJournalEntry
 {
   CoglPipeline            *pipeline;
   int                      n_layers;
-  CoglMatrix               model_view;
+  /* A reference to the state of the modelview stack when the quad
+   * was logged. Quads logged with the same modelview share the same
+   * entry so they can be batched by comparing the pointers */
+  CoglMatrixEntry         *modelview_entry;
   CoglClipStack           *clip_stack;
   /* Offset into ctx->logged_vertices */
   size_t                   array_offset;
-  /* XXX: These entries are pretty big now considering the padding in
-   * CoglPipelineFlushOptions and CoglMatrix, so we might need to optimize this
-   * later. */
 } CoglJournalEntry;
 
 CoglJournal *
@@ -74,6 +108,20 @@ _cogl_journal_flush (CoglJournal *journal,
 void
 _cogl_journal_discard (CoglJournal *journal);
 
+/* Code outside of the journal can keep some geometry of its own
+ * pending to batch it across several paint calls. These callbacks are
+ * invoked before anything else is logged to or flushed from any
+ * journal so that the pending geometry can be submitted first and the
+ * order of the drawing is preserved. The callbacks must not remove
+ * themselves while they are being invoked. */
+void
+_cogl_journal_add_pre_flush_callback (CoglCallbackListFunc callback,
+                                      void *user_data);
+
+void
+_cogl_journal_remove_pre_flush_callback (CoglCallbackListFunc callback,
+                                         void *user_data);
+
 gboolean
 _cogl_journal_all_entries_within_bounds (CoglJournal *journal,
                                          float clip_x0,
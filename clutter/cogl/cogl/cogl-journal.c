@@ -122,9 +122,14 @@ static void _cogl_journal_free (CoglJournal *journal);
 
 COGL_OBJECT_DEFINE (Journal, journal);
 
+static void
+_cogl_journal_clear_overrides (CoglJournal *journal);
+
 static void
 _cogl_journal_free (CoglJournal *journal)
 {
+  _cogl_journal_clear_overrides (journal);
+
   if (journal->entries)
     g_array_free (journal->entries, TRUE);
   if (journal->vertices)
@@ -281,8 +286,8 @@ _cogl_journal_flush_modelview_and_entries (CoglJournalEntry *batch_start,
 
   if (G_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_DISABLE_SOFTWARE_TRANSFORM)))
     {
-      _cogl_matrix_stack_set (state->modelview_stack,
-                              &batch_start->model_view);
+      _cogl_matrix_stack_set_entry (state->modelview_stack,
+                                    batch_start->modelview_entry);
       _cogl_matrix_stack_flush_to_gl (state->modelview_stack,
                                       COGL_MATRIX_MODELVIEW);
     }
@@ -385,22 +390,12 @@ static gboolean
 compare_entry_modelviews (CoglJournalEntry *entry0,
                           CoglJournalEntry *entry1)
 {
-  /* Batch together quads with the same model view matrix */
-
-  /* FIXME: this is nasty, there are much nicer ways to track this
-   * (at the add_quad_vertices level) without resorting to a memcmp!
-   *
-   * E.g. If the cogl-current-matrix code maintained an "age" for
-   * the modelview matrix we could simply check in add_quad_vertices
-   * if the age has increased, and if so record the change as a
-   * boolean in the journal.
-   */
-
-  if (memcmp (&entry0->model_view, &entry1->model_view,
-              sizeof (GLfloat) * 16) == 0)
-    return TRUE;
-  else
-    return FALSE;
+  /* Batch together quads with the same model view matrix. Matrix
+   * stack entries are never modified while the journal references
+   * them so comparing the pointers is enough. This can miss equal
+   * matrices that were set separately but that only matters when
+   * the software transform is disabled */
+  return entry0->modelview_entry == entry1->modelview_entry;
 }
 
 /* At this point we have a run of quads that we know have compatible
@@ -863,7 +858,7 @@ can_software_clip_entry (CoglJournalEntry *journal_entry,
       clip_rect = (CoglClipStackRect *) clip_entry;
 
       if (!calculate_translation (&clip_rect->matrix,
-                                  &journal_entry->model_view,
+                                  &journal_entry->modelview_entry->matrix,
                                   &tx, &ty))
         return FALSE;
 
@@ -1151,7 +1146,7 @@ upload_vertices (const CoglJournalEntry *entries,
           v[6] = vin[array_stride];
           v[7] = vin[1];
 
-          cogl_matrix_transform_points (&entry->model_view,
+          cogl_matrix_transform_points (&entry->modelview_entry->matrix,
                                         2, /* n_components */
                                         sizeof (float) * 2, /* stride_in */
                                         v, /* points_in */
@@ -1185,6 +1180,26 @@ upload_vertices (const CoglJournalEntry *entries,
   return array;
 }
 
+void
+_cogl_journal_add_pre_flush_callback (CoglCallbackListFunc callback,
+                                      void *user_data)
+{
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  _cogl_callback_list_add (&ctx->journal_pre_flush_callbacks,
+                           callback, user_data);
+}
+
+void
+_cogl_journal_remove_pre_flush_callback (CoglCallbackListFunc callback,
+                                         void *user_data)
+{
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  _cogl_callback_list_remove (&ctx->journal_pre_flush_callbacks,
+                              callback, user_data);
+}
+
 void
 _cogl_journal_discard (CoglJournal *journal)
 {
@@ -1196,12 +1211,17 @@ _cogl_journal_discard (CoglJournal *journal)
         &g_array_index (journal->entries, CoglJournalEntry, i);
       _cogl_pipeline_journal_unref (entry->pipeline);
       _cogl_clip_stack_unref (entry->clip_stack);
+      _cogl_matrix_entry_unref (entry->modelview_entry);
     }
 
   g_array_set_size (journal->entries, 0);
   g_array_set_size (journal->vertices, 0);
   journal->needed_vbo_len = 0;
   journal->fast_read_pixel_count = 0;
+
+  /* Don't keep the application's pipelines alive any longer than the
+     quads using them */
+  _cogl_journal_clear_overrides (journal);
 }
 
 /* Note: A return value of FALSE doesn't mean 'no' it means
@@ -1291,6 +1311,8 @@ _cogl_journal_flush (CoglJournal *journal,
 
   _COGL_GET_CONTEXT (ctx, NO_RETVAL);
 
+  _cogl_callback_list_invoke (&ctx->journal_pre_flush_callbacks);
+
   if (journal->entries->len == 0)
     return;
 
@@ -1405,6 +1427,106 @@ add_framebuffer_deps_cb (CoglPipelineLayer *layer, void *user_data)
   return TRUE;
 }
 
+static void
+_cogl_journal_clear_overrides (CoglJournal *journal)
+{
+  int i;
+
+  for (i = 0; i < journal->n_overrides; i++)
+    {
+      CoglJournalOverride *override = journal->overrides + i;
+
+      cogl_handle_unref (override->derived);
+      cogl_handle_unref (override->parent);
+    }
+
+  journal->n_overrides = 0;
+  journal->next_override = 0;
+}
+
+static gboolean
+legacy_fog_state_equal (const CoglPipelineFogState *fog_state0,
+                        const CoglPipelineFogState *fog_state1)
+{
+  if (fog_state0->enabled != fog_state1->enabled)
+    return FALSE;
+
+  if (!fog_state0->enabled)
+    return TRUE;
+
+  return (cogl_color_equal (&fog_state0->color, &fog_state1->color) &&
+          fog_state0->mode == fog_state1->mode &&
+          fog_state0->density == fog_state1->density &&
+          fog_state0->z_near == fog_state1->z_near &&
+          fog_state0->z_far == fog_state1->z_far);
+}
+
+/* Returns a pipeline derived from @pipeline with the current legacy
+ * state and the overrides in @flush_options applied. The journal owns
+ * the returned pipeline. */
+static CoglPipeline *
+_cogl_journal_get_override_pipeline (CoglJournal *journal,
+                                     CoglPipeline *pipeline,
+                                     CoglPipelineFlushOptions *options)
+{
+  CoglJournalOverride *override;
+  CoglPipeline *derived;
+  int i;
+
+  _COGL_GET_CONTEXT (ctx, NULL);
+
+  for (i = 0; i < journal->n_overrides; i++)
+    {
+      override = journal->overrides + i;
+
+      if (override->parent == pipeline &&
+          override->parent_age == pipeline->age &&
+          override->disable_layers == options->disable_layers &&
+          (override->layer0_override_texture ==
+           options->layer0_override_texture) &&
+          override->legacy_program == ctx->current_program &&
+          (override->legacy_depth_test_enabled ==
+           ctx->legacy_depth_test_enabled) &&
+          legacy_fog_state_equal (&override->legacy_fog_state,
+                                  &ctx->legacy_fog_state))
+        return override->derived;
+    }
+
+  derived = cogl_pipeline_copy (pipeline);
+
+  if (ctx->legacy_state_set)
+    _cogl_pipeline_apply_legacy_state (derived);
+
+  if (options->flags)
+    _cogl_pipeline_apply_overrides (derived, options);
+
+  if (journal->n_overrides < COGL_JOURNAL_N_OVERRIDE_PIPELINES)
+    override = journal->overrides + journal->n_overrides++;
+  else
+    {
+      /* Replace the entries in the order they were added. The
+         journal has its own reference on any derived pipeline that
+         is still used by a logged quad */
+      override = journal->overrides + journal->next_override;
+      journal->next_override = ((journal->next_override + 1) %
+                                COGL_JOURNAL_N_OVERRIDE_PIPELINES);
+
+      cogl_handle_unref (override->derived);
+      cogl_handle_unref (override->parent);
+    }
+
+  override->parent = cogl_handle_ref (pipeline);
+  override->parent_age = pipeline->age;
+  override->disable_layers = options->disable_layers;
+  override->layer0_override_texture = options->layer0_override_texture;
+  override->legacy_program = ctx->current_program;
+  override->legacy_depth_test_enabled = ctx->legacy_depth_test_enabled;
+  override->legacy_fog_state = ctx->legacy_fog_state;
+  override->derived = derived;
+
+  return derived;
+}
+
 void
 _cogl_journal_log_quad (CoglJournal  *journal,
                         const float  *position,
@@ -1423,6 +1545,7 @@ _cogl_journal_log_quad (CoglJournal  *journal,
   CoglJournalEntry *entry;
   CoglPipeline     *source;
   CoglClipStack    *clip_stack;
+  CoglMatrixStack  *modelview_stack;
   CoglPipelineFlushOptions flush_options;
   COGL_STATIC_TIMER (log_timer,
                      "Mainloop", /* parent */
@@ -1432,6 +1555,8 @@ _cogl_journal_log_quad (CoglJournal  *journal,
 
   _COGL_GET_CONTEXT (ctx, NO_RETVAL);
 
+  _cogl_callback_list_invoke (&ctx->journal_pre_flush_callbacks);
+
   COGL_TIMER_START (_cogl_uprof_context, log_timer);
 
   /* The vertex data is logged into a separate array. The data needs
@@ -1487,15 +1612,11 @@ _cogl_journal_log_quad (CoglJournal  *journal,
   entry->n_layers = n_layers;
   entry->array_offset = next_vert;
 
-  source = pipeline;
-
-  if (G_UNLIKELY (ctx->legacy_state_set))
-    {
-      source = cogl_pipeline_copy (pipeline);
-      _cogl_pipeline_apply_legacy_state (source);
-    }
-
+  /* The options that aren't used are left as zero so that they can
+     be compared when looking for a cached derived pipeline */
   flush_options.flags = 0;
+  flush_options.disable_layers = 0;
+  flush_options.layer0_override_texture = COGL_INVALID_HANDLE;
   if (G_UNLIKELY (cogl_pipeline_get_n_layers (pipeline) != n_layers))
     {
       disable_layers = (1 << n_layers) - 1;
@@ -1509,23 +1630,22 @@ _cogl_journal_log_quad (CoglJournal  *journal,
       flush_options.layer0_override_texture = layer0_override_texture;
     }
 
-  if (G_UNLIKELY (flush_options.flags))
-    {
-      /* If we haven't already created a derived pipeline... */
-      if (source == pipeline)
-        source = cogl_pipeline_copy (pipeline);
-      _cogl_pipeline_apply_overrides (source, &flush_options);
-    }
+  if (G_UNLIKELY (ctx->legacy_state_set || flush_options.flags))
+    source = _cogl_journal_get_override_pipeline (journal,
+                                                  pipeline,
+                                                  &flush_options);
+  else
+    source = pipeline;
 
   entry->pipeline = _cogl_pipeline_journal_ref (source);
 
   clip_stack = _cogl_framebuffer_get_clip_stack (_cogl_get_draw_buffer ());
   entry->clip_stack = _cogl_clip_stack_ref (clip_stack);
 
-  if (G_UNLIKELY (source != pipeline))
-    cogl_handle_unref (source);
-
-  cogl_get_modelview_matrix (&entry->model_view);
+  modelview_stack =
+    _cogl_framebuffer_get_modelview_stack (_cogl_get_draw_buffer ());
+  entry->modelview_entry =
+    _cogl_matrix_entry_ref (_cogl_matrix_stack_get_entry (modelview_stack));
 
   _cogl_pipeline_foreach_layer_internal (pipeline,
                                          add_framebuffer_deps_cb,
@@ -1578,7 +1698,7 @@ entry_to_screen_polygon (const CoglJournalEntry *entry,
    * _cogl_transform_points utility...
    */
 
-  cogl_matrix_transform_points (&entry->model_view,
+  cogl_matrix_transform_points (&entry->modelview_entry->matrix,
                                 2, /* n_components */
                                 sizeof (float) * 4, /* stride_in */
                                 poly, /* points_in */
@@ -1718,6 +1838,10 @@ _cogl_journal_try_read_pixel (CoglJournal *journal,
 
   _COGL_GET_CONTEXT (ctx, FALSE);
 
+  /* Any pending geometry could cover the pixel so it needs to be
+   * logged or drawn first */
+  _cogl_callback_list_invoke (&ctx->journal_pre_flush_callbacks);
+
   /* XXX: this number has been plucked out of thin air, but the idea
    * is that if so many pixels are being read from the same un-changed
    * journal than we expect that it will be more efficient to fail
@@ -70,6 +70,7 @@
  */
 
 #include "cogl-matrix-mesa.h"
+#include "cogl-matrix-private.h"
 
 #include <string.h>
 #include <math.h>
@@ -218,8 +219,8 @@ static float identity[16] = {
  *
  * \author This \c matmul was contributed by Thomas Malik
  */
-static void
-matrix_multiply4x4 (float *result, const float *a, const float *b)
+void
+_math_matrix_multiply4x4 (float *result, const float *a, const float *b)
 {
   int i;
   for (i = 0; i < 4; i++)
@@ -240,8 +241,8 @@ matrix_multiply4x4 (float *result, const float *a, const float *b)
  * \param b matrix.
  * \param product will receive the product of \p a and \p b.
  */
-static void
-matrix_multiply3x4 (float *result, const float *a, const float *b)
+void
+_math_matrix_multiply3x4 (float *result, const float *a, const float *b)
 {
   int i;
   for (i = 0; i < 3; i++)
@@ -271,7 +272,8 @@ matrix_multiply3x4 (float *result, const float *a, const float *b)
  * \param flags flags of the matrix \p m.
  *
  * Joins both flags and marks the type and inverse as dirty.  Calls
- * matrix_multiply3x4() if both matrices are 3D, or matrix_multiply4x4()
+ * _math_matrix_multiply3x4() if both matrices are 3D, or
+ * _math_matrix_multiply4x4()
  * otherwise.
  */
 static void
@@ -282,9 +284,9 @@ matrix_multiply_array_with_flags (CoglMatrix *result,
   result->flags |= (flags | MAT_DIRTY_TYPE | MAT_DIRTY_INVERSE);
 
   if (TEST_MAT_FLAGS (result, MAT_FLAGS_3D))
-    matrix_multiply3x4 ((float *)result, (float *)result, array);
+    _cogl_matrix_funcs->multiply3x4 ((float *)result, (float *)result, array);
   else
-    matrix_multiply4x4 ((float *)result, (float *)result, array);
+    _cogl_matrix_funcs->multiply4x4 ((float *)result, (float *)result, array);
 }
 
 /*
@@ -295,7 +297,8 @@ matrix_multiply_array_with_flags (CoglMatrix *result,
  * \param b right matrix.
  *
  * Joins both flags and marks the type and inverse as dirty.  Calls
- * matrix_multiply3x4() if both matrices are 3D, or matrix_multiply4x4()
+ * _math_matrix_multiply3x4() if both matrices are 3D, or
+ * _math_matrix_multiply4x4()
  * otherwise.
  */
 void
@@ -309,9 +312,9 @@ _math_matrix_multiply (CoglMatrix *result,
                    MAT_DIRTY_INVERSE);
 
   if (TEST_MAT_FLAGS(result, MAT_FLAGS_3D))
-    matrix_multiply3x4 ((float *)result, (float *)a, (float *)b);
+    _cogl_matrix_funcs->multiply3x4 ((float *)result, (float *)a, (float *)b);
   else
-    matrix_multiply4x4 ((float *)result, (float *)a, (float *)b);
+    _cogl_matrix_funcs->multiply4x4 ((float *)result, (float *)a, (float *)b);
 }
 
 /*
@@ -321,7 +324,7 @@ _math_matrix_multiply (CoglMatrix *result,
  * \param m right matrix array.
  *
  * Marks the matrix flags with general flag, and type and inverse dirty flags.
- * Calls matrix_multiply4x4() for the multiplication.
+ * Calls _math_matrix_multiply4x4() for the multiplication.
  */
 void
 _math_matrix_multiply_array (CoglMatrix *result, const float *array)
@@ -331,7 +334,9 @@ _math_matrix_multiply_array (CoglMatrix *result, const float *array)
                   MAT_DIRTY_INVERSE |
                   MAT_DIRTY_FLAGS);
 
-  matrix_multiply4x4 ((float *)result, (float *)result, (float *)array);
+  _cogl_matrix_funcs->multiply4x4 ((float *)result,
+                                   (float *)result,
+                                   (float *)array);
 }
 
 /*@}*/
@@ -372,7 +377,7 @@ _math_matrix_print (const CoglMatrix *matrix)
     {
       float prod[16];
       print_matrix_floats (matrix->inv);
-      matrix_multiply4x4 (prod, (float *)matrix, matrix->inv);
+      _math_matrix_multiply4x4 (prod, (float *)matrix, matrix->inv);
       g_print ("Mat * Inverse:\n");
       print_matrix_floats (prod);
     }
@@ -404,7 +409,7 @@ _math_matrix_print (const CoglMatrix *matrix)
 /*
  * Swaps the values of two floating pointer variables.
  *
- * Used by invert_matrix_general() to swap the row pointers.
+ * Used by _math_matrix_invert_general() to swap the row pointers.
  */
 #define SWAP_ROWS(a, b) { float *_tmp = a; (a)=(b); (b)=_tmp; }
 
@@ -423,8 +428,8 @@ _math_matrix_print (const CoglMatrix *matrix)
  * with partial pivoting followed by back/substitution with the loops manually
  * unrolled.
  */
-static gboolean
-invert_matrix_general (CoglMatrix *matrix)
+gboolean
+_math_matrix_invert_general (CoglMatrix *matrix)
 {
   const float *m = (float *)matrix;
   float *out = matrix->inv;
@@ -830,6 +835,16 @@ invert_matrix_perspective (CoglMatrix *matrix)
 }
 #endif
 
+/*
+ * Computes the inverse of a general matrix with the implementation
+ * selected for the CPU.
+ */
+static gboolean
+invert_matrix_general (CoglMatrix *matrix)
+{
+  return _cogl_matrix_funcs->invert_general (matrix);
+}
+
 /*
  * Matrix inversion function pointer type.
  */
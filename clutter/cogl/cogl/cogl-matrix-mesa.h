@@ -107,6 +107,15 @@ _math_matrix_multiply (CoglMatrix *result,
 void
 _math_matrix_multiply_array (CoglMatrix *result, const float *b);
 
+void
+_math_matrix_multiply4x4 (float *result, const float *a, const float *b);
+
+void
+_math_matrix_multiply3x4 (float *result, const float *a, const float *b);
+
+gboolean
+_math_matrix_invert_general (CoglMatrix *matrix);
+
 void
 _math_matrix_init_from_array (CoglMatrix *matrix, const float *array);
 
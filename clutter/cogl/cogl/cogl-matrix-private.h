@@ -41,6 +41,55 @@ G_BEGIN_DECLS
 void
 _cogl_matrix_print (CoglMatrix *matrix);
 
+typedef void (* CoglMatrixMultiplyFunc) (float *result,
+                                         const float *a,
+                                         const float *b);
+
+typedef void (* CoglMatrixPointsFunc) (const CoglMatrix *matrix,
+                                       size_t stride_in,
+                                       const void *points_in,
+                                       size_t stride_out,
+                                       void *points_out,
+                                       int n_points);
+
+/* The implementations of the inner loops of the matrix code. The
+ * plain C versions are used until the context is created, at which
+ * point versions using the SIMD instructions of the CPU may be
+ * selected instead. All the versions produce the same results as the
+ * C code, except for the general inverse which may differ slightly
+ * because it uses a different algorithm */
+typedef struct _CoglMatrixFuncs
+{
+  const char *name;
+
+  /* Multiplies the column-major 4x4 arrays a and b. result may be the
+   * same as a but not b */
+  CoglMatrixMultiplyFunc multiply4x4;
+  /* Same as multiply4x4 for matrices where the bottom row is
+   * (0, 0, 0, 1) */
+  CoglMatrixMultiplyFunc multiply3x4;
+
+  /* Stores the inverse of a general matrix in matrix->inv, returning
+   * FALSE if the matrix is singular */
+  gboolean (* invert_general) (CoglMatrix *matrix);
+
+  CoglMatrixPointsFunc transform_points_f2;
+  CoglMatrixPointsFunc transform_points_f3;
+  CoglMatrixPointsFunc project_points_f2;
+  CoglMatrixPointsFunc project_points_f3;
+  CoglMatrixPointsFunc project_points_f4;
+} CoglMatrixFuncs;
+
+extern const CoglMatrixFuncs *_cogl_matrix_funcs;
+
+void
+_cogl_matrix_init_funcs (void);
+
+/* Returns the SIMD implementation of the matrix functions if the CPU
+ * supports it, or NULL */
+const CoglMatrixFuncs *
+_cogl_matrix_get_simd_funcs (void);
+
 G_END_DECLS
 
 #endif /* __COGL_MATRIX_PRIVATE_H */
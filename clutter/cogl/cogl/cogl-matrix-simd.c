@@ -0,0 +1,421 @@
+/*
+ * Cogl
+ *
+ * An object oriented GL/GLES Abstraction/Utility Layer
+ *
+ * Copyright (C) 2011 Intel Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "cogl.h"
+#include "cogl-matrix-private.h"
+
+#include <glib.h>
+
+/* The SSE versions only need the instructions of the original SSE.
+ * Every x86-64 CPU has them but on 32-bit x86 the CPU is checked
+ * before using them. The functions are compiled for SSE with the
+ * target attribute so that they are available even if the rest of
+ * Cogl is built without -msse; that needs GCC 4.9 or Clang to use
+ * the intrinsics in such functions */
+#if defined(__GNUC__) && (defined(__x86_64) || defined(__i386)) && \
+  (defined(__SSE__) || defined(__clang__) || \
+   __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define COGL_USE_MATRIX_SSE
+#endif
+
+#ifdef COGL_USE_MATRIX_SSE
+
+#include <xmmintrin.h>
+#ifndef __x86_64
+#include <cpuid.h>
+#endif
+
+#define COGL_SSE_FUNC __attribute__ ((target ("sse")))
+
+/* All the functions below perform the same operations in the same
+ * order as the C versions in cogl-matrix-mesa.c and cogl-matrix.c so
+ * that they give exactly the same results. The columns of a CoglMatrix
+ * are stored contiguously so each column can be loaded into a single
+ * register and a whole column of the result is computed at once */
+
+static COGL_SSE_FUNC void
+_cogl_matrix_multiply4x4_sse (float *result, const float *a, const float *b)
+{
+  const __m128 a0 = _mm_loadu_ps (a);
+  const __m128 a1 = _mm_loadu_ps (a + 4);
+  const __m128 a2 = _mm_loadu_ps (a + 8);
+  const __m128 a3 = _mm_loadu_ps (a + 12);
+  int i;
+
+  /* result may be the same as a, which has been completely loaded
+   * already, but not b */
+  for (i = 0; i < 4; i++)
+    {
+      const float *bi = b + i * 4;
+      __m128 r;
+
+      r = _mm_mul_ps (a0, _mm_set1_ps (bi[0]));
+      r = _mm_add_ps (r, _mm_mul_ps (a1, _mm_set1_ps (bi[1])));
+      r = _mm_add_ps (r, _mm_mul_ps (a2, _mm_set1_ps (bi[2])));
+      r = _mm_add_ps (r, _mm_mul_ps (a3, _mm_set1_ps (bi[3])));
+
+      _mm_storeu_ps (result + i * 4, r);
+    }
+}
+
+static COGL_SSE_FUNC void
+_cogl_matrix_multiply3x4_sse (float *result, const float *a, const float *b)
+{
+  const __m128 a0 = _mm_loadu_ps (a);
+  const __m128 a1 = _mm_loadu_ps (a + 4);
+  const __m128 a2 = _mm_loadu_ps (a + 8);
+  const __m128 a3 = _mm_loadu_ps (a + 12);
+  int i;
+
+  for (i = 0; i < 4; i++)
+    {
+      const float *bi = b + i * 4;
+      __m128 r;
+
+      r = _mm_mul_ps (a0, _mm_set1_ps (bi[0]));
+      r = _mm_add_ps (r, _mm_mul_ps (a1, _mm_set1_ps (bi[1])));
+      r = _mm_add_ps (r, _mm_mul_ps (a2, _mm_set1_ps (bi[2])));
+      /* the bottom row of b is assumed to be (0, 0, 0, 1) */
+      if (i == 3)
+        r = _mm_add_ps (r, a3);
+
+      _mm_storeu_ps (result + i * 4, r);
+    }
+
+  result[3] = 0;
+  result[7] = 0;
+  result[11] = 0;
+  result[15] = 1;
+}
+
+/* Computes the inverse using Cramer's rule, as described in Intel's
+ * "Streaming SIMD Extensions - Inverse of 4x4 Matrix" application note.
+ * The note deals with row-major matrices but as the inverse of the
+ * transpose is the transpose of the inverse, the same code works for
+ * column-major ones. This is much shorter than the gaussian
+ * elimination of the C version but the rounding errors are a bit
+ * different so the results may not be exactly the same */
+static COGL_SSE_FUNC gboolean
+_cogl_matrix_invert_general_sse (CoglMatrix *matrix)
+{
+  const float *src = (const float *) matrix;
+  float *out = matrix->inv;
+  __m128 minor0, minor1, minor2, minor3;
+  __m128 row0, row1, row2, row3;
+  __m128 det, tmp1;
+  float det_value;
+
+  /* load the matrix transposed into row0-3, with the two halves of
+   * rows 1 and 3 swapped */
+  tmp1 = _mm_setzero_ps ();
+  row1 = _mm_setzero_ps ();
+  row3 = _mm_setzero_ps ();
+
+  tmp1 = _mm_loadh_pi (_mm_loadl_pi (tmp1, (const __m64 *) src),
+                       (const __m64 *) (src + 4));
+  row1 = _mm_loadh_pi (_mm_loadl_pi (row1, (const __m64 *) (src + 8)),
+                       (const __m64 *) (src + 12));
+  row0 = _mm_shuffle_ps (tmp1, row1, 0x88);
+  row1 = _mm_shuffle_ps (row1, tmp1, 0xdd);
+  tmp1 = _mm_loadh_pi (_mm_loadl_pi (tmp1, (const __m64 *) (src + 2)),
+                       (const __m64 *) (src + 6));
+  row3 = _mm_loadh_pi (_mm_loadl_pi (row3, (const __m64 *) (src + 10)),
+                       (const __m64 *) (src + 14));
+  row2 = _mm_shuffle_ps (tmp1, row3, 0x88);
+  row3 = _mm_shuffle_ps (row3, tmp1, 0xdd);
+
+  /* compute the cofactors */
+  tmp1 = _mm_mul_ps (row2, row3);
+  tmp1 = _mm_shuffle_ps (tmp1, tmp1, 0xb1);
+  minor0 = _mm_mul_ps (row1, tmp1);
+  minor1 = _mm_mul_ps (row0, tmp1);
+  tmp1 = _mm_shuffle_ps (tmp1, tmp1, 0x4e);
+  minor0 = _mm_sub_ps (_mm_mul_ps (row1, tmp1), minor0);
+  minor1 = _mm_sub_ps (_mm_mul_ps (row0, tmp1), minor1);
+  minor1 = _mm_shuffle_ps (minor1, minor1, 0x4e);
+
+  tmp1 = _mm_mul_ps (row1, row2);
+  tmp1 = _mm_shuffle_ps (tmp1, tmp1, 0xb1);
+  minor0 = _mm_add_ps (_mm_mul_ps (row3, tmp1), minor0);
+  minor3 = _mm_mul_ps (row0, tmp1);
+  tmp1 = _mm_shuffle_ps (tmp1, tmp1, 0x4e);
+  minor0 = _mm_sub_ps (minor0, _mm_mul_ps (row3, tmp1));
+  minor3 = _mm_sub_ps (_mm_mul_ps (row0, tmp1), minor3);
+  minor3 = _mm_shuffle_ps (minor3, minor3, 0x4e);
+
+  tmp1 = _mm_mul_ps (_mm_shuffle_ps (row1, row1, 0x4e), row3);
+  tmp1 = _mm_shuffle_ps (tmp1, tmp1, 0xb1);
+  row2 = _mm_shuffle_ps (row2, row2, 0x4e);
+  minor0 = _mm_add_ps (_mm_mul_ps (row2, tmp1), minor0);
+  minor2 = _mm_mul_ps (row0, tmp1);
+  tmp1 = _mm_shuffle_ps (tmp1, tmp1, 0x4e);
+  minor0 = _mm_sub_ps (minor0, _mm_mul_ps (row2, tmp1));
+  minor2 = _mm_sub_ps (_mm_mul_ps (row0, tmp1), minor2);
+  minor2 = _mm_shuffle_ps (minor2, minor2, 0x4e);
+
+  tmp1 = _mm_mul_ps (row0, row1);
+  tmp1 = _mm_shuffle_ps (tmp1, tmp1, 0xb1);
+  minor2 = _mm_add_ps (_mm_mul_ps (row3, tmp1), minor2);
+  minor3 = _mm_sub_ps (_mm_mul_ps (row2, tmp1), minor3);
+  tmp1 = _mm_shuffle_ps (tmp1, tmp1, 0x4e);
+  minor2 = _mm_sub_ps (_mm_mul_ps (row3, tmp1), minor2);
+  minor3 = _mm_sub_ps (minor3, _mm_mul_ps (row2, tmp1));
+
+  tmp1 = _mm_mul_ps (row0, row3);
+  tmp1 = _mm_shuffle_ps (tmp1, tmp1, 0xb1);
+  minor1 = _mm_sub_ps (minor1, _mm_mul_ps (row2, tmp1));
+  minor2 = _mm_add_ps (_mm_mul_ps (row1, tmp1), minor2);
+  tmp1 = _mm_shuffle_ps (tmp1, tmp1, 0x4e);
+  minor1 = _mm_add_ps (_mm_mul_ps (row2, tmp1), minor1);
+  minor2 = _mm_sub_ps (minor2, _mm_mul_ps (row1, tmp1));
+
+  tmp1 = _mm_mul_ps (row0, row2);
+  tmp1 = _mm_shuffle_ps (tmp1, tmp1, 0xb1);
+  minor1 = _mm_add_ps (_mm_mul_ps (row3, tmp1), minor1);
+  minor3 = _mm_sub_ps (minor3, _mm_mul_ps (row1, tmp1));
+  tmp1 = _mm_shuffle_ps (tmp1, tmp1, 0x4e);
+  minor1 = _mm_sub_ps (minor1, _mm_mul_ps (row3, tmp1));
+  minor3 = _mm_add_ps (_mm_mul_ps (row1, tmp1), minor3);
+
+  /* the determinant is the dot product of the first row and its
+   * cofactors */
+  det = _mm_mul_ps (row0, minor0);
+  det = _mm_add_ps (_mm_shuffle_ps (det, det, 0x4e), det);
+  det = _mm_add_ss (_mm_shuffle_ps (det, det, 0xb1), det);
+  _mm_store_ss (&det_value, det);
+
+  if (det_value == 0.0f)
+    return FALSE;
+
+  /* the approximate reciprocal instruction is not precise enough for
+   * picking so do a real division */
+  det = _mm_set1_ps (1.0f / det_value);
+
+  _mm_storeu_ps (out, _mm_mul_ps (det, minor0));
+  _mm_storeu_ps (out + 4, _mm_mul_ps (det, minor1));
+  _mm_storeu_ps (out + 8, _mm_mul_ps (det, minor2));
+  _mm_storeu_ps (out + 12, _mm_mul_ps (det, minor3));
+
+  return TRUE;
+}
+
+/* Stores the first three components of v. Only 12 bytes are written
+ * so that transforming the points in place with tightly packed points
+ * doesn't overwrite the next input point */
+static inline COGL_SSE_FUNC void
+store_f3 (float *o, __m128 v)
+{
+  _mm_storel_pi ((__m64 *) o, v);
+  _mm_store_ss (o + 2, _mm_movehl_ps (v, v));
+}
+
+#define POINT_IN(i) \
+  ((const float *) ((const guint8 *) points_in + (i) * stride_in))
+#define POINT_OUT(i) \
+  ((float *) ((guint8 *) points_out + (i) * stride_out))
+
+static COGL_SSE_FUNC void
+_cogl_matrix_transform_points_f2_sse (const CoglMatrix *matrix,
+                                      size_t stride_in,
+                                      const void *points_in,
+                                      size_t stride_out,
+                                      void *points_out,
+                                      int n_points)
+{
+  const __m128 c0 = _mm_loadu_ps (&matrix->xx);
+  const __m128 c1 = _mm_loadu_ps (&matrix->xy);
+  const __m128 c3 = _mm_loadu_ps (&matrix->xw);
+  int i;
+
+  for (i = 0; i < n_points; i++)
+    {
+      const float *p = POINT_IN (i);
+      __m128 r;
+
+      r = _mm_mul_ps (c0, _mm_set1_ps (p[0]));
+      r = _mm_add_ps (r, _mm_mul_ps (c1, _mm_set1_ps (p[1])));
+      r = _mm_add_ps (r, c3);
+
+      store_f3 (POINT_OUT (i), r);
+    }
+}
+
+static COGL_SSE_FUNC void
+_cogl_matrix_project_points_f2_sse (const CoglMatrix *matrix,
+                                    size_t stride_in,
+                                    const void *points_in,
+                                    size_t stride_out,
+                                    void *points_out,
+                                    int n_points)
+{
+  const __m128 c0 = _mm_loadu_ps (&matrix->xx);
+  const __m128 c1 = _mm_loadu_ps (&matrix->xy);
+  const __m128 c3 = _mm_loadu_ps (&matrix->xw);
+  int i;
+
+  for (i = 0; i < n_points; i++)
+    {
+      const float *p = POINT_IN (i);
+      __m128 r;
+
+      r = _mm_mul_ps (c0, _mm_set1_ps (p[0]));
+      r = _mm_add_ps (r, _mm_mul_ps (c1, _mm_set1_ps (p[1])));
+      r = _mm_add_ps (r, c3);
+
+      _mm_storeu_ps (POINT_OUT (i), r);
+    }
+}
+
+static COGL_SSE_FUNC void
+_cogl_matrix_transform_points_f3_sse (const CoglMatrix *matrix,
+                                      size_t stride_in,
+                                      const void *points_in,
+                                      size_t stride_out,
+                                      void *points_out,
+                                      int n_points)
+{
+  const __m128 c0 = _mm_loadu_ps (&matrix->xx);
+  const __m128 c1 = _mm_loadu_ps (&matrix->xy);
+  const __m128 c2 = _mm_loadu_ps (&matrix->xz);
+  const __m128 c3 = _mm_loadu_ps (&matrix->xw);
+  int i;
+
+  for (i = 0; i < n_points; i++)
+    {
+      const float *p = POINT_IN (i);
+      __m128 r;
+
+      r = _mm_mul_ps (c0, _mm_set1_ps (p[0]));
+      r = _mm_add_ps (r, _mm_mul_ps (c1, _mm_set1_ps (p[1])));
+      r = _mm_add_ps (r, _mm_mul_ps (c2, _mm_set1_ps (p[2])));
+      r = _mm_add_ps (r, c3);
+
+      store_f3 (POINT_OUT (i), r);
+    }
+}
+
+static COGL_SSE_FUNC void
+_cogl_matrix_project_points_f3_sse (const CoglMatrix *matrix,
+                                    size_t stride_in,
+                                    const void *points_in,
+                                    size_t stride_out,
+                                    void *points_out,
+                                    int n_points)
+{
+  const __m128 c0 = _mm_loadu_ps (&matrix->xx);
+  const __m128 c1 = _mm_loadu_ps (&matrix->xy);
+  const __m128 c2 = _mm_loadu_ps (&matrix->xz);
+  const __m128 c3 = _mm_loadu_ps (&matrix->xw);
+  int i;
+
+  for (i = 0; i < n_points; i++)
+    {
+      const float *p = POINT_IN (i);
+      __m128 r;
+
+      r = _mm_mul_ps (c0, _mm_set1_ps (p[0]));
+      r = _mm_add_ps (r, _mm_mul_ps (c1, _mm_set1_ps (p[1])));
+      r = _mm_add_ps (r, _mm_mul_ps (c2, _mm_set1_ps (p[2])));
+      r = _mm_add_ps (r, c3);
+
+      _mm_storeu_ps (POINT_OUT (i), r);
+    }
+}
+
+static COGL_SSE_FUNC void
+_cogl_matrix_project_points_f4_sse (const CoglMatrix *matrix,
+                                    size_t stride_in,
+                                    const void *points_in,
+                                    size_t stride_out,
+                                    void *points_out,
+                                    int n_points)
+{
+  const __m128 c0 = _mm_loadu_ps (&matrix->xx);
+  const __m128 c1 = _mm_loadu_ps (&matrix->xy);
+  const __m128 c2 = _mm_loadu_ps (&matrix->xz);
+  const __m128 c3 = _mm_loadu_ps (&matrix->xw);
+  int i;
+
+  for (i = 0; i < n_points; i++)
+    {
+      const float *p = POINT_IN (i);
+      __m128 r;
+
+      r = _mm_mul_ps (c0, _mm_set1_ps (p[0]));
+      r = _mm_add_ps (r, _mm_mul_ps (c1, _mm_set1_ps (p[1])));
+      r = _mm_add_ps (r, _mm_mul_ps (c2, _mm_set1_ps (p[2])));
+      r = _mm_add_ps (r, _mm_mul_ps (c3, _mm_set1_ps (p[3])));
+
+      _mm_storeu_ps (POINT_OUT (i), r);
+    }
+}
+
+#undef POINT_IN
+#undef POINT_OUT
+
+static const CoglMatrixFuncs
+_cogl_matrix_sse_funcs =
+  {
+    "SSE",
+    _cogl_matrix_multiply4x4_sse,
+    _cogl_matrix_multiply3x4_sse,
+    _cogl_matrix_invert_general_sse,
+    _cogl_matrix_transform_points_f2_sse,
+    _cogl_matrix_transform_points_f3_sse,
+    _cogl_matrix_project_points_f2_sse,
+    _cogl_matrix_project_points_f3_sse,
+    _cogl_matrix_project_points_f4_sse
+  };
+
+static gboolean
+_cogl_matrix_cpu_has_sse (void)
+{
+#ifdef __x86_64
+  /* SSE is part of the base x86-64 instruction set */
+  return TRUE;
+#else
+  unsigned int eax, ebx, ecx, edx;
+
+  if (!__get_cpuid (1, &eax, &ebx, &ecx, &edx))
+    return FALSE;
+
+  return (edx & bit_SSE) != 0;
+#endif
+}
+
+#endif /* COGL_USE_MATRIX_SSE */
+
+const CoglMatrixFuncs *
+_cogl_matrix_get_simd_funcs (void)
+{
+#ifdef COGL_USE_MATRIX_SSE
+  if (_cogl_matrix_cpu_has_sse ())
+    return &_cogl_matrix_sse_funcs;
+#endif
+
+  return NULL;
+}
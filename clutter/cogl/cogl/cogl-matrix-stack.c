@@ -36,30 +36,33 @@
 #include "cogl-framebuffer-private.h"
 #include "cogl-object-private.h"
 
-typedef struct {
-  CoglMatrix matrix;
-  gboolean is_identity;
-  /* count of pushes with no changes; when a change is
-   * requested, we create a new state and decrement this
-   */
-  int push_count;
-} CoglMatrixState;
-
 /**
  * CoglMatrixStack:
  *
  * Stores a cogl-side matrix stack, which we use as a cache
  * so we can get the matrix efficiently when using indirect
  * rendering.
+ *
+ * Each state of the matrix is stored in a refcounted #CoglMatrixEntry
+ * so that other components, such as the journal, can keep a reference
+ * to a state instead of copying the matrix. Pushing the stack only
+ * takes a reference on the top entry and an entry is never modified
+ * once anything else has a reference to it, so two entries with the
+ * same address always contain the same matrix.
  */
 struct _CoglMatrixStack
 {
   CoglObject _parent;
 
-  GArray *stack;
+  CoglMatrixEntry *top;
 
-  /* which state does GL have, NULL if unknown */
-  CoglMatrixState *flushed_state;
+  /* the entries to restore when popping the stack; each one holds a
+   * reference */
+  GPtrArray *saved_entries;
+
+  /* which entry GL has, NULL if unknown. This holds a reference so
+   * that the address can't be reused by a different entry */
+  CoglMatrixEntry *flushed_entry;
   gboolean flushed_identity;
 
   unsigned int age;
@@ -69,66 +72,85 @@ static void _cogl_matrix_stack_free (CoglMatrixStack *stack);
 
 COGL_OBJECT_INTERNAL_DEFINE (MatrixStack, matrix_stack);
 
-/* XXX: this doesn't initialize the matrix! */
-static void
-_cogl_matrix_state_init (CoglMatrixState *state)
+CoglMatrixEntry *
+_cogl_matrix_entry_ref (CoglMatrixEntry *entry)
 {
-  state->push_count = 0;
-  state->is_identity = FALSE;
+  entry->ref_count++;
+
+  return entry;
 }
 
-static CoglMatrixState *
-_cogl_matrix_stack_top (CoglMatrixStack *stack)
+void
+_cogl_matrix_entry_unref (CoglMatrixEntry *entry)
 {
-  return &g_array_index (stack->stack, CoglMatrixState, stack->stack->len - 1);
+  if (--entry->ref_count == 0)
+    g_slice_free (CoglMatrixEntry, entry);
 }
 
-/* XXX:
- * Operations like scale, translate, rotate etc need to have an
- * initialized state->matrix to work with, so they will pass
- * initialize = TRUE.
+static CoglMatrixEntry *
+_cogl_matrix_entry_new_identity (void)
+{
+  CoglMatrixEntry *entry = g_slice_new (CoglMatrixEntry);
+
+  cogl_matrix_init_identity (&entry->matrix);
+  entry->is_identity = TRUE;
+  entry->ref_count = 1;
+
+  return entry;
+}
+
+static void
+_cogl_matrix_stack_set_flushed_entry (CoglMatrixStack *stack,
+                                      CoglMatrixEntry *entry)
+{
+  if (entry)
+    _cogl_matrix_entry_ref (entry);
+  if (stack->flushed_entry)
+    _cogl_matrix_entry_unref (stack->flushed_entry);
+  stack->flushed_entry = entry;
+}
+
+/* Returns an entry for the top of the stack that can be modified.
  *
- * _cogl_matrix_stack_load_identity and _cogl_matrix_stack_set on the
- * other hand don't so they will pass initialize = FALSE
+ * The top entry is modified in place if nothing but the stack
+ * references it, otherwise it is replaced by a new entry so that the
+ * matrix seen by the other references doesn't change.
  *
- * NB: Identity matrices are represented by setting
- * state->is_identity=TRUE in which case state->matrix will be
- * uninitialized.
+ * Operations like scale, translate, rotate etc need to have an
+ * initialized matrix to work with, so they will pass initialize =
+ * TRUE. _cogl_matrix_stack_set on the other hand doesn't so it will
+ * pass initialize = FALSE.
+ *
+ * The returned entry is always going to be modified so the flushed
+ * entry is forgotten.
  */
-static CoglMatrixState *
+static CoglMatrixEntry *
 _cogl_matrix_stack_top_mutable (CoglMatrixStack *stack,
                                 gboolean initialize)
 {
-  CoglMatrixState *state;
-  CoglMatrixState *new_top;
-
-  state = _cogl_matrix_stack_top (stack);
+  CoglMatrixEntry *top = stack->top;
+  CoglMatrixEntry *new_top;
 
-  if (state->push_count == 0)
-    {
-      if (state->is_identity && initialize)
-        cogl_matrix_init_identity (&state->matrix);
-      return state;
-    }
+  /* mark dirty */
+  _cogl_matrix_stack_set_flushed_entry (stack, NULL);
+  stack->age++;
 
-  state->push_count -= 1;
+  if (top->ref_count == 1)
+    return top;
 
-  g_array_set_size (stack->stack, stack->stack->len + 1);
-  new_top = &g_array_index (stack->stack, CoglMatrixState,
-                            stack->stack->len - 1);
-  _cogl_matrix_state_init (new_top);
+  new_top = g_slice_new (CoglMatrixEntry);
+  new_top->ref_count = 1;
+  new_top->is_identity = FALSE;
 
   if (initialize)
     {
-      if (state->is_identity)
-        cogl_matrix_init_identity (&new_top->matrix);
-      else
-        new_top->matrix = state->matrix;
-
-      if (stack->flushed_state == state)
-        stack->flushed_state = new_top;
+      new_top->matrix = top->matrix;
+      new_top->is_identity = top->is_identity;
     }
 
+  _cogl_matrix_entry_unref (top);
+  stack->top = new_top;
+
   return new_top;
 }
 
@@ -136,16 +158,11 @@ CoglMatrixStack*
 _cogl_matrix_stack_new (void)
 {
   CoglMatrixStack *stack;
-  CoglMatrixState *state;
 
   stack = g_slice_new0 (CoglMatrixStack);
 
-  stack->stack = g_array_sized_new (FALSE, FALSE,
-                                    sizeof (CoglMatrixState), 10);
-  g_array_set_size (stack->stack, 1);
-  state = &g_array_index (stack->stack, CoglMatrixState, 0);
-  _cogl_matrix_state_init (state);
-  state->is_identity = TRUE;
+  stack->top = _cogl_matrix_entry_new_identity ();
+  stack->saved_entries = g_ptr_array_sized_new (10);
 
   stack->age = 0;
 
@@ -155,74 +172,66 @@ _cogl_matrix_stack_new (void)
 static void
 _cogl_matrix_stack_free (CoglMatrixStack *stack)
 {
-  g_array_free (stack->stack, TRUE);
+  int i;
+
+  for (i = 0; i < stack->saved_entries->len; i++)
+    _cogl_matrix_entry_unref (g_ptr_array_index (stack->saved_entries, i));
+  g_ptr_array_free (stack->saved_entries, TRUE);
+
+  _cogl_matrix_stack_set_flushed_entry (stack, NULL);
+  _cogl_matrix_entry_unref (stack->top);
+
   g_slice_free (CoglMatrixStack, stack);
 }
 
 void
 _cogl_matrix_stack_push (CoglMatrixStack *stack)
 {
-  CoglMatrixState *state;
-
-  state = _cogl_matrix_stack_top (stack);
-
-  /* we lazily create a new stack top if someone changes the matrix
-   * while push_count > 0
+  /* the top entry is now shared so a new entry will be lazily
+   * created if someone changes the matrix before popping
    */
-  state->push_count += 1;
+  g_ptr_array_add (stack->saved_entries,
+                   _cogl_matrix_entry_ref (stack->top));
 }
 
 void
 _cogl_matrix_stack_pop (CoglMatrixStack *stack)
 {
-  CoglMatrixState *state;
-
-  state = _cogl_matrix_stack_top (stack);
+  CoglMatrixEntry *saved;
 
-  if (state->push_count > 0)
+  if (stack->saved_entries->len == 0)
     {
-      state->push_count -= 1;
+      g_warning ("Too many matrix pops");
+      return;
     }
-  else
-    {
-      if (stack->stack->len == 1)
-        {
-          g_warning ("Too many matrix pops");
-          return;
-        }
 
-      if (stack->flushed_state == state)
-        {
-          stack->flushed_state = NULL;
-        }
+  saved = g_ptr_array_index (stack->saved_entries,
+                             stack->saved_entries->len - 1);
+  g_ptr_array_set_size (stack->saved_entries,
+                        stack->saved_entries->len - 1);
 
-      stack->age++;
-      g_array_set_size (stack->stack, stack->stack->len - 1);
-    }
+  /* the reference held by the saved entries is transferred to the
+   * top of the stack */
+  if (saved != stack->top)
+    stack->age++;
+
+  _cogl_matrix_entry_unref (stack->top);
+  stack->top = saved;
 }
 
 void
 _cogl_matrix_stack_load_identity (CoglMatrixStack *stack)
 {
-  CoglMatrixState *state;
+  CoglMatrixEntry *entry;
 
-  state = _cogl_matrix_stack_top_mutable (stack, FALSE);
-
-  /* NB: Identity matrices are represented by setting
-   * state->is_identity = TRUE and leaving state->matrix
-   * uninitialized.
-   *
-   * This is done to optimize the heavy usage of
-   * _cogl_matrix_stack_load_identity by the Cogl Journal.
-   */
-  if (!state->is_identity)
-    {
-      state->is_identity = TRUE;
+  /* This is heavily used by the Cogl Journal so it avoids doing
+   * anything if the matrix is already known to be the identity */
+  if (stack->top->is_identity)
+    return;
 
-      /* mark dirty */
-      stack->flushed_state = NULL;
-      stack->age++;
-    }
+  entry = _cogl_matrix_stack_top_mutable (stack, FALSE);
+  cogl_matrix_init_identity (&entry->matrix);
+  entry->is_identity = TRUE;
 }
 
 void
@@ -231,14 +240,11 @@ _cogl_matrix_stack_scale (CoglMatrixStack *stack,
                           float            y,
                           float            z)
 {
-  CoglMatrixState *state;
+  CoglMatrixEntry *entry;
 
-  state = _cogl_matrix_stack_top_mutable (stack, TRUE);
-  cogl_matrix_scale (&state->matrix, x, y, z);
-  /* mark dirty */
-  stack->flushed_state = NULL;
-  state->is_identity = FALSE;
-  stack->age++;
+  entry = _cogl_matrix_stack_top_mutable (stack, TRUE);
+  cogl_matrix_scale (&entry->matrix, x, y, z);
+  entry->is_identity = FALSE;
 }
 
 void
@@ -247,14 +253,11 @@ _cogl_matrix_stack_translate (CoglMatrixStack *stack,
                               float            y,
                               float            z)
 {
-  CoglMatrixState *state;
+  CoglMatrixEntry *entry;
 
-  state = _cogl_matrix_stack_top_mutable (stack, TRUE);
-  cogl_matrix_translate (&state->matrix, x, y, z);
-  /* mark dirty */
-  stack->flushed_state = NULL;
-  state->is_identity = FALSE;
-  stack->age++;
+  entry = _cogl_matrix_stack_top_mutable (stack, TRUE);
+  cogl_matrix_translate (&entry->matrix, x, y, z);
+  entry->is_identity = FALSE;
 }
 
 void
@@ -264,28 +267,22 @@ _cogl_matrix_stack_rotate (CoglMatrixStack *stack,
                            float            y,
                            float            z)
 {
-  CoglMatrixState *state;
+  CoglMatrixEntry *entry;
 
-  state = _cogl_matrix_stack_top_mutable (stack, TRUE);
-  cogl_matrix_rotate (&state->matrix, angle, x, y, z);
-  /* mark dirty */
-  stack->flushed_state = NULL;
-  state->is_identity = FALSE;
-  stack->age++;
+  entry = _cogl_matrix_stack_top_mutable (stack, TRUE);
+  cogl_matrix_rotate (&entry->matrix, angle, x, y, z);
+  entry->is_identity = FALSE;
 }
 
 void
 _cogl_matrix_stack_multiply (CoglMatrixStack  *stack,
                              const CoglMatrix *matrix)
 {
-  CoglMatrixState *state;
+  CoglMatrixEntry *entry;
 
-  state = _cogl_matrix_stack_top_mutable (stack, TRUE);
-  cogl_matrix_multiply (&state->matrix, &state->matrix, matrix);
-  /* mark dirty */
-  stack->flushed_state = NULL;
-  state->is_identity = FALSE;
-  stack->age++;
+  entry = _cogl_matrix_stack_top_mutable (stack, TRUE);
+  cogl_matrix_multiply (&entry->matrix, &entry->matrix, matrix);
+  entry->is_identity = FALSE;
 }
 
 void
@@ -297,16 +294,13 @@ _cogl_matrix_stack_frustum (CoglMatrixStack *stack,
                             float            z_near,
                             float            z_far)
 {
-  CoglMatrixState *state;
+  CoglMatrixEntry *entry;
 
-  state = _cogl_matrix_stack_top_mutable (stack, TRUE);
-  cogl_matrix_frustum (&state->matrix,
+  entry = _cogl_matrix_stack_top_mutable (stack, TRUE);
+  cogl_matrix_frustum (&entry->matrix,
                        left, right, bottom, top,
                        z_near, z_far);
-  /* mark dirty */
-  stack->flushed_state = NULL;
-  state->is_identity = FALSE;
-  stack->age++;
+  entry->is_identity = FALSE;
 }
 
 void
@@ -316,15 +310,12 @@ _cogl_matrix_stack_perspective (CoglMatrixStack *stack,
                                 float            z_near,
                                 float            z_far)
 {
-  CoglMatrixState *state;
+  CoglMatrixEntry *entry;
 
-  state = _cogl_matrix_stack_top_mutable (stack, TRUE);
-  cogl_matrix_perspective (&state->matrix,
+  entry = _cogl_matrix_stack_top_mutable (stack, TRUE);
+  cogl_matrix_perspective (&entry->matrix,
                            fov_y, aspect, z_near, z_far);
-  /* mark dirty */
-  stack->flushed_state = NULL;
-  state->is_identity = FALSE;
-  stack->age++;
+  entry->is_identity = FALSE;
 }
 
 void
@@ -336,60 +327,61 @@ _cogl_matrix_stack_ortho (CoglMatrixStack *stack,
                           float            z_near,
                           float            z_far)
 {
-  CoglMatrixState *state;
+  CoglMatrixEntry *entry;
 
-  state = _cogl_matrix_stack_top_mutable (stack, TRUE);
-  cogl_matrix_ortho (&state->matrix,
+  entry = _cogl_matrix_stack_top_mutable (stack, TRUE);
+  cogl_matrix_ortho (&entry->matrix,
                      left, right, bottom, top, z_near, z_far);
-  /* mark dirty */
-  stack->flushed_state = NULL;
-  state->is_identity = FALSE;
-  stack->age++;
+  entry->is_identity = FALSE;
 }
 
 gboolean
 _cogl_matrix_stack_get_inverse (CoglMatrixStack *stack,
                                 CoglMatrix      *inverse)
 {
-  CoglMatrixState *state;
-
-  state = _cogl_matrix_stack_top_mutable (stack, TRUE);
-
-  return cogl_matrix_get_inverse (&state->matrix, inverse);
+  /* NB: this caches the inverse in the top entry, which is fine even
+   * if the entry is shared because the matrix itself doesn't
+   * change */
+  return cogl_matrix_get_inverse (&stack->top->matrix, inverse);
 }
 
 void
 _cogl_matrix_stack_get (CoglMatrixStack *stack,
                         CoglMatrix      *matrix)
 {
-  CoglMatrixState *state;
-
-  state = _cogl_matrix_stack_top (stack);
-
-  /* NB: identity matrices are lazily initialized because we can often avoid
-   * initializing them at all if nothing is pushed on top of them since we
-   * load them using glLoadIdentity()
-   *
-   * The Cogl journal typically loads an identiy matrix because it performs
-   * software transformations, which is why we have optimized this case.
-   */
-  if (state->is_identity)
-    cogl_matrix_init_identity (matrix);
-  else
-    *matrix = state->matrix;
+  *matrix = stack->top->matrix;
 }
 
 void
 _cogl_matrix_stack_set (CoglMatrixStack  *stack,
                         const CoglMatrix *matrix)
 {
-  CoglMatrixState *state;
+  CoglMatrixEntry *entry;
 
-  state = _cogl_matrix_stack_top_mutable (stack, FALSE);
-  state->matrix = *matrix;
-  /* mark dirty */
-  stack->flushed_state = NULL;
-  state->is_identity = FALSE;
+  entry = _cogl_matrix_stack_top_mutable (stack, FALSE);
+  entry->matrix = *matrix;
+  entry->is_identity = FALSE;
+}
+
+CoglMatrixEntry *
+_cogl_matrix_stack_get_entry (CoglMatrixStack *stack)
+{
+  return stack->top;
+}
+
+void
+_cogl_matrix_stack_set_entry (CoglMatrixStack *stack,
+                              CoglMatrixEntry *entry)
+{
+  if (stack->top == entry)
+    return;
+
+  _cogl_matrix_entry_ref (entry);
+  _cogl_matrix_entry_unref (stack->top);
+  stack->top = entry;
+
+  /* NB: the flushed entry is kept because if it's the same as the new
+   * entry then GL already has the right matrix */
   stack->age++;
 }
 
@@ -423,12 +415,10 @@ _cogl_matrix_stack_prepare_for_flush (CoglMatrixStack *stack,
                                       CoglMatrixStackFlushFunc callback,
                                       void *user_data)
 {
-  CoglMatrixState *state;
+  CoglMatrixEntry *entry = stack->top;
 
   _COGL_GET_CONTEXT (ctx, NO_RETVAL);
 
-  state = _cogl_matrix_stack_top (stack);
-
   /* Because Cogl defines texture coordinates to have a top left origin and
    * because offscreen framebuffers may be used for rendering to textures we
    * always render upside down to offscreen buffers.
@@ -437,29 +427,21 @@ _cogl_matrix_stack_prepare_for_flush (CoglMatrixStack *stack,
       cogl_is_offscreen (_cogl_get_draw_buffer ()))
     {
       CoglMatrix flipped_projection;
-      CoglMatrix *projection =
-        state->is_identity ? &ctx->identity_matrix : &state->matrix;
 
       cogl_matrix_multiply (&flipped_projection,
-                            &ctx->y_flip_matrix, projection);
+                            &ctx->y_flip_matrix, &entry->matrix);
       callback (FALSE, &flipped_projection, user_data);
     }
   else
-    callback (state->is_identity,
-              state->is_identity ? &ctx->identity_matrix : &state->matrix,
-              user_data);
+    callback (entry->is_identity, &entry->matrix, user_data);
 }
 
 void
 _cogl_matrix_stack_flush_to_gl (CoglMatrixStack *stack,
                                 CoglMatrixMode   mode)
 {
-  CoglMatrixState *state;
-
   _COGL_GET_CONTEXT (ctx, NO_RETVAL);
 
-  state = _cogl_matrix_stack_top (stack);
-
 #ifdef HAVE_COGL_GLES2
 
   /* Under GLES2 we need to flush the matrices differently because
@@ -494,7 +476,7 @@ _cogl_matrix_stack_flush_to_gl (CoglMatrixStack *stack,
 
 #else /* HAVE_COGL_GLES2 */
 
-  if (stack->flushed_state == state)
+  if (stack->flushed_entry == stack->top)
     return;
 
   if (ctx->flushed_matrix_mode != mode)
@@ -527,13 +509,13 @@ _cogl_matrix_stack_flush_to_gl (CoglMatrixStack *stack,
 
 #endif /* HAVE_COGL_GLES2 */
 
-  stack->flushed_state = state;
+  _cogl_matrix_stack_set_flushed_entry (stack, stack->top);
 }
 
 void
 _cogl_matrix_stack_dirty (CoglMatrixStack *stack)
 {
-  stack->flushed_state = NULL;
+  _cogl_matrix_stack_set_flushed_entry (stack, NULL);
   stack->flushed_identity = FALSE;
 }
 
@@ -546,5 +528,5 @@ _cogl_matrix_stack_get_age (CoglMatrixStack *stack)
 gboolean
 _cogl_matrix_stack_has_identity_flag (CoglMatrixStack *stack)
 {
-  return _cogl_matrix_stack_top (stack)->is_identity;
+  return stack->top->is_identity;
 }
@@ -33,6 +33,22 @@
 
 typedef struct _CoglMatrixStack CoglMatrixStack;
 
+/* A state of the matrix at the top of a matrix stack. Entries are
+ * refcounted so that they can be referenced instead of copying the
+ * matrix, and an entry doesn't change while anything other than the
+ * stack it was created for references it. This means two references
+ * to the same entry always have the same matrix and can be compared
+ * without looking at the matrix. */
+typedef struct _CoglMatrixEntry
+{
+  CoglMatrix matrix;
+  /* If this is TRUE then the matrix is definitely the identity
+     matrix */
+  gboolean is_identity;
+
+  unsigned int ref_count;
+} CoglMatrixEntry;
+
 typedef enum {
   COGL_MATRIX_MODELVIEW,
   COGL_MATRIX_PROJECTION,
@@ -105,6 +121,24 @@ _cogl_matrix_stack_get (CoglMatrixStack *stack,
 void
 _cogl_matrix_stack_set (CoglMatrixStack *stack,
                         const CoglMatrix *matrix);
+
+/* Returns the entry at the top of the stack. No reference is taken
+   so _cogl_matrix_entry_ref() must be used to keep it. */
+CoglMatrixEntry *
+_cogl_matrix_stack_get_entry (CoglMatrixStack *stack);
+
+/* Replaces the top of the stack with an entry previously returned by
+   _cogl_matrix_stack_get_entry(), possibly for a different stack. */
+void
+_cogl_matrix_stack_set_entry (CoglMatrixStack *stack,
+                              CoglMatrixEntry *entry);
+
+CoglMatrixEntry *
+_cogl_matrix_entry_ref (CoglMatrixEntry *entry);
+
+void
+_cogl_matrix_entry_unref (CoglMatrixEntry *entry);
+
 void
 _cogl_matrix_stack_flush_to_gl (CoglMatrixStack *stack,
                                 CoglMatrixMode mode);
@@ -614,6 +614,38 @@ _cogl_matrix_project_points_f4 (const CoglMatrix *matrix,
     }
 }
 
+static const CoglMatrixFuncs
+_cogl_matrix_c_funcs =
+  {
+    "C",
+    _math_matrix_multiply4x4,
+    _math_matrix_multiply3x4,
+    _math_matrix_invert_general,
+    _cogl_matrix_transform_points_f2,
+    _cogl_matrix_transform_points_f3,
+    _cogl_matrix_project_points_f2,
+    _cogl_matrix_project_points_f3,
+    _cogl_matrix_project_points_f4
+  };
+
+const CoglMatrixFuncs *_cogl_matrix_funcs = &_cogl_matrix_c_funcs;
+
+/* Called when the context is created to pick the fastest
+ * implementation of the matrix functions for this CPU */
+void
+_cogl_matrix_init_funcs (void)
+{
+  const CoglMatrixFuncs *simd_funcs = _cogl_matrix_get_simd_funcs ();
+
+  if (simd_funcs && !COGL_DEBUG_ENABLED (COGL_DEBUG_DISABLE_SIMD))
+    _cogl_matrix_funcs = simd_funcs;
+  else
+    _cogl_matrix_funcs = &_cogl_matrix_c_funcs;
+
+  COGL_NOTE (MATRICES, "Using the %s matrix functions",
+             _cogl_matrix_funcs->name);
+}
+
 void
 cogl_matrix_transform_points (const CoglMatrix *matrix,
                               int n_components,
@@ -627,18 +659,18 @@ cogl_matrix_transform_points (const CoglMatrix *matrix,
   g_return_if_fail (stride_out >= sizeof (Point3f));
 
   if (n_components == 2)
-    _cogl_matrix_transform_points_f2 (matrix,
-                                      stride_in, points_in,
-                                      stride_out, points_out,
-                                      n_points);
+    _cogl_matrix_funcs->transform_points_f2 (matrix,
+                                             stride_in, points_in,
+                                             stride_out, points_out,
+                                             n_points);
   else
     {
       g_return_if_fail (n_components == 3);
 
-      _cogl_matrix_transform_points_f3 (matrix,
-                                        stride_in, points_in,
-                                        stride_out, points_out,
-                                        n_points);
+      _cogl_matrix_funcs->transform_points_f3 (matrix,
+                                               stride_in, points_in,
+                                               stride_out, points_out,
+                                               n_points);
     }
 }
 
@@ -652,22 +684,22 @@ cogl_matrix_project_points (const CoglMatrix *matrix,
                             int n_points)
 {
   if (n_components == 2)
-    _cogl_matrix_project_points_f2 (matrix,
-                                    stride_in, points_in,
-                                    stride_out, points_out,
-                                    n_points);
+    _cogl_matrix_funcs->project_points_f2 (matrix,
+                                           stride_in, points_in,
+                                           stride_out, points_out,
+                                           n_points);
   else if (n_components == 3)
-    _cogl_matrix_project_points_f3 (matrix,
-                                    stride_in, points_in,
-                                    stride_out, points_out,
-                                    n_points);
+    _cogl_matrix_funcs->project_points_f3 (matrix,
+                                           stride_in, points_in,
+                                           stride_out, points_out,
+                                           n_points);
   else
     {
       g_return_if_fail (n_components == 4);
 
-      _cogl_matrix_project_points_f4 (matrix,
-                                      stride_in, points_in,
-                                      stride_out, points_out,
-                                      n_points);
+      _cogl_matrix_funcs->project_points_f4 (matrix,
+                                             stride_in, points_in,
+                                             stride_out, points_out,
+                                             n_points);
     }
 }
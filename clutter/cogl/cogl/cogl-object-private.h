@@ -53,8 +53,48 @@ typedef struct _CoglObjectClass
 {
   GQuark   type;
   void    *virt_free;
+
+  /* Allocation statistics for the objects of this class. These are
+     logged after every frame with COGL_DEBUG=objects */
+  unsigned long instance_count;
+  unsigned long high_water_mark;
+  unsigned long frame_allocations;
+
+  /* The statistics as they were last logged, so that only the
+     classes whose statistics changed are logged again */
+  unsigned long logged_instance_count;
+  unsigned long logged_high_water_mark;
+  unsigned long logged_frame_allocations;
 } CoglObjectClass;
 
+/* A free list of blocks of a single size for the structures that are
+ * created and destroyed at a high rate, such as clip stack entries,
+ * pipeline copies and sub-textures. The blocks of destroyed
+ * structures are kept, up to max_free of them, and handed out again
+ * by the next allocation instead of going back to the allocator. */
+typedef struct _CoglObjectPool
+{
+  const char   *name;
+  size_t        size;
+  unsigned int  max_free;
+
+  /* The free blocks, each one linked to the next through its first
+     pointer */
+  void         *free_list;
+  unsigned int  n_free;
+
+  /* The number of allocations served from the free list since the
+     last frame, logged with COGL_DEBUG=objects */
+  unsigned long frame_recycled;
+
+  unsigned long logged_n_free;
+  unsigned long logged_frame_recycled;
+  gboolean      registered;
+} CoglObjectPool;
+
+#define COGL_OBJECT_POOL_INIT(Type, max_free) \
+  { G_STRINGIFY (Type), sizeof (Type), (max_free), NULL, 0, 0, 0, 0, FALSE }
+
 #define COGL_OBJECT_N_PRE_ALLOCATED_USER_DATA_ENTRIES 2
 
 typedef struct
@@ -158,8 +198,13 @@ _cogl_##type_name##_object_new (Cogl##TypeName *new_obj)        \
     {                                                           \
       obj->klass->type = _cogl_object_##type_name##_get_type ();\
       obj->klass->virt_free = _cogl_##type_name##_free;         \
+      _cogl_object_register_class (obj->klass);                 \
     }                                                           \
                                                                 \
+  if (++obj->klass->instance_count > obj->klass->high_water_mark) \
+    obj->klass->high_water_mark = obj->klass->instance_count;   \
+  obj->klass->frame_allocations++;                              \
+                                                                \
   _COGL_OBJECT_DEBUG_NEW (TypeName, obj);                       \
   return new_obj;                                               \
 }                                                               \
@@ -272,5 +317,17 @@ _cogl_object_set_user_data (CoglObject *object,
                             void *user_data,
                             CoglUserDataDestroyInternalCallback destroy);
 
+void
+_cogl_object_register_class (CoglObjectClass *klass);
+
+void *
+_cogl_object_pool_alloc (CoglObjectPool *pool);
+
+void
+_cogl_object_pool_free (CoglObjectPool *pool, void *block);
+
+void
+_cogl_object_log_stats (void);
+
 #endif /* __COGL_OBJECT_PRIVATE_H */
 
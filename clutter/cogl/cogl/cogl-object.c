@@ -33,6 +33,11 @@
 #include "cogl-types.h"
 #include "cogl-object-private.h"
 
+/* All the classes that have had an instance created and all the
+   pools that have been used, for logging the allocation statistics */
+static GSList *_cogl_object_classes = NULL;
+static GSList *_cogl_object_pools = NULL;
+
 void *
 cogl_object_ref (void *object)
 {
@@ -91,6 +96,7 @@ cogl_object_unref (void *object)
         }
 
       COGL_OBJECT_DEBUG_FREE (obj);
+      obj->klass->instance_count--;
       free_func = obj->klass->virt_free;
       free_func (obj);
     }
@@ -102,6 +108,116 @@ cogl_handle_unref (CoglHandle handle)
   cogl_object_unref (handle);
 }
 
+void
+_cogl_object_register_class (CoglObjectClass *klass)
+{
+  _cogl_object_classes = g_slist_prepend (_cogl_object_classes, klass);
+}
+
+void *
+_cogl_object_pool_alloc (CoglObjectPool *pool)
+{
+  void *block;
+
+  if (G_UNLIKELY (!pool->registered))
+    {
+      _cogl_object_pools = g_slist_prepend (_cogl_object_pools, pool);
+      pool->registered = TRUE;
+    }
+
+  if (pool->free_list)
+    {
+      block = pool->free_list;
+      pool->free_list = *(void **) block;
+      pool->n_free--;
+      pool->frame_recycled++;
+    }
+  else
+    block = g_slice_alloc (pool->size);
+
+  return block;
+}
+
+void
+_cogl_object_pool_free (CoglObjectPool *pool, void *block)
+{
+  if (pool->n_free < pool->max_free)
+    {
+      *(void **) block = pool->free_list;
+      pool->free_list = block;
+      pool->n_free++;
+    }
+  else
+    g_slice_free1 (pool->size, block);
+}
+
+/* This is called after every frame when COGL_DEBUG=objects is
+ * used. Only the classes and pools whose statistics changed since
+ * they were last logged are listed. */
+void
+_cogl_object_log_stats (void)
+{
+  gboolean header_logged = FALSE;
+  GSList *l;
+
+  for (l = _cogl_object_classes; l; l = l->next)
+    {
+      CoglObjectClass *klass = l->data;
+
+      if (klass->instance_count != klass->logged_instance_count ||
+          klass->high_water_mark != klass->logged_high_water_mark ||
+          klass->frame_allocations != klass->logged_frame_allocations)
+        {
+          if (!header_logged)
+            {
+              COGL_NOTE (OBJECTS, "%-28s %10s %10s %10s",
+                         "type", "live", "high-water", "allocated");
+              header_logged = TRUE;
+            }
+
+          COGL_NOTE (OBJECTS, "%-28s %10lu %10lu %10lu",
+                     g_quark_to_string (klass->type),
+                     klass->instance_count,
+                     klass->high_water_mark,
+                     klass->frame_allocations);
+
+          klass->logged_instance_count = klass->instance_count;
+          klass->logged_high_water_mark = klass->high_water_mark;
+          klass->logged_frame_allocations = klass->frame_allocations;
+        }
+
+      klass->frame_allocations = 0;
+    }
+
+  header_logged = FALSE;
+
+  for (l = _cogl_object_pools; l; l = l->next)
+    {
+      CoglObjectPool *pool = l->data;
+
+      if (pool->n_free != pool->logged_n_free ||
+          pool->frame_recycled != pool->logged_frame_recycled)
+        {
+          if (!header_logged)
+            {
+              COGL_NOTE (OBJECTS, "%-28s %10s %10s",
+                         "pool", "free", "recycled");
+              header_logged = TRUE;
+            }
+
+          COGL_NOTE (OBJECTS, "%-28s %10u %10lu",
+                     pool->name,
+                     pool->n_free,
+                     pool->frame_recycled);
+
+          pool->logged_n_free = pool->n_free;
+          pool->logged_frame_recycled = pool->frame_recycled;
+        }
+
+      pool->frame_recycled = 0;
+    }
+}
+
 GType
 cogl_handle_get_type (void)
 {
@@ -79,6 +79,11 @@ struct _CoglPathData
   floatVec2            path_nodes_min;
   floatVec2            path_nodes_max;
 
+  /* The tesselated geometry is cached until the path is modified and
+     is shared between all the copies of the path, including the ones
+     kept by the clip stack. If fill_vbo_indices is NULL then the path
+     is convex and fill_vbo_n_indices vertices can be drawn directly
+     as a triangle fan */
   CoglVertexArray     *fill_vbo;
   CoglIndices         *fill_vbo_indices;
   unsigned int         fill_vbo_n_indices;
@@ -427,12 +427,17 @@ _cogl_pipeline_revert_weak_ancestors (CoglPipeline *strong)
     }
 }
 
+/* Pipelines are copied for short lived changes, for example by the
+ * journal when it applies overrides, so their storage is recycled */
+static CoglObjectPool _cogl_pipeline_pool =
+  COGL_OBJECT_POOL_INIT (CoglPipeline, 64);
+
 /* XXX: Always have an eye out for opportunities to lower the cost of
  * cogl_pipeline_copy. */
 static CoglPipeline *
 _cogl_pipeline_copy (CoglPipeline *src, gboolean is_weak)
 {
-  CoglPipeline *pipeline = g_slice_new (CoglPipeline);
+  CoglPipeline *pipeline = _cogl_object_pool_alloc (&_cogl_pipeline_pool);
 
   _cogl_pipeline_node_init (COGL_PIPELINE_NODE (pipeline));
 
@@ -574,7 +579,7 @@ _cogl_pipeline_free (CoglPipeline *pipeline)
       g_list_free (pipeline->layer_differences);
     }
 
-  g_slice_free (CoglPipeline, pipeline);
+  _cogl_object_pool_free (&_cogl_pipeline_pool, pipeline);
 }
 
 gboolean
@@ -4906,10 +4911,14 @@ _cogl_pipeline_get_age (CoglPipeline *pipeline)
   return pipeline->age;
 }
 
+static CoglObjectPool _cogl_pipeline_layer_pool =
+  COGL_OBJECT_POOL_INIT (CoglPipelineLayer, 64);
+
 static CoglPipelineLayer *
 _cogl_pipeline_layer_copy (CoglPipelineLayer *src)
 {
-  CoglPipelineLayer *layer = g_slice_new (CoglPipelineLayer);
+  CoglPipelineLayer *layer =
+    _cogl_object_pool_alloc (&_cogl_pipeline_layer_pool);
 
   _cogl_pipeline_node_init (COGL_PIPELINE_NODE (layer));
 
@@ -4935,7 +4944,7 @@ _cogl_pipeline_layer_free (CoglPipelineLayer *layer)
   if (layer->differences & COGL_PIPELINE_LAYER_STATE_NEEDS_BIG_STATE)
     g_slice_free (CoglPipelineLayerBigState, layer->big_state);
 
-  g_slice_free (CoglPipelineLayer, layer);
+  _cogl_object_pool_free (&_cogl_pipeline_layer_pool, layer);
 }
 
   /* If a layer has descendants we can't modify it freely
@@ -41,6 +41,19 @@ struct _CoglPrimitive
   CoglIndices *indices;
   GArray *attributes;
 
+  /* The vertices of the instances drawn with
+     cogl_primitive_draw_instances(), kept so that the array can be
+     reused for the next call */
+  CoglVertexArray *instance_array;
+  CoglAttribute *instance_attributes[4];
+
+  /* The vertices of the primitive in the order they are drawn for
+     each instance. Reading them back from the buffers is expensive so
+     they are kept until the primitive changes */
+  CoglVertexP3T2C4 *instance_template;
+  int n_instance_template_vertices;
+  CoglVerticesMode instance_template_mode;
+
   int immutable_ref;
 };
 
@@ -33,8 +33,10 @@
 #include "cogl-primitive.h"
 #include "cogl-primitive-private.h"
 #include "cogl-attribute-private.h"
+#include "cogl-buffer-private.h"
 
 #include <stdarg.h>
+#include <string.h>
 
 static void _cogl_primitive_free (CoglPrimitive *primitive);
 
@@ -55,6 +57,9 @@ cogl_primitive_new_with_attributes_array (CoglVerticesMode mode,
   primitive->indices = NULL;
   primitive->attributes =
     g_array_new (TRUE, FALSE, sizeof (CoglAttribute *));
+  primitive->instance_array = NULL;
+  primitive->instance_attributes[0] = NULL;
+  primitive->instance_template = NULL;
   primitive->immutable_ref = 0;
 
   for (i = 0; attributes[i]; i++)
@@ -365,10 +370,37 @@ free_attributes_list (CoglPrimitive *primitive)
   g_array_set_size (primitive->attributes, 0);
 }
 
+static void
+free_instance_array (CoglPrimitive *primitive)
+{
+  int i;
+
+  for (i = 0; primitive->instance_attributes[i]; i++)
+    {
+      cogl_object_unref (primitive->instance_attributes[i]);
+      primitive->instance_attributes[i] = NULL;
+    }
+
+  if (primitive->instance_array)
+    {
+      cogl_object_unref (primitive->instance_array);
+      primitive->instance_array = NULL;
+    }
+}
+
+static void
+free_instance_template (CoglPrimitive *primitive)
+{
+  g_free (primitive->instance_template);
+  primitive->instance_template = NULL;
+}
+
 static void
 _cogl_primitive_free (CoglPrimitive *primitive)
 {
   free_attributes_list (primitive);
+  free_instance_array (primitive);
+  free_instance_template (primitive);
 
   g_array_free (primitive->attributes, TRUE);
 
@@ -402,6 +434,7 @@ cogl_primitive_set_attributes (CoglPrimitive *primitive,
     }
 
   free_attributes_list (primitive);
+  free_instance_template (primitive);
 
   g_array_set_size (primitive->attributes, 0);
   for (i = 0; attributes[i]; i++)
@@ -433,6 +466,7 @@ cogl_primitive_set_first_vertex (CoglPrimitive *primitive,
     }
 
   primitive->first_vertex = first_vertex;
+  free_instance_template (primitive);
 }
 
 int
@@ -450,6 +484,7 @@ cogl_primitive_set_n_vertices (CoglPrimitive *primitive,
   g_return_if_fail (cogl_is_primitive (primitive));
 
   primitive->n_vertices = n_vertices;
+  free_instance_template (primitive);
 }
 
 CoglVerticesMode
@@ -473,6 +508,7 @@ cogl_primitive_set_mode (CoglPrimitive *primitive,
     }
 
   primitive->mode = mode;
+  free_instance_template (primitive);
 }
 
 void
@@ -492,6 +528,8 @@ cogl_primitive_set_indices (CoglPrimitive *primitive,
   if (primitive->indices)
     cogl_object_unref (primitive->indices);
   primitive->indices = indices;
+
+  free_instance_template (primitive);
 }
 
 CoglPrimitive *
@@ -551,3 +589,419 @@ cogl_primitive_draw (CoglPrimitive *primitive)
                                 attributes);
 }
 
+
+/* The attributes of a primitive read by cogl_primitive_draw_instances */
+typedef struct
+{
+  CoglAttribute *position;
+  CoglAttribute *color;
+  CoglAttribute *tex_coord;
+} InstanceSource;
+
+static gboolean
+get_instance_source (CoglPrimitive *primitive,
+                     InstanceSource *source)
+{
+  int i;
+
+  memset (source, 0, sizeof (InstanceSource));
+
+  for (i = 0; i < primitive->attributes->len; i++)
+    {
+      CoglAttribute *attribute =
+        g_array_index (primitive->attributes, CoglAttribute *, i);
+
+      switch (attribute->name_id)
+        {
+        case COGL_ATTRIBUTE_NAME_ID_POSITION_ARRAY:
+          if (attribute->type != COGL_ATTRIBUTE_TYPE_FLOAT ||
+              attribute->n_components < 2 ||
+              attribute->n_components > 3)
+            return FALSE;
+          source->position = attribute;
+          break;
+
+        case COGL_ATTRIBUTE_NAME_ID_COLOR_ARRAY:
+          if (attribute->type != COGL_ATTRIBUTE_TYPE_UNSIGNED_BYTE ||
+              attribute->n_components != 4)
+            return FALSE;
+          source->color = attribute;
+          break;
+
+        case COGL_ATTRIBUTE_NAME_ID_TEXTURE_COORD_ARRAY:
+          if (attribute->type != COGL_ATTRIBUTE_TYPE_FLOAT ||
+              attribute->n_components != 2 ||
+              attribute->texture_unit != 0)
+            return FALSE;
+          source->tex_coord = attribute;
+          break;
+
+        default:
+          return FALSE;
+        }
+    }
+
+  return source->position != NULL;
+}
+
+static int
+get_vertex_index (CoglPrimitive *primitive,
+                  const void *indices,
+                  int position)
+{
+  position += primitive->first_vertex;
+
+  if (indices == NULL)
+    return position;
+
+  switch (cogl_indices_get_type (primitive->indices))
+    {
+    case COGL_INDICES_TYPE_UNSIGNED_BYTE:
+      return ((const guint8 *) indices)[position];
+    case COGL_INDICES_TYPE_UNSIGNED_SHORT:
+      return ((const guint16 *) indices)[position];
+    case COGL_INDICES_TYPE_UNSIGNED_INT:
+      return ((const guint32 *) indices)[position];
+    }
+
+  g_return_val_if_reached (0);
+}
+
+/* Instances can only be concatenated in a single draw call if the
+   primitive is drawn as separate points, lines or triangles, so this
+   converts the vertices of the primitive into such a list. Returns
+   the position of each vertex in the primitive */
+static int *
+get_instance_positions (CoglPrimitive *primitive,
+                        CoglVerticesMode *mode_out,
+                        int *n_positions_out)
+{
+  int n_vertices = primitive->n_vertices;
+  int *positions;
+  int n_positions = 0;
+  int i;
+
+  switch (primitive->mode)
+    {
+    case COGL_VERTICES_MODE_POINTS:
+    case COGL_VERTICES_MODE_LINES:
+    case COGL_VERTICES_MODE_TRIANGLES:
+      positions = g_new (int, n_vertices);
+      for (i = 0; i < n_vertices; i++)
+        positions[n_positions++] = i;
+      *mode_out = primitive->mode;
+      break;
+
+    case COGL_VERTICES_MODE_LINE_STRIP:
+    case COGL_VERTICES_MODE_LINE_LOOP:
+      positions = g_new (int, n_vertices * 2);
+      for (i = 0; i + 1 < n_vertices; i++)
+        {
+          positions[n_positions++] = i;
+          positions[n_positions++] = i + 1;
+        }
+      if (primitive->mode == COGL_VERTICES_MODE_LINE_LOOP && n_vertices > 2)
+        {
+          positions[n_positions++] = n_vertices - 1;
+          positions[n_positions++] = 0;
+        }
+      *mode_out = COGL_VERTICES_MODE_LINES;
+      break;
+
+    case COGL_VERTICES_MODE_TRIANGLE_STRIP:
+      positions = g_new (int, MAX (n_vertices - 2, 0) * 3);
+      for (i = 0; i + 2 < n_vertices; i++)
+        {
+          /* Every other triangle of a strip has the opposite
+             winding */
+          positions[n_positions++] = (i & 1) ? i + 1 : i;
+          positions[n_positions++] = (i & 1) ? i : i + 1;
+          positions[n_positions++] = i + 2;
+        }
+      *mode_out = COGL_VERTICES_MODE_TRIANGLES;
+      break;
+
+    case COGL_VERTICES_MODE_TRIANGLE_FAN:
+      positions = g_new (int, MAX (n_vertices - 2, 0) * 3);
+      for (i = 1; i + 1 < n_vertices; i++)
+        {
+          positions[n_positions++] = 0;
+          positions[n_positions++] = i;
+          positions[n_positions++] = i + 1;
+        }
+      *mode_out = COGL_VERTICES_MODE_TRIANGLES;
+      break;
+
+    default:
+      g_return_val_if_reached (NULL);
+    }
+
+  *n_positions_out = n_positions;
+
+  return positions;
+}
+
+/* Maps the array of @attribute for reading, unless it has already
+   been mapped for another attribute */
+static const guint8 *
+map_attribute (CoglAttribute *attribute,
+               CoglVertexArray **mapped_arrays,
+               int *n_mapped_arrays)
+{
+  CoglBuffer *buffer = COGL_BUFFER (attribute->array);
+  guint8 *data;
+  int i;
+
+  for (i = 0; i < *n_mapped_arrays; i++)
+    if (mapped_arrays[i] == attribute->array)
+      return (guint8 *) buffer->data + attribute->offset;
+
+  data = cogl_buffer_map (buffer, COGL_BUFFER_ACCESS_READ, 0);
+  if (data == NULL)
+    return NULL;
+
+  mapped_arrays[(*n_mapped_arrays)++] = attribute->array;
+
+  return data + attribute->offset;
+}
+
+/* Reads the vertices of the primitive, in the order they need to be
+   drawn for each instance */
+static CoglVertexP3T2C4 *
+get_instance_template (CoglPrimitive *primitive,
+                       CoglVerticesMode *mode_out,
+                       int *n_vertices_out)
+{
+  InstanceSource source;
+  CoglVertexArray *mapped_arrays[3];
+  int n_mapped_arrays = 0;
+  const guint8 *position_data, *color_data = NULL, *tex_coord_data = NULL;
+  const void *indices = NULL;
+  CoglVertexP3T2C4 *template = NULL;
+  int *positions = NULL;
+  int n_positions;
+  int i;
+
+  if (!get_instance_source (primitive, &source))
+    {
+      static gboolean seen = FALSE;
+      if (!seen)
+        {
+          g_warning ("Only primitives with a float position attribute, "
+                     "and optionally a color and a single texture "
+                     "coordinate attribute can be drawn as instances");
+          seen = TRUE;
+        }
+      return NULL;
+    }
+
+  position_data = map_attribute (source.position,
+                                 mapped_arrays, &n_mapped_arrays);
+  if (source.color)
+    color_data = map_attribute (source.color,
+                                mapped_arrays, &n_mapped_arrays);
+  if (source.tex_coord)
+    tex_coord_data = map_attribute (source.tex_coord,
+                                    mapped_arrays, &n_mapped_arrays);
+  if (primitive->indices)
+    {
+      CoglIndexArray *index_array = cogl_indices_get_array (primitive->indices);
+      indices = cogl_buffer_map (COGL_BUFFER (index_array),
+                                 COGL_BUFFER_ACCESS_READ, 0);
+      if (indices)
+        indices = ((const guint8 *) indices
+                   + cogl_indices_get_offset (primitive->indices));
+    }
+
+  if (position_data == NULL ||
+      (source.color && color_data == NULL) ||
+      (source.tex_coord && tex_coord_data == NULL) ||
+      (primitive->indices && indices == NULL))
+    {
+      g_warning ("Failed to read the vertices of a primitive drawn "
+                 "as instances");
+      goto done;
+    }
+
+  positions = get_instance_positions (primitive, mode_out, &n_positions);
+  if (positions == NULL)
+    goto done;
+
+  template = g_new (CoglVertexP3T2C4, n_positions);
+
+  for (i = 0; i < n_positions; i++)
+    {
+      CoglVertexP3T2C4 *v = template + i;
+      int vertex = get_vertex_index (primitive, indices, positions[i]);
+      const float *p = (const float *) (position_data +
+                                        vertex * source.position->stride);
+
+      v->x = p[0];
+      v->y = p[1];
+      v->z = source.position->n_components > 2 ? p[2] : 0.0f;
+
+      if (tex_coord_data)
+        {
+          const float *t = (const float *) (tex_coord_data +
+                                            vertex *
+                                            source.tex_coord->stride);
+          v->s = t[0];
+          v->t = t[1];
+        }
+      else
+        v->s = v->t = 0.0f;
+
+      if (color_data)
+        {
+          const guint8 *c = color_data + vertex * source.color->stride;
+          v->r = c[0];
+          v->g = c[1];
+          v->b = c[2];
+          v->a = c[3];
+        }
+      else
+        v->r = v->g = v->b = v->a = 0xff;
+    }
+
+  *n_vertices_out = n_positions;
+
+done:
+  g_free (positions);
+
+  for (i = 0; i < n_mapped_arrays; i++)
+    cogl_buffer_unmap (COGL_BUFFER (mapped_arrays[i]));
+  if (indices)
+    cogl_buffer_unmap (COGL_BUFFER (cogl_indices_get_array
+                                    (primitive->indices)));
+
+  return template;
+}
+
+static void
+ensure_instance_array (CoglPrimitive *primitive,
+                       gsize size)
+{
+  CoglVertexArray *array;
+
+  if (primitive->instance_array &&
+      cogl_buffer_get_size (COGL_BUFFER (primitive->instance_array)) >= size)
+    return;
+
+  free_instance_array (primitive);
+
+  /* Grow the array geometrically so that drawing a slowly growing
+     number of instances doesn't reallocate it every time */
+  size = MAX (size, sizeof (CoglVertexP3T2C4) * 256);
+  size = (gsize) 1 << g_bit_storage (size - 1);
+
+  array = cogl_vertex_array_new (size, NULL);
+  cogl_buffer_set_update_hint (COGL_BUFFER (array),
+                               COGL_BUFFER_UPDATE_HINT_STREAM);
+
+  primitive->instance_attributes[0] =
+    cogl_attribute_new (array,
+                        "cogl_position_in",
+                        sizeof (CoglVertexP3T2C4),
+                        offsetof (CoglVertexP3T2C4, x),
+                        3,
+                        COGL_ATTRIBUTE_TYPE_FLOAT);
+  primitive->instance_attributes[1] =
+    cogl_attribute_new (array,
+                        "cogl_tex_coord0_in",
+                        sizeof (CoglVertexP3T2C4),
+                        offsetof (CoglVertexP3T2C4, s),
+                        2,
+                        COGL_ATTRIBUTE_TYPE_FLOAT);
+  primitive->instance_attributes[2] =
+    cogl_attribute_new (array,
+                        "cogl_color_in",
+                        sizeof (CoglVertexP3T2C4),
+                        offsetof (CoglVertexP3T2C4, r),
+                        4,
+                        COGL_ATTRIBUTE_TYPE_UNSIGNED_BYTE);
+  primitive->instance_attributes[3] = NULL;
+
+  primitive->instance_array = array;
+}
+
+/* Instances are drawn by expanding them into a single vertex array on
+   the CPU, which is the only path for now. Hardware instancing would
+   need the GLSL vertend to apply the per-instance attributes in the
+   vertex shader it generates, the attributes to be flushed with a
+   divisor and a feature check for GL_ARB_instanced_arrays, none of
+   which exist yet; the expansion would also remain the fallback for
+   the fixed function vertend and for GLES 1. It is still much cheaper
+   than logging each instance in the journal or drawing it with a
+   separate draw call. */
+void
+cogl_primitive_draw_instances (CoglPrimitive *primitive,
+                               const CoglPrimitiveInstance *instances,
+                               int n_instances)
+{
+  CoglVerticesMode mode;
+  const CoglVertexP3T2C4 *template;
+  CoglVertexP3T2C4 *vout;
+  CoglBuffer *buffer;
+  int n_template_vertices;
+  int i, j;
+
+  g_return_if_fail (cogl_is_primitive (primitive));
+  g_return_if_fail (n_instances >= 0);
+  g_return_if_fail (n_instances == 0 || instances != NULL);
+
+  if (n_instances == 0 || primitive->n_vertices == 0)
+    return;
+
+  /* Mapping the buffers for reading waits for the GPU to finish
+     with them, so the template is only read once */
+  if (primitive->instance_template == NULL)
+    {
+      primitive->instance_template =
+        get_instance_template (primitive,
+                               &primitive->instance_template_mode,
+                               &primitive->n_instance_template_vertices);
+      if (primitive->instance_template == NULL)
+        return;
+    }
+
+  template = primitive->instance_template;
+  mode = primitive->instance_template_mode;
+  n_template_vertices = primitive->n_instance_template_vertices;
+
+  if (n_template_vertices == 0)
+    return;
+
+  ensure_instance_array (primitive,
+                         sizeof (CoglVertexP3T2C4) *
+                         n_template_vertices * n_instances);
+
+  buffer = COGL_BUFFER (primitive->instance_array);
+  vout = _cogl_buffer_map_for_fill_or_fallback (buffer);
+
+  for (i = 0; i < n_instances; i++)
+    {
+      const CoglPrimitiveInstance *instance = instances + i;
+
+      for (j = 0; j < n_template_vertices; j++, vout++)
+        {
+          const CoglVertexP3T2C4 *v = template + j;
+
+          vout->x = instance->xx * v->x + instance->xy * v->y + instance->x0;
+          vout->y = instance->yx * v->x + instance->yy * v->y + instance->y0;
+          vout->z = v->z;
+          vout->s = v->s + instance->s_offset;
+          vout->t = v->t + instance->t_offset;
+          vout->r = (v->r * instance->r + 127) / 255;
+          vout->g = (v->g * instance->g + 127) / 255;
+          vout->b = (v->b * instance->b + 127) / 255;
+          vout->a = (v->a * instance->a + 127) / 255;
+        }
+    }
+
+  _cogl_buffer_unmap_for_fill_or_fallback (buffer);
+
+  cogl_draw_attributes_array (mode,
+                              0,
+                              n_template_vertices * n_instances,
+                              primitive->instance_attributes);
+}
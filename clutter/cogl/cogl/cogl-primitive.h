@@ -653,6 +653,70 @@ cogl_primitive_set_indices (CoglPrimitive *primitive,
 void
 cogl_primitive_draw (CoglPrimitive *primitive);
 
+/**
+ * CoglPrimitiveInstance:
+ * @xx: The xx component of the affine transform of the instance
+ * @yx: The yx component of the affine transform of the instance
+ * @xy: The xy component of the affine transform of the instance
+ * @yy: The yy component of the affine transform of the instance
+ * @x0: The x translation of the instance
+ * @y0: The y translation of the instance
+ * @s_offset: The offset added to the s texture coordinates
+ * @t_offset: The offset added to the t texture coordinates
+ * @r: The red component of the color of the instance
+ * @g: The green component of the color of the instance
+ * @b: The blue component of the color of the instance
+ * @a: The alpha component of the color of the instance
+ *
+ * The per-instance attributes used by cogl_primitive_draw_instances().
+ * Each vertex (x, y) of the primitive is drawn at
+ * (xx * x + xy * y + x0, yx * x + yy * y + y0), and its color is
+ * multiplied by the color of the instance.
+ *
+ * Since: 1.8
+ * Stability: Unstable
+ */
+typedef struct
+{
+  float xx, yx;
+  float xy, yy;
+  float x0, y0;
+  float s_offset, t_offset;
+  guint8 r, g, b, a;
+} CoglPrimitiveInstance;
+
+/**
+ * cogl_primitive_draw_instances:
+ * @primitive: A #CoglPrimitive object
+ * @instances: (array length=n_instances): The attributes of each
+ *   instance
+ * @n_instances: The number of instances to draw
+ *
+ * Draws @n_instances copies of the given @primitive with the current
+ * source material, each one transformed, colored and with its texture
+ * coordinates offset according to the corresponding element of
+ * @instances. This is much cheaper than drawing the primitive once
+ * for each instance, for instance to draw many sprites.
+ *
+ * The instances are drawn in order, as a single batch. The primitive
+ * must only have a "cogl_position_in" attribute with 2 or 3 float
+ * components, and optionally a "cogl_color_in" attribute with 4
+ * unsigned byte components and a "cogl_tex_coord0_in" attribute with
+ * 2 float components.
+ *
+ * The vertices of @primitive are read back the first time it is drawn
+ * as instances and they are kept until its attributes, indices, mode,
+ * first vertex or number of vertices change. Modifying the contents
+ * of its buffers in the meantime doesn't affect the instances.
+ *
+ * Since: 1.8
+ * Stability: Unstable
+ */
+void
+cogl_primitive_draw_instances (CoglPrimitive *primitive,
+                               const CoglPrimitiveInstance *instances,
+                               int n_instances);
+
 /**
  * cogl_is_primitive:
  * @object: A #CoglObject
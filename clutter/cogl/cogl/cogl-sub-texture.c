@@ -235,14 +235,20 @@ _cogl_sub_texture_set_wrap_mode_parameters (CoglTexture *tex,
                                           wrap_mode_p);
 }
 
+/* Sub-textures are often created for a single draw so their storage
+   is recycled instead of being allocated with g_new */
+static CoglObjectPool _cogl_sub_texture_pool =
+  COGL_OBJECT_POOL_INIT (CoglSubTexture, 32);
+
 static void
 _cogl_sub_texture_free (CoglSubTexture *sub_tex)
 {
   cogl_handle_unref (sub_tex->next_texture);
   cogl_handle_unref (sub_tex->full_texture);
 
-  /* Chain up */
-  _cogl_texture_free (COGL_TEXTURE (sub_tex));
+  /* The storage comes from the pool so it isn't freed by chaining up
+     to _cogl_texture_free */
+  _cogl_object_pool_free (&_cogl_sub_texture_pool, sub_tex);
 }
 
 CoglHandle
@@ -264,7 +270,7 @@ _cogl_sub_texture_new (CoglHandle next_texture,
   g_return_val_if_fail (sub_x + sub_width <= next_width, COGL_INVALID_HANDLE);
   g_return_val_if_fail (sub_y + sub_height <= next_height, COGL_INVALID_HANDLE);
 
-  sub_tex = g_new (CoglSubTexture, 1);
+  sub_tex = _cogl_object_pool_alloc (&_cogl_sub_texture_pool);
 
   tex = COGL_TEXTURE (sub_tex);
 
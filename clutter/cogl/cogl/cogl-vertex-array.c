@@ -37,10 +37,16 @@ static void _cogl_vertex_array_free (CoglVertexArray *array);
 
 COGL_BUFFER_DEFINE (VertexArray, vertex_array);
 
+/* Vertex arrays are often created for a single draw, for example when
+   filling paths, so their storage is recycled */
+static CoglObjectPool _cogl_vertex_array_pool =
+  COGL_OBJECT_POOL_INIT (CoglVertexArray, 32);
+
 CoglVertexArray *
 cogl_vertex_array_new (gsize bytes, const void *data)
 {
-  CoglVertexArray *array = g_slice_new (CoglVertexArray);
+  CoglVertexArray *array =
+    _cogl_object_pool_alloc (&_cogl_vertex_array_pool);
   gboolean use_malloc;
 
   if (!cogl_features_available (COGL_FEATURE_VBOS))
@@ -72,6 +78,6 @@ _cogl_vertex_array_free (CoglVertexArray *array)
   /* parent's destructor */
   _cogl_buffer_fini (COGL_BUFFER (array));
 
-  g_slice_free (CoglVertexArray, array);
+  _cogl_object_pool_free (&_cogl_vertex_array_pool, array);
 }
 
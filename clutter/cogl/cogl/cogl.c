@@ -36,6 +36,7 @@
 #include "cogl-internal.h"
 #include "cogl-util.h"
 #include "cogl-context.h"
+#include "cogl-object-private.h"
 #include "cogl-pipeline-private.h"
 #include "cogl-pipeline-opengl-private.h"
 #include "cogl-winsys.h"
@@ -1119,4 +1120,7 @@ _cogl_swap_buffers_notify (void)
   _COGL_GET_CONTEXT (ctx, NO_RETVAL);
 
   _cogl_framebuffer_swap_notify (_cogl_get_draw_buffer ());
+
+  if (G_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_OBJECTS)))
+    _cogl_object_log_stats ();
 }
@@ -65,7 +65,8 @@ _cogl_path_data_clear_vbos (CoglPathData *data)
   if (data->fill_vbo)
     {
       cogl_object_unref (data->fill_vbo);
-      cogl_object_unref (data->fill_vbo_indices);
+      if (data->fill_vbo_indices)
+        cogl_object_unref (data->fill_vbo_indices);
 
       for (i = 0; i < COGL_PATH_N_ATTRIBUTES; i++)
         cogl_object_unref (data->fill_vbo_attributes[i]);
@@ -118,13 +119,15 @@ _cogl_path_modify (CoglPath *path)
                            old_data->path_nodes->data,
                            old_data->path_nodes->len);
 
+      /* The vbos belong to the old data */
       path->data->fill_vbo = COGL_INVALID_HANDLE;
+      path->data->stroke_vbo = NULL;
       path->data->ref_count = 1;
 
       _cogl_path_data_unref (old_data);
     }
-  /* The path is altered so the vbo will now be invalid */
-  else if (path->data->fill_vbo)
+  /* The path is altered so the vbos will now be invalid */
+  else
     _cogl_path_data_clear_vbos (path->data);
 }
 
@@ -343,7 +346,16 @@ _cogl_path_fill_nodes (CoglPath *path)
 
   _cogl_path_build_fill_vbo (path);
 
-  _cogl_draw_indexed_attributes_array
+  if (path->data->fill_vbo_indices == NULL)
+    _cogl_draw_attributes_array (COGL_VERTICES_MODE_TRIANGLE_FAN,
+                                 0, /* first_vertex */
+                                 path->data->fill_vbo_n_indices,
+                                 path->data->fill_vbo_attributes,
+                                 COGL_DRAW_SKIP_JOURNAL_FLUSH |
+                                 COGL_DRAW_SKIP_PIPELINE_VALIDATION |
+                                 COGL_DRAW_SKIP_FRAMEBUFFER_FLUSH);
+  else
+    _cogl_draw_indexed_attributes_array
                                  (COGL_VERTICES_MODE_TRIANGLES,
                                   0, /* first_vertex */
                                   path->data->fill_vbo_n_indices,
@@ -1388,12 +1400,93 @@ _cogl_path_tesselator_combine (double coords[3],
     }
 }
 
+/* Checks whether the path is a single convex contour. A triangle fan
+   then covers exactly the inside of the path whatever the fill rule,
+   so the tesselator isn't needed. This is the case for ellipses and
+   rounded rectangles which are commonly used for clipping. */
+static gboolean
+_cogl_path_is_convex (CoglPathData *data)
+{
+  CoglPathNode *nodes = (CoglPathNode *) data->path_nodes->data;
+  unsigned int n_nodes = data->path_nodes->len;
+  float prev_dx = 0.0f, prev_dy = 0.0f;
+  int turn_sign = 0;
+  int last_x_sign = 0, last_y_sign = 0;
+  int x_sign_changes = 0, y_sign_changes = 0;
+  unsigned int i;
+
+  if (n_nodes < 3 || nodes[0].path_size != n_nodes)
+    return FALSE;
+
+  /* Start with the last edge that isn't empty so that the turn into
+     the first edge is checked too */
+  for (i = n_nodes; i > 0; i--)
+    {
+      prev_dx = nodes[i % n_nodes].x - nodes[i - 1].x;
+      prev_dy = nodes[i % n_nodes].y - nodes[i - 1].y;
+      if (prev_dx != 0.0f || prev_dy != 0.0f)
+        break;
+    }
+
+  for (i = 0; i < n_nodes; i++)
+    {
+      const CoglPathNode *next = nodes + (i + 1) % n_nodes;
+      float dx = next->x - nodes[i].x;
+      float dy = next->y - nodes[i].y;
+      float cross;
+      int sign;
+
+      if (dx == 0.0f && dy == 0.0f)
+        continue;
+
+      /* All of the turns must be in the same direction */
+      cross = prev_dx * dy - prev_dy * dx;
+      if (cross != 0.0f)
+        {
+          sign = cross > 0.0f ? 1 : -1;
+          if (turn_sign == 0)
+            turn_sign = sign;
+          else if (sign != turn_sign)
+            return FALSE;
+        }
+      /* Going back along the previous edge */
+      else if (prev_dx * dx + prev_dy * dy < 0.0f)
+        return FALSE;
+
+      /* A contour that turns the same way but goes around more than
+         once, such as a star, changes direction along each axis more
+         than twice */
+      sign = dx > 0.0f ? 1 : dx < 0.0f ? -1 : 0;
+      if (sign != 0)
+        {
+          if (last_x_sign != 0 && sign != last_x_sign &&
+              ++x_sign_changes > 2)
+            return FALSE;
+          last_x_sign = sign;
+        }
+      sign = dy > 0.0f ? 1 : dy < 0.0f ? -1 : 0;
+      if (sign != 0)
+        {
+          if (last_y_sign != 0 && sign != last_y_sign &&
+              ++y_sign_changes > 2)
+            return FALSE;
+          last_y_sign = sign;
+        }
+
+      prev_dx = dx;
+      prev_dy = dy;
+    }
+
+  return TRUE;
+}
+
 static void
 _cogl_path_build_fill_vbo (CoglPath *path)
 {
   CoglPathTesselator tess;
   unsigned int path_start = 0;
   CoglPathData *data = path->data;
+  gboolean is_convex;
   int i;
 
   /* If we've already got a vbo then we don't need to do anything */
@@ -1430,55 +1523,67 @@ _cogl_path_build_fill_vbo (CoglPath *path)
                      / (data->path_nodes_max.y - data->path_nodes_min.y));
     }
 
-  tess.indices_type =
-    _cogl_path_tesselator_get_indices_type_for_size (data->path_nodes->len);
-  _cogl_path_tesselator_allocate_indices_array (&tess);
-
-  tess.glu_tess = gluNewTess ();
+  is_convex = _cogl_path_is_convex (data);
 
-  if (data->fill_rule == COGL_PATH_FILL_RULE_EVEN_ODD)
-    gluTessProperty (tess.glu_tess, GLU_TESS_WINDING_RULE,
-                     GLU_TESS_WINDING_ODD);
+  if (is_convex)
+    {
+      /* The nodes can be drawn directly as a triangle fan so there's
+         no need to run the tesselator or to have indices */
+      data->fill_vbo_indices = NULL;
+      data->fill_vbo_n_indices = tess.vertices->len;
+    }
   else
-    gluTessProperty (tess.glu_tess, GLU_TESS_WINDING_RULE,
-                     GLU_TESS_WINDING_NONZERO);
+    {
+      tess.indices_type =
+        _cogl_path_tesselator_get_indices_type_for_size (data->path_nodes->len);
+      _cogl_path_tesselator_allocate_indices_array (&tess);
 
-  /* All vertices are on the xy-plane */
-  gluTessNormal (tess.glu_tess, 0.0, 0.0, 1.0);
+      tess.glu_tess = gluNewTess ();
 
-  gluTessCallback (tess.glu_tess, GLU_TESS_BEGIN_DATA,
-                   _cogl_path_tesselator_begin);
-  gluTessCallback (tess.glu_tess, GLU_TESS_VERTEX_DATA,
-                   _cogl_path_tesselator_vertex);
-  gluTessCallback (tess.glu_tess, GLU_TESS_END_DATA,
-                   _cogl_path_tesselator_end);
-  gluTessCallback (tess.glu_tess, GLU_TESS_COMBINE_DATA,
-                   _cogl_path_tesselator_combine);
+      if (data->fill_rule == COGL_PATH_FILL_RULE_EVEN_ODD)
+        gluTessProperty (tess.glu_tess, GLU_TESS_WINDING_RULE,
+                         GLU_TESS_WINDING_ODD);
+      else
+        gluTessProperty (tess.glu_tess, GLU_TESS_WINDING_RULE,
+                         GLU_TESS_WINDING_NONZERO);
 
-  gluTessBeginPolygon (tess.glu_tess, &tess);
+      /* All vertices are on the xy-plane */
+      gluTessNormal (tess.glu_tess, 0.0, 0.0, 1.0);
 
-  while (path_start < data->path_nodes->len)
-    {
-      CoglPathNode *node =
-        &g_array_index (data->path_nodes, CoglPathNode, path_start);
+      gluTessCallback (tess.glu_tess, GLU_TESS_BEGIN_DATA,
+                       _cogl_path_tesselator_begin);
+      gluTessCallback (tess.glu_tess, GLU_TESS_VERTEX_DATA,
+                       _cogl_path_tesselator_vertex);
+      gluTessCallback (tess.glu_tess, GLU_TESS_END_DATA,
+                       _cogl_path_tesselator_end);
+      gluTessCallback (tess.glu_tess, GLU_TESS_COMBINE_DATA,
+                       _cogl_path_tesselator_combine);
 
-      gluTessBeginContour (tess.glu_tess);
+      gluTessBeginPolygon (tess.glu_tess, &tess);
 
-      for (i = 0; i < node->path_size; i++)
+      while (path_start < data->path_nodes->len)
         {
-          double vertex[3] = { node[i].x, node[i].y, 0.0 };
-          gluTessVertex (tess.glu_tess, vertex,
-                         GINT_TO_POINTER (i + path_start));
-        }
+          CoglPathNode *node =
+            &g_array_index (data->path_nodes, CoglPathNode, path_start);
 
-      gluTessEndContour (tess.glu_tess);
+          gluTessBeginContour (tess.glu_tess);
 
-      path_start += node->path_size;
-    }
+          for (i = 0; i < node->path_size; i++)
+            {
+              double vertex[3] = { node[i].x, node[i].y, 0.0 };
+              gluTessVertex (tess.glu_tess, vertex,
+                             GINT_TO_POINTER (i + path_start));
+            }
 
-  gluTessEndPolygon (tess.glu_tess);
+          gluTessEndContour (tess.glu_tess);
+
+          path_start += node->path_size;
+        }
 
-  gluDeleteTess (tess.glu_tess);
+      gluTessEndPolygon (tess.glu_tess);
+
+      gluDeleteTess (tess.glu_tess);
+    }
 
   data->fill_vbo = cogl_vertex_array_new (sizeof (CoglPathTesselatorVertex) *
                                           tess.vertices->len,
@@ -1502,11 +1607,14 @@ _cogl_path_build_fill_vbo (CoglPath *path)
   /* NULL terminator */
   data->fill_vbo_attributes[2] = NULL;
 
-  data->fill_vbo_indices = cogl_indices_new (tess.indices_type,
-                                             tess.indices->data,
-                                             tess.indices->len);
-  data->fill_vbo_n_indices = tess.indices->len;
-  g_array_free (tess.indices, TRUE);
+  if (!is_convex)
+    {
+      data->fill_vbo_indices = cogl_indices_new (tess.indices_type,
+                                                 tess.indices->data,
+                                                 tess.indices->len);
+      data->fill_vbo_n_indices = tess.indices->len;
+      g_array_free (tess.indices, TRUE);
+    }
 }
 
 static void
@@ -64,7 +64,7 @@ void dictDeleteDict( Dict *dict )
 
   for( node = dict->head.next; node != &dict->head; node = next ) {
     next = node->next;
-    memFree( node );
+    memArenaFree( node, sizeof( DictNode ));
   }
   memFree( dict );
 }
@@ -78,7 +78,7 @@ DictNode *dictInsertBefore( Dict *dict, DictNode *node, DictKey key )
     node = node->prev;
   } while( node->key != NULL && ! (*dict->leq)(dict->frame, node->key, key));
 
-  newNode = (DictNode *) memAlloc( sizeof( DictNode ));
+  newNode = (DictNode *) memArenaAlloc( sizeof( DictNode ));
   if (newNode == NULL) return NULL;
 
   newNode->key = key;
@@ -95,7 +95,7 @@ void dictDelete( Dict *dict, DictNode *node ) /*ARGSUSED*/
 {
   node->next->prev = node->prev;
   node->prev->next = node->next;
-  memFree( node );
+  memArenaFree( node, sizeof( DictNode ));
 }
 
 /* really __gl_dictListSearch */
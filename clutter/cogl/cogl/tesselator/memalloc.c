@@ -0,0 +1,193 @@
+/*
+ * Cogl
+ *
+ * An object oriented GL/GLES Abstraction/Utility Layer
+ *
+ * Copyright (C) 2011 Intel Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ */
+
+#include <string.h>
+
+#include "memalloc.h"
+
+/* Every allocation is rounded up to this so that the structures are
+   as aligned as they would be with malloc */
+#define ARENA_ALIGNMENT    (2 * sizeof (void *))
+#define ARENA_ALIGN(size)  (((size) + ARENA_ALIGNMENT - 1) & \
+                            ~(ARENA_ALIGNMENT - 1))
+
+/* Anything bigger than this is passed on to g_malloc. All of the
+   structures allocated from the arena are much smaller */
+#define ARENA_MAX_SIZE     256
+#define ARENA_N_SIZES      (ARENA_MAX_SIZE / ARENA_ALIGNMENT)
+
+/* The size of the first block. Each new block is twice the size of
+   the previous one */
+#define ARENA_MIN_BLOCK_SIZE  (16 * 1024)
+/* When the arena is reset the biggest block is kept for the next
+   tessellation unless it is bigger than this */
+#define ARENA_MAX_KEPT_BLOCK_SIZE  (1024 * 1024)
+
+typedef struct _ArenaBlock ArenaBlock;
+
+struct _ArenaBlock
+{
+  /* The previously allocated block */
+  ArenaBlock *next;
+  size_t size;
+};
+
+#define ARENA_BLOCK_DATA(block) \
+  ((char *) (block) + ARENA_ALIGN (sizeof (ArenaBlock)))
+
+typedef struct _Arena
+{
+  /* The most recently allocated block, which is the one being filled */
+  ArenaBlock *blocks;
+  char *pos;
+  char *end;
+
+  /* A list of freed structures for each size. The first pointer of a
+     freed structure links to the next one */
+  void *free_lists[ARENA_N_SIZES];
+
+  /* The number of structures that haven't been freed yet */
+  unsigned long n_allocated;
+} Arena;
+
+/* The tesselator is only used from the thread running Cogl so the
+   arena is simply global */
+static Arena arena;
+
+static void
+arena_add_block (size_t min_size)
+{
+  ArenaBlock *block;
+  size_t size;
+
+  if (arena.blocks)
+    size = arena.blocks->size * 2;
+  else
+    size = ARENA_MIN_BLOCK_SIZE;
+
+  min_size += ARENA_ALIGN (sizeof (ArenaBlock));
+  if (size < min_size)
+    size = min_size;
+
+  block = g_malloc (size);
+  block->next = arena.blocks;
+  block->size = size;
+
+  arena.blocks = block;
+  arena.pos = ARENA_BLOCK_DATA (block);
+  arena.end = (char *) block + size;
+}
+
+static void
+arena_reset (void)
+{
+  ArenaBlock *block;
+
+  /* Only keep the most recent block. It is the biggest so if the next
+     tessellation is similar it will need at most one more block, after
+     which that one will be enough on its own */
+  block = arena.blocks;
+
+  if (block)
+    {
+      while (block->next)
+        {
+          ArenaBlock *old_block = block->next;
+
+          block->next = old_block->next;
+          g_free (old_block);
+        }
+
+      if (block->size > ARENA_MAX_KEPT_BLOCK_SIZE)
+        {
+          g_free (block);
+          block = NULL;
+        }
+    }
+
+  arena.blocks = block;
+
+  if (block)
+    {
+      arena.pos = ARENA_BLOCK_DATA (block);
+      arena.end = (char *) block + block->size;
+    }
+  else
+    arena.pos = arena.end = NULL;
+
+  memset (arena.free_lists, 0, sizeof (arena.free_lists));
+}
+
+void *
+_cogl_tesselator_arena_alloc (size_t size)
+{
+  void **free_list;
+  void *ptr;
+
+  size = ARENA_ALIGN (size);
+
+  if (size > ARENA_MAX_SIZE)
+    return g_malloc (size);
+
+  free_list = arena.free_lists + size / ARENA_ALIGNMENT - 1;
+
+  if (*free_list)
+    {
+      ptr = *free_list;
+      *free_list = *(void **) ptr;
+    }
+  else
+    {
+      if ((size_t) (arena.end - arena.pos) < size)
+        arena_add_block (size);
+
+      ptr = arena.pos;
+      arena.pos += size;
+    }
+
+  arena.n_allocated++;
+
+  return ptr;
+}
+
+void
+_cogl_tesselator_arena_free (void *ptr, size_t size)
+{
+  void **free_list;
+
+  size = ARENA_ALIGN (size);
+
+  if (size > ARENA_MAX_SIZE)
+    {
+      g_free (ptr);
+      return;
+    }
+
+  free_list = arena.free_lists + size / ARENA_ALIGNMENT - 1;
+
+  *(void **) ptr = *free_list;
+  *free_list = ptr;
+
+  if (--arena.n_allocated == 0)
+    arena_reset ();
+}
@@ -34,6 +34,22 @@
 #define memFree    g_free
 #define memInit(x) 1
 
+/* The small fixed size structures that the tesselator creates and
+   destroys in large numbers (the vertices, faces and edges of the
+   mesh, the nodes of the edge dictionary and the active regions of
+   the sweep) are allocated from an arena instead. Freed structures
+   are kept in a list per size to be reused and the whole arena is
+   reset once all of them have been freed, which happens at the end
+   of each tessellation. The memory is kept for the next one. */
+#define memArenaAlloc(size)     _cogl_tesselator_arena_alloc (size)
+#define memArenaFree(ptr, size) _cogl_tesselator_arena_free ((ptr), (size))
+
+void *
+_cogl_tesselator_arena_alloc (size_t size);
+
+void
+_cogl_tesselator_arena_free (void *ptr, size_t size);
+
 /* tess.c defines TRUE and FALSE itself unconditionally so we need to
    undefine it from the glib headers */
 #undef TRUE
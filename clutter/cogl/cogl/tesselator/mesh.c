@@ -47,12 +47,12 @@
 
 static GLUvertex *allocVertex()
 {
-   return (GLUvertex *)memAlloc( sizeof( GLUvertex ));
+   return (GLUvertex *)memArenaAlloc( sizeof( GLUvertex ));
 }
 
 static GLUface *allocFace()
 {
-   return (GLUface *)memAlloc( sizeof( GLUface ));
+   return (GLUface *)memArenaAlloc( sizeof( GLUface ));
 }
 
 /************************ Utility Routines ************************/
@@ -71,7 +71,7 @@ static GLUhalfEdge *MakeEdge( GLUhalfEdge *eNext )
   GLUhalfEdge *e;
   GLUhalfEdge *eSym;
   GLUhalfEdge *ePrev;
-  EdgePair *pair = (EdgePair *)memAlloc( sizeof( EdgePair ));
+  EdgePair *pair = (EdgePair *)memArenaAlloc( sizeof( EdgePair ));
   if (pair == NULL) return NULL;
 
   e = &pair->e;
@@ -214,7 +214,7 @@ static void KillEdge( GLUhalfEdge *eDel )
   eNext->Sym->next = ePrev;
   ePrev->Sym->next = eNext;
 
-  memFree( eDel );
+  memArenaFree( eDel, sizeof( EdgePair ));
 }
 
 
@@ -239,7 +239,7 @@ static void KillVertex( GLUvertex *vDel, GLUvertex *newOrg )
   vNext->prev = vPrev;
   vPrev->next = vNext;
 
-  memFree( vDel );
+  memArenaFree( vDel, sizeof( GLUvertex ));
 }
 
 /* KillFace( fDel ) destroys a face and removes it from the global face
@@ -263,7 +263,7 @@ static void KillFace( GLUface *fDel, GLUface *newLface )
   fNext->prev = fPrev;
   fPrev->next = fNext;
 
-  memFree( fDel );
+  memArenaFree( fDel, sizeof( GLUface ));
 }
 
 
@@ -281,17 +281,17 @@ GLUhalfEdge *__gl_meshMakeEdge( GLUmesh *mesh )
 
   /* if any one is null then all get freed */
   if (newVertex1 == NULL || newVertex2 == NULL || newFace == NULL) {
-     if (newVertex1 != NULL) memFree(newVertex1);
-     if (newVertex2 != NULL) memFree(newVertex2);
-     if (newFace != NULL) memFree(newFace);     
+     if (newVertex1 != NULL) memArenaFree(newVertex1, sizeof(GLUvertex));
+     if (newVertex2 != NULL) memArenaFree(newVertex2, sizeof(GLUvertex));
+     if (newFace != NULL) memArenaFree(newFace, sizeof(GLUface));     
      return NULL;
   } 
 
   e = MakeEdge( &mesh->eHead );
   if (e == NULL) {
-     memFree(newVertex1);
-     memFree(newVertex2);
-     memFree(newFace);
+     memArenaFree(newVertex1, sizeof(GLUvertex));
+     memArenaFree(newVertex2, sizeof(GLUvertex));
+     memArenaFree(newFace, sizeof(GLUface));
      return NULL;
   }
 
@@ -593,7 +593,7 @@ void __gl_meshZapFace( GLUface *fZap )
   fNext->prev = fPrev;
   fPrev->next = fNext;
 
-  memFree( fZap );
+  memArenaFree( fZap, sizeof( GLUface ));
 }
 
 
@@ -716,18 +716,18 @@ void __gl_meshDeleteMesh( GLUmesh *mesh )
 
   for( f = mesh->fHead.next; f != &mesh->fHead; f = fNext ) {
     fNext = f->next;
-    memFree( f );
+    memArenaFree( f, sizeof( GLUface ));
   }
 
   for( v = mesh->vHead.next; v != &mesh->vHead; v = vNext ) {
     vNext = v->next;
-    memFree( v );
+    memArenaFree( v, sizeof( GLUvertex ));
   }
 
   for( e = mesh->eHead.next; e != &mesh->eHead; e = eNext ) {
     /* One call frees both e and e->Sym (see EdgePair above) */
     eNext = e->next;
-    memFree( e );
+    memArenaFree( e, sizeof( EdgePair ));
   }
 
   memFree( mesh );
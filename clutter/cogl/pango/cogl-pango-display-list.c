@@ -30,6 +30,27 @@
 #include <string.h>
 
 #include "cogl-pango-display-list.h"
+#include "cogl/cogl-debug.h"
+#include "cogl/cogl-clip-stack.h"
+#include "cogl/cogl-framebuffer-private.h"
+#include "cogl/cogl-journal-private.h"
+
+/* The largest number of quads in a glyph batch. The quads are drawn
+ * with 16-bit indices so the vertices must be addressable with a
+ * short */
+#define COGL_PANGO_GLYPH_BATCH_MAX_QUADS (65536 / 4)
+#define COGL_PANGO_GLYPH_BATCH_MIN_QUADS 256
+
+/* Rough relative costs used to pick how a run of glyphs is submitted,
+ * in units of the work needed to transform one vertex in software and
+ * to copy it into the journal. A separate draw call includes flushing
+ * the pipeline state and breaking up the journal batches; it matches
+ * the number of vertices below which we used to always go through the
+ * journal */
+#define COGL_PANGO_COST_JOURNAL_VERTEX 1.0f
+#define COGL_PANGO_COST_UPLOAD_VERTEX  0.5f
+#define COGL_PANGO_COST_DRAW_CALL      100.0f
+#define COGL_PANGO_COST_BATCH_NODE     1.0f
 
 typedef enum
 {
@@ -40,6 +61,10 @@ typedef enum
 
 typedef struct _CoglPangoDisplayListNode CoglPangoDisplayListNode;
 typedef struct _CoglPangoDisplayListVertex CoglPangoDisplayListVertex;
+typedef struct _CoglPangoGlyphBatch CoglPangoGlyphBatch;
+typedef struct _CoglPangoGlyphBatchVertex CoglPangoGlyphBatchVertex;
+typedef struct _CoglPangoGlyphBatchRange CoglPangoGlyphBatchRange;
+typedef struct _CoglPangoPendingBatch CoglPangoPendingBatch;
 
 struct _CoglPangoDisplayList
 {
@@ -66,6 +91,29 @@ struct _CoglPangoDisplayListNode
       GArray     *verts;
       /* A VBO representing those vertices */
       CoglHandle  vertex_buffer;
+
+      /* The modelview matrix and the premultiplied color the node
+         was last rendered with, the number of renders in a row for
+         which they haven't changed and the number of renders since
+         the vertices changed */
+      CoglMatrix  modelview;
+      CoglColor   draw_color;
+      int         n_stable_renders;
+      int         n_renders;
+
+      /* The slot holding the transformed vertices in a glyph batch.
+         The slot is lost if the batch is compacted which changes its
+         generation */
+      CoglPangoGlyphBatch *batch;
+      unsigned int batch_generation;
+      int          batch_offset;
+      int          batch_n_quads;
+      /* The serial number of the pending batch the slot was last
+         queued in */
+      unsigned int batch_serial;
+      /* Whether the slot contains the vertices transformed with the
+         current modelview and color */
+      gboolean     batch_valid;
     } texture;
 
     struct
@@ -91,6 +139,70 @@ struct _CoglPangoDisplayListVertex
   float x, y, t_x, t_y;
 };
 
+/* The vertices of the static runs of glyphs are kept in a persistent
+ * buffer per glyph texture, already transformed by their modelview
+ * matrix. That way the runs of any number of labels using the same
+ * texture can be drawn with a single call and each label only needs
+ * to update its own slot in the buffer when it moves or changes
+ * color */
+struct _CoglPangoGlyphBatchVertex
+{
+  float x, y, z;
+  float t_x, t_y;
+  guint8 color[4];
+};
+
+struct _CoglPangoGlyphBatch
+{
+  CoglHandle       texture;
+
+  /* A copy of the contents of the vertex array, 4 vertices per quad */
+  GArray          *verts;
+  CoglVertexArray *array;
+  CoglAttribute   *attributes[4];
+  int              n_allocated_quads;
+
+  /* The number of quads belonging to slots which have been released */
+  int              n_dead_quads;
+
+  /* The range of quads that needs to be uploaded */
+  int              dirty_start;
+  int              dirty_end;
+
+  unsigned int     generation;
+
+  /* The number of nodes with a slot in this batch */
+  int              n_nodes;
+};
+
+struct _CoglPangoGlyphBatchRange
+{
+  int start;
+  int n_quads;
+};
+
+/* The glyph batch currently being collected. It is drawn when the
+ * state it depends on changes or just before anything else gets
+ * logged to or flushed from a journal so the painting order is
+ * preserved */
+struct _CoglPangoPendingBatch
+{
+  CoglPangoGlyphBatch *batch;
+  unsigned int         serial;
+
+  CoglMaterial        *source;
+  CoglMaterial        *material;
+  CoglFramebuffer     *framebuffer;
+  CoglClipStack       *clip_stack;
+  CoglMatrix           projection;
+
+  /* The ranges of quads to draw, in painting order */
+  GArray              *ranges;
+};
+
+static GHashTable *glyph_batches = NULL;
+static CoglPangoPendingBatch pending_batch;
+
 CoglPangoDisplayList *
 _cogl_pango_display_list_new (void)
 {
@@ -121,6 +233,323 @@ _cogl_pango_display_list_remove_color_override (CoglPangoDisplayList *dl)
   dl->color_override = FALSE;
 }
 
+static void
+_cogl_pango_pending_batch_flush (void *user_data)
+{
+  CoglPangoPendingBatch *pending = user_data;
+  CoglPangoGlyphBatch *batch = pending->batch;
+  CoglClipState *clip_state;
+  CoglClipStack *old_clip_stack;
+  CoglMatrix old_projection, identity;
+  CoglIndices *indices;
+  int i, n_quads = 0;
+
+  if (batch == NULL)
+    return;
+
+  /* Drawing the batch flushes the journal which will invoke this
+     function again so the batch needs to be detached first */
+  pending->batch = NULL;
+
+  /* Anything in the journal was logged before the batch was started
+     so it needs to be drawn before we change the matrices */
+  _cogl_framebuffer_flush_journal (pending->framebuffer);
+
+  if (batch->dirty_start < batch->dirty_end)
+    {
+      cogl_buffer_set_data (COGL_BUFFER (batch->array),
+                            batch->dirty_start * 4
+                            * sizeof (CoglPangoGlyphBatchVertex),
+                            &g_array_index (batch->verts,
+                                            CoglPangoGlyphBatchVertex,
+                                            batch->dirty_start * 4),
+                            (batch->dirty_end - batch->dirty_start) * 4
+                            * sizeof (CoglPangoGlyphBatchVertex));
+      batch->dirty_start = G_MAXINT;
+      batch->dirty_end = 0;
+    }
+
+  for (i = 0; i < pending->ranges->len; i++)
+    {
+      CoglPangoGlyphBatchRange *range =
+        &g_array_index (pending->ranges, CoglPangoGlyphBatchRange, i);
+
+      n_quads = MAX (n_quads, range->start + range->n_quads);
+    }
+
+  indices = cogl_get_rectangle_indices (n_quads);
+
+  /* Draw with the state that was current when the glyphs were
+     queued. The vertices are already in eye coordinates */
+  clip_state = _cogl_framebuffer_get_clip_state (pending->framebuffer);
+  old_clip_stack =
+    _cogl_clip_stack_ref (_cogl_clip_state_get_stack (clip_state));
+  _cogl_clip_state_set_stack (clip_state, pending->clip_stack);
+
+  cogl_get_projection_matrix (&old_projection);
+  cogl_set_projection_matrix (&pending->projection);
+
+  cogl_push_matrix ();
+  cogl_matrix_init_identity (&identity);
+  cogl_set_modelview_matrix (&identity);
+
+  cogl_push_source (pending->material);
+
+  for (i = 0; i < pending->ranges->len; i++)
+    {
+      CoglPangoGlyphBatchRange *range =
+        &g_array_index (pending->ranges, CoglPangoGlyphBatchRange, i);
+
+      cogl_draw_indexed_attributes_array (COGL_VERTICES_MODE_TRIANGLES,
+                                          range->start * 6,
+                                          range->n_quads * 6,
+                                          indices,
+                                          batch->attributes);
+    }
+
+  cogl_pop_source ();
+
+  cogl_pop_matrix ();
+  cogl_set_projection_matrix (&old_projection);
+
+  _cogl_clip_state_set_stack (clip_state, old_clip_stack);
+  _cogl_clip_stack_unref (old_clip_stack);
+
+  _cogl_clip_stack_unref (pending->clip_stack);
+  pending->clip_stack = NULL;
+  cogl_object_unref (pending->material);
+  pending->material = NULL;
+  g_array_set_size (pending->ranges, 0);
+}
+
+static void
+_cogl_pango_glyph_batch_free (CoglPangoGlyphBatch *batch)
+{
+  if (pending_batch.batch == batch)
+    _cogl_pango_pending_batch_flush (&pending_batch);
+
+  g_hash_table_remove (glyph_batches, batch->texture);
+
+  if (batch->array)
+    {
+      int i;
+
+      for (i = 0; batch->attributes[i]; i++)
+        cogl_object_unref (batch->attributes[i]);
+      cogl_object_unref (batch->array);
+    }
+
+  g_array_free (batch->verts, TRUE);
+  cogl_handle_unref (batch->texture);
+
+  g_slice_free (CoglPangoGlyphBatch, batch);
+}
+
+static CoglPangoGlyphBatch *
+_cogl_pango_glyph_batch_get (CoglHandle texture)
+{
+  CoglPangoGlyphBatch *batch;
+
+  if (G_UNLIKELY (glyph_batches == NULL))
+    glyph_batches = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  batch = g_hash_table_lookup (glyph_batches, texture);
+  if (batch == NULL)
+    {
+      batch = g_slice_new0 (CoglPangoGlyphBatch);
+      batch->texture = cogl_handle_ref (texture);
+      batch->verts = g_array_new (FALSE, FALSE,
+                                  sizeof (CoglPangoGlyphBatchVertex));
+      batch->dirty_start = G_MAXINT;
+      batch->dirty_end = 0;
+
+      g_hash_table_insert (glyph_batches, texture, batch);
+    }
+
+  return batch;
+}
+
+static gboolean
+_cogl_pango_glyph_batch_reserve (CoglPangoGlyphBatch *batch,
+                                 int n_quads)
+{
+  int n_used_quads = batch->verts->len / 4;
+  int n_allocated_quads;
+  int i;
+
+  if (n_used_quads + n_quads <= batch->n_allocated_quads)
+    return TRUE;
+
+  /* The buffer can't be changed while some of it is still waiting to
+     be drawn */
+  if (pending_batch.batch == batch)
+    _cogl_pango_pending_batch_flush (&pending_batch);
+
+  /* If at least half of the buffer belongs to released slots then
+     it's cheaper to drop all of the slots and let the nodes write
+     their vertices again the next time they are rendered */
+  if (batch->n_dead_quads * 2 >= n_used_quads)
+    {
+      batch->generation++;
+      batch->n_dead_quads = 0;
+      batch->dirty_start = G_MAXINT;
+      batch->dirty_end = 0;
+      g_array_set_size (batch->verts, 0);
+      n_used_quads = 0;
+
+      if (n_quads <= batch->n_allocated_quads)
+        return TRUE;
+    }
+
+  n_allocated_quads = MAX (batch->n_allocated_quads,
+                           COGL_PANGO_GLYPH_BATCH_MIN_QUADS);
+  while (n_allocated_quads < n_used_quads + n_quads)
+    n_allocated_quads *= 2;
+
+  if (n_allocated_quads > COGL_PANGO_GLYPH_BATCH_MAX_QUADS)
+    {
+      if (n_used_quads + n_quads > COGL_PANGO_GLYPH_BATCH_MAX_QUADS)
+        return FALSE;
+      n_allocated_quads = COGL_PANGO_GLYPH_BATCH_MAX_QUADS;
+    }
+
+  if (batch->array)
+    {
+      for (i = 0; batch->attributes[i]; i++)
+        cogl_object_unref (batch->attributes[i]);
+      cogl_object_unref (batch->array);
+    }
+
+  batch->array =
+    cogl_vertex_array_new (n_allocated_quads * 4
+                           * sizeof (CoglPangoGlyphBatchVertex),
+                           NULL);
+  cogl_buffer_set_update_hint (COGL_BUFFER (batch->array),
+                               COGL_BUFFER_UPDATE_HINT_DYNAMIC);
+  batch->n_allocated_quads = n_allocated_quads;
+
+  batch->attributes[0] =
+    cogl_attribute_new (batch->array, "cogl_position_in",
+                        sizeof (CoglPangoGlyphBatchVertex),
+                        G_STRUCT_OFFSET (CoglPangoGlyphBatchVertex, x),
+                        3,
+                        COGL_ATTRIBUTE_TYPE_FLOAT);
+  batch->attributes[1] =
+    cogl_attribute_new (batch->array, "cogl_tex_coord0_in",
+                        sizeof (CoglPangoGlyphBatchVertex),
+                        G_STRUCT_OFFSET (CoglPangoGlyphBatchVertex, t_x),
+                        2,
+                        COGL_ATTRIBUTE_TYPE_FLOAT);
+  batch->attributes[2] =
+    cogl_attribute_new (batch->array, "cogl_color_in",
+                        sizeof (CoglPangoGlyphBatchVertex),
+                        G_STRUCT_OFFSET (CoglPangoGlyphBatchVertex, color),
+                        4,
+                        COGL_ATTRIBUTE_TYPE_UNSIGNED_BYTE);
+  batch->attributes[3] = NULL;
+
+  /* The new buffer needs the existing slots as well */
+  batch->dirty_start = 0;
+  batch->dirty_end = n_used_quads;
+
+  return TRUE;
+}
+
+static void
+_cogl_pango_glyph_batch_release_slot (CoglPangoDisplayListNode *node)
+{
+  CoglPangoGlyphBatch *batch = node->d.texture.batch;
+
+  if (batch == NULL)
+    return;
+
+  /* The quads of a released slot are only reused once the batch is
+     compacted so a pending draw of the slot is still valid */
+  if (node->d.texture.batch_generation == batch->generation)
+    batch->n_dead_quads += node->d.texture.batch_n_quads;
+
+  node->d.texture.batch = NULL;
+
+  if (--batch->n_nodes == 0)
+    _cogl_pango_glyph_batch_free (batch);
+}
+
+static gboolean
+_cogl_pango_glyph_batch_ensure_slot (CoglPangoGlyphBatch *batch,
+                                     CoglPangoDisplayListNode *node)
+{
+  int n_quads = node->d.texture.verts->len / 4;
+
+  if (node->d.texture.batch == batch
+      && node->d.texture.batch_generation == batch->generation)
+    return TRUE;
+
+  if (!_cogl_pango_glyph_batch_reserve (batch, n_quads))
+    return FALSE;
+
+  if (node->d.texture.batch != batch)
+    {
+      batch->n_nodes++;
+      node->d.texture.batch = batch;
+    }
+
+  node->d.texture.batch_generation = batch->generation;
+  node->d.texture.batch_offset = batch->verts->len / 4;
+  node->d.texture.batch_n_quads = n_quads;
+  node->d.texture.batch_serial = pending_batch.serial - 1;
+  node->d.texture.batch_valid = FALSE;
+
+  g_array_set_size (batch->verts, batch->verts->len + n_quads * 4);
+
+  return TRUE;
+}
+
+static void
+_cogl_pango_glyph_batch_write_slot (CoglPangoGlyphBatch *batch,
+                                    CoglPangoDisplayListNode *node)
+{
+  CoglPangoDisplayListVertex *in;
+  CoglPangoGlyphBatchVertex *out;
+  guint8 red, green, blue, alpha;
+  int n_verts = node->d.texture.verts->len;
+  int i;
+
+  in = &g_array_index (node->d.texture.verts,
+                       CoglPangoDisplayListVertex, 0);
+  out = &g_array_index (batch->verts, CoglPangoGlyphBatchVertex,
+                        node->d.texture.batch_offset * 4);
+
+  cogl_matrix_transform_points (&node->d.texture.modelview,
+                                2,
+                                sizeof (CoglPangoDisplayListVertex),
+                                &in->x,
+                                sizeof (CoglPangoGlyphBatchVertex),
+                                &out->x,
+                                n_verts);
+
+  red = cogl_color_get_red_byte (&node->d.texture.draw_color);
+  green = cogl_color_get_green_byte (&node->d.texture.draw_color);
+  blue = cogl_color_get_blue_byte (&node->d.texture.draw_color);
+  alpha = cogl_color_get_alpha_byte (&node->d.texture.draw_color);
+
+  for (i = 0; i < n_verts; i++)
+    {
+      out[i].t_x = in[i].t_x;
+      out[i].t_y = in[i].t_y;
+      out[i].color[0] = red;
+      out[i].color[1] = green;
+      out[i].color[2] = blue;
+      out[i].color[3] = alpha;
+    }
+
+  batch->dirty_start = MIN (batch->dirty_start, node->d.texture.batch_offset);
+  batch->dirty_end = MAX (batch->dirty_end,
+                          node->d.texture.batch_offset
+                          + node->d.texture.batch_n_quads);
+
+  node->d.texture.batch_valid = TRUE;
+}
+
 void
 _cogl_pango_display_list_add_texture (CoglPangoDisplayList *dl,
                                       CoglHandle texture,
@@ -147,6 +576,11 @@ _cogl_pango_display_list_add_texture (CoglPangoDisplayList *dl,
           cogl_handle_unref (node->d.texture.vertex_buffer);
           node->d.texture.vertex_buffer = COGL_INVALID_HANDLE;
         }
+
+      /* The slot in the glyph batch is too small now */
+      _cogl_pango_glyph_batch_release_slot (node);
+      node->d.texture.n_renders = 0;
+      node->d.texture.n_stable_renders = 0;
     }
   else
     {
@@ -160,6 +594,9 @@ _cogl_pango_display_list_add_texture (CoglPangoDisplayList *dl,
       node->d.texture.verts
         = g_array_new (FALSE, FALSE, sizeof (CoglPangoDisplayListVertex));
       node->d.texture.vertex_buffer = COGL_INVALID_HANDLE;
+      node->d.texture.n_stable_renders = 0;
+      node->d.texture.n_renders = 0;
+      node->d.texture.batch = NULL;
 
       _cogl_pango_display_list_append_node (dl, node);
     }
@@ -308,12 +745,144 @@ emit_vertex_buffer_geometry (CoglPangoDisplayListNode *node)
 #endif /* CLUTTER_COGL_HAS_GL */
 }
 
+static gboolean
+emit_glyph_batch_geometry (CoglMaterial *material,
+                           CoglPangoDisplayListNode *node)
+{
+  CoglPangoPendingBatch *pending = &pending_batch;
+  CoglPangoGlyphBatch *batch;
+  CoglPangoGlyphBatchRange *range;
+  CoglFramebuffer *framebuffer;
+  CoglClipStack *clip_stack;
+  CoglMatrix projection;
+
+  batch = node->d.texture.batch;
+  if (batch == NULL)
+    batch = _cogl_pango_glyph_batch_get (node->d.texture.texture);
+
+  if (!_cogl_pango_glyph_batch_ensure_slot (batch, node))
+    {
+      if (batch->n_nodes == 0)
+        _cogl_pango_glyph_batch_free (batch);
+      return FALSE;
+    }
+
+  framebuffer = _cogl_get_draw_buffer ();
+  clip_stack =
+    _cogl_clip_state_get_stack (_cogl_framebuffer_get_clip_state (framebuffer));
+  cogl_get_projection_matrix (&projection);
+
+  if (pending->batch
+      && (pending->batch != batch
+          || pending->source != material
+          || pending->framebuffer != framebuffer
+          || pending->clip_stack != clip_stack
+          || !cogl_matrix_equal (&pending->projection, &projection)))
+    _cogl_pango_pending_batch_flush (pending);
+
+  if (!node->d.texture.batch_valid)
+    {
+      /* The node may already be queued with its old vertices, for
+         example if it is painted more than once in a frame */
+      if (pending->batch && node->d.texture.batch_serial == pending->serial)
+        _cogl_pango_pending_batch_flush (pending);
+
+      _cogl_pango_glyph_batch_write_slot (batch, node);
+    }
+
+  if (pending->batch == NULL)
+    {
+      if (G_UNLIKELY (pending->ranges == NULL))
+        {
+          pending->ranges = g_array_new (FALSE, FALSE,
+                                         sizeof (CoglPangoGlyphBatchRange));
+          _cogl_journal_add_pre_flush_callback
+            (_cogl_pango_pending_batch_flush, pending);
+        }
+
+      pending->batch = batch;
+      pending->serial++;
+      pending->source = material;
+      pending->material = cogl_material_copy (material);
+      cogl_material_set_layer (pending->material, 0, batch->texture);
+      pending->framebuffer = framebuffer;
+      pending->clip_stack = _cogl_clip_stack_ref (clip_stack);
+      pending->projection = projection;
+    }
+
+  node->d.texture.batch_serial = pending->serial;
+
+  /* Extend the last range if the slot follows it so a static scene
+     ends up drawn with a single call */
+  range = NULL;
+  if (pending->ranges->len > 0)
+    {
+      range = &g_array_index (pending->ranges, CoglPangoGlyphBatchRange,
+                              pending->ranges->len - 1);
+      if (range->start + range->n_quads != node->d.texture.batch_offset)
+        range = NULL;
+    }
+
+  if (range)
+    range->n_quads += node->d.texture.batch_n_quads;
+  else
+    {
+      g_array_set_size (pending->ranges, pending->ranges->len + 1);
+      range = &g_array_index (pending->ranges, CoglPangoGlyphBatchRange,
+                              pending->ranges->len - 1);
+      range->start = node->d.texture.batch_offset;
+      range->n_quads = node->d.texture.batch_n_quads;
+    }
+
+  return TRUE;
+}
+
 static void
 _cogl_pango_display_list_render_texture (CoglMaterial *material,
                                          const CoglColor *color,
                                          CoglPangoDisplayListNode *node)
 {
   CoglColor premult_color = *color;
+  CoglMatrix modelview;
+  float n_verts = node->d.texture.verts->len;
+  float journal_cost, vbo_cost, batch_cost;
+
+  cogl_get_modelview_matrix (&modelview);
+
+  if (node->d.texture.n_renders > 0
+      && cogl_matrix_equal (&modelview, &node->d.texture.modelview)
+      && cogl_color_equal (color, &node->d.texture.draw_color))
+    node->d.texture.n_stable_renders++;
+  else
+    {
+      node->d.texture.modelview = modelview;
+      node->d.texture.draw_color = *color;
+      node->d.texture.n_stable_renders = 0;
+      node->d.texture.batch_valid = FALSE;
+    }
+
+  node->d.texture.n_renders++;
+
+  /* Going through the journal costs a software transform of every
+   * vertex each time the node is rendered but the glyphs can be
+   * batched with any other geometry. A VBO of our own avoids the
+   * transform but needs a separate draw call. The glyph batch only
+   * transforms and uploads the vertices when the modelview or the
+   * color changes, so we assume the node will stay put for as long
+   * as it already has and spread that cost over those renders */
+  journal_cost = n_verts * COGL_PANGO_COST_JOURNAL_VERTEX;
+  vbo_cost = (COGL_PANGO_COST_DRAW_CALL
+              + n_verts * COGL_PANGO_COST_UPLOAD_VERTEX
+              / node->d.texture.n_renders);
+  batch_cost = (COGL_PANGO_COST_BATCH_NODE
+                + n_verts * (COGL_PANGO_COST_JOURNAL_VERTEX
+                             + COGL_PANGO_COST_UPLOAD_VERTEX)
+                / (node->d.texture.n_stable_renders + 1));
+
+  if (batch_cost < MIN (journal_cost, vbo_cost)
+      && G_LIKELY (!COGL_DEBUG_ENABLED (COGL_DEBUG_DISABLE_BATCHING))
+      && emit_glyph_batch_geometry (material, node))
+    return;
 
   cogl_material_set_layer (material, 0, node->d.texture.texture);
   cogl_material_set_color (material, &premult_color);
@@ -323,9 +892,7 @@ _cogl_pango_display_list_render_texture (CoglMaterial *material,
   /* For small runs of text like icon labels, we can get better performance
    * going through the Cogl journal since text may then be batched together
    * with other geometry. */
-  /* FIXME: 100 is a number I plucked out of thin air; it would be good
-   * to determine this empirically! */
-  if (node->d.texture.verts->len < 100)
+  if (journal_cost <= vbo_cost)
     emit_rectangles_through_journal (node);
   else
     emit_vertex_buffer_geometry (node);
@@ -407,6 +974,7 @@ _cogl_pango_display_list_node_free (CoglPangoDisplayListNode *node)
 {
   if (node->type == COGL_PANGO_DISPLAY_LIST_TEXTURE)
     {
+      _cogl_pango_glyph_batch_release_slot (node);
       g_array_free (node->d.texture.verts, TRUE);
       if (node->d.texture.texture != COGL_INVALID_HANDLE)
         cogl_handle_unref (node->d.texture.texture);
@@ -197,6 +197,53 @@ cogl_pango_font_map_get_use_mipmapping (CoglPangoFontMap *fm)
   return _cogl_pango_renderer_get_use_mipmapping (renderer);
 }
 
+/**
+ * cogl_pango_font_map_set_use_distance_field:
+ * @fm: a #CoglPangoFontMap
+ * @value: %TRUE to store the glyphs as signed distance fields
+ *
+ * Sets whether the renderer for the passed font map should store the
+ * glyphs as signed distance fields. The glyphs of every size of a font
+ * are then rasterized once at a reference size and they stay sharp
+ * when the text is scaled, which avoids filling the glyph cache when
+ * the size of the text is animated. Small text will look slightly
+ * softer than with the default glyph cache because the glyphs are not
+ * hinted.
+ *
+ * Since: 1.8
+ */
+void
+cogl_pango_font_map_set_use_distance_field (CoglPangoFontMap *fm,
+                                            gboolean          value)
+{
+  CoglPangoRenderer *renderer;
+
+  renderer = COGL_PANGO_RENDERER (cogl_pango_font_map_get_renderer (fm));
+
+  _cogl_pango_renderer_set_use_distance_field (renderer, value);
+}
+
+/**
+ * cogl_pango_font_map_get_use_distance_field:
+ * @fm: a #CoglPangoFontMap
+ *
+ * Retrieves whether the #CoglPangoRenderer used by @fm will store
+ * the glyphs as signed distance fields.
+ *
+ * Return value: %TRUE if distance fields are used, %FALSE otherwise.
+ *
+ * Since: 1.8
+ */
+gboolean
+cogl_pango_font_map_get_use_distance_field (CoglPangoFontMap *fm)
+{
+  CoglPangoRenderer *renderer;
+
+  renderer = COGL_PANGO_RENDERER (cogl_pango_font_map_get_renderer (fm));
+
+  return _cogl_pango_renderer_get_use_distance_field (renderer);
+}
+
 static GQuark
 cogl_pango_font_map_get_renderer_key (void)
 {
@@ -26,6 +26,8 @@
 #endif
 
 #include <glib.h>
+#include <math.h>
+#include <pango/pangocairo.h>
 
 #include "cogl-pango-glyph-cache.h"
 #include "cogl-pango-private.h"
@@ -33,6 +35,7 @@
 #include "cogl/cogl-callback-list.h"
 
 typedef struct _CoglPangoGlyphCacheKey     CoglPangoGlyphCacheKey;
+typedef struct _CoglPangoGlyphCacheFont    CoglPangoGlyphCacheFont;
 
 struct _CoglPangoGlyphCache
 {
@@ -50,6 +53,22 @@ struct _CoglPangoGlyphCache
      optimization in _cogl_pango_glyph_cache_set_dirty_glyphs to avoid
      iterating the hash table if we know none of them are dirty */
   gboolean          has_dirty_glyphs;
+
+  /* True if the glyphs are stored as distance fields. In that case
+     the glyphs of every size of a font are taken from the same font
+     at the reference size, so the glyphs are keyed on that font
+     instead. The mapping is cached in reference_fonts */
+  gboolean          use_distance_field;
+  GHashTable       *reference_fonts;
+  /* Context used to load the reference fonts without hinting */
+  PangoContext     *reference_context;
+};
+
+struct _CoglPangoGlyphCacheFont
+{
+  PangoFont *font;
+  /* The size of the original font relative to the reference size */
+  float      scale;
 };
 
 struct _CoglPangoGlyphCacheKey
@@ -65,6 +84,13 @@ cogl_pango_glyph_cache_value_free (CoglPangoGlyphCacheValue *value)
   g_slice_free (CoglPangoGlyphCacheValue, value);
 }
 
+static void
+cogl_pango_glyph_cache_font_free (CoglPangoGlyphCacheFont *font)
+{
+  g_object_unref (font->font);
+  g_slice_free (CoglPangoGlyphCacheFont, font);
+}
+
 static void
 cogl_pango_glyph_cache_key_free (CoglPangoGlyphCacheKey *key)
 {
@@ -102,7 +128,7 @@ cogl_pango_glyph_cache_equal_func (gconstpointer a,
 }
 
 CoglPangoGlyphCache *
-cogl_pango_glyph_cache_new (void)
+cogl_pango_glyph_cache_new (gboolean use_distance_field)
 {
   CoglPangoGlyphCache *cache;
 
@@ -119,6 +145,16 @@ cogl_pango_glyph_cache_new (void)
 
   cache->has_dirty_glyphs = FALSE;
 
+  cache->use_distance_field = use_distance_field;
+  cache->reference_fonts = NULL;
+  cache->reference_context = NULL;
+
+  if (use_distance_field)
+    cache->reference_fonts =
+      g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                             g_object_unref,
+                             (GDestroyNotify) cogl_pango_glyph_cache_font_free);
+
   return cache;
 }
 
@@ -131,6 +167,15 @@ cogl_pango_glyph_cache_clear (CoglPangoGlyphCache *cache)
   cache->has_dirty_glyphs = FALSE;
 
   g_hash_table_remove_all (cache->hash_table);
+
+  /* The font options might have changed as well */
+  if (cache->reference_fonts)
+    g_hash_table_remove_all (cache->reference_fonts);
+  if (cache->reference_context)
+    {
+      g_object_unref (cache->reference_context);
+      cache->reference_context = NULL;
+    }
 }
 
 void
@@ -139,6 +184,8 @@ cogl_pango_glyph_cache_free (CoglPangoGlyphCache *cache)
   cogl_pango_glyph_cache_clear (cache);
 
   g_hash_table_unref (cache->hash_table);
+  if (cache->reference_fonts)
+    g_hash_table_unref (cache->reference_fonts);
 
   _cogl_callback_list_destroy (&cache->reorganize_callbacks);
 
@@ -180,6 +227,78 @@ cogl_pango_glyph_cache_reorganize_cb (void *user_data)
   _cogl_callback_list_invoke (&cache->reorganize_callbacks);
 }
 
+static CoglPangoGlyphCacheFont *
+cogl_pango_glyph_cache_get_reference_font (CoglPangoGlyphCache *cache,
+                                           PangoFont           *font)
+{
+  CoglPangoGlyphCacheFont *reference;
+  PangoFontDescription *desc;
+  PangoFontMap *font_map;
+  int size;
+
+  reference = g_hash_table_lookup (cache->reference_fonts, font);
+  if (reference)
+    return reference;
+
+  font_map = pango_font_get_font_map (font);
+
+  if (cache->reference_context == NULL)
+    {
+      cairo_font_options_t *font_options;
+
+      cache->reference_context =
+        pango_cairo_font_map_create_context (PANGO_CAIRO_FONT_MAP (font_map));
+
+      /* Hinting would snap the outlines to the pixel grid of the
+         reference size which looks wrong at any other size */
+      font_options = cairo_font_options_create ();
+      cairo_font_options_set_hint_style (font_options, CAIRO_HINT_STYLE_NONE);
+      cairo_font_options_set_hint_metrics (font_options,
+                                           CAIRO_HINT_METRICS_OFF);
+      cairo_font_options_set_antialias (font_options, CAIRO_ANTIALIAS_GRAY);
+      pango_cairo_context_set_font_options (cache->reference_context,
+                                            font_options);
+      cairo_font_options_destroy (font_options);
+    }
+
+  desc = pango_font_describe_with_absolute_size (font);
+  size = pango_font_description_get_size (desc);
+  pango_font_description_set_absolute_size (desc,
+                                            COGL_PANGO_DISTANCE_FIELD_SIZE
+                                            * PANGO_SCALE);
+
+  reference = g_slice_new (CoglPangoGlyphCacheFont);
+  reference->font = pango_font_map_load_font (font_map,
+                                              cache->reference_context,
+                                              desc);
+  reference->scale = size / (float) (COGL_PANGO_DISTANCE_FIELD_SIZE
+                                     * PANGO_SCALE);
+
+  pango_font_description_free (desc);
+
+  /* If the font can't be loaded at the reference size then we'll
+     just use it as is */
+  if (reference->font == NULL)
+    {
+      reference->font = g_object_ref (font);
+      reference->scale = 1.0f;
+    }
+
+  g_hash_table_insert (cache->reference_fonts, g_object_ref (font), reference);
+
+  return reference;
+}
+
+float
+_cogl_pango_glyph_cache_get_scale (CoglPangoGlyphCache *cache,
+                                   PangoFont           *font)
+{
+  if (!cache->use_distance_field || font == NULL)
+    return 1.0f;
+
+  return cogl_pango_glyph_cache_get_reference_font (cache, font)->scale;
+}
+
 CoglPangoGlyphCacheValue *
 cogl_pango_glyph_cache_lookup (CoglPangoGlyphCache *cache,
                                gboolean             create,
@@ -189,6 +308,9 @@ cogl_pango_glyph_cache_lookup (CoglPangoGlyphCache *cache,
   CoglPangoGlyphCacheKey lookup_key;
   CoglPangoGlyphCacheValue *value;
 
+  if (cache->use_distance_field)
+    font = cogl_pango_glyph_cache_get_reference_font (cache, font)->font;
+
   lookup_key.font = font;
   lookup_key.glyph = glyph;
 
@@ -211,11 +333,23 @@ cogl_pango_glyph_cache_lookup (CoglPangoGlyphCache *cache,
       value->draw_width = ink_rect.width;
       value->draw_height = ink_rect.height;
       value->dirty = TRUE;
+      value->distance_field = cache->use_distance_field;
+
+      /* Leave room around the outline for the distance field to fade
+         out */
+      if (value->distance_field && ink_rect.width > 0 && ink_rect.height > 0)
+        {
+          value->draw_x -= COGL_PANGO_DISTANCE_FIELD_SPREAD;
+          value->draw_y -= COGL_PANGO_DISTANCE_FIELD_SPREAD;
+          value->draw_width += COGL_PANGO_DISTANCE_FIELD_SPREAD * 2;
+          value->draw_height += COGL_PANGO_DISTANCE_FIELD_SPREAD * 2;
+        }
 
       /* Look for an atlas that can reserve the space */
       for (l = cache->atlases; l; l = l->next)
         if (_cogl_atlas_reserve_space (l->data,
-                                       ink_rect.width + 1, ink_rect.height + 1,
+                                       value->draw_width + 1,
+                                       value->draw_height + 1,
                                        value))
           {
             atlas = l->data;
@@ -232,8 +366,8 @@ cogl_pango_glyph_cache_lookup (CoglPangoGlyphCache *cache,
           /* If we still can't reserve space then something has gone
              seriously wrong so we'll just give up */
           if (!_cogl_atlas_reserve_space (atlas,
-                                          ink_rect.width + 1,
-                                          ink_rect.height + 1, value))
+                                          value->draw_width + 1,
+                                          value->draw_height + 1, value))
             {
               cogl_object_unref (atlas);
               cogl_pango_glyph_cache_value_free (value);
@@ -306,3 +440,129 @@ _cogl_pango_glyph_cache_remove_reorganize_callback (CoglPangoGlyphCache *cache,
 {
   _cogl_callback_list_remove (&cache->reorganize_callbacks, func, user_data);
 }
+
+/* Finds the distance from each pixel to the nearest pixel for which
+ * the coverage is on the other side of the outline. This uses two
+ * passes of a 3x3 propagation of the nearest site which is not exact
+ * but is close enough for the small spread we need */
+static void
+cogl_pango_glyph_cache_find_distances (const guint8 *data,
+                                       int           width,
+                                       int           height,
+                                       int           rowstride,
+                                       gboolean      inside,
+                                       float        *distances)
+{
+  static const int forward[][2] = { { -1, -1 }, { 0, -1 }, { 1, -1 },
+                                    { -1, 0 } };
+  static const int backward[][2] = { { 1, 0 }, { -1, 1 }, { 0, 1 },
+                                     { 1, 1 } };
+  gint16 *sites = g_new (gint16, width * height * 2);
+  int pass, x, y, i;
+
+  for (y = 0; y < height; y++)
+    for (x = 0; x < width; x++)
+      {
+        int pos = y * width + x;
+
+        if ((data[y * rowstride + x] >= 128) != inside)
+          {
+            sites[pos * 2] = x;
+            sites[pos * 2 + 1] = y;
+            distances[pos] = 0.0f;
+          }
+        else
+          {
+            sites[pos * 2] = G_MAXINT16;
+            distances[pos] = G_MAXFLOAT;
+          }
+      }
+
+  for (pass = 0; pass < 2; pass++)
+    {
+      const int (* offsets)[2] = pass ? backward : forward;
+
+      for (i = 0; i < width * height; i++)
+        {
+          int pos = pass ? width * height - 1 - i : i;
+          int j;
+
+          x = pos % width;
+          y = pos / width;
+
+          for (j = 0; j < 4; j++)
+            {
+              int nx = x + offsets[j][0], ny = y + offsets[j][1];
+              int npos = ny * width + nx;
+              float dx, dy, distance;
+
+              if (nx < 0 || nx >= width || ny < 0 || ny >= height
+                  || sites[npos * 2] == G_MAXINT16)
+                continue;
+
+              dx = x - sites[npos * 2];
+              dy = y - sites[npos * 2 + 1];
+              distance = sqrtf (dx * dx + dy * dy);
+
+              if (distance < distances[pos])
+                {
+                  sites[pos * 2] = sites[npos * 2];
+                  sites[pos * 2 + 1] = sites[npos * 2 + 1];
+                  distances[pos] = distance;
+                }
+            }
+        }
+    }
+
+  g_free (sites);
+}
+
+/* Replaces the coverage of a glyph with a signed distance field. The
+ * outline maps to 128 and the values grow towards 255 inside the glyph
+ * and fall towards 0 outside of it, reaching the ends of the range at
+ * COGL_PANGO_DISTANCE_FIELD_SPREAD pixels from the outline */
+void
+_cogl_pango_glyph_cache_make_distance_field (guint8 *data,
+                                             int     width,
+                                             int     height,
+                                             int     rowstride)
+{
+  float *to_outside, *to_inside;
+  int x, y;
+
+  if (width <= 0 || height <= 0)
+    return;
+
+  to_outside = g_new (float, width * height);
+  to_inside = g_new (float, width * height);
+
+  cogl_pango_glyph_cache_find_distances (data, width, height, rowstride,
+                                         TRUE, to_outside);
+  cogl_pango_glyph_cache_find_distances (data, width, height, rowstride,
+                                         FALSE, to_inside);
+
+  for (y = 0; y < height; y++)
+    for (x = 0; x < width; x++)
+      {
+        guint8 *p = data + y * rowstride + x;
+        int pos = y * width + x;
+        float distance;
+
+        /* Partially covered pixels are on the outline so the coverage
+           gives a better estimate than the distance to the nearest
+           pixel center */
+        if (*p > 0 && *p < 255)
+          distance = *p / 255.0f - 0.5f;
+        else if (*p >= 128)
+          distance = to_outside[pos] - 0.5f;
+        else
+          distance = 0.5f - to_inside[pos];
+
+        *p = CLAMP (128.0f + distance * 127.0f
+                    / COGL_PANGO_DISTANCE_FIELD_SPREAD + 0.5f,
+                    0.0f, 255.0f);
+      }
+
+  g_free (to_outside);
+  g_free (to_inside);
+}
@@ -31,6 +31,13 @@
 
 G_BEGIN_DECLS
 
+/* When the glyph cache stores distance fields, glyphs are rasterized
+   once at this pixel size and scaled to any other size when they are
+   drawn. The distance field extends this many pixels on each side of
+   the outline of the glyph */
+#define COGL_PANGO_DISTANCE_FIELD_SIZE   32
+#define COGL_PANGO_DISTANCE_FIELD_SPREAD 4
+
 typedef struct _CoglPangoGlyphCache      CoglPangoGlyphCache;
 typedef struct _CoglPangoGlyphCacheValue CoglPangoGlyphCacheValue;
 
@@ -54,6 +61,10 @@ struct _CoglPangoGlyphCacheValue
   /* This will be set to TRUE when the glyph atlas is reorganized
      which means the glyph will need to be redrawn */
   gboolean   dirty;
+
+  /* TRUE if the texture contains a distance field instead of the
+     coverage of the glyph */
+  gboolean   distance_field;
 };
 
 typedef void (* CoglPangoGlyphCacheDirtyFunc) (PangoFont *font,
@@ -61,7 +72,7 @@ typedef void (* CoglPangoGlyphCacheDirtyFunc) (PangoFont *font,
                                                CoglPangoGlyphCacheValue *value);
 
 CoglPangoGlyphCache *
-cogl_pango_glyph_cache_new (void);
+cogl_pango_glyph_cache_new (gboolean use_distance_field);
 
 void
 cogl_pango_glyph_cache_free (CoglPangoGlyphCache *cache);
@@ -89,6 +100,16 @@ void
 _cogl_pango_glyph_cache_set_dirty_glyphs (CoglPangoGlyphCache *cache,
                                           CoglPangoGlyphCacheDirtyFunc func);
 
+float
+_cogl_pango_glyph_cache_get_scale (CoglPangoGlyphCache *cache,
+                                   PangoFont           *font);
+
+void
+_cogl_pango_glyph_cache_make_distance_field (guint8 *data,
+                                             int     width,
+                                             int     height,
+                                             int     rowstride);
+
 G_END_DECLS
 
 #endif /* __COGL_PANGO_GLYPH_CACHE_H__ */
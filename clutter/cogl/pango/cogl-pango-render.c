@@ -48,8 +48,16 @@ struct _CoglPangoRenderer
   /* The material used for solid fills. (boxes, rectangles + trapezoids) */
   CoglMaterial *solid_material;
 
+  /* The material used to render glyphs from the distance field
+     cache. This is created lazily */
+  CoglMaterial *distance_field_material;
+
   /* Caches of glyphs as textures */
   CoglPangoGlyphCache *glyph_cache;
+  /* Cache of glyphs as signed distance fields. This is only created
+     once distance fields are enabled */
+  CoglPangoGlyphCache *distance_field_cache;
+  gboolean use_distance_field;
 
   /* The current display list that is being built */
   CoglPangoDisplayList *display_list;
@@ -67,6 +75,8 @@ typedef struct _CoglPangoRendererQdata CoglPangoRendererQdata;
 struct _CoglPangoRendererQdata
 {
   CoglPangoRenderer *renderer;
+  /* The glyph cache that the display list was built from */
+  CoglPangoGlyphCache *glyph_cache;
   /* The cache of the geometry for the layout */
   CoglPangoDisplayList *display_list;
   /* A reference to the first line of the layout. This is just used to
@@ -77,18 +87,33 @@ struct _CoglPangoRendererQdata
 static void
 _cogl_pango_ensure_glyph_cache_for_layout_line (PangoLayoutLine *line);
 
+static CoglPangoGlyphCache *
+cogl_pango_renderer_get_glyph_cache (CoglPangoRenderer *priv)
+{
+  if (priv->use_distance_field)
+    {
+      if (priv->distance_field_cache == NULL)
+        priv->distance_field_cache = cogl_pango_glyph_cache_new (TRUE);
+
+      return priv->distance_field_cache;
+    }
+
+  return priv->glyph_cache;
+}
+
 static void
 cogl_pango_renderer_draw_glyph (CoglPangoRenderer        *priv,
                                 CoglPangoGlyphCacheValue *cache_value,
                                 float                     x1,
-                                float                     y1)
+                                float                     y1,
+                                float                     scale)
 {
   float x2, y2;
 
   g_return_if_fail (priv->display_list != NULL);
 
-  x2 = x1 + (float) cache_value->draw_width;
-  y2 = y1 + (float) cache_value->draw_height;
+  x2 = x1 + cache_value->draw_width * scale;
+  y2 = y1 + cache_value->draw_height * scale;
 
   _cogl_pango_display_list_add_texture (priv->display_list,
                                         cache_value->texture,
@@ -99,6 +124,120 @@ cogl_pango_renderer_draw_glyph (CoglPangoRenderer        *priv,
                                         cache_value->ty2);
 }
 
+/* Creates a program which thresholds the distance field around the
+ * outline. Where the screen space derivatives are available they give
+ * the width of the transition so that the edges stay about a pixel
+ * wide at any scale */
+static CoglHandle
+cogl_pango_renderer_create_distance_field_program (void)
+{
+  CoglHandle shader, program;
+  char *source;
+  int location;
+
+  source = g_strdup_printf (
+    "uniform sampler2D tex;\n"
+    "\n"
+    "void\n"
+    "main ()\n"
+    "{\n"
+    "  float distance = texture2D (tex, cogl_tex_coord_in[0].st).a;\n"
+#ifdef HAVE_COGL_GL
+    "  float smoothing = fwidth (distance) * 0.7;\n"
+#else
+    /* Without derivatives assume the glyphs are drawn at roughly
+       the reference size */
+    "  float smoothing = %f;\n"
+#endif
+    "  float alpha = smoothstep (0.5 - smoothing, 0.5 + smoothing,\n"
+    "                            distance);\n"
+    "  cogl_color_out = cogl_color_in * alpha;\n"
+    "}\n"
+#ifndef HAVE_COGL_GL
+    /* One pixel covers 127 / SPREAD levels of the field */
+    , 127.0 / 255.0 / COGL_PANGO_DISTANCE_FIELD_SPREAD / 2.0
+#endif
+    );
+
+  shader = cogl_create_shader (COGL_SHADER_TYPE_FRAGMENT);
+  cogl_shader_source (shader, source);
+  cogl_shader_compile (shader);
+  g_free (source);
+
+  if (!cogl_shader_is_compiled (shader))
+    {
+      char *log = cogl_shader_get_info_log (shader);
+
+      g_warning ("Unable to compile the distance field shader: %s", log);
+
+      g_free (log);
+      cogl_handle_unref (shader);
+
+      return COGL_INVALID_HANDLE;
+    }
+
+  program = cogl_create_program ();
+  cogl_program_attach_shader (program, shader);
+  cogl_program_link (program);
+  cogl_handle_unref (shader);
+
+  location = cogl_program_get_uniform_location (program, "tex");
+  cogl_program_set_uniform_1i (program, location, 0);
+
+  return program;
+}
+
+static CoglMaterial *
+cogl_pango_renderer_get_glyph_material (CoglPangoRenderer *priv)
+{
+  if (!priv->use_distance_field)
+    return priv->glyph_material;
+
+  if (priv->distance_field_material == NULL)
+    {
+      CoglMaterial *material = cogl_material_new ();
+      CoglHandle program = COGL_INVALID_HANDLE;
+
+      if (cogl_features_available (COGL_FEATURE_SHADERS_GLSL))
+        program = cogl_pango_renderer_create_distance_field_program ();
+
+      if (program != COGL_INVALID_HANDLE)
+        {
+          cogl_material_set_user_program (material, program);
+          cogl_handle_unref (program);
+        }
+      else
+        {
+          /* Without shaders we can still get a hard edge at the
+             outline by scaling the distance around 0.5 until it
+             saturates. (ADD_SIGNED computes a + b - 0.5 so each layer
+             doubles the distance from the outline) */
+          cogl_material_set_layer_combine (material, 0,
+                                           "RGBA = ADD_SIGNED (TEXTURE[A], "
+                                           "TEXTURE[A])",
+                                           NULL);
+          cogl_material_set_layer_combine (material, 1,
+                                           "RGBA = ADD_SIGNED (PREVIOUS, "
+                                           "PREVIOUS)",
+                                           NULL);
+          cogl_material_set_layer_combine (material, 2,
+                                           "RGBA = MODULATE (PRIMARY, "
+                                           "PREVIOUS[A])",
+                                           NULL);
+        }
+
+      cogl_material_set_layer_wrap_mode (material, 0,
+                                         COGL_MATERIAL_WRAP_MODE_CLAMP_TO_EDGE);
+      cogl_material_set_layer_filters (material, 0,
+                                       COGL_MATERIAL_FILTER_LINEAR,
+                                       COGL_MATERIAL_FILTER_LINEAR);
+
+      priv->distance_field_material = material;
+    }
+
+  return priv->distance_field_material;
+}
+
 static void cogl_pango_renderer_finalize (GObject *object);
 static void cogl_pango_renderer_draw_glyphs (PangoRenderer    *renderer,
                                              PangoFont        *font,
@@ -149,7 +288,7 @@ cogl_pango_renderer_init (CoglPangoRenderer *priv)
 
   priv->solid_material = cogl_material_new ();
 
-  priv->glyph_cache = cogl_pango_glyph_cache_new ();
+  priv->glyph_cache = cogl_pango_glyph_cache_new (FALSE);
 
   _cogl_pango_renderer_set_use_mipmapping (priv, FALSE);
 }
@@ -173,6 +312,11 @@ cogl_pango_renderer_finalize (GObject *object)
   CoglPangoRenderer *priv = COGL_PANGO_RENDERER (object);
 
   cogl_pango_glyph_cache_free (priv->glyph_cache);
+  if (priv->distance_field_cache)
+    cogl_pango_glyph_cache_free (priv->distance_field_cache);
+
+  if (priv->distance_field_material)
+    cogl_object_unref (priv->distance_field_material);
 
   G_OBJECT_CLASS (cogl_pango_renderer_parent_class)->finalize (object);
 }
@@ -211,7 +355,7 @@ cogl_pango_render_qdata_forget_display_list (CoglPangoRendererQdata *qdata)
   if (qdata->display_list)
     {
       _cogl_pango_glyph_cache_remove_reorganize_callback
-        (qdata->renderer->glyph_cache,
+        (qdata->glyph_cache,
          (CoglCallbackListFunc) cogl_pango_render_qdata_forget_display_list,
          qdata);
 
@@ -252,12 +396,15 @@ cogl_pango_render_layout_subpixel (PangoLayout     *layout,
   PangoContext           *context;
   CoglPangoRenderer      *priv;
   CoglPangoRendererQdata *qdata;
+  CoglPangoGlyphCache    *glyph_cache;
 
   context = pango_layout_get_context (layout);
   priv = cogl_pango_get_renderer_from_context (context);
   if (G_UNLIKELY (!priv))
     return;
 
+  glyph_cache = cogl_pango_renderer_get_glyph_cache (priv);
+
   qdata = g_object_get_qdata (G_OBJECT (layout),
                               cogl_pango_render_get_qdata_key ());
 
@@ -279,16 +426,22 @@ cogl_pango_render_layout_subpixel (PangoLayout     *layout,
       && qdata->first_line->layout != layout)
     cogl_pango_render_qdata_forget_display_list (qdata);
 
+  /* The display list also needs to be rebuilt if the glyphs should
+     now come from the other cache */
+  if (qdata->display_list && qdata->glyph_cache != glyph_cache)
+    cogl_pango_render_qdata_forget_display_list (qdata);
+
   if (qdata->display_list == NULL)
     {
       cogl_pango_ensure_glyph_cache_for_layout (layout);
 
       qdata->display_list = _cogl_pango_display_list_new ();
+      qdata->glyph_cache = glyph_cache;
 
       /* Register for notification of when the glyph cache changes so
          we can rebuild the display list */
       _cogl_pango_glyph_cache_add_reorganize_callback
-        (priv->glyph_cache,
+        (glyph_cache,
          (CoglCallbackListFunc) cogl_pango_render_qdata_forget_display_list,
          qdata);
 
@@ -301,7 +454,7 @@ cogl_pango_render_layout_subpixel (PangoLayout     *layout,
   cogl_translate (x / (gfloat) PANGO_SCALE, y / (gfloat) PANGO_SCALE, 0);
   _cogl_pango_display_list_render (qdata->display_list,
                                    color,
-                                   priv->glyph_material,
+                                   cogl_pango_renderer_get_glyph_material (priv),
                                    priv->solid_material);
   cogl_pop_matrix ();
 
@@ -378,7 +531,7 @@ cogl_pango_render_layout_line (PangoLayoutLine *line,
 
   _cogl_pango_display_list_render (priv->display_list,
                                    color,
-                                   priv->glyph_material,
+                                   cogl_pango_renderer_get_glyph_material (priv),
                                    priv->solid_material);
 
   _cogl_pango_display_list_free (priv->display_list);
@@ -389,6 +542,8 @@ void
 _cogl_pango_renderer_clear_glyph_cache (CoglPangoRenderer *renderer)
 {
   cogl_pango_glyph_cache_clear (renderer->glyph_cache);
+  if (renderer->distance_field_cache)
+    cogl_pango_glyph_cache_clear (renderer->distance_field_cache);
 }
 
 void
@@ -416,6 +571,19 @@ _cogl_pango_renderer_get_use_mipmapping (CoglPangoRenderer *renderer)
           == COGL_MATERIAL_FILTER_LINEAR_MIPMAP_LINEAR);
 }
 
+void
+_cogl_pango_renderer_set_use_distance_field (CoglPangoRenderer *renderer,
+                                             gboolean           value)
+{
+  renderer->use_distance_field = !!value;
+}
+
+gboolean
+_cogl_pango_renderer_get_use_distance_field (CoglPangoRenderer *renderer)
+{
+  return renderer->use_distance_field;
+}
+
 static CoglPangoGlyphCacheValue *
 cogl_pango_renderer_get_cached_glyph (PangoRenderer *renderer,
                                       gboolean       create,
@@ -424,7 +592,8 @@ cogl_pango_renderer_get_cached_glyph (PangoRenderer *renderer,
 {
   CoglPangoRenderer *priv = COGL_PANGO_RENDERER (renderer);
 
-  return cogl_pango_glyph_cache_lookup (priv->glyph_cache, create, font, glyph);
+  return cogl_pango_glyph_cache_lookup (cogl_pango_renderer_get_glyph_cache (priv),
+                                        create, font, glyph);
 }
 
 static void
@@ -457,6 +626,13 @@ cogl_pango_renderer_set_dirty_glyph (PangoFont *font,
   cairo_destroy (cr);
   cairo_surface_flush (surface);
 
+  if (value->distance_field)
+    _cogl_pango_glyph_cache_make_distance_field
+      (cairo_image_surface_get_data (surface),
+       value->draw_width,
+       value->draw_height,
+       cairo_image_surface_get_stride (surface));
+
   /* Copy the glyph to the texture */
   cogl_texture_set_region (value->texture,
                            0, /* src_x */
@@ -522,7 +698,8 @@ _cogl_pango_ensure_glyph_cache_for_layout_line (PangoLayoutLine *line)
   /* Now that we know all of the positions are settled we'll fill in
      any dirty glyphs */
   _cogl_pango_glyph_cache_set_dirty_glyphs
-    (priv->glyph_cache, cogl_pango_renderer_set_dirty_glyph);
+    (cogl_pango_renderer_get_glyph_cache (priv),
+     cogl_pango_renderer_set_dirty_glyph);
 }
 
 void
@@ -555,7 +732,8 @@ cogl_pango_ensure_glyph_cache_for_layout (PangoLayout *layout)
   /* Now that we know all of the positions are settled we'll fill in
      any dirty glyphs */
   _cogl_pango_glyph_cache_set_dirty_glyphs
-    (priv->glyph_cache, cogl_pango_renderer_set_dirty_glyph);
+    (cogl_pango_renderer_get_glyph_cache (priv),
+     cogl_pango_renderer_set_dirty_glyph);
 }
 
 static void
@@ -693,8 +871,15 @@ cogl_pango_renderer_draw_glyphs (PangoRenderer    *renderer,
 {
   CoglPangoRenderer *priv = (CoglPangoRenderer *) renderer;
   CoglPangoGlyphCacheValue *cache_value;
+  float scale;
   int i;
 
+  /* Glyphs from the distance field cache are stored at the reference
+     size so they need to be scaled to the size of the font */
+  scale =
+    _cogl_pango_glyph_cache_get_scale (cogl_pango_renderer_get_glyph_cache (priv),
+                                       font);
+
   cogl_pango_renderer_set_color_for_part (renderer,
 					  PANGO_RENDER_PART_FOREGROUND);
 
@@ -757,10 +942,10 @@ cogl_pango_renderer_draw_glyphs (PangoRenderer    *renderer,
             }
 	  else
 	    {
-	      x += (float)(cache_value->draw_x);
-	      y += (float)(cache_value->draw_y);
+	      x += cache_value->draw_x * scale;
+	      y += cache_value->draw_y * scale;
 
-              cogl_pango_renderer_draw_glyph (priv, cache_value, x, y);
+              cogl_pango_renderer_draw_glyph (priv, cache_value, x, y, scale);
 	    }
 	}
 
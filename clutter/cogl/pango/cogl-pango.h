@@ -50,6 +50,9 @@ void           cogl_pango_ensure_glyph_cache_for_layout (PangoLayout      *layou
 void           cogl_pango_font_map_set_use_mipmapping   (CoglPangoFontMap *fm,
                                                          gboolean          value);
 gboolean       cogl_pango_font_map_get_use_mipmapping   (CoglPangoFontMap *fm);
+void           cogl_pango_font_map_set_use_distance_field (CoglPangoFontMap *fm,
+                                                           gboolean          value);
+gboolean       cogl_pango_font_map_get_use_distance_field (CoglPangoFontMap *fm);
 PangoRenderer *cogl_pango_font_map_get_renderer         (CoglPangoFontMap *fm);
 
 #define COGL_PANGO_TYPE_RENDERER                (cogl_pango_renderer_get_type ())
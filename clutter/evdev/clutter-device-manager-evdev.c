@@ -30,6 +30,7 @@
 #include <sys/types.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <string.h>
 #include <unistd.h>
 
@@ -44,6 +45,7 @@
 #include "clutter-input-device-evdev.h"
 #include "clutter-main.h"
 #include "clutter-private.h"
+#include "clutter-profile.h"
 #include "clutter-xkb-utils.h"
 
 #include "clutter-device-manager-evdev.h"
@@ -87,6 +89,50 @@ const char *option_xkb_layout = "us";
 const char *option_xkb_variant = "";
 const char *option_xkb_options = "";
 
+/* whether the devices should be read by a dedicated thread; see
+ * _clutter_events_evdev_init()
+ */
+static gboolean use_input_thread = FALSE;
+
+/*
+ * Input thread
+ *
+ * When CLUTTER_EVDEV_INPUT_THREAD is set, each event source spawns a
+ * thread that reads the device node as soon as it becomes readable, so
+ * that the kernel buffer does not overflow while the main loop is busy
+ * painting. The thread only decodes the raw input_event structures,
+ * coalescing the relative motion between two EV_SYN, and pushes the
+ * results into a single producer, single consumer ring; the main loop
+ * is woken up through a pipe and creates the ClutterEvents from the
+ * records, as the ClutterEvent API is not thread safe.
+ */
+
+#define EVENT_RING_SIZE         512     /* must be a power of two */
+#define EVENT_RING_MASK         (EVENT_RING_SIZE - 1)
+
+/* pushed by the input thread when the device cannot be read any more */
+#define RECORD_DEVICE_ERROR     0xffff
+
+typedef struct _ClutterEvdevRecord
+{
+  guint32 time;         /* kernel timestamp, in milliseconds */
+  guint16 type;         /* EV_KEY, EV_REL or RECORD_DEVICE_ERROR */
+  guint16 code;
+  gint32 value;
+  gint32 dx, dy;        /* coalesced relative motion, for EV_REL */
+} ClutterEvdevRecord;
+
+typedef struct _ClutterEvdevRing
+{
+  ClutterEvdevRecord records[EVENT_RING_SIZE];
+
+  /* head is only written by the input thread, and tail only by the
+   * main thread; the ring is full when head is right behind tail
+   */
+  volatile gint head;
+  volatile gint tail;
+} ClutterEvdevRing;
+
 /*
  * ClutterEventSource for reading input devices
  */
@@ -102,8 +148,297 @@ struct _ClutterEventSource
   struct xkb_desc *xkb;               /* compiled xkb keymap */
   uint32_t modifier_state;            /* remember the modifier state */
   gint x, y;                          /* last x, y position for pointers */
+
+  /* only used when reading from an input thread */
+  GThread *thread;
+  ClutterEvdevRing *ring;
+  GPollFD wakeup_poll_fd;             /* read end of the wakeup pipe */
+  gint wakeup_fd;                     /* write end of the wakeup pipe */
+  gint control_fds[2];                /* used to stop the input thread */
 };
 
+static gboolean
+event_ring_push (ClutterEvdevRing         *ring,
+                 const ClutterEvdevRecord *record)
+{
+  gint head = ring->head;
+  gint next = (head + 1) & EVENT_RING_MASK;
+
+  if (next == g_atomic_int_get (&ring->tail))
+    return FALSE;
+
+  ring->records[head] = *record;
+
+  /* we are the only writer, so this always succeeds; we use it for the
+   * memory barrier, to publish the record before the new head
+   */
+  g_atomic_int_compare_and_exchange (&ring->head, head, next);
+
+  return TRUE;
+}
+
+static gboolean
+event_ring_pop (ClutterEvdevRing   *ring,
+                ClutterEvdevRecord *record)
+{
+  gint tail = ring->tail;
+
+  if (tail == g_atomic_int_get (&ring->head))
+    return FALSE;
+
+  *record = ring->records[tail];
+
+  /* same as above: release the slot only after reading it */
+  g_atomic_int_compare_and_exchange (&ring->tail, tail,
+                                     (tail + 1) & EVENT_RING_MASK);
+
+  return TRUE;
+}
+
+static void
+input_thread_wakeup (ClutterEventSource *source)
+{
+  const gchar c = 0;
+
+  /* if the pipe is full the main loop is going to wake up anyway */
+  if (write (source->wakeup_fd, &c, 1) < 0 && errno != EAGAIN)
+    g_warning ("Unable to wake up the main loop: %s", g_strerror (errno));
+}
+
+/* returns TRUE if the thread has been asked to stop, waiting at most
+ * @timeout milliseconds
+ */
+static gboolean
+input_thread_should_stop (ClutterEventSource *source,
+                          gint                timeout)
+{
+  struct pollfd control_fd;
+
+  control_fd.fd = source->control_fds[0];
+  control_fd.events = POLLIN;
+  control_fd.revents = 0;
+
+  return poll (&control_fd, 1, timeout) > 0;
+}
+
+/* pushes @record, waiting for the main thread to make room if the ring
+ * is full; returns FALSE if the thread has been asked to stop meanwhile
+ */
+static gboolean
+input_thread_push (ClutterEventSource       *source,
+                   const ClutterEvdevRecord *record)
+{
+  while (!event_ring_push (source->ring, record))
+    {
+      input_thread_wakeup (source);
+
+      if (input_thread_should_stop (source, 1))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gpointer
+input_thread_func (gpointer data)
+{
+  ClutterEventSource *source = data;
+  ClutterEvdevRecord motion = { 0, };
+  struct input_event ev[64];
+  struct pollfd fds[2];
+
+  fds[0].fd = source->event_poll_fd.fd;
+  fds[0].events = POLLIN;
+  fds[1].fd = source->control_fds[0];
+  fds[1].events = POLLIN;
+
+  motion.type = EV_REL;
+
+  while (TRUE)
+    {
+      ClutterEvdevRecord record = { 0, };
+      gboolean pushed = FALSE;
+      gint len, i;
+
+      fds[0].revents = fds[1].revents = 0;
+
+      if (poll (fds, 2, -1) < 0)
+        {
+          if (errno == EINTR)
+            continue;
+
+          goto error;
+        }
+
+      if (fds[1].revents != 0)
+        break;
+
+      len = read (fds[0].fd, &ev, sizeof (ev));
+      if (len < 0 || len % sizeof (ev[0]) != 0)
+        {
+          if (len < 0 && (errno == EAGAIN || errno == EINTR))
+            continue;
+
+          goto error;
+        }
+
+      for (i = 0; i < len / sizeof (ev[0]); i++)
+        {
+          struct input_event *e = &ev[i];
+          guint32 _time = e->time.tv_sec * 1000 + e->time.tv_usec / 1000;
+
+          switch (e->type)
+            {
+            case EV_REL:
+              /* compress the relative motion until the next EV_SYN */
+              if (e->code == REL_X)
+                motion.dx += e->value;
+              else if (e->code == REL_Y)
+                motion.dy += e->value;
+
+              motion.time = _time;
+              break;
+
+            case EV_SYN:
+              if (motion.dx != 0 || motion.dy != 0)
+                {
+                  /* if the ring is full we keep accumulating the motion
+                   * instead of blocking the reads
+                   */
+                  if (event_ring_push (source->ring, &motion))
+                    {
+                      motion.dx = motion.dy = 0;
+                      pushed = TRUE;
+                    }
+                }
+              break;
+
+            case EV_MSC:
+              break;
+
+            case EV_KEY:
+              /* don't repeat mouse buttons */
+              if (e->code >= BTN_MOUSE && e->code < KEY_OK && e->value == 2)
+                break;
+
+              /* fall through */
+            default:
+              /* keep the ordering with the pending motion */
+              if (motion.dx != 0 || motion.dy != 0)
+                {
+                  if (!input_thread_push (source, &motion))
+                    goto out;
+
+                  motion.dx = motion.dy = 0;
+                }
+
+              record.time = _time;
+              record.type = e->type;
+              record.code = e->code;
+              record.value = e->value;
+
+              if (!input_thread_push (source, &record))
+                goto out;
+
+              pushed = TRUE;
+              break;
+            }
+        }
+
+      if (pushed)
+        input_thread_wakeup (source);
+    }
+
+out:
+  return NULL;
+
+error:
+  {
+    ClutterEvdevRecord record = { 0, };
+
+    /* let the main thread remove the device */
+    record.type = RECORD_DEVICE_ERROR;
+    input_thread_push (source, &record);
+    input_thread_wakeup (source);
+  }
+
+  return NULL;
+}
+
+static gboolean
+input_thread_start (ClutterEventSource *source)
+{
+  GError *error = NULL;
+  gint wakeup_fds[2];
+
+  if (pipe (wakeup_fds) < 0)
+    {
+      g_warning ("Unable to create the input thread pipe: %s",
+                 g_strerror (errno));
+      return FALSE;
+    }
+
+  if (pipe (source->control_fds) < 0)
+    {
+      g_warning ("Unable to create the input thread pipe: %s",
+                 g_strerror (errno));
+      close (wakeup_fds[0]);
+      close (wakeup_fds[1]);
+      return FALSE;
+    }
+
+  fcntl (wakeup_fds[0], F_SETFL, O_NONBLOCK);
+  fcntl (wakeup_fds[1], F_SETFL, O_NONBLOCK);
+
+  source->wakeup_poll_fd.fd = wakeup_fds[0];
+  source->wakeup_poll_fd.events = G_IO_IN;
+  source->wakeup_fd = wakeup_fds[1];
+
+  source->ring = g_new0 (ClutterEvdevRing, 1);
+
+  source->thread = g_thread_create (input_thread_func, source, TRUE, &error);
+  if (source->thread == NULL)
+    {
+      g_warning ("Unable to create the input thread: %s", error->message);
+      g_error_free (error);
+
+      close (wakeup_fds[0]);
+      close (wakeup_fds[1]);
+      close (source->control_fds[0]);
+      close (source->control_fds[1]);
+
+      g_free (source->ring);
+      source->ring = NULL;
+
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+input_thread_stop (ClutterEventSource *source)
+{
+  const gchar c = 0;
+
+  if (source->thread == NULL)
+    return;
+
+  if (write (source->control_fds[1], &c, 1) < 0)
+    g_warning ("Unable to stop the input thread: %s", g_strerror (errno));
+
+  g_thread_join (source->thread);
+  source->thread = NULL;
+
+  close (source->wakeup_poll_fd.fd);
+  close (source->wakeup_fd);
+  close (source->control_fds[0]);
+  close (source->control_fds[1]);
+
+  g_free (source->ring);
+  source->ring = NULL;
+}
+
 static gboolean
 clutter_event_prepare (GSource *source,
                        gint    *timeout)
@@ -128,8 +463,12 @@ clutter_event_check (GSource *source)
 
   clutter_threads_enter ();
 
-  retval = ((event_source->event_poll_fd.revents & G_IO_IN) ||
-            clutter_events_pending ());
+  if (event_source->ring != NULL)
+    retval = ((event_source->wakeup_poll_fd.revents & G_IO_IN) ||
+              clutter_events_pending ());
+  else
+    retval = ((event_source->event_poll_fd.revents & G_IO_IN) ||
+              clutter_events_pending ());
 
   clutter_threads_leave ();
 
@@ -258,6 +597,124 @@ notify_button (ClutterEventSource *source,
   queue_event (event);
 }
 
+static void
+process_key (ClutterEventSource *source,
+             guint32             time_,
+             guint32             code,
+             gint32              value)
+{
+  switch (code)
+    {
+    case BTN_TOUCH:
+    case BTN_TOOL_PEN:
+    case BTN_TOOL_RUBBER:
+    case BTN_TOOL_BRUSH:
+    case BTN_TOOL_PENCIL:
+    case BTN_TOOL_AIRBRUSH:
+    case BTN_TOOL_FINGER:
+    case BTN_TOOL_MOUSE:
+    case BTN_TOOL_LENS:
+      break;
+
+    case BTN_LEFT:
+    case BTN_RIGHT:
+    case BTN_MIDDLE:
+    case BTN_SIDE:
+    case BTN_EXTRA:
+    case BTN_FORWARD:
+    case BTN_BACK:
+    case BTN_TASK:
+      notify_button (source, time_, code, value);
+      break;
+
+    default:
+      notify_key (source, time_, code, value);
+      break;
+    }
+}
+
+static void
+remove_faulty_device (ClutterEventSource *source)
+{
+  ClutterDeviceManager *manager;
+  ClutterInputDevice *device;
+  const gchar *device_path;
+
+  device = CLUTTER_INPUT_DEVICE (source->device);
+
+  if (CLUTTER_HAS_DEBUG (EVENT))
+    {
+      device_path =
+        _clutter_input_device_evdev_get_device_path (source->device);
+
+      CLUTTER_NOTE (EVENT, "Could not read device (%s), removing.",
+                    device_path);
+    }
+
+  /* remove the faulty device */
+  manager = clutter_device_manager_get_default ();
+  _clutter_device_manager_remove_device (manager, device);
+}
+
+/* creates the ClutterEvents for the records pushed by the input thread;
+ * returns FALSE if the device has been removed
+ */
+static gboolean
+process_records (ClutterEventSource *source)
+{
+  ClutterEvdevRecord record;
+  gchar buf[64];
+
+  /* drain the wakeup pipe before the ring, so that we get woken up
+   * again for the records pushed after this point
+   */
+  while (read (source->wakeup_poll_fd.fd, buf, sizeof (buf)) > 0)
+    ;
+
+  while (event_ring_pop (source->ring, &record))
+    {
+      switch (record.type)
+        {
+        case EV_KEY:
+          process_key (source, record.time, record.code, record.value);
+          break;
+
+        case EV_REL:
+          notify_motion (source, record.time,
+                         source->x + record.dx,
+                         source->y + record.dy);
+          break;
+
+        case RECORD_DEVICE_ERROR:
+          remove_faulty_device (source);
+          return FALSE;
+
+        default:
+          g_warning ("Unhandled event of type %d", record.type);
+          break;
+        }
+    }
+
+  return TRUE;
+}
+
+#ifdef CLUTTER_ENABLE_PROFILE
+static void
+profile_event_latency (ClutterEvent *event)
+{
+  GTimeVal now;
+  guint32 now_ms;
+
+  /* the time of the events is the kernel timestamp, which uses the
+   * wall clock and wraps around like the event time
+   */
+  g_get_current_time (&now);
+  now_ms = now.tv_sec * 1000 + now.tv_usec / 1000;
+
+  _clutter_profile_input_latency (now_ms - clutter_event_get_time (event));
+}
+#endif /* CLUTTER_ENABLE_PROFILE */
+
 static gboolean
 clutter_event_dispatch (GSource     *g_source,
                         GSourceFunc  callback,
@@ -271,35 +728,24 @@ clutter_event_dispatch (GSource     *g_source,
 
   clutter_threads_enter ();
 
+  /* The input thread keeps reading the device, so we can always
+   * queue the events it decoded
+   */
+  if (source->ring != NULL)
+    {
+      if (!process_records (source))
+        goto out;
+    }
   /* Don't queue more events if we haven't finished handling the previous batch
    */
-  if (!clutter_events_pending ())
+  else if (!clutter_events_pending ())
     {
        len = read (source->event_poll_fd.fd, &ev, sizeof (ev));
        if (len < 0 || len % sizeof (ev[0]) != 0)
        {
          if (errno != EAGAIN)
-           {
-             ClutterDeviceManager *manager;
-             ClutterInputDevice *device;
-             const gchar *device_path;
+           remove_faulty_device (source);
 
-             device = CLUTTER_INPUT_DEVICE (source->device);
-
-             if (CLUTTER_HAS_DEBUG (EVENT))
-               {
-                 device_path =
-                   _clutter_input_device_evdev_get_device_path (source->device);
-
-                 CLUTTER_NOTE (EVENT, "Could not read device (%s), removing.",
-                               device_path);
-               }
-
-             /* remove the faulty device */
-             manager = clutter_device_manager_get_default ();
-             _clutter_device_manager_remove_device (manager, device);
-
-           }
          goto out;
        }
 
@@ -319,34 +765,7 @@ clutter_event_dispatch (GSource     *g_source,
                  if (e->value == 2)
                    continue;
 
-               switch (e->code)
-                 {
-                 case BTN_TOUCH:
-                 case BTN_TOOL_PEN:
-                 case BTN_TOOL_RUBBER:
-                 case BTN_TOOL_BRUSH:
-                 case BTN_TOOL_PENCIL:
-                 case BTN_TOOL_AIRBRUSH:
-                 case BTN_TOOL_FINGER:
-                 case BTN_TOOL_MOUSE:
-                 case BTN_TOOL_LENS:
-                   break;
-
-                 case BTN_LEFT:
-                 case BTN_RIGHT:
-                 case BTN_MIDDLE:
-                 case BTN_SIDE:
-                 case BTN_EXTRA:
-                 case BTN_FORWARD:
-                 case BTN_BACK:
-                 case BTN_TASK:
-                   notify_button(source, _time, e->code, e->value);
-                   break;
-
-                 default:
-                   notify_key (source, _time, e->code, e->value);
-                 break;
-                 }
+               process_key (source, _time, e->code, e->value);
                break;
 
              case EV_SYN:
@@ -388,9 +807,12 @@ clutter_event_dispatch (GSource     *g_source,
 
   if (event)
     {
+#ifdef CLUTTER_ENABLE_PROFILE
+      profile_event_latency (event);
+#endif
+
       /* forward the event into clutter for emission etc. */
-      clutter_do_event (event);
-      clutter_event_free (event);
+      _clutter_do_event_take (event);
     }
 
 out:
@@ -465,9 +887,19 @@ clutter_event_source_new (ClutterInputDeviceEvdev *input_device)
       event_source->y = (gint) stage_height / 2;
     }
 
+  /* the main loop polls the input thread instead of the device */
+  if (use_input_thread && input_thread_start (event_source))
+    {
+      CLUTTER_NOTE (EVENT, "Reading device %s from an input thread",
+                    node_path);
+
+      g_source_add_poll (source, &event_source->wakeup_poll_fd);
+    }
+  else
+    g_source_add_poll (source, &event_source->event_poll_fd);
+
   /* and finally configure and attach the GSource */
   g_source_set_priority (source, CLUTTER_PRIORITY_EVENTS);
-  g_source_add_poll (source, &event_source->event_poll_fd);
   g_source_set_can_recurse (source, TRUE);
   g_source_attach (source, NULL);
 
@@ -484,6 +916,9 @@ clutter_event_source_free (ClutterEventSource *source)
 
   CLUTTER_NOTE (EVENT, "Removing GSource for device %s", node_path);
 
+  /* the thread must not read the device after we close it */
+  input_thread_stop (source);
+
   /* ignore the return value of close, it's not like we can do something
    * about it */
   close (source->event_poll_fd.fd);
@@ -859,8 +1294,21 @@ clutter_device_manager_evdev_init (ClutterDeviceManagerEvdev *self)
 void
 _clutter_events_evdev_init (ClutterBackend *backend)
 {
+  const gchar *env_string;
+
   CLUTTER_NOTE (EVENT, "Initializing evdev backend");
 
+  env_string = g_getenv ("CLUTTER_EVDEV_INPUT_THREAD");
+  if (env_string != NULL && g_strcmp0 (env_string, "0") != 0)
+    {
+      if (g_thread_supported ())
+        use_input_thread = TRUE;
+      else
+        g_warning ("CLUTTER_EVDEV_INPUT_THREAD is set, but threads have "
+                   "not been initialized; reading the devices from the "
+                   "main loop");
+    }
+
   /* We just have to create the singleon here */
   clutter_device_manager_get_default ();
 }
@@ -163,8 +163,11 @@ clutter_backend_glx_dispose (GObject *gobject)
   ClutterBackendGLX *backend_glx = CLUTTER_BACKEND_GLX (gobject);
   ClutterBackendX11 *backend_x11 = CLUTTER_BACKEND_X11 (gobject);
 
-  /* Unrealize all shaders, since the GL context is going away */
+  /* Unrealize all shaders and release the offscreen targets, since
+   * the GL context is going away
+   */
   _clutter_shader_release_all ();
+  _clutter_context_free_offscreen_pool ();
 
   if (backend_glx->gl_context)
     {
@@ -228,6 +228,7 @@ clutter_backend_osx_dispose (GObject *object)
   ClutterBackendOSX *self = CLUTTER_BACKEND_OSX (object);
 
   _clutter_shader_release_all ();
+  _clutter_context_free_offscreen_pool ();
 
   [self->context release];
   self->context = NULL;
@@ -33,6 +33,7 @@
 #include <sys/uio.h>
 #include <unistd.h>
 #include <clutter/clutter-debug.h>
+#include <clutter/clutter-event-private.h>
 
 /* 
  * This file implementations integration between the GLib main loop and
@@ -707,8 +708,7 @@ clutter_event_dispatch (GSource     *source,
   if (event)
     {
       /* forward the event into clutter for emission etc. */
-      clutter_do_event (event);
-      clutter_event_free (event);
+      _clutter_do_event_take (event);
     }
 
   clutter_threads_leave ();
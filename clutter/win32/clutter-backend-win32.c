@@ -136,8 +136,11 @@ clutter_backend_win32_dispose (GObject *gobject)
   CLUTTER_NOTE (BACKEND, "Removing the event source");
   _clutter_backend_win32_events_uninit (CLUTTER_BACKEND (backend_win32));
 
-  /* Unrealize all shaders, since the GL context is going away */
+  /* Unrealize all shaders and release the offscreen targets, since
+   * the GL context is going away
+   */
   _clutter_shader_release_all ();
+  _clutter_context_free_offscreen_pool ();
 
   if (backend_win32->gl_context)
     {
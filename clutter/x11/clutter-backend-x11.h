@@ -135,13 +135,7 @@ void
 _clutter_x11_select_events (Window xwin);
 
 ClutterEventX11 *
-_clutter_event_x11_new (void);
-
-ClutterEventX11 *
-_clutter_event_x11_copy (ClutterEventX11 *event_x11);
-
-void
-_clutter_event_x11_free (ClutterEventX11 *event_x11);
+_clutter_event_x11_new (ClutterEvent *event);
 
 gboolean
 _clutter_x11_input_device_translate_screen_coord (ClutterInputDevice *device,
@@ -225,8 +225,7 @@ translate_key_event (ClutterBackendX11       *backend_x11,
   clutter_event_set_device (event, manager_x11->core_keyboard);
 
   /* KeyEvents have platform specific data associated to them */
-  event_x11 = _clutter_event_x11_new ();
-  _clutter_event_set_platform_data (event, event_x11);
+  event_x11 = _clutter_event_x11_new (event);
 
   event->key.modifier_state = (ClutterModifierType) xevent->xkey.state;
   event->key.hardware_keycode = xevent->xkey.keycode;
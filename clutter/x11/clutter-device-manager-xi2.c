@@ -641,8 +641,7 @@ clutter_device_manager_xi2_translate_event (ClutterEventTranslator *translator,
                                                    NULL);
 
         /* KeyEvents have platform specific data associated to them */
-        event_x11 = _clutter_event_x11_new ();
-        _clutter_event_set_platform_data (event, event_x11);
+        event_x11 = _clutter_event_x11_new (event);
 
         event_x11->key_group =
           _clutter_keymap_x11_get_key_group (backend_x11->keymap,
@@ -71,26 +71,11 @@ struct _ClutterEventSource
   GPollFD event_poll_fd;
 };
 
+/* the platform data is owned by @event, and it is stored inside it */
 ClutterEventX11 *
-_clutter_event_x11_new (void)
+_clutter_event_x11_new (ClutterEvent *event)
 {
-  return g_slice_new0 (ClutterEventX11);
-}
-
-ClutterEventX11 *
-_clutter_event_x11_copy (ClutterEventX11 *event_x11)
-{
-  if (event_x11 != NULL)
-    return g_slice_dup (ClutterEventX11, event_x11);
-
-  return NULL;
-}
-
-void
-_clutter_event_x11_free (ClutterEventX11 *event_x11)
-{
-  if (event_x11 != NULL)
-    g_slice_free (ClutterEventX11, event_x11);
+  return _clutter_event_alloc_platform_data (event, sizeof (ClutterEventX11));
 }
 
 static gboolean clutter_event_prepare  (GSource     *source,
@@ -317,8 +302,7 @@ clutter_x11_handle_event (XEvent *xevent)
   while (spin > 0 && (event = clutter_event_get ()))
     {
       /* forward the event into clutter for emission etc. */
-      clutter_do_event (event);
-      clutter_event_free (event);
+      _clutter_do_event_take (event);
       --spin;
     }
 
@@ -384,8 +368,7 @@ clutter_event_dispatch (GSource     *source,
   if (event != NULL)
     {
       /* forward the event into clutter for emission etc. */
-      clutter_do_event (event);
-      clutter_event_free (event);
+      _clutter_do_event_take (event);
     }
 
   clutter_threads_leave ();
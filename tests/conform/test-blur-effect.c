@@ -0,0 +1,123 @@
+#include <clutter/clutter.h>
+#include <cogl/cogl.h>
+#include <string.h>
+
+#include "test-conform-common.h"
+
+static const ClutterColor stage_color = { 0x00, 0x00, 0x00, 0xff };
+static const ClutterColor rect_color = { 0xff, 0x00, 0x00, 0xff };
+
+#define RECT_X      50
+#define RECT_Y      50
+#define RECT_SIZE   100
+#define BLUR_RADIUS 10.0
+
+typedef struct _TestState
+{
+  ClutterActor *rect;
+  gboolean was_painted;
+} TestState;
+
+static guint8
+get_red (int x, int y)
+{
+  guint8 pixel[4];
+
+  cogl_read_pixels (x, y, 1, 1,
+                    COGL_READ_PIXELS_COLOR_BUFFER,
+                    COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                    pixel);
+
+  return pixel[0];
+}
+
+static void
+on_paint (ClutterActor *stage, TestState *state)
+{
+  ClutterActorBox box;
+  guint8 inside, edge, outside;
+
+  /* The paint box should grow by the radius in every direction */
+  g_assert (clutter_actor_get_paint_box (state->rect, &box));
+
+  if (g_test_verbose ())
+    g_print ("paint box = (%.0f, %.0f) - (%.0f, %.0f)\n",
+             box.x1, box.y1, box.x2, box.y2);
+
+  g_assert_cmpfloat (ABS (box.x1 - (RECT_X - BLUR_RADIUS)), <=, 1.0);
+  g_assert_cmpfloat (ABS (box.y1 - (RECT_Y - BLUR_RADIUS)), <=, 1.0);
+  g_assert_cmpfloat (ABS (box.x2 - (RECT_X + RECT_SIZE + BLUR_RADIUS)), <=, 1.0);
+  g_assert_cmpfloat (ABS (box.y2 - (RECT_Y + RECT_SIZE + BLUR_RADIUS)), <=, 1.0);
+
+  /* The middle of the rectangle is not affected by the blur, while
+     its edges should bleed outside of it */
+  inside = get_red (RECT_X + RECT_SIZE / 2, RECT_Y + RECT_SIZE / 2);
+  edge = get_red (RECT_X + 1, RECT_Y + RECT_SIZE / 2);
+  outside = get_red (RECT_X - 3, RECT_Y + RECT_SIZE / 2);
+
+  if (g_test_verbose ())
+    g_print ("inside = 0x%02x, edge = 0x%02x, outside = 0x%02x\n",
+             inside, edge, outside);
+
+  g_assert_cmpint (inside, >=, 0xf0);
+  g_assert_cmpint (edge, <, inside);
+  g_assert_cmpint (outside, >, 0);
+  g_assert_cmpint (outside, <, edge);
+
+  state->was_painted = TRUE;
+
+  /* Comment this out if you want visual feedback for what this test paints */
+#if 1
+  clutter_main_quit ();
+#endif
+}
+
+void
+blur_effect_radius (TestConformSimpleFixture *fixture,
+                    gconstpointer data)
+{
+  TestState state;
+  ClutterActor *stage;
+  ClutterEffect *effect;
+
+  if (!clutter_feature_available (CLUTTER_FEATURE_OFFSCREEN) ||
+      !clutter_feature_available (CLUTTER_FEATURE_SHADERS_GLSL))
+    {
+      if (g_test_verbose ())
+        g_print ("Offscreen buffers or GLSL are not supported; skipping\n");
+
+      return;
+    }
+
+  memset (&state, 0, sizeof (state));
+
+  stage = clutter_stage_get_default ();
+  clutter_stage_set_color (CLUTTER_STAGE (stage), &stage_color);
+
+  state.rect = clutter_rectangle_new_with_color (&rect_color);
+  clutter_actor_set_position (state.rect, RECT_X, RECT_Y);
+  clutter_actor_set_size (state.rect, RECT_SIZE, RECT_SIZE);
+  clutter_container_add_actor (CLUTTER_CONTAINER (stage), state.rect);
+
+  effect = clutter_blur_effect_new ();
+  clutter_blur_effect_set_radius (CLUTTER_BLUR_EFFECT (effect), BLUR_RADIUS);
+  g_assert_cmpfloat (clutter_blur_effect_get_radius (CLUTTER_BLUR_EFFECT (effect)),
+                     ==,
+                     BLUR_RADIUS);
+  clutter_actor_add_effect (state.rect, effect);
+
+  g_signal_connect_after (stage, "paint", G_CALLBACK (on_paint), &state);
+
+  clutter_actor_show_all (stage);
+
+  clutter_main ();
+
+  g_assert (state.was_painted);
+
+  g_signal_handlers_disconnect_by_func (stage, on_paint, &state);
+
+  clutter_actor_destroy (state.rect);
+
+  if (g_test_verbose ())
+    g_print ("OK\n");
+}
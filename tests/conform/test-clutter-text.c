@@ -410,3 +410,46 @@ text_event (void)
   clutter_actor_destroy (CLUTTER_ACTOR (text));
 }
 
+void
+text_shared_layout (void)
+{
+  ClutterText *text_a = CLUTTER_TEXT (clutter_text_new ());
+  ClutterText *text_b = CLUTTER_TEXT (clutter_text_new ());
+  PangoLayout *layout_a, *layout_b;
+
+  clutter_text_set_shared_layout (text_a, TRUE);
+  clutter_text_set_shared_layout (text_b, TRUE);
+
+  clutter_text_set_font_name (text_a, "Sans 12px");
+  clutter_text_set_font_name (text_b, "Sans 12px");
+
+  clutter_text_set_text (text_a, "Play");
+  clutter_text_set_text (text_b, "Play");
+
+  /* identical contents share the same layout */
+  layout_a = clutter_text_get_layout (text_a);
+  layout_b = clutter_text_get_layout (text_b);
+  g_assert (layout_a == layout_b);
+
+  /* different contents do not */
+  clutter_text_set_text (text_b, "Pause");
+  layout_b = clutter_text_get_layout (text_b);
+  g_assert (layout_a != layout_b);
+  g_assert_cmpstr (pango_layout_get_text (layout_a), ==, "Play");
+  g_assert_cmpstr (pango_layout_get_text (layout_b), ==, "Pause");
+
+  /* neither do different attributes */
+  clutter_text_set_text (text_b, "Play");
+  clutter_text_set_markup (text_b, "<b>Play</b>");
+  layout_b = clutter_text_get_layout (text_b);
+  g_assert (layout_a != layout_b);
+
+  /* the layout is not shared anymore once the actor opts out */
+  clutter_text_set_text (text_b, "Play");
+  clutter_text_set_shared_layout (text_b, FALSE);
+  layout_b = clutter_text_get_layout (text_b);
+  g_assert (layout_a != layout_b);
+
+  clutter_actor_destroy (CLUTTER_ACTOR (text_a));
+  clutter_actor_destroy (CLUTTER_ACTOR (text_b));
+}
@@ -0,0 +1,226 @@
+#include <clutter/clutter.h>
+#include <math.h>
+#include <string.h>
+
+#include "test-conform-common.h"
+
+/* The matrix functions may use SIMD instructions selected when the
+ * context is created. They are checked against plain double precision
+ * versions written here, allowing for the rounding errors of single
+ * precision floats */
+
+#define N_MATRICES 256
+#define N_POINTS   17
+
+typedef struct _TestState
+{
+  GRand *rand;
+} TestState;
+
+static gboolean
+float_equal (double expected, float value)
+{
+  return fabs (expected - value) <= 1e-4 * (1.0 + fabs (expected));
+}
+
+static void
+random_matrix (TestState *state, CoglMatrix *matrix)
+{
+  float array[16];
+  int i;
+
+  for (i = 0; i < 16; i++)
+    array[i] = g_rand_double_range (state->rand, -2.0, 2.0);
+
+  /* make the matrix diagonally dominant so that it is far from being
+   * singular and the inverse is well defined */
+  for (i = 0; i < 4; i++)
+    array[i * 4 + i] += 10.0f;
+
+  cogl_matrix_init_from_array (matrix, array);
+}
+
+static void
+reference_multiply (double *result, const float *a, const float *b)
+{
+  int row, col, k;
+
+  for (col = 0; col < 4; col++)
+    for (row = 0; row < 4; row++)
+      {
+        result[col * 4 + row] = 0.0;
+        for (k = 0; k < 4; k++)
+          result[col * 4 + row] += (double) a[k * 4 + row] * b[col * 4 + k];
+      }
+}
+
+static void
+check_multiply (TestState *state)
+{
+  int i, j;
+
+  for (i = 0; i < N_MATRICES; i++)
+    {
+      CoglMatrix a, b, result;
+      double expected[16];
+
+      random_matrix (state, &a);
+      random_matrix (state, &b);
+
+      reference_multiply (expected,
+                          cogl_matrix_get_array (&a),
+                          cogl_matrix_get_array (&b));
+
+      cogl_matrix_multiply (&result, &a, &b);
+      for (j = 0; j < 16; j++)
+        g_assert (float_equal (expected[j],
+                               cogl_matrix_get_array (&result)[j]));
+
+      /* the result can be the same matrix as the left hand side */
+      cogl_matrix_multiply (&a, &a, &b);
+      for (j = 0; j < 16; j++)
+        g_assert (float_equal (expected[j],
+                               cogl_matrix_get_array (&a)[j]));
+    }
+}
+
+static void
+check_inverse (TestState *state)
+{
+  /* two identical columns; all the values are small integers so the
+   * determinant is exactly zero whatever the order of the operations */
+  static const float singular_array[16] = {
+    1, 2, 3, 4,
+    1, 2, 3, 4,
+    5, 6, 7, 9,
+    2, 1, 0, 3
+  };
+  CoglMatrix singular, inverse;
+  int i, j;
+
+  for (i = 0; i < N_MATRICES; i++)
+    {
+      CoglMatrix matrix;
+      double product[16];
+
+      random_matrix (state, &matrix);
+
+      g_assert (cogl_matrix_get_inverse (&matrix, &inverse));
+
+      reference_multiply (product,
+                          cogl_matrix_get_array (&matrix),
+                          cogl_matrix_get_array (&inverse));
+
+      for (j = 0; j < 16; j++)
+        g_assert (float_equal (j % 5 == 0 ? 1.0 : 0.0, product[j]));
+    }
+
+  cogl_matrix_init_from_array (&singular, singular_array);
+  g_assert (!cogl_matrix_get_inverse (&singular, &inverse));
+}
+
+static void
+check_points (TestState *state,
+              const CoglMatrix *matrix,
+              int n_components_in,
+              int n_components_out,
+              gboolean in_place)
+{
+  float points_in[N_POINTS * 5];
+  float points_out[N_POINTS * 5];
+  const float *m = cogl_matrix_get_array (matrix);
+  size_t stride_in, stride_out;
+  int i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (points_in); i++)
+    points_in[i] = g_rand_double_range (state->rand, -10.0, 10.0);
+
+  memcpy (points_out, points_in, sizeof (points_out));
+
+  if (in_place)
+    {
+      /* tightly packed points, where writing more than the size of a
+       * point would overwrite the next one before it is read */
+      stride_in = sizeof (float) * n_components_out;
+      stride_out = stride_in;
+    }
+  else
+    {
+      /* leave a gap after each point to check the strides */
+      stride_in = sizeof (float) * (n_components_in + 1);
+      stride_out = sizeof (float) * 5;
+    }
+
+  if (n_components_out == 3)
+    cogl_matrix_transform_points (matrix, n_components_in,
+                                  stride_in, in_place ? points_out : points_in,
+                                  stride_out, points_out,
+                                  N_POINTS);
+  else
+    cogl_matrix_project_points (matrix, n_components_in,
+                                stride_in, in_place ? points_out : points_in,
+                                stride_out, points_out,
+                                N_POINTS);
+
+  for (i = 0; i < N_POINTS; i++)
+    {
+      const float *p = (const float *) ((guint8 *) points_in + i * stride_in);
+      const float *o = (const float *) ((guint8 *) points_out +
+                                        i * stride_out);
+      double in[4] = { p[0], p[1], 0.0, 1.0 };
+
+      if (n_components_in >= 3)
+        in[2] = p[2];
+      if (n_components_in == 4)
+        in[3] = p[3];
+
+      for (j = 0; j < n_components_out; j++)
+        {
+          double expected = (m[j] * in[0] +
+                             m[4 + j] * in[1] +
+                             m[8 + j] * in[2] +
+                             m[12 + j] * in[3]);
+
+          g_assert (float_equal (expected, o[j]));
+        }
+
+      /* the padding after each point must not be touched */
+      if (!in_place)
+        for (j = n_components_out; j < 5; j++)
+          g_assert_cmpfloat (o[j], ==, points_in[i * 5 + j]);
+    }
+}
+
+void
+test_cogl_matrix (TestConformSimpleFixture *fixture,
+                  gconstpointer data)
+{
+  TestState state;
+  int i;
+
+  state.rand = g_rand_new_with_seed (42);
+
+  check_multiply (&state);
+  check_inverse (&state);
+
+  for (i = 0; i < N_MATRICES; i++)
+    {
+      CoglMatrix matrix;
+
+      random_matrix (&state, &matrix);
+
+      check_points (&state, &matrix, 2, 3, FALSE);
+      check_points (&state, &matrix, 3, 3, FALSE);
+      check_points (&state, &matrix, 2, 4, FALSE);
+      check_points (&state, &matrix, 3, 4, FALSE);
+      check_points (&state, &matrix, 4, 4, FALSE);
+
+      check_points (&state, &matrix, 3, 3, TRUE);
+      check_points (&state, &matrix, 4, 4, TRUE);
+    }
+
+  g_rand_free (state.rand);
+
+  if (g_test_verbose ())
+    g_print ("OK\n");
+}
@@ -161,6 +161,8 @@ main (int argc, char **argv)
   TEST_CONFORM_SIMPLE ("/text", text_get_chars);
   TEST_CONFORM_SIMPLE ("/text", text_cache);
   TEST_CONFORM_SIMPLE ("/text", text_password_char);
+  TEST_CONFORM_SIMPLE ("/text", text_shared_layout);
+  TEST_CONFORM_SIMPLE ("/text", text_distance_field);
 
   TEST_CONFORM_SIMPLE ("/rectangle", test_rect_set_size);
   TEST_CONFORM_SIMPLE ("/rectangle", test_rect_set_color);
@@ -176,6 +178,7 @@ main (int argc, char **argv)
   TEST_CONFORM_SIMPLE ("/model", test_list_model_populate);
   TEST_CONFORM_SIMPLE ("/model", test_list_model_iterate);
   TEST_CONFORM_SIMPLE ("/model", test_list_model_filter);
+  TEST_CONFORM_SIMPLE ("/model", test_list_model_background_sort);
   TEST_CONFORM_SIMPLE ("/model", test_list_model_from_script);
 
   TEST_CONFORM_SIMPLE ("/color", test_color_from_string);
@@ -189,6 +192,9 @@ main (int argc, char **argv)
 
   TEST_CONFORM_SIMPLE ("/group", test_group_depth_sorting);
 
+  TEST_CONFORM_SIMPLE ("/effect", offscreen_effect_cache);
+  TEST_CONFORM_SIMPLE ("/effect", blur_effect_radius);
+
   TEST_CONFORM_SIMPLE ("/script", test_script_single);
   TEST_CONFORM_SIMPLE ("/script", test_script_child);
   TEST_CONFORM_SIMPLE ("/script", test_script_implicit_alpha);
@@ -200,6 +206,7 @@ main (int argc, char **argv)
   TEST_CONFORM_SIMPLE ("/script", test_animator_multi_properties);
   TEST_CONFORM_SIMPLE ("/script", test_state_base);
   TEST_CONFORM_SIMPLE ("/script", test_script_layout_property);
+  TEST_CONFORM_SIMPLE ("/script", test_script_compiled);
 
   TEST_CONFORM_SIMPLE ("/timeline", test_timeline);
   TEST_CONFORM_SKIP (!g_test_slow (), "/timeline", timeline_interpolation);
@@ -219,6 +226,7 @@ main (int argc, char **argv)
   TEST_CONFORM_SIMPLE ("/cogl", test_cogl_readpixels);
   TEST_CONFORM_SIMPLE ("/cogl", test_cogl_path);
   TEST_CONFORM_SIMPLE ("/cogl", test_cogl_depth_test);
+  TEST_CONFORM_SIMPLE ("/cogl", test_cogl_matrix);
 
   TEST_CONFORM_SIMPLE ("/cogl/texture", test_cogl_npot_texture);
   TEST_CONFORM_SIMPLE ("/cogl/texture", test_cogl_multitexture);
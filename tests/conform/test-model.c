@@ -353,6 +353,125 @@ test_list_model_populate (TestConformSimpleFixture *fixture,
   g_object_unref (test_data.model);
 }
 
+static gint
+compare_bar_values (ClutterModel *model,
+                    const GValue *a,
+                    const GValue *b,
+                    gpointer      dummy G_GNUC_UNUSED)
+{
+  return g_value_get_int (a) - g_value_get_int (b);
+}
+
+static gboolean
+check_sorted_rows (ClutterModel *model,
+                   gint          expected_rows)
+{
+  ClutterModelIter *iter;
+  gint last_bar = G_MININT;
+  gint n_rows = 0;
+  gboolean sorted = TRUE;
+
+  iter = clutter_model_get_first_iter (model);
+  while (!clutter_model_iter_is_last (iter))
+    {
+      gint bar = 0;
+
+      clutter_model_iter_get (iter, COLUMN_BAR, &bar, -1);
+      if (bar < last_bar)
+        sorted = FALSE;
+
+      last_bar = bar;
+      n_rows += 1;
+
+      iter = clutter_model_iter_next (iter);
+    }
+
+  g_object_unref (iter);
+
+  return sorted && n_rows == expected_rows;
+}
+
+static void
+on_sort_changed (ClutterModel *model,
+                 gint         *n_sort_changed)
+{
+  /* the new order is applied before the signal is emitted */
+  g_assert (check_sorted_rows (model, 2000));
+
+  *n_sort_changed += 1;
+}
+
+void
+test_list_model_background_sort (TestConformSimpleFixture *fixture,
+                                 gconstpointer             data)
+{
+  ClutterModel *model;
+  const guint filter_columns[] = { COLUMN_BAR };
+  gint n_sort_changed = 0;
+  gint i;
+
+  model = clutter_list_model_new (N_COLUMNS,
+                                  G_TYPE_STRING, "Foo",
+                                  G_TYPE_INT,    "Bar");
+  clutter_list_model_set_background_sort (CLUTTER_LIST_MODEL (model), TRUE);
+  g_assert (clutter_list_model_get_background_sort (CLUTTER_LIST_MODEL (model)));
+
+  /* enough rows to go through the worker threads */
+  for (i = 2000; i > 0; i--)
+    {
+      gchar *foo = g_strdup_printf ("String %d", i);
+
+      clutter_model_append (model,
+                            COLUMN_FOO, foo,
+                            COLUMN_BAR, i,
+                            -1);
+
+      g_free (foo);
+    }
+
+  g_signal_connect (model, "sort-changed",
+                    G_CALLBACK (on_sort_changed),
+                    &n_sort_changed);
+
+  clutter_model_set_sort (model, COLUMN_BAR, compare_bar_values, NULL, NULL);
+
+  /* without threading support the sort is synchronous */
+  while (!check_sorted_rows (model, 2000))
+    g_main_context_iteration (NULL, TRUE);
+
+  while (g_main_context_pending (NULL))
+    g_main_context_iteration (NULL, FALSE);
+
+  /* the sort is only announced once, after the rows have moved */
+  g_assert_cmpint (n_sort_changed, ==, 1);
+
+  g_signal_handlers_disconnect_by_func (model,
+                                        on_sort_changed,
+                                        &n_sort_changed);
+
+  if (g_test_verbose ())
+    g_print ("Sorted 2000 rows, filtering odd rows...\n");
+
+  clutter_list_model_set_filter_columns (CLUTTER_LIST_MODEL (model),
+                                         G_N_ELEMENTS (filter_columns),
+                                         filter_columns);
+  clutter_model_set_filter (model, filter_odd_rows, NULL, NULL);
+
+  /* the filter results do not depend on the background job */
+  g_assert (check_sorted_rows (model, 1000));
+
+  while (g_main_context_pending (NULL))
+    g_main_context_iteration (NULL, FALSE);
+
+  g_assert (check_sorted_rows (model, 1000));
+
+  /* changing a row drops its cached filter result */
+  clutter_model_insert_value (model, 0, COLUMN_BAR, 0);
+  g_assert (check_sorted_rows (model, 999));
+
+  g_object_unref (model);
+}
+
 void
 test_list_model_from_script (TestConformSimpleFixture *fixture,
                              gconstpointer dummy)
@@ -0,0 +1,217 @@
+#include <clutter/clutter.h>
+#include <string.h>
+
+#include "test-conform-common.h"
+
+static const ClutterColor stage_color = { 0x00, 0x00, 0x00, 0xff };
+static const ClutterColor red = { 0xff, 0x00, 0x00, 0xff };
+static const ClutterColor green = { 0x00, 0xff, 0x00, 0xff };
+static const ClutterColor blue = { 0x00, 0x00, 0xff, 0xff };
+
+/* A trivial offscreen effect counting how many times the contents of
+   its offscreen buffer are painted */
+typedef struct _CountEffect      CountEffect;
+typedef struct _CountEffectClass CountEffectClass;
+
+struct _CountEffect
+{
+  ClutterOffscreenEffect parent_instance;
+
+  guint n_target_paints;
+};
+
+struct _CountEffectClass
+{
+  ClutterOffscreenEffectClass parent_class;
+};
+
+static GType count_effect_get_type (void);
+
+G_DEFINE_TYPE (CountEffect, count_effect, CLUTTER_TYPE_OFFSCREEN_EFFECT);
+
+static void
+count_effect_paint_target (ClutterOffscreenEffect *effect)
+{
+  ClutterOffscreenEffectClass *parent_class =
+    CLUTTER_OFFSCREEN_EFFECT_CLASS (count_effect_parent_class);
+
+  ((CountEffect *) effect)->n_target_paints++;
+
+  parent_class->paint_target (effect);
+}
+
+static void
+count_effect_class_init (CountEffectClass *klass)
+{
+  ClutterOffscreenEffectClass *offscreen_class =
+    CLUTTER_OFFSCREEN_EFFECT_CLASS (klass);
+
+  offscreen_class->paint_target = count_effect_paint_target;
+}
+
+static void
+count_effect_init (CountEffect *self)
+{
+}
+
+typedef enum
+{
+  /* the first paint always redirects the actor */
+  STEP_FIRST_PAINT,
+  /* only a sibling overlapping the group changes, so the offscreen
+     buffer should be reused */
+  STEP_SIBLING_CHANGED,
+  /* a child of the group changes, so the group needs to be
+     redirected again */
+  STEP_CHILD_CHANGED,
+  STEP_DONE
+} TestStep;
+
+typedef struct _TestState
+{
+  ClutterActor *stage;
+  ClutterActor *group;
+  ClutterActor *child;
+  ClutterActor *sibling;
+  CountEffect *effect;
+
+  TestStep step;
+  guint step_idle;
+
+  guint n_child_paints;
+  guint last_n_child_paints;
+  guint last_n_target_paints;
+} TestState;
+
+static void
+on_child_paint (ClutterActor *actor,
+                TestState    *state)
+{
+  state->n_child_paints++;
+}
+
+static gboolean
+next_step (gpointer data)
+{
+  TestState *state = data;
+
+  state->step_idle = 0;
+
+  switch (state->step)
+    {
+    case STEP_FIRST_PAINT:
+      clutter_rectangle_set_color (CLUTTER_RECTANGLE (state->sibling), &blue);
+      break;
+
+    case STEP_SIBLING_CHANGED:
+      clutter_rectangle_set_color (CLUTTER_RECTANGLE (state->child), &green);
+      break;
+
+    default:
+      clutter_main_quit ();
+      break;
+    }
+
+  state->step++;
+
+  return FALSE;
+}
+
+static void
+on_stage_paint (ClutterActor *stage,
+                TestState    *state)
+{
+  guint n_child_paints, n_target_paints;
+
+  n_child_paints = state->n_child_paints - state->last_n_child_paints;
+  n_target_paints =
+    state->effect->n_target_paints - state->last_n_target_paints;
+
+  if (g_test_verbose ())
+    g_print ("step %d: %u child paints, %u target paints\n",
+             state->step,
+             n_child_paints,
+             n_target_paints);
+
+  /* the offscreen buffer is painted on every frame */
+  g_assert_cmpuint (n_target_paints, >, 0);
+
+  switch (state->step)
+    {
+    case STEP_FIRST_PAINT:
+    case STEP_CHILD_CHANGED:
+      g_assert_cmpuint (n_child_paints, >, 0);
+      break;
+
+    case STEP_SIBLING_CHANGED:
+      g_assert_cmpuint (n_child_paints, ==, 0);
+      break;
+
+    default:
+      break;
+    }
+
+  state->last_n_child_paints = state->n_child_paints;
+  state->last_n_target_paints = state->effect->n_target_paints;
+
+  /* the next step changes the scene, which can't be done while
+     painting */
+  if (state->step_idle == 0)
+    state->step_idle = g_idle_add (next_step, state);
+}
+
+void
+offscreen_effect_cache (TestConformSimpleFixture *fixture,
+                        gconstpointer data)
+{
+  TestState state;
+
+  if (!clutter_feature_available (CLUTTER_FEATURE_OFFSCREEN))
+    {
+      if (g_test_verbose ())
+        g_print ("Offscreen buffers are not supported; skipping\n");
+
+      return;
+    }
+
+  memset (&state, 0, sizeof (state));
+
+  state.stage = clutter_stage_get_default ();
+  clutter_stage_set_color (CLUTTER_STAGE (state.stage), &stage_color);
+
+  state.group = clutter_group_new ();
+  clutter_container_add_actor (CLUTTER_CONTAINER (state.stage), state.group);
+
+  state.child = clutter_rectangle_new_with_color (&red);
+  clutter_actor_set_size (state.child, 50, 50);
+  clutter_container_add_actor (CLUTTER_CONTAINER (state.group), state.child);
+
+  state.effect = g_object_new (count_effect_get_type (), NULL);
+  clutter_actor_add_effect (state.group, CLUTTER_EFFECT (state.effect));
+
+  state.sibling = clutter_rectangle_new_with_color (&red);
+  clutter_actor_set_size (state.sibling, 50, 50);
+  clutter_actor_set_position (state.sibling, 25, 25);
+  clutter_container_add_actor (CLUTTER_CONTAINER (state.stage), state.sibling);
+
+  g_signal_connect (state.child, "paint",
+                    G_CALLBACK (on_child_paint), &state);
+  g_signal_connect_after (state.stage, "paint",
+                          G_CALLBACK (on_stage_paint), &state);
+
+  clutter_actor_show_all (state.stage);
+
+  clutter_main ();
+
+  g_assert_cmpint (state.step, ==, STEP_DONE);
+
+  g_signal_handlers_disconnect_by_func (state.stage,
+                                        on_stage_paint,
+                                        &state);
+
+  clutter_actor_destroy (state.sibling);
+  clutter_actor_destroy (state.group);
+
+  if (g_test_verbose ())
+    g_print ("OK\n");
+}
@@ -545,6 +545,148 @@ path_test_get_position (CallbackData *data)
   return TRUE;
 }
 
+static gboolean
+check_curve_speed (CallbackData *data)
+{
+  /* A curve whose first control point is on the start point, so
+     that it starts very slowly in terms of the bezier parameter */
+  static const ClutterPathNode nodes[] =
+    { { CLUTTER_PATH_MOVE_TO,  { { 0, 0 } } },
+      { CLUTTER_PATH_CURVE_TO, { { 0, 0 }, { 0, 300 }, { 300, 300 } } } };
+  gdouble progress[17];
+  ClutterKnot positions[G_N_ELEMENTS (progress)];
+  gfloat step;
+  gint i;
+
+  clutter_path_clear (data->path);
+
+  for (i = 0; i < G_N_ELEMENTS (nodes); i++)
+    clutter_path_add_node (data->path, nodes + i);
+
+  memcpy (data->nodes, nodes, sizeof (nodes));
+  data->n_nodes = G_N_ELEMENTS (nodes);
+
+  for (i = 0; i < G_N_ELEMENTS (progress); i++)
+    progress[i] = i / (gdouble) (G_N_ELEMENTS (progress) - 1);
+
+  clutter_path_get_positions (data->path,
+                              progress,
+                              G_N_ELEMENTS (progress),
+                              positions);
+
+  step = clutter_path_get_length (data->path)
+       / (gfloat) (G_N_ELEMENTS (progress) - 1);
+
+  /* Equal steps of progress should cover roughly equal distances
+     along the curve */
+  for (i = 1; i < G_N_ELEMENTS (progress); i++)
+    {
+      gfloat dx = positions[i].x - positions[i - 1].x;
+      gfloat dy = positions[i].y - positions[i - 1].y;
+      gfloat chord = sqrtf (dx * dx + dy * dy);
+
+      if (fabs (chord - step) > step * 0.1f)
+        {
+          if (g_test_verbose ())
+            g_print ("step %i covers %f instead of %f\n", i, chord, step);
+
+          return FALSE;
+        }
+    }
+
+  return TRUE;
+}
+
+static gboolean
+check_node_boundaries (CallbackData *data)
+{
+  /* Three lines of length 30, 40 and 30 so that the node ends fall
+     exactly on progress values */
+  static const ClutterPathNode nodes[] =
+    { { CLUTTER_PATH_MOVE_TO, { { 0, 0 } } },
+      { CLUTTER_PATH_LINE_TO, { { 30, 0 } } },
+      { CLUTTER_PATH_LINE_TO, { { 30, 40 } } },
+      { CLUTTER_PATH_LINE_TO, { { 0, 40 } } } };
+  static const struct
+  {
+    gdouble progress;
+    guint node_num;
+    ClutterKnot position;
+  }
+  values[] =
+    {
+      { 0.0, 1, { 0, 0 } },
+      { 0.29, 1, { 29, 0 } },
+      { 0.3, 2, { 30, 0 } },
+      { 0.31, 2, { 30, 1 } },
+      { 0.7, 3, { 30, 40 } },
+      { 1.0, 3, { 0, 40 } }
+    };
+  gint i;
+
+  clutter_path_clear (data->path);
+
+  for (i = 0; i < G_N_ELEMENTS (nodes); i++)
+    clutter_path_add_node (data->path, nodes + i);
+
+  memcpy (data->nodes, nodes, sizeof (nodes));
+  data->n_nodes = G_N_ELEMENTS (nodes);
+
+  /* A position on the end of a node should be at the start of the
+     next node */
+  for (i = 0; i < G_N_ELEMENTS (values); i++)
+    {
+      ClutterKnot pos;
+      guint node_num;
+
+      node_num = clutter_path_get_position (data->path,
+                                            values[i].progress,
+                                            &pos);
+
+      if (node_num != values[i].node_num
+          || !clutter_knot_equal (&pos, &values[i].position))
+        {
+          if (g_test_verbose ())
+            g_print ("progress %f gave node %u at %i,%i\n",
+                     values[i].progress, node_num, pos.x, pos.y);
+
+          return FALSE;
+        }
+    }
+
+  return TRUE;
+}
+
+static gboolean
+path_test_get_positions (CallbackData *data)
+{
+  static const gdouble progress[] = { 0.0, 0.125, 0.25, 0.375, 0.5,
+                                      0.625, 0.75, 0.875, 1.0 };
+  ClutterKnot positions[G_N_ELEMENTS (progress)];
+  gint i;
+
+  set_triangle_path (data);
+
+  clutter_path_get_positions (data->path,
+                              progress,
+                              G_N_ELEMENTS (progress),
+                              positions);
+
+  /* Each position should be the same as the one returned by
+     clutter_path_get_position */
+  for (i = 0; i < G_N_ELEMENTS (progress); i++)
+    {
+      ClutterKnot pos;
+
+      clutter_path_get_position (data->path, progress[i], &pos);
+
+      if (!clutter_knot_equal (&pos, positions + i))
+        return FALSE;
+    }
+
+  return check_curve_speed (data) && check_node_boundaries (data);
+}
+
 static gboolean
 path_test_get_length (CallbackData *data)
 {
@@ -625,6 +767,7 @@ path_tests[] =
     { "Convert to cairo path and back", path_test_convert_to_cairo_path },
     { "Clear", path_test_clear },
     { "Get position", path_test_get_position },
+    { "Get positions", path_test_get_positions },
     { "Check node boxed type", path_test_boxed_type },
     { "Get length", path_test_get_length }
   };
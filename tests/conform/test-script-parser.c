@@ -1,5 +1,8 @@
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+
+#include <glib/gstdio.h>
 
 #undef CLUTTER_DISABLE_DEPRECATED
 #include <clutter/clutter.h>
@@ -400,3 +403,75 @@ test_script_layout_property (TestConformSimpleFixture *fixture,
 
   g_object_unref (script);
 }
+
+void
+test_script_compiled (TestConformSimpleFixture *fixture,
+                      gconstpointer dummy)
+{
+  ClutterScript *script = clutter_script_new ();
+  GObject *container, *actor;
+  GError *error = NULL;
+  gboolean focus_ret;
+  gchar *test_file, *compiled_file;
+  gint fd;
+
+  fd = g_file_open_tmp ("test-script-XXXXXX", &compiled_file, &error);
+  g_assert (fd >= 0);
+  close (fd);
+
+  test_file = clutter_test_get_data_file ("test-script-child.json");
+  clutter_script_compile_file (script, test_file, compiled_file, &error);
+  if (g_test_verbose () && error)
+    g_print ("Error: %s", error->message);
+
+#if GLIB_CHECK_VERSION (2, 20, 0)
+  g_assert_no_error (error);
+#else
+  g_assert (error == NULL);
+#endif
+
+  /* compiling does not construct anything */
+  g_assert (clutter_script_list_objects (script) == NULL);
+
+  clutter_script_load_from_file (script, compiled_file, &error);
+  if (g_test_verbose () && error)
+    g_print ("Error: %s", error->message);
+
+#if GLIB_CHECK_VERSION (2, 20, 0)
+  g_assert_no_error (error);
+#else
+  g_assert (error == NULL);
+#endif
+
+  /* retrieving a child first also constructs its container */
+  actor = clutter_script_get_object (script, "test-rect-2");
+  g_assert (CLUTTER_IS_RECTANGLE (actor));
+  g_assert_cmpfloat (clutter_actor_get_width (CLUTTER_ACTOR (actor)), ==, 100.0);
+
+  container = clutter_script_get_object (script, "test-group");
+  g_assert (TEST_IS_GROUP (container));
+  g_assert (clutter_actor_get_parent (CLUTTER_ACTOR (actor)) ==
+            CLUTTER_ACTOR (container));
+
+  focus_ret = TRUE;
+  clutter_container_child_get (CLUTTER_CONTAINER (container),
+                               CLUTTER_ACTOR (actor),
+                               "focus", &focus_ret,
+                               NULL);
+  g_assert (!focus_ret);
+
+  actor = clutter_script_get_object (script, "test-rect-1");
+  g_assert (CLUTTER_IS_RECTANGLE (actor));
+
+  focus_ret = FALSE;
+  clutter_container_child_get (CLUTTER_CONTAINER (container),
+                               CLUTTER_ACTOR (actor),
+                               "focus", &focus_ret,
+                               NULL);
+  g_assert (focus_ret);
+
+  g_object_unref (script);
+  g_unlink (compiled_file);
+  g_free (compiled_file);
+  g_free (test_file);
+}
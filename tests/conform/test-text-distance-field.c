@@ -0,0 +1,148 @@
+#include <clutter/clutter.h>
+#include <cogl/cogl.h>
+#include <pango/cogl-pango.h>
+#include <string.h>
+
+#include "test-conform-common.h"
+
+static const ClutterColor stage_color = { 0x00, 0x00, 0x00, 0xff };
+
+#define TEST_FONT  "Sans 48px"
+#define TEST_TEXT  "Ag"
+
+/* The size of the area each layout is drawn in */
+#define AREA_WIDTH  160
+#define AREA_HEIGHT 80
+
+typedef struct _TestState
+{
+  PangoLayout *layouts[2];
+  gboolean was_painted;
+} TestState;
+
+static guint
+get_coverage (int y)
+{
+  guint8 *pixels = g_malloc (AREA_WIDTH * AREA_HEIGHT * 4);
+  guint coverage = 0;
+  int i;
+
+  cogl_read_pixels (0, y, AREA_WIDTH, AREA_HEIGHT,
+                    COGL_READ_PIXELS_COLOR_BUFFER,
+                    COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                    pixels);
+
+  /* The text is white on a black stage so the red component is the
+     coverage of the pixel */
+  for (i = 0; i < AREA_WIDTH * AREA_HEIGHT; i++)
+    coverage += pixels[i * 4];
+
+  g_free (pixels);
+
+  return coverage;
+}
+
+static void
+on_paint (ClutterActor *actor, TestState *state)
+{
+  CoglPangoFontMap *font_map = COGL_PANGO_FONT_MAP (clutter_get_font_map ());
+  gboolean use_distance_field;
+  CoglColor color;
+  guint a8_coverage, distance_field_coverage;
+
+  use_distance_field = cogl_pango_font_map_get_use_distance_field (font_map);
+
+  cogl_color_init_from_4ub (&color, 0xff, 0xff, 0xff, 0xff);
+
+  /* Render the text once with the default glyph cache */
+  cogl_pango_font_map_set_use_distance_field (font_map, FALSE);
+  cogl_pango_render_layout (state->layouts[0], 0, 0, &color, 0);
+
+  /* And again with the glyphs stored as distance fields */
+  cogl_pango_font_map_set_use_distance_field (font_map, TRUE);
+  cogl_pango_render_layout (state->layouts[1], 0, AREA_HEIGHT, &color, 0);
+
+  cogl_pango_font_map_set_use_distance_field (font_map, use_distance_field);
+
+  a8_coverage = get_coverage (0);
+  distance_field_coverage = get_coverage (AREA_HEIGHT);
+
+  if (g_test_verbose ())
+    g_print ("A8 coverage = %u, distance field coverage = %u\n",
+             a8_coverage, distance_field_coverage);
+
+  /* The glyphs should cover about the same area. The outlines won't
+     match exactly because the distance field glyphs are not hinted and
+     are scaled from the reference size */
+  g_assert (a8_coverage > 0);
+  g_assert (ABS ((int) a8_coverage - (int) distance_field_coverage)
+            <= a8_coverage / 10);
+
+  state->was_painted = TRUE;
+
+  /* Comment this out if you want visual feedback for what this test paints */
+#if 1
+  clutter_main_quit ();
+#endif
+}
+
+static gboolean
+queue_redraw (gpointer stage)
+{
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (stage));
+
+  return TRUE;
+}
+
+void
+text_distance_field (void)
+{
+  TestState state;
+  ClutterActor *stage;
+  ClutterActor *group;
+  PangoFontDescription *desc;
+  guint idle_source;
+  int i;
+
+  memset (&state, 0, sizeof (state));
+
+  stage = clutter_stage_get_default ();
+
+  clutter_stage_set_color (CLUTTER_STAGE (stage), &stage_color);
+
+  desc = pango_font_description_from_string (TEST_FONT);
+
+  for (i = 0; i < G_N_ELEMENTS (state.layouts); i++)
+    {
+      state.layouts[i] = clutter_actor_create_pango_layout (stage, TEST_TEXT);
+      pango_layout_set_font_description (state.layouts[i], desc);
+    }
+
+  pango_font_description_free (desc);
+
+  group = clutter_group_new ();
+  clutter_container_add_actor (CLUTTER_CONTAINER (stage), group);
+
+  /* We force continuous redrawing of the stage, since we need to skip
+   * the first few frames, and we wont be doing anything else that
+   * will trigger redrawing. */
+  idle_source = g_idle_add (queue_redraw, stage);
+
+  g_signal_connect (group, "paint", G_CALLBACK (on_paint), &state);
+
+  clutter_actor_show_all (stage);
+
+  clutter_main ();
+
+  g_source_remove (idle_source);
+
+  g_assert (state.was_painted);
+
+  for (i = 0; i < G_N_ELEMENTS (state.layouts); i++)
+    g_object_unref (state.layouts[i]);
+
+  clutter_actor_destroy (group);
+
+  if (g_test_verbose ())
+    g_print ("OK\n");
+}
@@ -0,0 +1,196 @@
+#define COGL_ENABLE_EXPERIMENTAL_API
+
+#include <clutter/clutter.h>
+#include <cogl/cogl.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define STAGE_WIDTH  800
+#define STAGE_HEIGHT 600
+
+#define SPRITE_SIZE  8
+
+#define TARGET_FPS   60
+
+/* the number of sprites is adjusted every second until the frame rate
+ * settles around TARGET_FPS
+ */
+static int n_sprites = 1000;
+static int best_n_sprites = 0;
+
+static gboolean use_rectangles = FALSE;
+
+static GTimer *animation_timer = NULL;
+
+static CoglPrimitive *sprite = NULL;
+static CoglPrimitiveInstance *instances = NULL;
+static int n_instances = 0;
+
+static void
+update_instances (void)
+{
+  float t = g_timer_elapsed (animation_timer, NULL);
+  int i;
+
+  if (n_instances < n_sprites)
+    {
+      instances = g_renew (CoglPrimitiveInstance, instances, n_sprites);
+      n_instances = n_sprites;
+    }
+
+  for (i = 0; i < n_sprites; i++)
+    {
+      CoglPrimitiveInstance *instance = instances + i;
+      float angle = t + i * 0.1f;
+      float s = sinf (angle), c = cosf (angle);
+
+      instance->xx = c;
+      instance->yx = s;
+      instance->xy = -s;
+      instance->yy = c;
+      instance->x0 = (i * 37) % STAGE_WIDTH;
+      instance->y0 = (i * 53) % STAGE_HEIGHT;
+      instance->s_offset = 0;
+      instance->t_offset = 0;
+      instance->r = 0xff;
+      instance->g = (i * 7) & 0xff;
+      instance->b = (i * 13) & 0xff;
+      instance->a = 0xff;
+    }
+}
+
+static void
+paint_sprites (void)
+{
+  int i;
+
+  update_instances ();
+
+  if (!use_rectangles)
+    {
+      cogl_set_source_color4ub (0xff, 0xff, 0xff, 0xff);
+      cogl_primitive_draw_instances (sprite, instances, n_sprites);
+      return;
+    }
+
+  /* draw the same sprites one by one, for comparison */
+  for (i = 0; i < n_sprites; i++)
+    {
+      const CoglPrimitiveInstance *instance = instances + i;
+      float matrix[16] = {
+        instance->xx, instance->yx, 0, 0,
+        instance->xy, instance->yy, 0, 0,
+        0, 0, 1, 0,
+        instance->x0, instance->y0, 0, 1
+      };
+      CoglMatrix transform;
+
+      cogl_matrix_init_from_array (&transform, matrix);
+
+      cogl_push_matrix ();
+      cogl_transform (&transform);
+      cogl_set_source_color4ub (instance->r,
+                                instance->g,
+                                instance->b,
+                                instance->a);
+      cogl_rectangle (0, 0, SPRITE_SIZE, SPRITE_SIZE);
+      cogl_pop_matrix ();
+    }
+}
+
+static void
+on_paint (ClutterActor *actor, gconstpointer *data)
+{
+  static GTimer *timer = NULL;
+  static int fps = 0;
+
+  paint_sprites ();
+
+  if (!timer)
+    {
+      timer = g_timer_new ();
+      g_timer_start (timer);
+    }
+
+  if (g_timer_elapsed (timer, NULL) >= 1)
+    {
+      if (fps >= TARGET_FPS)
+        best_n_sprites = MAX (best_n_sprites, n_sprites);
+
+      printf ("fps=%d, sprites=%d, sprites per frame at %d fps=%d\n",
+              fps,
+              n_sprites,
+              TARGET_FPS,
+              best_n_sprites);
+
+      /* scale the number of sprites by how far we are from the
+       * target frame rate, without jumping too far at once
+       */
+      n_sprites = n_sprites * CLAMP ((float) fps / TARGET_FPS, 0.5f, 2.0f);
+      n_sprites = MAX (n_sprites, 1);
+
+      g_timer_start (timer);
+      fps = 0;
+    }
+
+  ++fps;
+}
+
+static gboolean
+queue_redraw (gpointer stage)
+{
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (stage));
+
+  return TRUE;
+}
+
+int
+main (int argc, char *argv[])
+{
+  ClutterColor stage_color = { 0x00, 0x00, 0x00, 0xff };
+  CoglVertexP2C4 vertices[] = {
+    { 0, 0, 0xff, 0xff, 0xff, 0xff },
+    { 0, SPRITE_SIZE, 0xff, 0xff, 0xff, 0xff },
+    { SPRITE_SIZE, 0, 0xff, 0xff, 0xff, 0xff },
+    { SPRITE_SIZE, SPRITE_SIZE, 0xff, 0xff, 0xff, 0xff }
+  };
+  ClutterActor *stage;
+
+  g_setenv ("CLUTTER_VBLANK", "none", FALSE);
+  g_setenv ("CLUTTER_DEFAULT_FPS", "1000", FALSE);
+
+  if (clutter_init (&argc, &argv) != CLUTTER_INIT_SUCCESS)
+    return 1;
+
+  if (argc > 1)
+    use_rectangles = strcmp (argv[1], "rectangles") == 0;
+
+  g_print ("Drawing sprites %s\n",
+           use_rectangles ? "one by one" : "as instances");
+
+  animation_timer = g_timer_new ();
+
+  sprite = cogl_primitive_new_p2c4 (COGL_VERTICES_MODE_TRIANGLE_STRIP,
+                                    G_N_ELEMENTS (vertices),
+                                    vertices);
+
+  stage = clutter_stage_get_default ();
+  clutter_actor_set_size (stage, STAGE_WIDTH, STAGE_HEIGHT);
+  clutter_stage_set_color (CLUTTER_STAGE (stage), &stage_color);
+
+  g_signal_connect (stage, "paint", G_CALLBACK (on_paint), NULL);
+
+  clutter_actor_show_all (stage);
+
+  g_idle_add (queue_redraw, stage);
+
+  clutter_main ();
+
+  cogl_object_unref (sprite);
+  g_free (instances);
+  g_timer_destroy (animation_timer);
+
+  return 0;
+}
@@ -0,0 +1,156 @@
+#include <clutter/clutter.h>
+#include <cogl/cogl.h>
+
+#include <stdio.h>
+
+/* Times the matrix functions used while painting and picking. The
+ * SIMD versions are selected when the Cogl context is created; run
+ * with COGL_DEBUG=disable-simd to compare with the plain C versions */
+
+#define N_ITERATIONS 1000000
+#define N_POINTS     1024
+
+typedef struct _Point4f
+{
+  float x, y, z, w;
+} Point4f;
+
+static Point4f points_in[N_POINTS];
+static Point4f points_out[N_POINTS];
+
+static void
+init_matrix (CoglMatrix *matrix, float angle)
+{
+  cogl_matrix_init_identity (matrix);
+  cogl_matrix_perspective (matrix, 60, 4.0f / 3.0f, 0.1f, 100.0f);
+  cogl_matrix_translate (matrix, 10, -20, -50);
+  cogl_matrix_rotate (matrix, angle, 0.3f, 1, 0.2f);
+  cogl_matrix_scale (matrix, 1.5f, 0.5f, 2);
+}
+
+static void
+report (const char *name, GTimer *timer, int n_operations)
+{
+  g_print ("%-24s %8.2f ns/op\n",
+           name,
+           g_timer_elapsed (timer, NULL) * 1e9 / n_operations);
+}
+
+static void
+test_multiply (GTimer *timer)
+{
+  CoglMatrix a, b, result;
+  int i;
+
+  init_matrix (&a, 10);
+  init_matrix (&b, 20);
+
+  g_timer_start (timer);
+  for (i = 0; i < N_ITERATIONS; i++)
+    {
+      cogl_matrix_multiply (&result, &a, &b);
+      /* chain the results so the loop can't be optimized away */
+      a.xw = result.xw * 0.5f;
+    }
+  g_timer_stop (timer);
+
+  report ("multiply", timer, N_ITERATIONS);
+}
+
+static void
+test_inverse (GTimer *timer)
+{
+  CoglMatrix matrix, inverse;
+  int i;
+
+  init_matrix (&matrix, 10);
+
+  g_timer_start (timer);
+  for (i = 0; i < N_ITERATIONS; i++)
+    {
+      /* modifying the matrix invalidates the cached inverse */
+      cogl_matrix_translate (&matrix, 0.001f, 0, 0);
+      cogl_matrix_get_inverse (&matrix, &inverse);
+    }
+  g_timer_stop (timer);
+
+  report ("translate + get_inverse", timer, N_ITERATIONS);
+}
+
+static void
+test_points (GTimer *timer)
+{
+  CoglMatrix matrix;
+  int n_batches = N_ITERATIONS / N_POINTS * 16;
+  int i;
+
+  init_matrix (&matrix, 10);
+
+  for (i = 0; i < N_POINTS; i++)
+    {
+      points_in[i].x = i % 32;
+      points_in[i].y = i / 32;
+      points_in[i].z = 0;
+      points_in[i].w = 1;
+    }
+
+  g_timer_start (timer);
+  for (i = 0; i < n_batches; i++)
+    cogl_matrix_transform_points (&matrix, 2,
+                                  sizeof (Point4f), points_in,
+                                  sizeof (Point4f), points_out,
+                                  N_POINTS);
+  g_timer_stop (timer);
+  report ("transform_points (2)", timer, n_batches * N_POINTS);
+
+  g_timer_start (timer);
+  for (i = 0; i < n_batches; i++)
+    cogl_matrix_transform_points (&matrix, 3,
+                                  sizeof (Point4f), points_in,
+                                  sizeof (Point4f), points_out,
+                                  N_POINTS);
+  g_timer_stop (timer);
+  report ("transform_points (3)", timer, n_batches * N_POINTS);
+
+  g_timer_start (timer);
+  for (i = 0; i < n_batches; i++)
+    cogl_matrix_project_points (&matrix, 3,
+                                sizeof (Point4f), points_in,
+                                sizeof (Point4f), points_out,
+                                N_POINTS);
+  g_timer_stop (timer);
+  report ("project_points (3)", timer, n_batches * N_POINTS);
+
+  g_timer_start (timer);
+  for (i = 0; i < n_batches; i++)
+    cogl_matrix_project_points (&matrix, 4,
+                                sizeof (Point4f), points_in,
+                                sizeof (Point4f), points_out,
+                                N_POINTS);
+  g_timer_stop (timer);
+  report ("project_points (4)", timer, n_batches * N_POINTS);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GTimer *timer;
+
+  if (clutter_init (&argc, &argv) != CLUTTER_INIT_SUCCESS)
+    return 1;
+
+  /* make sure the Cogl context, and so the matrix functions to use,
+   * have been set up */
+  clutter_actor_realize (clutter_stage_get_default ());
+  cogl_get_features ();
+
+  timer = g_timer_new ();
+
+  test_multiply (timer);
+  test_inverse (timer);
+  test_points (timer);
+
+  g_timer_destroy (timer);
+
+  return 0;
+}
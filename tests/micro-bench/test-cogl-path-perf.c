@@ -0,0 +1,190 @@
+#include <clutter/clutter.h>
+#include <cogl/cogl.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define STAGE_WIDTH  800
+#define STAGE_HEIGHT 600
+
+#define N_ICONS      1000
+#define ICON_SIZE    16
+
+/* Draws a grid of small vector icons with CoglPath. By default the
+ * paths are built once and filled again every frame, so the
+ * tessellated geometry cached on each path is reused. Run with the
+ * "rebuild" argument to create new paths every frame for comparison */
+
+typedef enum
+{
+  ICON_ROUNDED_RECT,
+  ICON_CIRCLE,
+  ICON_STAR,
+  ICON_RING,
+
+  N_ICON_TYPES
+} IconType;
+
+static gboolean rebuild_paths = FALSE;
+
+static CoglPath *icon_paths[N_ICON_TYPES];
+
+static void
+build_icon (IconType type)
+{
+  float half = ICON_SIZE / 2.0f;
+  int i;
+
+  cogl_path_new ();
+
+  switch (type)
+    {
+    case ICON_ROUNDED_RECT:
+      cogl_path_round_rectangle (0, 0, ICON_SIZE, ICON_SIZE, 4, 10);
+      break;
+
+    case ICON_CIRCLE:
+      cogl_path_ellipse (half, half, half, half);
+      break;
+
+    case ICON_STAR:
+      for (i = 0; i < 10; i++)
+        {
+          float angle = i * G_PI / 5;
+          float radius = (i & 1) ? half * 0.4f : half;
+          float x = half + sinf (angle) * radius;
+          float y = half - cosf (angle) * radius;
+
+          if (i == 0)
+            cogl_path_move_to (x, y);
+          else
+            cogl_path_line_to (x, y);
+        }
+      cogl_path_close ();
+      break;
+
+    case ICON_RING:
+      /* two contours, which needs the general tesselator */
+      cogl_path_ellipse (half, half, half, half);
+      cogl_path_ellipse (half, half, half * 0.5f, half * 0.5f);
+      break;
+
+    default:
+      g_assert_not_reached ();
+    }
+}
+
+static void
+paint_icons (void)
+{
+  int columns = STAGE_WIDTH / (ICON_SIZE + 4);
+  int i;
+
+  if (!rebuild_paths)
+    for (i = 0; i < N_ICON_TYPES; i++)
+      if (icon_paths[i] == NULL)
+        {
+          build_icon (i);
+          icon_paths[i] = cogl_object_ref (cogl_get_path ());
+        }
+
+  for (i = 0; i < N_ICONS; i++)
+    {
+      IconType type = i % N_ICON_TYPES;
+
+      cogl_push_matrix ();
+      cogl_translate ((i % columns) * (ICON_SIZE + 4) + 2,
+                      (i / columns) * (ICON_SIZE + 4) + 2,
+                      0);
+
+      cogl_set_source_color4ub (0xff,
+                                (i * 7) & 0xff,
+                                (i * 13) & 0xff,
+                                0xff);
+
+      if (rebuild_paths)
+        {
+          build_icon (type);
+          cogl_path_fill ();
+        }
+      else
+        {
+          cogl_set_path (icon_paths[type]);
+          cogl_path_fill_preserve ();
+        }
+
+      cogl_pop_matrix ();
+    }
+}
+
+static void
+on_paint (ClutterActor *actor, gconstpointer *data)
+{
+  static GTimer *timer = NULL;
+  static int fps = 0;
+
+  paint_icons ();
+
+  if (!timer)
+    {
+      timer = g_timer_new ();
+      g_timer_start (timer);
+    }
+
+  if (g_timer_elapsed (timer, NULL) >= 1)
+    {
+      printf ("fps=%d, icons per second=%d\n", fps, fps * N_ICONS);
+      g_timer_start (timer);
+      fps = 0;
+    }
+
+  ++fps;
+}
+
+static gboolean
+queue_redraw (gpointer stage)
+{
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (stage));
+
+  return TRUE;
+}
+
+int
+main (int argc, char *argv[])
+{
+  ClutterColor stage_color = { 0x00, 0x00, 0x00, 0xff };
+  ClutterActor *stage;
+  int i;
+
+  g_setenv ("CLUTTER_VBLANK", "none", FALSE);
+  g_setenv ("CLUTTER_DEFAULT_FPS", "1000", FALSE);
+
+  if (clutter_init (&argc, &argv) != CLUTTER_INIT_SUCCESS)
+    return 1;
+
+  if (argc > 1)
+    rebuild_paths = strcmp (argv[1], "rebuild") == 0;
+
+  g_print ("Drawing %d icons with %s paths\n",
+           N_ICONS,
+           rebuild_paths ? "new" : "cached");
+
+  stage = clutter_stage_get_default ();
+  clutter_actor_set_size (stage, STAGE_WIDTH, STAGE_HEIGHT);
+  clutter_stage_set_color (CLUTTER_STAGE (stage), &stage_color);
+
+  g_signal_connect (stage, "paint", G_CALLBACK (on_paint), NULL);
+
+  clutter_actor_show_all (stage);
+
+  g_idle_add (queue_redraw, stage);
+
+  clutter_main ();
+
+  for (i = 0; i < N_ICON_TYPES; i++)
+    if (icon_paths[i])
+      cogl_object_unref (icon_paths[i]);
+
+  return 0;
+}
@@ -0,0 +1,182 @@
+#include <clutter/clutter.h>
+#include <cogl/cogl.h>
+
+#include <math.h>
+
+/* Times filling new paths, which runs the tesselator each time. The
+ * small paths are the ones drawn by the test-cogl-path conformance
+ * test. The paths are drawn to a small offscreen buffer so that most
+ * of the time is spent building the geometry rather than drawing it */
+
+#define BLOCK_SIZE   16
+#define TARGET_SIZE  64
+
+#define N_SMALL_ITERATIONS 20000
+#define N_LARGE_ITERATIONS 50
+
+typedef void (* BuildPathFunc) (void);
+
+static void
+build_two_rectangles (void)
+{
+  cogl_path_rectangle (BLOCK_SIZE * 3 / 4, BLOCK_SIZE / 2,
+                       BLOCK_SIZE, BLOCK_SIZE);
+  cogl_path_rectangle (BLOCK_SIZE / 2, BLOCK_SIZE / 2,
+                       BLOCK_SIZE * 3 / 4, BLOCK_SIZE);
+}
+
+static void
+build_extended_path (void)
+{
+  build_two_rectangles ();
+  cogl_path_line_to (0, BLOCK_SIZE / 2);
+  cogl_path_line_to (0, 0);
+  cogl_path_line_to (BLOCK_SIZE / 2, 0);
+  cogl_path_line_to (BLOCK_SIZE / 2, BLOCK_SIZE / 2);
+}
+
+static void
+build_self_intersecting (void)
+{
+  cogl_path_rectangle (0, 0, BLOCK_SIZE, BLOCK_SIZE);
+  cogl_path_line_to (0, BLOCK_SIZE / 2);
+  cogl_path_line_to (BLOCK_SIZE / 2, BLOCK_SIZE / 2);
+  cogl_path_line_to (BLOCK_SIZE / 2, 0);
+  cogl_path_close ();
+}
+
+static void
+build_intersecting_sub_paths (void)
+{
+  cogl_path_rectangle (0, 0, BLOCK_SIZE, BLOCK_SIZE);
+  cogl_path_rectangle (BLOCK_SIZE / 2, BLOCK_SIZE / 2,
+                       BLOCK_SIZE, BLOCK_SIZE);
+}
+
+static void
+build_nested_sub_paths (void)
+{
+  cogl_path_move_to (0, 0);
+  cogl_path_line_to (BLOCK_SIZE, 0);
+  cogl_path_line_to (BLOCK_SIZE, BLOCK_SIZE);
+  cogl_path_line_to (0, BLOCK_SIZE);
+  cogl_path_close ();
+
+  cogl_path_move_to (0, 0);
+  cogl_path_line_to (BLOCK_SIZE / 2, 0);
+  cogl_path_line_to (BLOCK_SIZE / 2, BLOCK_SIZE / 2);
+  cogl_path_line_to (0, BLOCK_SIZE / 2);
+  cogl_path_close ();
+
+  cogl_path_move_to (BLOCK_SIZE / 2, 0);
+  cogl_path_line_to (BLOCK_SIZE / 2, BLOCK_SIZE / 2);
+  cogl_path_line_to (BLOCK_SIZE, BLOCK_SIZE / 2);
+  cogl_path_line_to (BLOCK_SIZE, 0);
+  cogl_path_close ();
+}
+
+static void
+build_many_rectangles (void)
+{
+  int i;
+
+  for (i = 0; i < 200; i++)
+    {
+      float x = (i * 37) % (TARGET_SIZE - 12);
+      float y = (i * 53) % (TARGET_SIZE - 10);
+
+      cogl_path_rectangle (x, y, x + 12, y + 10);
+    }
+}
+
+static void
+build_star (void)
+{
+  int i;
+
+  for (i = 0; i < 2000; i++)
+    {
+      float angle = i * 2 * G_PI / 2000;
+      float radius = (i & 1) ? TARGET_SIZE / 4 : TARGET_SIZE / 2;
+      float x = TARGET_SIZE / 2 + cosf (angle) * radius;
+      float y = TARGET_SIZE / 2 + sinf (angle) * radius;
+
+      if (i == 0)
+        cogl_path_move_to (x, y);
+      else
+        cogl_path_line_to (x, y);
+    }
+}
+
+static void
+time_path (GTimer *timer,
+           const char *name,
+           BuildPathFunc build_path,
+           int n_iterations)
+{
+  int i;
+
+  g_timer_start (timer);
+
+  for (i = 0; i < n_iterations; i++)
+    {
+      cogl_path_new ();
+      build_path ();
+      cogl_path_fill ();
+    }
+
+  cogl_flush ();
+  g_timer_stop (timer);
+
+  g_print ("%-24s %10.2f us/path\n",
+           name,
+           g_timer_elapsed (timer, NULL) * 1e6 / n_iterations);
+}
+
+int
+main (int argc, char *argv[])
+{
+  CoglHandle texture, offscreen;
+  GTimer *timer;
+
+  if (clutter_init (&argc, &argv) != CLUTTER_INIT_SUCCESS)
+    return 1;
+
+  /* make sure the Cogl context has been set up */
+  clutter_actor_realize (clutter_stage_get_default ());
+
+  texture = cogl_texture_new_with_size (TARGET_SIZE, TARGET_SIZE,
+                                        COGL_TEXTURE_NO_SLICING,
+                                        COGL_PIXEL_FORMAT_RGBA_8888_PRE);
+  offscreen = cogl_offscreen_new_to_texture (texture);
+
+  cogl_push_framebuffer (offscreen);
+  cogl_ortho (0, TARGET_SIZE, TARGET_SIZE, 0, -1, 100);
+  cogl_set_source_color4ub (0xff, 0xff, 0xff, 0xff);
+
+  timer = g_timer_new ();
+
+  time_path (timer, "two rectangles",
+             build_two_rectangles, N_SMALL_ITERATIONS);
+  time_path (timer, "extended path",
+             build_extended_path, N_SMALL_ITERATIONS);
+  time_path (timer, "self-intersecting",
+             build_self_intersecting, N_SMALL_ITERATIONS);
+  time_path (timer, "intersecting sub paths",
+             build_intersecting_sub_paths, N_SMALL_ITERATIONS);
+  time_path (timer, "nested sub paths",
+             build_nested_sub_paths, N_SMALL_ITERATIONS);
+  time_path (timer, "200 rectangles",
+             build_many_rectangles, N_LARGE_ITERATIONS);
+  time_path (timer, "2000 point star",
+             build_star, N_LARGE_ITERATIONS);
+
+  g_timer_destroy (timer);
+
+  cogl_pop_framebuffer ();
+
+  cogl_handle_unref (offscreen);
+  cogl_handle_unref (texture);
+
+  return 0;
+}
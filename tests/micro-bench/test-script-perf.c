@@ -0,0 +1,172 @@
+#include <clutter/clutter.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <glib/gstdio.h>
+
+#define DEFAULT_N_ACTORS 2000
+#define N_RUNS           5
+
+static gchar *
+create_definition (int n_actors)
+{
+  GString *str = g_string_new (NULL);
+  int i;
+
+  g_string_append (str, "[\n");
+
+  for (i = 0; i < n_actors; i++)
+    {
+      g_string_append_printf (str,
+                              "  {\n"
+                              "    \"id\" : \"rect-%d\",\n"
+                              "    \"type\" : \"ClutterRectangle\",\n"
+                              "    \"x\" : %d, \"y\" : %d,\n"
+                              "    \"width\" : 10, \"height\" : 10,\n"
+                              "    \"color\" : \"#%02x%02x%02xff\",\n"
+                              "    \"request-mode\" : \"width-for-height\",\n"
+                              "    \"reactive\" : true\n"
+                              "  }%s\n",
+                              i,
+                              (i % 80) * 10, (i / 80) * 10,
+                              i & 0xff, (i * 3) & 0xff, (i * 7) & 0xff,
+                              i < n_actors - 1 ? "," : "");
+    }
+
+  g_string_append (str, "]\n");
+
+  return g_string_free (str, FALSE);
+}
+
+static gchar *
+write_temp_file (const gchar *template,
+                 const gchar *contents)
+{
+  GError *error = NULL;
+  gchar *filename;
+  gint fd;
+
+  fd = g_file_open_tmp (template, &filename, &error);
+  if (fd < 0)
+    g_error ("Unable to create a temporary file: %s", error->message);
+
+  close (fd);
+
+  if (contents != NULL &&
+      !g_file_set_contents (filename, contents, -1, &error))
+    g_error ("Unable to write '%s': %s", filename, error->message);
+
+  return filename;
+}
+
+/* loads @filename and retrieves the object named @name, returning the
+ * time it took in milliseconds; the objects are not parented, so they
+ * are released together with the script
+ */
+static gdouble
+time_load (const gchar *filename,
+           const gchar *name,
+           gboolean     ensure_all)
+{
+  ClutterScript *script;
+  GError *error = NULL;
+  GTimer *timer;
+  gdouble retval;
+
+  timer = g_timer_new ();
+
+  script = clutter_script_new ();
+  clutter_script_load_from_file (script, filename, &error);
+  if (error != NULL)
+    g_error ("Unable to load '%s': %s", filename, error->message);
+
+  if (clutter_script_get_object (script, name) == NULL)
+    g_error ("No object named '%s'", name);
+
+  if (ensure_all)
+    clutter_script_ensure_objects (script);
+
+  retval = g_timer_elapsed (timer, NULL) * 1000.0;
+
+  g_object_unref (script);
+  g_timer_destroy (timer);
+
+  return retval;
+}
+
+static void
+run_test (const gchar *description,
+          const gchar *filename,
+          const gchar *name,
+          gboolean     ensure_all)
+{
+  gdouble best = G_MAXDOUBLE, total = 0.0;
+  int i;
+
+  for (i = 0; i < N_RUNS; i++)
+    {
+      gdouble elapsed = time_load (filename, name, ensure_all);
+
+      total += elapsed;
+      best = MIN (best, elapsed);
+    }
+
+  g_print ("%-40s best: %8.2f ms, average: %8.2f ms\n",
+           description,
+           best,
+           total / N_RUNS);
+}
+
+int
+main (int argc, char *argv[])
+{
+  ClutterScript *script;
+  GError *error = NULL;
+  gchar *definition, *json_file, *compiled_file;
+  int n_actors = DEFAULT_N_ACTORS;
+  GTimer *timer;
+
+  if (clutter_init (&argc, &argv) != CLUTTER_INIT_SUCCESS)
+    return 1;
+
+  if (argc > 1)
+    n_actors = MAX (atoi (argv[1]), 1);
+
+  g_print ("%d actors\n", n_actors);
+
+  definition = create_definition (n_actors);
+  json_file = write_temp_file ("test-script-perf-json-XXXXXX", definition);
+  compiled_file = write_temp_file ("test-script-perf-XXXXXX", NULL);
+  g_free (definition);
+
+  timer = g_timer_new ();
+
+  script = clutter_script_new ();
+  if (!clutter_script_compile_file (script, json_file, compiled_file, &error))
+    g_error ("Unable to compile '%s': %s", json_file, error->message);
+
+  g_print ("%-40s %8.2f ms\n",
+           "Compiling",
+           g_timer_elapsed (timer, NULL) * 1000.0);
+
+  g_object_unref (script);
+  g_timer_destroy (timer);
+
+  /* make sure every type is registered before timing anything */
+  time_load (json_file, "rect-0", TRUE);
+
+  run_test ("JSON, single object", json_file, "rect-0", FALSE);
+  run_test ("Compiled, single object", compiled_file, "rect-0", FALSE);
+  run_test ("JSON, all objects", json_file, "rect-0", TRUE);
+  run_test ("Compiled, all objects", compiled_file, "rect-0", TRUE);
+
+  g_unlink (json_file);
+  g_unlink (compiled_file);
+
+  g_free (json_file);
+  g_free (compiled_file);
+
+  return 0;
+}
@@ -0,0 +1,127 @@
+#include <clutter/clutter.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#define STAGE_WIDTH  800
+#define STAGE_HEIGHT 600
+
+#define DEFAULT_N_ROWS 100
+#define DEFAULT_N_COLS 100
+
+static int n_rows = DEFAULT_N_ROWS;
+static int n_cols = DEFAULT_N_COLS;
+
+static ClutterActor **cells = NULL;
+static int frame = 0;
+
+static void
+on_paint (ClutterActor *actor, gconstpointer *data)
+{
+  static GTimer *timer = NULL;
+  static int fps = 0;
+
+  if (!timer)
+    {
+      timer = g_timer_new ();
+      g_timer_start (timer);
+    }
+
+  if (g_timer_elapsed (timer, NULL) >= 1)
+    {
+      printf ("fps=%d, cells=%d\n", fps, n_rows * n_cols);
+      g_timer_start (timer);
+      fps = 0;
+    }
+
+  ++fps;
+}
+
+/* changes the text of a single cell each frame, which should only
+ * require the row and the column of that cell to be solved again
+ */
+static gboolean
+change_cell (gpointer stage)
+{
+  ClutterActor *cell;
+  gchar *text;
+
+  cell = cells[frame % (n_rows * n_cols)];
+
+  text = g_strdup_printf ("%d", frame % 1000);
+  clutter_text_set_text (CLUTTER_TEXT (cell), text);
+  g_free (text);
+
+  frame += 1;
+
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (stage));
+
+  return TRUE;
+}
+
+int
+main (int argc, char *argv[])
+{
+  ClutterColor stage_color = { 0x00, 0x00, 0x00, 0xff };
+  ClutterColor label_color = { 0xff, 0xff, 0xff, 0xff };
+  ClutterLayoutManager *layout;
+  ClutterActor *stage, *box;
+  int row, col;
+
+  g_setenv ("CLUTTER_VBLANK", "none", FALSE);
+  g_setenv ("CLUTTER_DEFAULT_FPS", "1000", FALSE);
+
+  if (clutter_init (&argc, &argv) != CLUTTER_INIT_SUCCESS)
+    return 1;
+
+  if (argc > 1)
+    n_rows = MAX (atoi (argv[1]), 1);
+
+  if (argc > 2)
+    n_cols = MAX (atoi (argv[2]), 1);
+
+  g_print ("%d rows, %d columns\n", n_rows, n_cols);
+
+  stage = clutter_stage_get_default ();
+  clutter_actor_set_size (stage, STAGE_WIDTH, STAGE_HEIGHT);
+  clutter_stage_set_color (CLUTTER_STAGE (stage), &stage_color);
+
+  g_signal_connect (stage, "paint", G_CALLBACK (on_paint), NULL);
+
+  layout = clutter_table_layout_new ();
+  clutter_table_layout_set_column_spacing (CLUTTER_TABLE_LAYOUT (layout), 2);
+  clutter_table_layout_set_row_spacing (CLUTTER_TABLE_LAYOUT (layout), 2);
+
+  box = clutter_box_new (layout);
+  clutter_container_add_actor (CLUTTER_CONTAINER (stage), box);
+
+  cells = g_new (ClutterActor *, n_rows * n_cols);
+
+  for (row = 0; row < n_rows; row++)
+    for (col = 0; col < n_cols; col++)
+      {
+        ClutterActor *label;
+        gchar *text;
+
+        text = g_strdup_printf ("%d", row * n_cols + col);
+        label = clutter_text_new_with_text ("Monospace 6px", text);
+        clutter_text_set_color (CLUTTER_TEXT (label), &label_color);
+        g_free (text);
+
+        clutter_table_layout_pack (CLUTTER_TABLE_LAYOUT (layout),
+                                   label,
+                                   col, row);
+
+        cells[row * n_cols + col] = label;
+      }
+
+  clutter_actor_show_all (stage);
+
+  g_idle_add (change_cell, stage);
+
+  clutter_main ();
+
+  g_free (cells);
+
+  return 0;
+}
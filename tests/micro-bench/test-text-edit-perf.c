@@ -0,0 +1,115 @@
+#include <clutter/clutter.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#define STAGE_WIDTH  800
+#define STAGE_HEIGHT 600
+
+#define DEFAULT_N_LINES 10000
+
+static int n_lines = DEFAULT_N_LINES;
+static int n_typed = 0;
+
+static void
+on_paint (ClutterActor *actor, gconstpointer *data)
+{
+  static GTimer *timer = NULL;
+  static int fps = 0;
+
+  if (!timer)
+    {
+      timer = g_timer_new ();
+      g_timer_start (timer);
+    }
+
+  if (g_timer_elapsed (timer, NULL) >= 1)
+    {
+      printf ("fps=%d, lines=%d, typed=%d\n", fps, n_lines, n_typed);
+      g_timer_start (timer);
+      fps = 0;
+    }
+
+  ++fps;
+}
+
+/* types a character each frame in the middle of the buffer, and
+ * a new line every 40 characters
+ */
+static gboolean
+type_char (gpointer user_data)
+{
+  ClutterText *text = user_data;
+
+  if (n_typed % 40 == 39)
+    clutter_text_insert_unichar (text, '\n');
+  else
+    clutter_text_insert_unichar (text, 'a' + n_typed % 26);
+
+  n_typed += 1;
+
+  return TRUE;
+}
+
+int
+main (int argc, char *argv[])
+{
+  ClutterColor stage_color = { 0x00, 0x00, 0x00, 0xff };
+  ClutterColor text_color = { 0xff, 0xff, 0xff, 0xff };
+  ClutterActor *stage, *text;
+  GString *contents;
+  gfloat cursor_y = 0;
+  int line_length;
+  int i;
+
+  g_setenv ("CLUTTER_VBLANK", "none", FALSE);
+  g_setenv ("CLUTTER_DEFAULT_FPS", "1000", FALSE);
+
+  if (clutter_init (&argc, &argv) != CLUTTER_INIT_SUCCESS)
+    return 1;
+
+  if (argc > 1)
+    n_lines = MAX (atoi (argv[1]), 1);
+
+  g_print ("%d lines\n", n_lines);
+
+  stage = clutter_stage_get_default ();
+  clutter_actor_set_size (stage, STAGE_WIDTH, STAGE_HEIGHT);
+  clutter_stage_set_color (CLUTTER_STAGE (stage), &stage_color);
+
+  g_signal_connect (stage, "paint", G_CALLBACK (on_paint), NULL);
+
+  contents = g_string_new (NULL);
+  for (i = 0; i < n_lines; i++)
+    g_string_append_printf (contents,
+                            "%05d: The quick brown fox jumps over the lazy dog\n",
+                            i % 100000);
+
+  line_length = contents->len / n_lines;
+
+  text = clutter_text_new_full ("Monospace 10px", contents->str, &text_color);
+  clutter_text_set_editable (CLUTTER_TEXT (text), TRUE);
+  clutter_text_set_line_wrap (CLUTTER_TEXT (text), TRUE);
+  clutter_actor_set_width (text, STAGE_WIDTH);
+  clutter_container_add_actor (CLUTTER_CONTAINER (stage), text);
+
+  g_string_free (contents, TRUE);
+
+  /* type in the middle of the buffer, and scroll there */
+  clutter_text_set_cursor_position (CLUTTER_TEXT (text),
+                                    (n_lines / 2) * line_length);
+  clutter_text_position_to_coords (CLUTTER_TEXT (text),
+                                   (n_lines / 2) * line_length,
+                                   NULL, &cursor_y, NULL);
+  clutter_actor_set_anchor_point (text, 0, cursor_y - STAGE_HEIGHT / 2);
+
+  clutter_stage_set_key_focus (CLUTTER_STAGE (stage), text);
+
+  clutter_actor_show_all (stage);
+
+  g_idle_add (type_char, text);
+
+  clutter_main ();
+
+  return 0;
+}
@@ -10,26 +10,53 @@ static int font_size;
 static int n_chars;
 static int rows, cols;
 
+static gboolean use_async = FALSE;
+static gboolean relayout = FALSE;
+static GList *labels = NULL;
+static int frame = 0;
+
 static void
 on_paint (ClutterActor *actor, gconstpointer *data)
 {
   static GTimer *timer = NULL;
+  static GTimer *frame_timer = NULL;
   static int fps = 0;
+  static double frame_sum = 0, frame_sum_sq = 0, frame_max = 0;
 
   if (!timer)
     {
       timer = g_timer_new ();
       g_timer_start (timer);
+
+      frame_timer = g_timer_new ();
+      g_timer_start (frame_timer);
+    }
+  else
+    {
+      /* the time between two paints, in milliseconds */
+      double frame_time = g_timer_elapsed (frame_timer, NULL) * 1000.0;
+
+      frame_sum += frame_time;
+      frame_sum_sq += frame_time * frame_time;
+      frame_max = MAX (frame_max, frame_time);
+
+      g_timer_start (frame_timer);
     }
 
   if (g_timer_elapsed (timer, NULL) >= 1)
     {
-      printf ("fps=%d, strings/sec=%d, chars/sec=%d\n",
+      double mean = fps > 0 ? frame_sum / fps : 0;
+      double variance = fps > 0 ? frame_sum_sq / fps - mean * mean : 0;
+
+      printf ("fps=%d, strings/sec=%d, chars/sec=%d, "
+              "frame time: mean=%.3fms, variance=%.3fms^2, max=%.3fms\n",
 	      fps,
 	      fps * rows * cols,
-	      fps * rows * cols * n_chars);
+	      fps * rows * cols * n_chars,
+              mean, MAX (variance, 0), frame_max);
       g_timer_start (timer);
       fps = 0;
+      frame_sum = frame_sum_sq = frame_max = 0;
     }
 
   ++fps;
@@ -38,6 +65,24 @@ on_paint (ClutterActor *actor, gconstpointer *data)
 static gboolean
 queue_redraw (gpointer stage)
 {
+  if (relayout && labels != NULL)
+    {
+      /* rotate the contents of one label each frame, so that
+       * the text has to be shaped again
+       */
+      ClutterText *label = g_list_nth_data (labels, frame % g_list_length (labels));
+      const gchar *text = clutter_text_get_text (label);
+      const gchar *next = g_utf8_next_char (text);
+      gchar *rotated;
+
+      rotated = g_strdup_printf ("%s%.*s", next, (int) (next - text), text);
+
+      clutter_text_set_text (label, rotated);
+      g_free (rotated);
+
+      frame += 1;
+    }
+
   clutter_actor_queue_redraw (CLUTTER_ACTOR (stage));
 
   return TRUE;
@@ -94,6 +139,7 @@ create_label (void)
 
   label = clutter_text_new_with_text (font_name, str->str);
   clutter_text_set_color (CLUTTER_TEXT (label), &label_color);
+  clutter_text_set_async_layout (CLUTTER_TEXT (label), use_async);
 
   g_free (font_name);
   g_string_free (str, TRUE);
@@ -114,19 +160,34 @@ main (int argc, char *argv[])
   g_setenv ("CLUTTER_VBLANK", "none", FALSE);
   g_setenv ("CLUTTER_DEFAULT_FPS", "1000", FALSE);
 
+  g_thread_init (NULL);
+  clutter_threads_init ();
+
   if (clutter_init (&argc, &argv) != CLUTTER_INIT_SUCCESS)
     return 1;
 
-  if (argc != 3)
+  if (argc < 3 || argc > 4)
     {
-      g_printerr ("Usage test-text-perf FONT_SIZE N_CHARS\n");
+      g_printerr ("Usage test-text-perf FONT_SIZE N_CHARS [relayout|async]\n");
       exit (1);
     }
 
   font_size = atoi (argv[1]);
   n_chars = atoi (argv[2]);
 
-  g_print ("Monospace %dpx, string length = %d\n", font_size, n_chars);
+  /* "relayout" changes the text of a label each frame, and "async"
+   * also shapes the text in a separate thread
+   */
+  if (argc > 3)
+    {
+      use_async = strcmp (argv[3], "async") == 0;
+      relayout = use_async || strcmp (argv[3], "relayout") == 0;
+    }
+
+  g_print ("Monospace %dpx, string length = %d%s%s\n",
+           font_size, n_chars,
+           relayout ? ", relayout" : "",
+           use_async ? ", async layout" : "");
 
   stage = clutter_stage_get_default ();
   clutter_actor_set_size (stage, STAGE_WIDTH, STAGE_HEIGHT);
@@ -175,6 +236,8 @@ main (int argc, char *argv[])
         clutter_actor_set_scale (label, scale, scale);
 	clutter_actor_set_position (label, w * col * scale, h * row * scale);
 	clutter_container_add_actor (CLUTTER_CONTAINER (stage), label);
+
+        labels = g_list_prepend (labels, label);
       }
 
   clutter_actor_show_all (stage);
@@ -183,5 +246,7 @@ main (int argc, char *argv[])
 
   clutter_main ();
 
+  g_list_free (labels);
+
   return 0;
 }
@@ -0,0 +1,181 @@
+#include <clutter/clutter.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#define STAGE_WIDTH  800
+#define STAGE_HEIGHT 600
+
+#define DEFAULT_N_ROWS 10000
+
+static int n_rows = DEFAULT_N_ROWS;
+static int n_created = 0;
+
+static ClutterLayoutManager *layout = NULL;
+static ClutterActor *box = NULL;
+static gfloat scroll = 0;
+
+static void
+on_paint (ClutterActor *actor, gconstpointer *data)
+{
+  static GTimer *timer = NULL;
+  static int fps = 0;
+
+  if (!timer)
+    {
+      timer = g_timer_new ();
+      g_timer_start (timer);
+    }
+
+  if (g_timer_elapsed (timer, NULL) >= 1)
+    {
+      printf ("fps=%d, rows=%d, children=%d\n",
+              fps,
+              n_rows,
+              n_created);
+      g_timer_start (timer);
+      fps = 0;
+    }
+
+  ++fps;
+}
+
+static ClutterActor *
+bind_row (ClutterLayoutManager *manager,
+          ClutterActor         *child,
+          ClutterModelIter     *iter,
+          gpointer              user_data)
+{
+  ClutterColor label_color = { 0xff, 0xff, 0xff, 0xff };
+  gchar *text = NULL;
+
+  clutter_model_iter_get (iter, 0, &text, -1);
+
+  if (child == NULL)
+    {
+      child = clutter_text_new_with_text ("Sans 12px", text);
+      clutter_text_set_color (CLUTTER_TEXT (child), &label_color);
+
+      n_created += 1;
+    }
+  else
+    clutter_text_set_text (CLUTTER_TEXT (child), text);
+
+  g_free (text);
+
+  return child;
+}
+
+/* scrolls the box by a few pixels each frame, which should only
+ * re-bind the children entering the viewport
+ */
+static gboolean
+scroll_box (gpointer stage)
+{
+  gfloat height = clutter_actor_get_height (box);
+
+  scroll += 7;
+  if (scroll > height - STAGE_HEIGHT)
+    scroll = 0;
+
+  clutter_actor_set_anchor_point (box, 0, scroll);
+
+  if (CLUTTER_IS_BOX_LAYOUT (layout))
+    clutter_box_layout_set_viewport (CLUTTER_BOX_LAYOUT (layout),
+                                     0, scroll,
+                                     STAGE_WIDTH, STAGE_HEIGHT);
+  else
+    clutter_flow_layout_set_viewport (CLUTTER_FLOW_LAYOUT (layout),
+                                      0, scroll,
+                                      STAGE_WIDTH, STAGE_HEIGHT);
+
+  return TRUE;
+}
+
+int
+main (int argc, char *argv[])
+{
+  ClutterColor stage_color = { 0x00, 0x00, 0x00, 0xff };
+  ClutterModel *model;
+  ClutterActor *stage;
+  gboolean use_flow = FALSE;
+  int i;
+
+  g_setenv ("CLUTTER_VBLANK", "none", FALSE);
+  g_setenv ("CLUTTER_DEFAULT_FPS", "1000", FALSE);
+
+  if (clutter_init (&argc, &argv) != CLUTTER_INIT_SUCCESS)
+    return 1;
+
+  if (argc > 1)
+    n_rows = MAX (atoi (argv[1]), 1);
+
+  if (argc > 2)
+    use_flow = strcmp (argv[2], "flow") == 0;
+
+  g_print ("%d rows, %s layout\n", n_rows, use_flow ? "flow" : "box");
+
+  stage = clutter_stage_get_default ();
+  clutter_actor_set_size (stage, STAGE_WIDTH, STAGE_HEIGHT);
+  clutter_stage_set_color (CLUTTER_STAGE (stage), &stage_color);
+
+  g_signal_connect (stage, "paint", G_CALLBACK (on_paint), NULL);
+
+  model = clutter_list_model_new (1, G_TYPE_STRING, "Text");
+
+  for (i = 0; i < n_rows; i++)
+    {
+      gchar *text = g_strdup_printf ("Row %d", i);
+
+      clutter_model_append (model, 0, text, -1);
+      g_free (text);
+    }
+
+  if (use_flow)
+    {
+      layout = clutter_flow_layout_new (CLUTTER_FLOW_HORIZONTAL);
+      clutter_flow_layout_set_column_spacing (CLUTTER_FLOW_LAYOUT (layout), 4);
+      clutter_flow_layout_set_row_spacing (CLUTTER_FLOW_LAYOUT (layout), 2);
+    }
+  else
+    {
+      layout = clutter_box_layout_new ();
+      clutter_box_layout_set_vertical (CLUTTER_BOX_LAYOUT (layout), TRUE);
+      clutter_box_layout_set_spacing (CLUTTER_BOX_LAYOUT (layout), 2);
+    }
+
+  box = clutter_box_new (layout);
+  clutter_actor_set_width (box, STAGE_WIDTH);
+  clutter_container_add_actor (CLUTTER_CONTAINER (stage), box);
+
+  if (use_flow)
+    {
+      clutter_flow_layout_set_model (CLUTTER_FLOW_LAYOUT (layout),
+                                     model,
+                                     bind_row,
+                                     NULL, NULL);
+      clutter_flow_layout_set_viewport (CLUTTER_FLOW_LAYOUT (layout),
+                                        0, 0,
+                                        STAGE_WIDTH, STAGE_HEIGHT);
+    }
+  else
+    {
+      clutter_box_layout_set_model (CLUTTER_BOX_LAYOUT (layout),
+                                    model,
+                                    bind_row,
+                                    NULL, NULL);
+      clutter_box_layout_set_viewport (CLUTTER_BOX_LAYOUT (layout),
+                                       0, 0,
+                                       STAGE_WIDTH, STAGE_HEIGHT);
+    }
+
+  clutter_actor_show_all (stage);
+
+  g_idle_add (scroll_box, stage);
+
+  clutter_main ();
+
+  g_object_unref (model);
+
+  return 0;
+}